@@ -0,0 +1,15 @@
+/* contrib/hypo_tuner/hypo_tuner--1.0.sql */
+
+-- complain if script is sourced in psql, rather than via CREATE EXTENSION
+\echo Use "CREATE EXTENSION hypo_tuner" to load this file. \quit
+
+-- Register functions.
+CREATE FUNCTION hypo_tuner_candidates(
+    OUT name text,
+    OUT statement text,
+    OUT size int8,
+    OUT score float8
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME', 'hypo_tuner_show_candidates'
+LANGUAGE C STRICT VOLATILE;
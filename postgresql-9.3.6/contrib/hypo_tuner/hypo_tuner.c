@@ -0,0 +1,703 @@
+/* -------------------------------------------------------------------------
+ *
+ * hypo_tuner.c
+ *		Background worker that turns hypothetical indexes into real ones.
+ *
+ * Every hypo_tuner.naptime seconds, if no more than
+ * hypo_tuner.max_active_backends other backends are running a statement,
+ * the worker scores the hypothetical indexes in the catalogs of
+ * hypo_tuner.database against the workload captured by the planner (see
+ * hypothetical_workload_entries).  The worker has no query texts to cost,
+ * only the columns each statement restricts and joins on and how often it
+ * ran, so an index scores the executions of the statements that restrict
+ * or join on its leading column, equality counting double.  The indexes
+ * scoring at least hypo_tuner.min_score are built for real with CREATE
+ * INDEX CONCURRENTLY, best score per byte first, up to
+ * hypo_tuner.max_builds indexes and hypo_tuner.build_budget of estimated
+ * index size per round, and the hypothetical index is then dropped.
+ *
+ * If hypo_tuner.retire_after is set, real indexes that back no constraint
+ * and that pg_stat_user_indexes shows no scan of for that long are dropped
+ * with DROP INDEX CONCURRENTLY.  The worker only trusts what it has seen
+ * itself, so the clock starts when it first sees an index, and again after
+ * every scan.
+ *
+ * Session-private hypothetical indexes are invisible to the worker.
+ *
+ * CREATE EXTENSION hypo_tuner adds the hypo_tuner_candidates() function,
+ * which shows what the worker would build in the current database, and
+ * with which statements.
+ *
+ * HYPOTHETICAL INDEX
+ * SELF TUNING GROUP - PUC-RIO - 2015
+ *
+ * IDENTIFICATION
+ *		contrib/hypo_tuner/hypo_tuner.c
+ *
+ * -------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+/* These are always necessary for a bgworker */
+#include "miscadmin.h"
+#include "postmaster/bgworker.h"
+#include "storage/ipc.h"
+#include "storage/latch.h"
+#include "storage/lwlock.h"
+#include "storage/proc.h"
+#include "storage/shmem.h"
+
+/* these headers are used by this particular worker's code */
+#include "access/xact.h"
+#include "executor/spi.h"
+#include "fmgr.h"
+#include "funcapi.h"
+#include "lib/stringinfo.h"
+#include "pgstat.h"
+#include "tcop/tcopprot.h"
+#include "tcop/utility.h"
+#include "utils/builtins.h"
+#include "utils/guc.h"
+#include "utils/hsearch.h"
+#include "utils/memutils.h"
+#include "utils/snapmgr.h"
+#include "utils/timestamp.h"
+
+PG_MODULE_MAGIC;
+
+void		_PG_init(void);
+
+PG_FUNCTION_INFO_V1(hypo_tuner_show_candidates);
+
+Datum		hypo_tuner_show_candidates(PG_FUNCTION_ARGS);
+
+/* flags set by signal handlers */
+static volatile sig_atomic_t got_sighup = false;
+static volatile sig_atomic_t got_sigterm = false;
+
+/* GUC variables */
+static char *hypo_tuner_database = NULL;
+static int	hypo_tuner_naptime = 600;
+static int	hypo_tuner_max_active_backends = 2;
+static int	hypo_tuner_min_score = 1000;
+static int	hypo_tuner_max_builds = 1;
+static int	hypo_tuner_build_budget = 1024 * 1024;		/* kB */
+static int	hypo_tuner_retire_after = 0;
+
+/* A hypothetical index worth building */
+typedef struct HypoTunerCandidate
+{
+	char	   *name;			/* qualified name of the hypothetical index */
+	char	   *indexdef;		/* CREATE INDEX CONCURRENTLY statement */
+	int64		size;			/* estimated size in bytes */
+	double		score;
+} HypoTunerCandidate;
+
+/* Scans of a real index, as last seen by the worker */
+typedef struct HypoTunerUsage
+{
+	Oid			indexoid;		/* hash key */
+	int64		idx_scan;		/* pg_stat_user_indexes.idx_scan */
+	TimestampTz since;			/* when idx_scan last changed */
+	bool		seen;			/* seen in the current round? */
+} HypoTunerUsage;
+
+static HTAB *hypoTunerUsage = NULL;
+
+/* long-lived state of a round, see hypo_tuner_round() */
+static MemoryContext HypoTunerContext = NULL;
+
+static void hypo_tuner_round(void);
+static bool hypo_tuner_quiet(void);
+static List *hypo_tuner_candidates(double min_score, MemoryContext cxt);
+static List *hypo_tuner_unused_indexes(void);
+static bool hypo_tuner_utility(const char *sql);
+
+/*
+ * Signal handler for SIGTERM
+ *		Set a flag to let the main loop to terminate, and set our latch to wake
+ *		it up.
+ */
+static void
+hypo_tuner_sigterm(SIGNAL_ARGS)
+{
+	int			save_errno = errno;
+
+	got_sigterm = true;
+	if (MyProc)
+		SetLatch(&MyProc->procLatch);
+
+	errno = save_errno;
+}
+
+/*
+ * Signal handler for SIGHUP
+ *		Set a flag to tell the main loop to reread the config file, and set
+ *		our latch to wake it up.
+ */
+static void
+hypo_tuner_sighup(SIGNAL_ARGS)
+{
+	int			save_errno = errno;
+
+	got_sighup = true;
+	if (MyProc)
+		SetLatch(&MyProc->procLatch);
+
+	errno = save_errno;
+}
+
+static void
+hypo_tuner_main(Datum main_arg)
+{
+	HASHCTL		ctl;
+
+	/* Establish signal handlers before unblocking signals. */
+	pqsignal(SIGHUP, hypo_tuner_sighup);
+	pqsignal(SIGTERM, hypo_tuner_sigterm);
+
+	/* We're now ready to receive signals */
+	BackgroundWorkerUnblockSignals();
+
+	/* Connect to our database */
+	BackgroundWorkerInitializeConnection(hypo_tuner_database, NULL);
+
+	HypoTunerContext = AllocSetContextCreate(TopMemoryContext,
+											 "hypo_tuner",
+											 ALLOCSET_DEFAULT_MINSIZE,
+											 ALLOCSET_DEFAULT_INITSIZE,
+											 ALLOCSET_DEFAULT_MAXSIZE);
+
+	memset(&ctl, 0, sizeof(ctl));
+	ctl.keysize = sizeof(Oid);
+	ctl.entrysize = sizeof(HypoTunerUsage);
+	ctl.hash = oid_hash;
+	hypoTunerUsage = hash_create("hypo_tuner index usage", 256, &ctl,
+								 HASH_ELEM | HASH_FUNCTION);
+
+	elog(LOG, "%s started on database \"%s\"",
+		 MyBgworkerEntry->bgw_name, hypo_tuner_database);
+
+	/*
+	 * Main loop: do this until the SIGTERM handler tells us to terminate
+	 */
+	while (!got_sigterm)
+	{
+		int			rc;
+
+		rc = WaitLatch(&MyProc->procLatch,
+					   WL_LATCH_SET | WL_TIMEOUT | WL_POSTMASTER_DEATH,
+					   hypo_tuner_naptime * 1000L);
+		ResetLatch(&MyProc->procLatch);
+
+		/* emergency bailout if postmaster has died */
+		if (rc & WL_POSTMASTER_DEATH)
+			proc_exit(1);
+
+		/*
+		 * In case of a SIGHUP, just reload the configuration.
+		 */
+		if (got_sighup)
+		{
+			got_sighup = false;
+			ProcessConfigFile(PGC_SIGHUP);
+		}
+
+		if (!(rc & WL_TIMEOUT) || got_sigterm)
+			continue;
+
+		hypo_tuner_round();
+		MemoryContextReset(HypoTunerContext);
+	}
+
+	proc_exit(0);
+}
+
+/*
+ * One round of work: build the best hypothetical indexes and drop the real
+ * ones that have gone unused, if the server is quiet enough.
+ */
+static void
+hypo_tuner_round(void)
+{
+	List	   *candidates = NIL;
+	List	   *unused = NIL;
+	ListCell   *lc;
+	int64		budget = (int64) hypo_tuner_build_budget * 1024;
+	int			builds = 0;
+
+	SetCurrentStatementStartTimestamp();
+	StartTransactionCommand();
+	SPI_connect();
+	PushActiveSnapshot(GetTransactionSnapshot());
+	pgstat_report_activity(STATE_RUNNING, "hypo_tuner: scoring indexes");
+
+	if (hypo_tuner_quiet())
+	{
+		if (hypo_tuner_max_builds > 0 && budget > 0)
+			candidates = hypo_tuner_candidates(hypo_tuner_min_score,
+											   HypoTunerContext);
+		if (hypo_tuner_retire_after > 0)
+			unused = hypo_tuner_unused_indexes();
+	}
+	else
+		elog(DEBUG1, "%s: server busy, skipping this round",
+			 MyBgworkerEntry->bgw_name);
+
+	SPI_finish();
+	PopActiveSnapshot();
+	CommitTransactionCommand();
+	pgstat_report_activity(STATE_IDLE, NULL);
+
+	/* candidates come best first */
+	foreach(lc, candidates)
+	{
+		HypoTunerCandidate *cand = (HypoTunerCandidate *) lfirst(lc);
+		StringInfoData buf;
+
+		if (builds >= hypo_tuner_max_builds || got_sigterm)
+			break;
+		if (cand->size > budget)
+			continue;
+
+		elog(LOG, "%s: building hypothetical index %s (score %.0f, %s)",
+			 MyBgworkerEntry->bgw_name, cand->name, cand->score,
+			 DatumGetCString(DirectFunctionCall1(pg_size_pretty,
+											 Int64GetDatum(cand->size))));
+		if (!hypo_tuner_utility(cand->indexdef))
+			continue;
+
+		initStringInfo(&buf);
+		appendStringInfo(&buf, "DROP HYPOTHETICAL INDEX %s", cand->name);
+		(void) hypo_tuner_utility(buf.data);
+
+		budget -= cand->size;
+		builds++;
+	}
+
+	foreach(lc, unused)
+	{
+		char	   *name = (char *) lfirst(lc);
+		StringInfoData buf;
+
+		if (got_sigterm)
+			break;
+
+		elog(LOG, "%s: dropping index %s, unused for %d seconds",
+			 MyBgworkerEntry->bgw_name, name, hypo_tuner_retire_after);
+		initStringInfo(&buf);
+		appendStringInfo(&buf, "DROP INDEX CONCURRENTLY %s", name);
+		(void) hypo_tuner_utility(buf.data);
+	}
+}
+
+/*
+ * Is the server quiet enough to build or drop indexes?  Must be called
+ * connected to SPI.
+ */
+static bool
+hypo_tuner_quiet(void)
+{
+	int			ret;
+	bool		isnull;
+	int64		active;
+
+	ret = SPI_execute("SELECT count(*) FROM pg_stat_activity "
+					  "WHERE state = 'active' AND pid <> pg_backend_pid()",
+					  true, 0);
+	if (ret != SPI_OK_SELECT || SPI_processed != 1)
+		elog(ERROR, "could not count active backends: error code %d", ret);
+
+	active = DatumGetInt64(SPI_getbinval(SPI_tuptable->vals[0],
+										 SPI_tuptable->tupdesc,
+										 1, &isnull));
+
+	return active <= hypo_tuner_max_active_backends;
+}
+
+/*
+ * The hypothetical indexes scoring at least min_score, best score per byte
+ * first.  Must be called connected to SPI; the result is allocated in cxt.
+ */
+static List *
+hypo_tuner_candidates(double min_score, MemoryContext cxt)
+{
+	List	   *result = NIL;
+	int			ret;
+	int			i;
+
+	/*
+	 * A statement counts once per column, with its strongest use.  The
+	 * relation OIDs of hypothetical_workload() are all of this database's:
+	 * statements planned in other databases are left out of it.
+	 */
+	ret = SPI_execute("SELECT name, indisunique, relname, indexdef, size, score "
+					  "FROM (SELECT i.indexrelid::regclass::text AS name, "
+					  "             i.indisunique, c.relname, "
+					  "             pg_get_indexdef(i.indexrelid) AS indexdef, "
+					  "             pg_hypothetical_index_size(i.indexrelid::regclass::text) AS size, "
+					  "             sum(w.calls * CASE WHEN w.equality THEN 2 ELSE 1 END)::float8 AS score "
+					  "      FROM pg_index i "
+					  "      JOIN pg_class c ON c.oid = i.indexrelid "
+					  "      JOIN (SELECT queryid, relid, attnum, max(calls) AS calls, "
+					  "                   bool_or(clause = 'equality') AS equality "
+					  "            FROM hypothetical_workload() "
+					  "            GROUP BY queryid, relid, attnum) w "
+					  "        ON w.relid = i.indrelid AND w.attnum = i.indkey[0] "
+					  "      WHERE i.indishypothetical "
+					  "      GROUP BY 1, 2, 3, 4, 5) s "
+					  "ORDER BY score / greatest(size, 1) DESC",
+					  true, 0);
+	if (ret != SPI_OK_SELECT)
+		elog(ERROR, "could not score hypothetical indexes: error code %d",
+			 ret);
+
+	for (i = 0; i < SPI_processed; i++)
+	{
+		HeapTuple	tuple = SPI_tuptable->vals[i];
+		TupleDesc	tupdesc = SPI_tuptable->tupdesc;
+		HypoTunerCandidate *cand;
+		MemoryContext oldcxt;
+		StringInfoData prefix;
+		StringInfoData buf;
+		char	   *indexdef;
+		bool		unique;
+		bool		isnull;
+		double		score;
+
+		score = DatumGetFloat8(SPI_getbinval(tuple, tupdesc, 6, &isnull));
+		if (score < min_score)
+			continue;
+
+		/*
+		 * pg_get_indexdef() names the index; leave that to CREATE INDEX, as
+		 * the hypothetical index still holds the name.
+		 */
+		unique = DatumGetBool(SPI_getbinval(tuple, tupdesc, 2, &isnull));
+		indexdef = SPI_getvalue(tuple, tupdesc, 4);
+		initStringInfo(&prefix);
+		appendStringInfo(&prefix, "CREATE %sINDEX %s ON ",
+						 unique ? "UNIQUE " : "",
+						 quote_identifier(SPI_getvalue(tuple, tupdesc, 3)));
+		if (strncmp(indexdef, prefix.data, prefix.len) != 0)
+		{
+			elog(WARNING, "hypo_tuner: cannot parse definition of %s: %s",
+				 SPI_getvalue(tuple, tupdesc, 1), indexdef);
+			continue;
+		}
+
+		oldcxt = MemoryContextSwitchTo(cxt);
+		initStringInfo(&buf);
+		appendStringInfo(&buf, "CREATE %sINDEX CONCURRENTLY ON %s",
+						 unique ? "UNIQUE " : "", indexdef + prefix.len);
+		cand = (HypoTunerCandidate *) palloc(sizeof(HypoTunerCandidate));
+		cand->name = pstrdup(SPI_getvalue(tuple, tupdesc, 1));
+		cand->indexdef = buf.data;
+		cand->size = DatumGetInt64(SPI_getbinval(tuple, tupdesc, 5, &isnull));
+		cand->score = score;
+		result = lappend(result, cand);
+		MemoryContextSwitchTo(oldcxt);
+	}
+
+	return result;
+}
+
+/*
+ * Update what we know of the scans of the real indexes, and return the
+ * qualified names of those unused for hypo_tuner.retire_after seconds.
+ * Must be called connected to SPI; the result is in HypoTunerContext.
+ */
+static List *
+hypo_tuner_unused_indexes(void)
+{
+	List	   *result = NIL;
+	TimestampTz now = GetCurrentTimestamp();
+	HASH_SEQ_STATUS status;
+	HypoTunerUsage *usage;
+	int			ret;
+	int			i;
+
+	/* indexes backing a constraint are needed whether scanned or not */
+	ret = SPI_execute("SELECT s.indexrelid, s.idx_scan, "
+					  "       quote_ident(s.schemaname) || '.' || "
+					  "       quote_ident(s.indexrelname) "
+					  "FROM pg_stat_user_indexes s "
+					  "JOIN pg_index i ON i.indexrelid = s.indexrelid "
+					  "WHERE NOT i.indishypothetical AND i.indisvalid "
+					  "  AND NOT i.indisunique AND NOT i.indisprimary "
+					  "  AND NOT EXISTS (SELECT 1 FROM pg_constraint c "
+					  "                  WHERE c.conindid = s.indexrelid)",
+					  true, 0);
+	if (ret != SPI_OK_SELECT)
+		elog(ERROR, "could not read index statistics: error code %d", ret);
+
+	for (i = 0; i < SPI_processed; i++)
+	{
+		HeapTuple	tuple = SPI_tuptable->vals[i];
+		TupleDesc	tupdesc = SPI_tuptable->tupdesc;
+		Oid			indexoid;
+		int64		idx_scan;
+		bool		isnull;
+		bool		found;
+
+		indexoid = DatumGetObjectId(SPI_getbinval(tuple, tupdesc, 1, &isnull));
+		idx_scan = DatumGetInt64(SPI_getbinval(tuple, tupdesc, 2, &isnull));
+
+		usage = (HypoTunerUsage *) hash_search(hypoTunerUsage, &indexoid,
+											   HASH_ENTER, &found);
+		if (!found || usage->idx_scan != idx_scan)
+		{
+			usage->idx_scan = idx_scan;
+			usage->since = now;
+		}
+		usage->seen = true;
+
+		if (TimestampDifferenceExceeds(usage->since, now,
+									   hypo_tuner_retire_after * 1000))
+		{
+			MemoryContext oldcxt = MemoryContextSwitchTo(HypoTunerContext);
+
+			result = lappend(result,
+							 pstrdup(SPI_getvalue(tuple, tupdesc, 3)));
+			MemoryContextSwitchTo(oldcxt);
+		}
+	}
+
+	/* forget the indexes that are gone */
+	hash_seq_init(&status, hypoTunerUsage);
+	while ((usage = (HypoTunerUsage *) hash_seq_search(&status)) != NULL)
+	{
+		if (!usage->seen)
+			hash_search(hypoTunerUsage, &usage->indexoid, HASH_REMOVE, NULL);
+		else
+			usage->seen = false;
+	}
+
+	return result;
+}
+
+/*
+ * Run a utility statement as a top-level command, as CREATE INDEX
+ * CONCURRENTLY and DROP INDEX CONCURRENTLY must be, in transactions of its
+ * own.  An error is reported and the statement given up, as autovacuum
+ * does with a table; returns whether it succeeded.
+ */
+static bool
+hypo_tuner_utility(const char *sql)
+{
+	MemoryContext oldcxt = CurrentMemoryContext;
+	volatile bool result = true;
+
+	PG_TRY();
+	{
+		Node	   *parsetree;
+
+		SetCurrentStatementStartTimestamp();
+		StartTransactionCommand();
+		PushActiveSnapshot(GetTransactionSnapshot());
+		pgstat_report_activity(STATE_RUNNING, sql);
+
+		/*
+		 * The statement commits transactions on its way, so keep the parse
+		 * tree and whatever the statement allocates outside of them.
+		 */
+		MemoryContextSwitchTo(HypoTunerContext);
+		parsetree = (Node *) linitial(pg_parse_query(sql));
+		ProcessUtility(parsetree, sql, PROCESS_UTILITY_TOPLEVEL, NULL,
+					   None_Receiver, NULL);
+
+		if (ActiveSnapshotSet())
+			PopActiveSnapshot();
+		CommitTransactionCommand();
+	}
+	PG_CATCH();
+	{
+		HOLD_INTERRUPTS();
+		EmitErrorReport();
+		AbortOutOfAnyTransaction();
+		FlushErrorState();
+		RESUME_INTERRUPTS();
+		result = false;
+	}
+	PG_END_TRY();
+
+	MemoryContextSwitchTo(oldcxt);
+	pgstat_report_activity(STATE_IDLE, NULL);
+	return result;
+}
+
+/*
+ * hypo_tuner_candidates
+ *		Show the hypothetical indexes of the current database the worker
+ *		would build, with the statements it would build them with, best
+ *		first.  hypo_tuner.min_score and the budgets are not applied.
+ */
+Datum
+hypo_tuner_show_candidates(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext per_query_ctx;
+	MemoryContext oldcontext;
+	List	   *candidates;
+	ListCell   *lc;
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not " \
+						"allowed in this context")));
+
+	/* Build a tuple descriptor for our result type */
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	tupdesc = CreateTupleDescCopy(tupdesc);
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	if (SPI_connect() != SPI_OK_CONNECT)
+		elog(ERROR, "SPI_connect failed");
+	candidates = hypo_tuner_candidates(0, per_query_ctx);
+	SPI_finish();
+
+	foreach(lc, candidates)
+	{
+		HypoTunerCandidate *cand = (HypoTunerCandidate *) lfirst(lc);
+		Datum		values[4];
+		bool		nulls[4];
+
+		values[0] = CStringGetTextDatum(cand->name);
+		values[1] = CStringGetTextDatum(cand->indexdef);
+		values[2] = Int64GetDatum(cand->size);
+		values[3] = Float8GetDatum(cand->score);
+		memset(nulls, 0, sizeof(nulls));
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+
+	/* clean up and return the tuplestore */
+	tuplestore_donestoring(tupstore);
+
+	return (Datum) 0;
+}
+
+/*
+ * Entrypoint of this module.
+ */
+void
+_PG_init(void)
+{
+	BackgroundWorker worker;
+
+	if (!process_shared_preload_libraries_in_progress)
+		return;
+
+	/* get the configuration */
+	DefineCustomStringVariable("hypo_tuner.database",
+							   "Database whose hypothetical indexes are built.",
+							   NULL,
+							   &hypo_tuner_database,
+							   "postgres",
+							   PGC_POSTMASTER,
+							   0,
+							   NULL,
+							   NULL,
+							   NULL);
+	DefineCustomIntVariable("hypo_tuner.naptime",
+							"Duration between each round (in seconds).",
+							NULL,
+							&hypo_tuner_naptime,
+							600,
+							1,
+							INT_MAX / 1000,
+							PGC_SIGHUP,
+							GUC_UNIT_S,
+							NULL,
+							NULL,
+							NULL);
+	DefineCustomIntVariable("hypo_tuner.max_active_backends",
+							"Other backends running a statement beyond which a round is skipped.",
+							NULL,
+							&hypo_tuner_max_active_backends,
+							2,
+							0,
+							INT_MAX,
+							PGC_SIGHUP,
+							0,
+							NULL,
+							NULL,
+							NULL);
+	DefineCustomIntVariable("hypo_tuner.min_score",
+							"Workload score a hypothetical index needs to be built.",
+							"Each execution of a statement restricting or joining "
+							"on the index's leading column counts one, two for "
+							"an equality.",
+							&hypo_tuner_min_score,
+							1000,
+							0,
+							INT_MAX,
+							PGC_SIGHUP,
+							0,
+							NULL,
+							NULL,
+							NULL);
+	DefineCustomIntVariable("hypo_tuner.max_builds",
+							"Indexes built per round.",
+							"Zero disables building.",
+							&hypo_tuner_max_builds,
+							1,
+							0,
+							INT_MAX,
+							PGC_SIGHUP,
+							0,
+							NULL,
+							NULL,
+							NULL);
+	DefineCustomIntVariable("hypo_tuner.build_budget",
+							"Estimated size of the indexes built per round.",
+							NULL,
+							&hypo_tuner_build_budget,
+							1024 * 1024,
+							0,
+							INT_MAX,
+							PGC_SIGHUP,
+							GUC_UNIT_KB,
+							NULL,
+							NULL,
+							NULL);
+	DefineCustomIntVariable("hypo_tuner.retire_after",
+							"Time without scans after which a real index is dropped.",
+							"Zero disables dropping.",
+							&hypo_tuner_retire_after,
+							0,
+							0,
+							INT_MAX / 1000,
+							PGC_SIGHUP,
+							GUC_UNIT_S,
+							NULL,
+							NULL,
+							NULL);
+
+	worker.bgw_flags = BGWORKER_SHMEM_ACCESS |
+		BGWORKER_BACKEND_DATABASE_CONNECTION;
+	worker.bgw_start_time = BgWorkerStart_RecoveryFinished;
+	worker.bgw_restart_time = BGW_DEFAULT_RESTART_INTERVAL;
+	worker.bgw_main = hypo_tuner_main;
+	worker.bgw_main_arg = (Datum) 0;
+	snprintf(worker.bgw_name, BGW_MAXLEN, "hypo_tuner");
+
+	RegisterBackgroundWorker(&worker);
+}
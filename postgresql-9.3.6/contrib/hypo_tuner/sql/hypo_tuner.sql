@@ -0,0 +1,37 @@
+--
+-- hypo_tuner scores hypothetical indexes against the captured workload
+--
+CREATE EXTENSION hypo_tuner;
+CREATE TABLE tuned (a int4, b text, c int4);
+INSERT INTO tuned SELECT i, 'b' || i, i % 10 FROM generate_series(1, 10000) i;
+ANALYZE tuned;
+CREATE HYPOTHETICAL INDEX tuned_a ON tuned (a);
+CREATE HYPOTHETICAL UNIQUE INDEX tuned_a_unique ON tuned (a);
+CREATE HYPOTHETICAL INDEX tuned_b_part ON tuned (b) WHERE c > 5;
+CREATE HYPOTHETICAL INDEX tuned_c_hash ON tuned USING hash (c);
+CREATE HYPOTHETICAL INDEX tuned_ca ON tuned (c, a);
+SELECT hypothetical_workload_reset();
+-- no workload, nothing to build
+SELECT * FROM hypo_tuner_candidates();
+SELECT count(*) FROM tuned WHERE a = 1;
+SELECT count(*) FROM tuned WHERE a = 2;
+SELECT count(*) FROM tuned WHERE a = 3;
+SELECT count(*) FROM tuned WHERE b > 'b9';
+SELECT count(*) FROM tuned WHERE c = 2 AND a > 5;
+-- equality counts double, and only the leading column scores; the
+-- hypothetical index definitions become CREATE INDEX CONCURRENTLY
+SELECT name, statement, size > 0 AS has_size, score
+  FROM hypo_tuner_candidates() ORDER BY name;
+-- statements planned in another database are not scored here
+\set regressdb :DBNAME
+CREATE DATABASE hypo_tuner_other;
+\c hypo_tuner_other
+CREATE TABLE tuned (a int4, b text, c int4);
+SELECT count(*) FROM tuned WHERE b = 'x';
+SELECT count(*) FROM tuned WHERE b = 'y';
+SELECT count(*) FROM hypothetical_workload();
+\c :regressdb
+DROP DATABASE hypo_tuner_other;
+SELECT name, score FROM hypo_tuner_candidates() ORDER BY name;
+DROP TABLE tuned;
+DROP EXTENSION hypo_tuner;
@@ -50,6 +50,7 @@
 #include "nodes/makefuncs.h"
 #include "nodes/nodeFuncs.h"
 #include "optimizer/clauses.h"
+#include "optimizer/hypoindex.h"
 #include "parser/parser.h"
 #include "storage/bufmgr.h"
 #include "storage/lmgr.h"
@@ -608,7 +609,7 @@ UpdateIndexRelation(Oid indexoid,
 	values[Anum_pg_index_indisprimary - 1] = BoolGetDatum(primary);
 	values[Anum_pg_index_indisexclusion - 1] = BoolGetDatum(isexclusion);
 	values[Anum_pg_index_indimmediate - 1] = BoolGetDatum(immediate);
-	values[Anum_pg_index_indisclustered - 1] = BoolGetDatum(false);
+	values[Anum_pg_index_indisclustered - 1] = BoolGetDatum(indexInfo->ii_Clustered);
 	values[Anum_pg_index_indisvalid - 1] = BoolGetDatum(isvalid);
 	values[Anum_pg_index_indcheckxmin - 1] = BoolGetDatum(false);
 	/* we set isvalid and isready the same way */
@@ -1086,18 +1087,28 @@ index_create(Relation heapRelation,
             {
                     index_register(heapRelationId, indexRelationId, indexInfo);
                     RelationCacheInvalidateEntry(heapRelationId);
+                    hypo_index_catalog_changed();
             }
 
 		/*
 		 * Caller is responsible for filling the index later on.  However,
 		 * we'd better make sure that the heap relation is correctly marked as
 		 * having an index.
+		 *
+		 * HYPOTHETICAL INDEX
+		 * SELF TUNING GROUP - PUC-RIO - 2015
+		 *
+		 * Except for a hypothetical index: updating the table's pg_class row
+		 * would send every backend a relcache inval for it, but only
+		 * hypothetical planning cares about the new index, and it learns
+		 * about it from hypo_index_generation() instead.
 		 */
-		index_update_stats(heapRelation,
-						   true,
-						   isprimary,
-						   InvalidOid,
-						   -1.0);
+		if (!indexInfo->ii_Hypothetical)
+			index_update_stats(heapRelation,
+							   true,
+							   isprimary,
+							   InvalidOid,
+							   -1.0);
 		/* Make the above update visible */
 		CommandCounterIncrement();
 	}
@@ -1343,6 +1354,7 @@ index_drop(Oid indexId, bool concurrent)
 	Relation	indexRelation;
 	HeapTuple	tuple;
 	bool		hasexprs;
+	bool		hypothetical;
 	LockRelId	heaprelid,
 				indexrelid;
 	LOCKTAG		heaplocktag;
@@ -1381,6 +1393,7 @@ index_drop(Oid indexId, bool concurrent)
 
 	userIndexRelation = index_open(indexId, AccessExclusiveLock);
 	lockmode = concurrent ? ShareUpdateExclusiveLock : AccessExclusiveLock;
+	hypothetical = userIndexRelation->rd_index->indishypothetical;
 
 	if (userIndexRelation->rd_index->indishypothetical)
 	{
@@ -1637,8 +1650,20 @@ index_drop(Oid indexId, bool concurrent)
 	 * must send out a shared-cache-inval notice on the owning relation to
 	 * ensure other backends update their relcache lists of indexes.  (In the
 	 * concurrent case, this is redundant but harmless.)
+	 *
+	 * HYPOTHETICAL INDEX
+	 * SELF TUNING GROUP - PUC-RIO - 2015
+	 *
+	 * Not for a hypothetical index, see index_create().  One created ON
+	 * COMMIT DROP no longer needs dropping at commit.
 	 */
-	CacheInvalidateRelcache(userHeapRelation);
+	if (hypothetical)
+	{
+		hypo_index_catalog_changed();
+		remove_on_commit_action(indexId);
+	}
+	else
+		CacheInvalidateRelcache(userHeapRelation);
 
 	/*
 	 * Close owning rel, but keep lock
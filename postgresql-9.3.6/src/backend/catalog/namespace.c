@@ -42,6 +42,7 @@
 #include "mb/pg_wchar.h"
 #include "miscadmin.h"
 #include "nodes/makefuncs.h"
+#include "optimizer/hypoindex.h"
 #include "parser/parse_func.h"
 #include "storage/ipc.h"
 #include "storage/lmgr.h"
@@ -3877,6 +3878,9 @@ assign_search_path(const char *newval, void *extra)
 	 * initialization, or outside a transaction.
 	 */
 	baseSearchPathValid = false;
+
+	/* unqualified names of disabled indexes may resolve differently now */
+	hypo_index_invalidate_disabled();
 }
 
 /*
@@ -685,6 +685,9 @@ CREATE VIEW pg_stat_bgwriter AS
         pg_stat_get_buf_alloc() AS buffers_alloc,
         pg_stat_get_bgwriter_stat_reset_time() AS stats_reset;
 
+CREATE VIEW pg_stat_planner_phases AS
+    SELECT * FROM pg_stat_get_planner_phases() AS P;
+
 CREATE VIEW pg_user_mappings AS
     SELECT
         U.oid       AS umid,
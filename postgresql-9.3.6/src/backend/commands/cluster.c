@@ -154,7 +154,9 @@ cluster(ClusterStmt *stmt, bool isTopLevel)
 				if (!HeapTupleIsValid(idxtuple))
 					elog(ERROR, "cache lookup failed for index %u", indexOid);
 				indexForm = (Form_pg_index) GETSTRUCT(idxtuple);
-				if (indexForm->indisclustered)
+				/* a hypothetical index is only clustered hypothetically */
+				if (indexForm->indisclustered &&
+					!indexForm->indishypothetical)
 				{
 					ReleaseSysCache(idxtuple);
 					break;
@@ -468,6 +470,20 @@ check_index_is_clusterable(Relation OldHeap, Oid indexOid, bool recheck, LOCKMOD
 						RelationGetRelationName(OldIndex),
 						RelationGetRelationName(OldHeap))));
 
+	/*
+	 * HYPOTHETICAL INDEX
+	 * SELF TUNING GROUP - PUC-RIO - 2015
+	 *
+	 * A hypothetical index has nothing to read the table in order from; it
+	 * can only be declared clustered when it is created.
+	 */
+	if (OldIndex->rd_index->indishypothetical)
+		ereport(ERROR,
+				(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+				 errmsg("cannot cluster on hypothetical index \"%s\"",
+						RelationGetRelationName(OldIndex)),
+				 errhint("Use CREATE HYPOTHETICAL INDEX ... WITH (clustered) to cost scans as if the table were clustered on it.")));
+
 	/* Index AM must allow clustering */
 	if (!OldIndex->rd_am->amclusterable)
 		ereport(ERROR,
@@ -557,6 +573,19 @@ mark_index_clustered(Relation rel, Oid indexOid, bool is_internal)
 			elog(ERROR, "cache lookup failed for index %u", thisIndexOid);
 		indexForm = (Form_pg_index) GETSTRUCT(indexTuple);
 
+		/*
+		 * HYPOTHETICAL INDEX
+		 * SELF TUNING GROUP - PUC-RIO - 2015
+		 *
+		 * The bit of a hypothetical index says how it was declared, not how
+		 * the table was last clustered; leave it alone.
+		 */
+		if (indexForm->indishypothetical)
+		{
+			heap_freetuple(indexTuple);
+			continue;
+		}
+
 		/*
 		 * Unset the bit if set.  We know it's wrong because we checked this
 		 * earlier.
@@ -1635,6 +1664,10 @@ get_tables_to_cluster(MemoryContext cluster_context)
 	{
 		index = (Form_pg_index) GETSTRUCT(indexTuple);
 
+		/* hypothetical indexes are only clustered hypothetically */
+		if (index->indishypothetical)
+			continue;
+
 		if (!pg_class_ownercheck(index->indrelid, GetUserId()))
 			continue;
 
@@ -13,7 +13,10 @@
  */
 #include "postgres.h"
 
+#include "access/genam.h"
+#include "access/htup_details.h"
 #include "access/xact.h"
+#include "catalog/pg_index.h"
 #include "catalog/pg_type.h"
 #include "commands/createas.h"
 #include "commands/defrem.h"
@@ -21,6 +24,8 @@
 #include "executor/hashjoin.h"
 #include "foreign/fdwapi.h"
 #include "optimizer/clauses.h"
+#include "optimizer/hypoindex.h"
+#include "optimizer/hypotiming.h"
 #include "parser/parsetree.h"
 #include "rewrite/rewriteHandler.h"
 #include "tcop/tcopprot.h"
@@ -29,6 +34,7 @@
 #include "utils/lsyscache.h"
 #include "utils/rel.h"
 #include "utils/snapmgr.h"
+#include "utils/syscache.h"
 #include "utils/tuplesort.h"
 #include "utils/xml.h"
 
@@ -52,6 +58,24 @@ explain_get_index_name_hook_type explain_get_index_name_hook = NULL;
 
 static void ExplainOneQuery(Query *query, IntoClause *into, ExplainState *es,
 				const char *queryString, ParamListInfo params);
+static PlannedStmt *ExplainPlanQuery(Query *query, ParamListInfo params,
+				 ExplainState *es, HypoPlannerTimes **times);
+static void ExplainPlanningTime(ExplainState *es);
+static void ExplainCompareQuery(Query *query, IntoClause *into,
+					ExplainState *es, const char *queryString,
+					ParamListInfo params);
+static void ExplainComparePlan(PlannedStmt *plannedstmt, const char *label,
+				   IntoClause *into, ExplainState *es,
+				   const char *queryString, ParamListInfo params);
+static void ExplainCompareScans(PlannedStmt *realplan, PlannedStmt *hypoplan,
+					ExplainState *es);
+static void ExplainCompareScan(Scan *realscan, Scan *hyposcan, List *rtable,
+				   ExplainState *es);
+static void ExplainCompareScanLabel(Scan *scan, ExplainState *es);
+static const char *ExplainCompareScanType(Scan *scan);
+static Oid	ExplainCompareScanIndex(Scan *scan);
+static void ExplainCollectScans(Plan *plan, List **scans, List **indexids);
+static bool explain_index_is_hypothetical(Oid indexid);
 static void report_triggers(ResultRelInfo *rInfo, bool show_relname,
 				ExplainState *es);
 static double elapsed_time(instr_time *starttime);
@@ -85,6 +109,7 @@ static void show_sort_keys_common(PlanState *planstate,
 					  List *ancestors, ExplainState *es);
 static void show_sort_info(SortState *sortstate, ExplainState *es);
 static void show_hash_info(HashState *hashstate, ExplainState *es);
+static void show_hashagg_info(AggState *aggstate, ExplainState *es);
 static void show_instrumentation_count(const char *qlabel, int which,
 						   PlanState *planstate, ExplainState *es);
 static void show_foreignscan_info(ForeignScanState *fsstate, ExplainState *es);
@@ -95,6 +120,13 @@ static void ExplainScanTarget(Scan *plan, ExplainState *es);
 static void ExplainModifyTarget(ModifyTable *plan, ExplainState *es);
 static void ExplainTargetRel(Plan *plan, Index rti, ExplainState *es);
 static void show_modifytable_info(ModifyTableState *mtstate, ExplainState *es);
+static void show_hypothetical_write_cost(ModifyTableState *mtstate,
+							 ExplainState *es);
+static void show_hypothetical_heap_fetches(IndexOnlyScan *plan,
+							   ExplainState *es);
+static void show_hypothetical_index_write_cost(const char *indexname,
+								   HypoIndexWriteCost *cost,
+								   bool *opened, ExplainState *es);
 static void ExplainMemberNodes(List *plans, PlanState **planstates,
 				   List *ancestors, ExplainState *es);
 static void ExplainSubPlans(List *plans, List *ancestors,
@@ -149,6 +181,11 @@ ExplainQuery(ExplainStmt *stmt, const char *queryString,
 			timing_set = true;
 			es.timing = defGetBoolean(opt);
 		}
+		/* HYPOTHETICAL INDEX SELF TUNING GROUP - PUC-RIO - 2015 */
+		else if (strcmp(opt->defname, "compare") == 0)
+			es.compare = defGetBoolean(opt);
+		else if (strcmp(opt->defname, "summary") == 0)
+			es.summary = defGetBoolean(opt);
 		else if (strcmp(opt->defname, "format") == 0)
 		{
 			char	   *p = defGetString(opt);
@@ -179,6 +216,12 @@ ExplainQuery(ExplainStmt *stmt, const char *queryString,
 				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
 				 errmsg("EXPLAIN option BUFFERS requires ANALYZE")));
 
+	/* a plan using hypothetical indexes cannot be run */
+	if (es.compare && es.analyze)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("EXPLAIN options COMPARE and ANALYZE cannot be used together")));
+
 	/* if the timing was not set explicitly, set default value */
 	es.timing = (timing_set) ? es.timing : es.analyze;
 
@@ -315,19 +358,498 @@ ExplainOneQuery(Query *query, IntoClause *into, ExplainState *es,
 		return;
 	}
 
+	/* HYPOTHETICAL INDEX SELF TUNING GROUP - PUC-RIO - 2015 */
+	if (es->compare)
+		ExplainCompareQuery(query, into, es, queryString, params);
 	/* if an advisor plugin is present, let it manage things */
-	if (ExplainOneQuery_hook)
+	else if (ExplainOneQuery_hook)
 		(*ExplainOneQuery_hook) (query, into, es, queryString, params);
 	else
 	{
 		PlannedStmt *plan;
 
 		/* plan the query */
-		plan = pg_plan_query(query, 0, params);
+		plan = ExplainPlanQuery(query, params, es, &es->planning);
 
 		/* run it (if needed) and produce output */
 		ExplainOnePlan(plan, into, es, queryString, params);
+		es->planning = NULL;
+	}
+}
+
+/*
+ * ExplainPlanQuery -
+ *	  plan a Query for EXPLAIN
+ *
+ * With SUMMARY, the planning is timed by phase and *times is set to its
+ * times; otherwise *times is set to NULL.
+ */
+static PlannedStmt *
+ExplainPlanQuery(Query *query, ParamListInfo params, ExplainState *es,
+				 HypoPlannerTimes **times)
+{
+	PlannedStmt *plan;
+
+	if (!es->summary)
+	{
+		*times = NULL;
+		return pg_plan_query(query, 0, params);
+	}
+
+	hypo_timing_request();
+	plan = pg_plan_query(query, 0, params);
+	*times = (HypoPlannerTimes *) palloc(sizeof(HypoPlannerTimes));
+	hypo_timing_last(*times);
+
+	return plan;
+}
+
+/*
+ * ExplainPlanningTime -
+ *	  print the planning time of es->planning and its breakdown by phase,
+ *	  for EXPLAIN (SUMMARY)
+ */
+static void
+ExplainPlanningTime(ExplainState *es)
+{
+	HypoPlannerTimes *times = es->planning;
+	int			i;
+
+	if (times == NULL)
+		return;
+
+	if (es->format == EXPLAIN_FORMAT_TEXT)
+	{
+		appendStringInfoSpaces(es->str, es->indent * 2);
+		appendStringInfo(es->str, "Planning Time: %.3f ms%s\n",
+						 times->total_ms,
+						 times->cached ? " (cached plan)" : "");
+		for (i = 0; i < HYPO_NUM_PHASES; i++)
+		{
+			appendStringInfoSpaces(es->str, (es->indent + 1) * 2);
+			appendStringInfo(es->str, "%s: %.3f ms\n",
+							 hypo_phase_names[i], times->phase_ms[i]);
+		}
+		return;
 	}
+
+	ExplainPropertyFloat("Planning Time", times->total_ms, 3, es);
+	ExplainProperty("Cached Plan", times->cached ? "true" : "false", true,
+					es);
+	ExplainOpenGroup("Planning Phases", "Planning Phases", true, es);
+	for (i = 0; i < HYPO_NUM_PHASES; i++)
+		ExplainPropertyFloat(hypo_phase_names[i], times->phase_ms[i], 3, es);
+	ExplainCloseGroup("Planning Phases", "Planning Phases", true, es);
+}
+
+/*
+ * ExplainCompareQuery -
+ *	  print out the plans of one Query without and with hypothetical
+ *	  indexes, and how they differ
+ *
+ * This is EXPLAIN (COMPARE).  The two plans are made from copies of the
+ * same Query, so their flattened range tables line up and scans of the
+ * same relation can be matched by range table index.
+ */
+static void
+ExplainCompareQuery(Query *query, IntoClause *into, ExplainState *es,
+					const char *queryString, ParamListInfo params)
+{
+	Query	   *hypoquery = (Query *) copyObject(query);
+	PlannedStmt *realplan;
+	PlannedStmt *hypoplan;
+	HypoPlannerTimes *realtimes;
+	HypoPlannerTimes *hypotimes;
+
+	query->hypothetical = false;
+	realplan = ExplainPlanQuery(query, params, es, &realtimes);
+	hypoquery->hypothetical = true;
+	hypoplan = ExplainPlanQuery(hypoquery, params, es, &hypotimes);
+
+	ExplainOpenGroup("Query", NULL, true, es);
+	es->planning = realtimes;
+	ExplainComparePlan(realplan, "Plan Without Hypothetical Indexes", into,
+					   es, queryString, params);
+	es->planning = hypotimes;
+	ExplainComparePlan(hypoplan, "Plan With Hypothetical Indexes", into,
+					   es, queryString, params);
+	es->planning = NULL;
+	ExplainCompareScans(realplan, hypoplan, es);
+	ExplainCloseGroup("Query", NULL, true, es);
+}
+
+/*
+ * Print one of the plans of EXPLAIN (COMPARE) under the given label.  As
+ * ANALYZE isn't allowed, this is the EXPLAIN_ONLY part of ExplainOnePlan().
+ */
+static void
+ExplainComparePlan(PlannedStmt *plannedstmt, const char *label,
+				   IntoClause *into, ExplainState *es,
+				   const char *queryString, ParamListInfo params)
+{
+	QueryDesc  *queryDesc;
+	int			eflags = EXEC_FLAG_EXPLAIN_ONLY;
+	int			save_indent = es->indent;
+
+	PushCopiedSnapshot(GetActiveSnapshot());
+	UpdateActiveSnapshotCommandId();
+
+	queryDesc = CreateQueryDesc(plannedstmt, queryString,
+								GetActiveSnapshot(), InvalidSnapshot,
+								into ? CreateIntoRelDestReceiver(into) :
+								None_Receiver,
+								params, 0);
+	if (into)
+		eflags |= GetIntoRelEFlags(into);
+	ExecutorStart(queryDesc, eflags);
+
+	ExplainOpenGroup(label, label, true, es);
+	if (es->format == EXPLAIN_FORMAT_TEXT)
+	{
+		/* laid out like a SubPlan */
+		appendStringInfoSpaces(es->str, es->indent * 2);
+		appendStringInfo(es->str, "%s\n", label);
+		es->indent++;
+	}
+	ExplainPrintPlan(es, queryDesc);
+	ExplainPlanningTime(es);
+	/* the group handles the indentation of the structured formats */
+	if (es->format == EXPLAIN_FORMAT_TEXT)
+		es->indent = save_indent;
+	ExplainCloseGroup(label, label, true, es);
+
+	ExecutorEnd(queryDesc);
+	FreeQueryDesc(queryDesc);
+	PopActiveSnapshot();
+}
+
+/*
+ * Print how the plan with hypothetical indexes differs from the one
+ * without: the total cost delta, the hypothetical indexes it uses, and the
+ * row and cost estimates of each relation scan in both.
+ */
+static void
+ExplainCompareScans(PlannedStmt *realplan, PlannedStmt *hypoplan,
+					ExplainState *es)
+{
+	List	   *realscans = NIL;
+	List	   *hyposcans = NIL;
+	List	   *realindexes = NIL;
+	List	   *hypoindexes = NIL;
+	List	   *usedoids = NIL;
+	List	   *usednames = NIL;
+	ListCell   *lc;
+	ListCell   *lc2;
+
+	ExplainCollectScans(realplan->planTree, &realscans, &realindexes);
+	foreach(lc, realplan->subplans)
+		ExplainCollectScans((Plan *) lfirst(lc), &realscans, &realindexes);
+	ExplainCollectScans(hypoplan->planTree, &hyposcans, &hypoindexes);
+	foreach(lc, hypoplan->subplans)
+		ExplainCollectScans((Plan *) lfirst(lc), &hyposcans, &hypoindexes);
+
+	if (es->costs)
+	{
+		double		delta = hypoplan->planTree->total_cost -
+			realplan->planTree->total_cost;
+
+		if (es->format == EXPLAIN_FORMAT_TEXT)
+		{
+			appendStringInfoSpaces(es->str, es->indent * 2);
+			appendStringInfo(es->str, "Total Cost Delta: %.2f\n", delta);
+		}
+		else
+			ExplainPropertyFloat("Total Cost Delta", delta, 2, es);
+	}
+
+	foreach(lc, hypoindexes)
+	{
+		Oid			indexid = lfirst_oid(lc);
+
+		if (explain_index_is_hypothetical(indexid) &&
+			!list_member_oid(usedoids, indexid))
+		{
+			usedoids = lappend_oid(usedoids, indexid);
+			usednames = lappend(usednames,
+								(char *) explain_get_index_name(indexid));
+		}
+	}
+	if (usednames == NIL && es->format == EXPLAIN_FORMAT_TEXT)
+		usednames = list_make1("none");
+	ExplainPropertyList("Hypothetical Indexes Used", usednames, es);
+
+	ExplainOpenGroup("Scan Deltas", "Scan Deltas", false, es);
+	if (es->format == EXPLAIN_FORMAT_TEXT)
+	{
+		appendStringInfoSpaces(es->str, es->indent * 2);
+		appendStringInfoString(es->str, "Scan Deltas:\n");
+		es->indent++;
+	}
+
+	foreach(lc, realscans)
+	{
+		Scan	   *realscan = (Scan *) lfirst(lc);
+		Scan	   *hyposcan = NULL;
+
+		foreach(lc2, hyposcans)
+		{
+			if (((Scan *) lfirst(lc2))->scanrelid == realscan->scanrelid)
+			{
+				hyposcan = (Scan *) lfirst(lc2);
+				hyposcans = list_delete_ptr(hyposcans, hyposcan);
+				break;
+			}
+		}
+		ExplainCompareScan(realscan, hyposcan, realplan->rtable, es);
+	}
+	/* anything left is only scanned with hypothetical indexes */
+	foreach(lc, hyposcans)
+		ExplainCompareScan(NULL, (Scan *) lfirst(lc), hypoplan->rtable, es);
+
+	if (es->format == EXPLAIN_FORMAT_TEXT)
+		es->indent--;
+	ExplainCloseGroup("Scan Deltas", "Scan Deltas", false, es);
+}
+
+/*
+ * Print the two scans of one relation for ExplainCompareScans(); either may
+ * be NULL.
+ */
+static void
+ExplainCompareScan(Scan *realscan, Scan *hyposcan, List *rtable,
+				   ExplainState *es)
+{
+	Scan	   *scan = realscan ? realscan : hyposcan;
+	RangeTblEntry *rte = rt_fetch(scan->scanrelid, rtable);
+	char	   *relname = get_rel_name(rte->relid);
+	char	   *alias = rte->eref->aliasname;
+
+	if (relname == NULL)
+		elog(ERROR, "cache lookup failed for relation %u", rte->relid);
+
+	if (es->format == EXPLAIN_FORMAT_TEXT)
+	{
+		appendStringInfoSpaces(es->str, es->indent * 2);
+		appendStringInfoString(es->str, quote_identifier(relname));
+		if (strcmp(alias, relname) != 0)
+			appendStringInfo(es->str, " %s", quote_identifier(alias));
+		appendStringInfoString(es->str, ": ");
+		ExplainCompareScanLabel(realscan, es);
+		appendStringInfoString(es->str, " -> ");
+		ExplainCompareScanLabel(hyposcan, es);
+		if (es->costs)
+		{
+			if (realscan && hyposcan)
+				appendStringInfo(es->str,
+								 "  Rows: %.0f -> %.0f  Total Cost: %.2f -> %.2f (%.2f)",
+								 realscan->plan.plan_rows,
+								 hyposcan->plan.plan_rows,
+								 realscan->plan.total_cost,
+								 hyposcan->plan.total_cost,
+								 hyposcan->plan.total_cost -
+								 realscan->plan.total_cost);
+			else
+				appendStringInfo(es->str,
+								 "  Rows: %.0f  Total Cost: %.2f",
+								 scan->plan.plan_rows,
+								 scan->plan.total_cost);
+		}
+		appendStringInfoChar(es->str, '\n');
+		return;
+	}
+
+	ExplainOpenGroup("Scan", NULL, true, es);
+	ExplainPropertyText("Relation Name", relname, es);
+	ExplainPropertyText("Alias", alias, es);
+	if (realscan)
+	{
+		ExplainPropertyText("Node Type Without",
+							ExplainCompareScanType(realscan), es);
+		if (ExplainCompareScanIndex(realscan) != InvalidOid)
+			ExplainPropertyText("Index Name Without",
+				explain_get_index_name(ExplainCompareScanIndex(realscan)),
+								es);
+	}
+	if (hyposcan)
+	{
+		ExplainPropertyText("Node Type With",
+							ExplainCompareScanType(hyposcan), es);
+		if (ExplainCompareScanIndex(hyposcan) != InvalidOid)
+			ExplainPropertyText("Index Name With",
+				explain_get_index_name(ExplainCompareScanIndex(hyposcan)),
+								es);
+	}
+	if (es->costs)
+	{
+		if (realscan)
+		{
+			ExplainPropertyFloat("Plan Rows Without",
+								 realscan->plan.plan_rows, 0, es);
+			ExplainPropertyFloat("Total Cost Without",
+								 realscan->plan.total_cost, 2, es);
+		}
+		if (hyposcan)
+		{
+			ExplainPropertyFloat("Plan Rows With",
+								 hyposcan->plan.plan_rows, 0, es);
+			ExplainPropertyFloat("Total Cost With",
+								 hyposcan->plan.total_cost, 2, es);
+		}
+		if (realscan && hyposcan)
+		{
+			ExplainPropertyFloat("Rows Delta",
+								 hyposcan->plan.plan_rows -
+								 realscan->plan.plan_rows, 0, es);
+			ExplainPropertyFloat("Total Cost Delta",
+								 hyposcan->plan.total_cost -
+								 realscan->plan.total_cost, 2, es);
+		}
+	}
+	ExplainCloseGroup("Scan", NULL, true, es);
+}
+
+/*
+ * Text form of one side of a scan delta: the node type, and the index for
+ * index scans.
+ */
+static void
+ExplainCompareScanLabel(Scan *scan, ExplainState *es)
+{
+	if (scan == NULL)
+	{
+		appendStringInfoString(es->str, "(none)");
+		return;
+	}
+	appendStringInfoString(es->str, ExplainCompareScanType(scan));
+	if (ExplainCompareScanIndex(scan) != InvalidOid)
+		appendStringInfo(es->str, " using %s",
+				 explain_get_index_name(ExplainCompareScanIndex(scan)));
+}
+
+/*
+ * Node type name of a relation scan, as ExplainNode() shows it
+ */
+static const char *
+ExplainCompareScanType(Scan *scan)
+{
+	switch (nodeTag(scan))
+	{
+		case T_SeqScan:
+			return "Seq Scan";
+		case T_IndexScan:
+			return "Index Scan";
+		case T_IndexOnlyScan:
+			return "Index Only Scan";
+		case T_BitmapHeapScan:
+			return "Bitmap Heap Scan";
+		case T_TidScan:
+			return "Tid Scan";
+		case T_ForeignScan:
+			return "Foreign Scan";
+		default:
+			return "???";
+	}
+}
+
+/*
+ * Index read by an index or index-only scan, else InvalidOid.  The indexes
+ * of a bitmap scan are reported among those used, not here.
+ */
+static Oid
+ExplainCompareScanIndex(Scan *scan)
+{
+	if (IsA(scan, IndexScan))
+		return ((IndexScan *) scan)->indexid;
+	if (IsA(scan, IndexOnlyScan))
+		return ((IndexOnlyScan *) scan)->indexid;
+	return InvalidOid;
+}
+
+/*
+ * Collect the relation scans of a plan tree into *scans and the OIDs of
+ * the indexes it reads into *indexids.  SubPlans and InitPlans are in the
+ * PlannedStmt's subplans list, which the caller walks separately.
+ */
+static void
+ExplainCollectScans(Plan *plan, List **scans, List **indexids)
+{
+	ListCell   *lc;
+
+	if (plan == NULL)
+		return;
+
+	switch (nodeTag(plan))
+	{
+		case T_SeqScan:
+		case T_BitmapHeapScan:
+		case T_TidScan:
+		case T_ForeignScan:
+			*scans = lappend(*scans, plan);
+			break;
+		case T_IndexScan:
+			*scans = lappend(*scans, plan);
+			*indexids = lappend_oid(*indexids, ((IndexScan *) plan)->indexid);
+			break;
+		case T_IndexOnlyScan:
+			*scans = lappend(*scans, plan);
+			*indexids = lappend_oid(*indexids,
+									((IndexOnlyScan *) plan)->indexid);
+			break;
+		case T_BitmapIndexScan:
+			*indexids = lappend_oid(*indexids,
+									((BitmapIndexScan *) plan)->indexid);
+			break;
+		case T_ModifyTable:
+			foreach(lc, ((ModifyTable *) plan)->plans)
+				ExplainCollectScans((Plan *) lfirst(lc), scans, indexids);
+			break;
+		case T_Append:
+			foreach(lc, ((Append *) plan)->appendplans)
+				ExplainCollectScans((Plan *) lfirst(lc), scans, indexids);
+			break;
+		case T_MergeAppend:
+			foreach(lc, ((MergeAppend *) plan)->mergeplans)
+				ExplainCollectScans((Plan *) lfirst(lc), scans, indexids);
+			break;
+		case T_BitmapAnd:
+			foreach(lc, ((BitmapAnd *) plan)->bitmapplans)
+				ExplainCollectScans((Plan *) lfirst(lc), scans, indexids);
+			break;
+		case T_BitmapOr:
+			foreach(lc, ((BitmapOr *) plan)->bitmapplans)
+				ExplainCollectScans((Plan *) lfirst(lc), scans, indexids);
+			break;
+		case T_SubqueryScan:
+			ExplainCollectScans(((SubqueryScan *) plan)->subplan,
+								scans, indexids);
+			break;
+		default:
+			break;
+	}
+
+	ExplainCollectScans(plan->lefttree, scans, indexids);
+	ExplainCollectScans(plan->righttree, scans, indexids);
+}
+
+/*
+ * Is indexid a hypothetical index, in the catalogs or session-private?
+ */
+static bool
+explain_index_is_hypothetical(Oid indexid)
+{
+	HeapTuple	tuple;
+	bool		result;
+
+	if (hypo_index_find(indexid) != NULL)
+		return true;
+
+	tuple = SearchSysCache1(INDEXRELID, ObjectIdGetDatum(indexid));
+	if (!HeapTupleIsValid(tuple))
+		return false;
+	result = ((Form_pg_index) GETSTRUCT(tuple))->indishypothetical;
+	ReleaseSysCache(tuple);
+
+	return result;
 }
 
 /*
@@ -365,8 +887,15 @@ ExplainOneUtility(Node *utilityStmt, IntoClause *into, ExplainState *es,
 						queryString, params);
 	}
 	else if (IsA(utilityStmt, ExecuteStmt))
+	{
+		/* the prepared plan was made one way only */
+		if (es->compare)
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("EXPLAIN option COMPARE is not supported for EXECUTE")));
 		ExplainExecuteQuery((ExecuteStmt *) utilityStmt, into, es,
 							queryString, params);
+	}
 	else if (IsA(utilityStmt, NotifyStmt))
 	{
 		if (es->format == EXPLAIN_FORMAT_TEXT)
@@ -528,6 +1057,9 @@ ExplainOnePlan(PlannedStmt *plannedstmt, IntoClause *into, ExplainState *es,
 
 	totaltime += elapsed_time(&starttime);
 
+	/* HYPOTHETICAL INDEX SELF TUNING GROUP - PUC-RIO - 2015 */
+	ExplainPlanningTime(es);
+
 	if (es->analyze)
 	{
 		if (es->format == EXPLAIN_FORMAT_TEXT)
@@ -1248,6 +1780,8 @@ ExplainNode(PlanState *planstate, List *ancestors,
 			if (es->analyze)
 				ExplainPropertyLong("Heap Fetches",
 				   ((IndexOnlyScanState *) planstate)->ioss_HeapFetches, es);
+			else if (explain_index_is_hypothetical(((IndexOnlyScan *) plan)->indexid))
+				show_hypothetical_heap_fetches((IndexOnlyScan *) plan, es);
 			break;
 		case T_BitmapIndexScan:
 			show_scan_qual(((BitmapIndexScan *) plan)->indexqualorig,
@@ -1347,6 +1881,9 @@ ExplainNode(PlanState *planstate, List *ancestors,
 			if (plan->qual)
 				show_instrumentation_count("Rows Removed by Filter", 1,
 										   planstate, es);
+			if (IsA(plan, Agg) &&
+				((Agg *) plan)->aggstrategy == AGG_HASHED)
+				show_hashagg_info((AggState *) planstate, es);
 			break;
 		case T_Sort:
 			show_sort_keys((SortState *) planstate, ancestors, es);
@@ -1823,6 +2360,40 @@ show_hash_info(HashState *hashstate, ExplainState *es)
 	}
 }
 
+/*
+ * If it's EXPLAIN ANALYZE, show how much a hashed aggregation spilled to
+ * disk.  In text format, nothing is shown unless it did.
+ */
+static void
+show_hashagg_info(AggState *aggstate, ExplainState *es)
+{
+	long		diskUsedKb;
+	long		spacePeakKb;
+
+	Assert(IsA(aggstate, AggState));
+
+	if (!es->analyze)
+		return;
+
+	diskUsedKb = (long) ((aggstate->hash_disk_used + 1023) / 1024);
+	spacePeakKb = (long) ((aggstate->hash_mem_peak + 1023) / 1024);
+
+	if (es->format != EXPLAIN_FORMAT_TEXT)
+	{
+		ExplainPropertyLong("Hash Batches", aggstate->hash_batches_used, es);
+		ExplainPropertyLong("Disk Usage", diskUsedKb, es);
+		ExplainPropertyLong("Peak Memory Usage", spacePeakKb, es);
+	}
+	else if (aggstate->hash_batches_used > 0)
+	{
+		appendStringInfoSpaces(es->str, es->indent * 2);
+		appendStringInfo(es->str,
+						 "Batches: %d  Disk Usage: %ldkB  Memory Usage: %ldkB\n",
+						 aggstate->hash_batches_used, diskUsedKb,
+						 spacePeakKb);
+	}
+}
+
 /*
  * If it's EXPLAIN ANALYZE, show instrumentation information for a plan node
  *
@@ -1883,6 +2454,14 @@ explain_get_index_name(Oid indexId)
 	else
 		result = NULL;
 	if (result == NULL)
+	{
+		/* HYPOTHETICAL INDEX SELF TUNING GROUP - PUC-RIO - 2015 */
+		HypoIndex  *hypoindex = hypo_index_find(indexId);
+
+		if (hypoindex != NULL)
+			result = quote_identifier(hypoindex->name);
+	}
+	if (result == NULL)
 	{
 		/* default behavior: look in the catalogs and quote it */
 		result = get_rel_name(indexId);
@@ -2086,6 +2665,172 @@ show_modifytable_info(ModifyTableState *mtstate, ExplainState *es)
 										 0,
 										 es);
 	}
+
+	/* HYPOTHETICAL INDEX SELF TUNING GROUP - PUC-RIO - 2015 */
+	if (es->pstmt->hypothetical && es->costs)
+		show_hypothetical_write_cost(mtstate, es);
+}
+
+/*
+ * Show how much of the table an index-only scan on a hypothetical index
+ * would still have to visit, see hypo_index_allvisfrac()
+ */
+static void
+show_hypothetical_heap_fetches(IndexOnlyScan *plan, ExplainState *es)
+{
+	Relation	rel;
+	double		allvisfrac;
+
+	rel = heap_open(rt_fetch(plan->scan.scanrelid, es->rtable)->relid,
+					NoLock);
+	allvisfrac = hypo_index_allvisfrac(rel);
+	heap_close(rel, NoLock);
+
+	ExplainPropertyFloat("All-Visible Fraction", allvisfrac, 2, es);
+	if (es->costs)
+		ExplainPropertyFloat("Estimated Heap Fetches",
+							 plan->scan.plan.plan_rows * (1.0 - allvisfrac),
+							 0, es);
+}
+
+/*
+ * Show what maintaining each hypothetical index of the target relations
+ * would cost the statement, for EXPLAIN HYPOTHETICAL
+ */
+static void
+show_hypothetical_write_cost(ModifyTableState *mtstate, ExplainState *es)
+{
+	bool		opened = false;
+	int			i;
+
+	for (i = 0; i < mtstate->mt_nplans; i++)
+	{
+		ResultRelInfo *resultRelInfo = mtstate->resultRelInfo + i;
+		Relation	rel = resultRelInfo->ri_RelationDesc;
+		double		rows = mtstate->mt_plans[i]->plan->plan_rows;
+		Bitmapset  *modifiedCols;
+		Bitmapset  *hypoattrs;
+		List	   *indexoids;
+		List	   *hypoindexes;
+		ListCell   *lc;
+
+		modifiedCols = rt_fetch(resultRelInfo->ri_RangeTableIndex,
+								es->rtable)->modifiedCols;
+
+		/*
+		 * Describe the hypothetical indexes in the catalogs the same way as
+		 * the session-private ones, and cost them all together: an update
+		 * that any one of them spoils HOT for adds entries to every index.
+		 */
+		hypoindexes = NIL;
+		indexoids = RelationGetIndexList_PUC(rel, true);
+		if (!rel->rd_hashypothetical)
+		{
+			/* only real indexes, no need to open each of them */
+			list_free(indexoids);
+			indexoids = NIL;
+		}
+		foreach(lc, indexoids)
+		{
+			Relation	indexRel;
+			HypoIndex  *hypoindex;
+			int			j;
+
+			/* may have been dropped since, see get_relation_info() */
+			indexRel = try_relation_open(lfirst_oid(lc), AccessShareLock);
+			if (indexRel == NULL)
+				continue;
+			if (!indexRel->rd_index->indishypothetical)
+			{
+				index_close(indexRel, AccessShareLock);
+				continue;
+			}
+
+			hypoindex = (HypoIndex *) palloc0(sizeof(HypoIndex));
+			hypoindex->name = pstrdup(RelationGetRelationName(indexRel));
+			hypoindex->relam = indexRel->rd_rel->relam;
+			hypoindex->ncolumns = indexRel->rd_index->indnatts;
+			hypoindex->indexkeys = (int *) palloc(sizeof(int) * hypoindex->ncolumns);
+			for (j = 0; j < hypoindex->ncolumns; j++)
+				hypoindex->indexkeys[j] = indexRel->rd_index->indkey.values[j];
+			hypoindex->indexprs = RelationGetIndexExpressions(indexRel);
+			hypoindex->indpred = RelationGetIndexPredicate(indexRel);
+			hypoindex->fillfactor = hypo_index_fillfactor(indexRel->rd_rel->relam,
+														  indexRel->rd_options);
+			hypoindexes = lappend(hypoindexes, hypoindex);
+
+			index_close(indexRel, AccessShareLock);
+		}
+		list_free(indexoids);
+		hypoindexes = list_concat(hypoindexes,
+								  hypo_index_list_for_relation(rel));
+
+		hypoattrs = NULL;
+		foreach(lc, hypoindexes)
+		{
+			HypoIndex  *hypoindex = (HypoIndex *) lfirst(lc);
+
+			hypoattrs = hypo_index_attrs(hypoattrs, hypoindex->ncolumns,
+										 hypoindex->indexkeys,
+										 hypoindex->indexprs,
+										 hypoindex->indpred);
+		}
+
+		foreach(lc, hypoindexes)
+		{
+			HypoIndex  *hypoindex = (HypoIndex *) lfirst(lc);
+			HypoIndexWriteCost cost;
+
+			hypo_index_write_cost(rel, hypoindex->relam,
+								  hypoindex->ncolumns, hypoindex->indexkeys,
+								  hypoindex->indexprs, hypoindex->indpred,
+								  hypoindex->fillfactor,
+								  mtstate->operation, rows, modifiedCols,
+								  hypoattrs, &cost);
+			show_hypothetical_index_write_cost(hypoindex->name,
+											   &cost, &opened, es);
+		}
+		list_free(hypoindexes);
+		bms_free(hypoattrs);
+	}
+
+	if (opened)
+		ExplainCloseGroup("Hypothetical Indexes", "Hypothetical Indexes",
+						  false, es);
+}
+
+static void
+show_hypothetical_index_write_cost(const char *indexname,
+								   HypoIndexWriteCost *cost,
+								   bool *opened, ExplainState *es)
+{
+	if (es->format == EXPLAIN_FORMAT_TEXT)
+	{
+		appendStringInfoSpaces(es->str, es->indent * 2);
+		appendStringInfo(es->str,
+						 "Hypothetical Index %s: Entries: %.0f  Page Writes: %.0f  WAL: %.0fkB",
+						 quote_identifier(indexname), cost->entries,
+						 cost->pages, cost->wal_bytes / 1024.0);
+		if (cost->lost_hot > 0)
+			appendStringInfo(es->str, "  Lost HOT Updates: %.0f",
+							 cost->lost_hot);
+		appendStringInfoChar(es->str, '\n');
+		return;
+	}
+
+	if (!*opened)
+	{
+		ExplainOpenGroup("Hypothetical Indexes", "Hypothetical Indexes",
+						 false, es);
+		*opened = true;
+	}
+	ExplainOpenGroup("Hypothetical Index", NULL, true, es);
+	ExplainPropertyText("Index Name", indexname, es);
+	ExplainPropertyFloat("Index Entries", cost->entries, 0, es);
+	ExplainPropertyFloat("Page Writes", cost->pages, 0, es);
+	ExplainPropertyFloat("WAL Bytes", cost->wal_bytes, 0, es);
+	ExplainPropertyFloat("Lost HOT Updates", cost->lost_hot, 0, es);
+	ExplainCloseGroup("Hypothetical Index", NULL, true, es);
 }
 
 /*
@@ -19,8 +19,11 @@
 #include "access/reloptions.h"
 #include "access/xact.h"
 #include "catalog/catalog.h"
+#include "catalog/dependency.h"
 #include "catalog/index.h"
 #include "catalog/indexing.h"
+#include "catalog/namespace.h"
+#include "catalog/pg_namespace.h"
 #include "catalog/pg_opclass.h"
 #include "catalog/pg_opfamily.h"
 #include "catalog/pg_tablespace.h"
@@ -34,6 +37,7 @@
 #include "miscadmin.h"
 #include "nodes/nodeFuncs.h"
 #include "optimizer/clauses.h"
+#include "optimizer/hypoindex.h"
 #include "optimizer/planner.h"
 #include "parser/parse_coerce.h"
 #include "parser/parse_func.h"
@@ -72,6 +76,8 @@ static char *ChooseIndexName(const char *tabname, Oid namespaceId,
 				bool primary, bool isconstraint);
 static char *ChooseIndexNameAddition(List *colnames);
 static List *ChooseIndexColumnNames(List *indexElems);
+static void SetHypotheticalIndexLifetime(Oid indexRelationId,
+							 IndexStmt *stmt);
 static void RangeVarCallbackForReindexIndex(const RangeVar *relation,
 								Oid relId, Oid oldRelId, void *arg);
 
@@ -316,7 +322,11 @@ DefineIndex(Oid relationId,
 	HeapTuple	tuple;
 	Form_pg_am	accessMethodForm;
 	bool		amcanorder;
+	bool		amclusterable;
 	RegProcedure amoptions;
+	List	   *indexOptions;
+	ListCell   *lc;
+	bool		clustered;
 	Datum		reloptions;
 	int16	   *coloptions;
 	IndexInfo  *indexInfo;
@@ -521,6 +531,7 @@ DefineIndex(Oid relationId,
 			   accessMethodName)));
 
 	amcanorder = accessMethodForm->amcanorder;
+	amclusterable = accessMethodForm->amclusterable;
 	amoptions = accessMethodForm->amoptions;
 
 	ReleaseSysCache(tuple);
@@ -531,10 +542,41 @@ DefineIndex(Oid relationId,
 	if (stmt->whereClause)
 		CheckPredicate((Expr *) stmt->whereClause);
 
+	/*
+	 * HYPOTHETICAL INDEX
+	 * SELF TUNING GROUP - PUC-RIO - 2015
+	 *
+	 * A hypothetical index can be declared clustered, so that its scans are
+	 * costed as if the table had been CLUSTERed on it.  That is no option
+	 * of the access method, so take it out before they are validated.
+	 */
+	indexOptions = NIL;
+	clustered = false;
+	foreach(lc, stmt->options)
+	{
+		DefElem    *def = (DefElem *) lfirst(lc);
+
+		if (stmt->hypothetical && def->defnamespace == NULL &&
+			pg_strcasecmp(def->defname, "clustered") == 0)
+			clustered = defGetBoolean(def);
+		else
+			indexOptions = lappend(indexOptions, def);
+	}
+	if (clustered && !amclusterable)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("access method \"%s\" does not support clustering",
+						accessMethodName)));
+	if (clustered && stmt->whereClause)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("cannot cluster on partial index \"%s\"",
+						indexRelationName)));
+
 	/*
 	 * Parse AM-specific options, convert to text array form, validate.
 	 */
-	reloptions = transformRelOptions((Datum) 0, stmt->options,
+	reloptions = transformRelOptions((Datum) 0, indexOptions,
 									 NULL, NULL, false, false);
 
 	(void) index_reloptions(amoptions, reloptions, true);
@@ -560,6 +602,7 @@ DefineIndex(Oid relationId,
      * Assign the value of hypothetical to IndexInfo->Hypothetical,
      */
     indexInfo->ii_Hypothetical = stmt->hypothetical;
+	indexInfo->ii_Clustered = clustered;
 	/* In a concurrent build, mark it not-ready-for-inserts */
 	indexInfo->ii_ReadyForInserts = !stmt->concurrent;
 	indexInfo->ii_Concurrent = stmt->concurrent;
@@ -609,6 +652,37 @@ DefineIndex(Oid relationId,
 				  indexRelationName, RelationGetRelationName(rel))));
 	}
 
+	/*
+	 * HYPOTHETICAL INDEX
+	 * SELF TUNING GROUP - PUC-RIO - 2015
+	 *
+	 * A concurrent build commits midway, which would already drop an index
+	 * created ON COMMIT DROP.
+	 */
+	if (stmt->oncommitdrop && stmt->concurrent)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("ON COMMIT DROP cannot be used with CONCURRENTLY")));
+
+	/*
+	 * A session-private hypothetical index is only remembered in backend
+	 * memory; it gets no catalog entries, storage or comment.  It lasts for
+	 * the session anyway, so TEMP changes nothing for it.
+	 */
+	if (stmt->hypothetical && hypothetical_index_private)
+	{
+		indexRelationId = hypo_index_store(rel, indexRelationName,
+										   stmt->idxname != NULL,
+										   indexInfo, accessMethodId,
+										   tablespaceId, collationObjectId,
+										   classObjectId, coloptions,
+										   reloptions);
+		if (stmt->oncommitdrop)
+			hypo_index_drop_at_eoxact(indexRelationId);
+		heap_close(rel, NoLock);
+		return indexRelationId;
+	}
+
 	/*
 	 * A valid stmt->oldNode implies that we already have a built form of the
 	 * index.  The caller should also decline any index build.
@@ -635,6 +709,10 @@ DefineIndex(Oid relationId,
 		CreateComments(indexRelationId, RelationRelationId, 0,
 					   stmt->idxcomment);
 
+	/* HYPOTHETICAL INDEX SELF TUNING GROUP - PUC-RIO - 2015 */
+	if (stmt->hypothetical)
+		SetHypotheticalIndexLifetime(indexRelationId, stmt);
+
 	if (!stmt->concurrent)
 	{
 		/* Close the heap and we're done, in the non-concurrent case */
@@ -906,6 +984,42 @@ DefineIndex(Oid relationId,
 }
 
 
+/*
+ * HYPOTHETICAL INDEX
+ * SELF TUNING GROUP - PUC-RIO - 2015
+ *
+ * SetHypotheticalIndexLifetime
+ *		Arrange for a catalog hypothetical index to be dropped automatically.
+ *
+ * TEMP makes the index depend on the session's temporary schema, so that
+ * RemoveTempRelations() drops it with the session's temporary tables: at
+ * session end, or when the schema of a session that crashed is cleaned out
+ * on its next use.  ON COMMIT DROP drops it at commit like a temporary table
+ * created so; at abort, its catalog entries are rolled back anyway.
+ */
+static void
+SetHypotheticalIndexLifetime(Oid indexRelationId, IndexStmt *stmt)
+{
+	if (stmt->temporary)
+	{
+		ObjectAddress myself;
+		ObjectAddress referenced;
+
+		myself.classId = RelationRelationId;
+		myself.objectId = indexRelationId;
+		myself.objectSubId = 0;
+
+		referenced.classId = NamespaceRelationId;
+		referenced.objectId = LookupCreationNamespace("pg_temp");
+		referenced.objectSubId = 0;
+
+		recordDependencyOn(&myself, &referenced, DEPENDENCY_NORMAL);
+	}
+
+	if (stmt->oncommitdrop)
+		register_on_commit_action(indexRelationId, ONCOMMIT_DROP);
+}
+
 /*
  * CheckMutability
  *		Test whether given expression is mutable
@@ -59,6 +59,7 @@
 #include "nodes/nodeFuncs.h"
 #include "nodes/parsenodes.h"
 #include "optimizer/clauses.h"
+#include "optimizer/hypoindex.h"
 #include "optimizer/planner.h"
 #include "parser/parse_clause.h"
 #include "parser/parse_coerce.h"
@@ -250,6 +251,7 @@ struct DropRelationCallbackState
 	char		relkind;
 	Oid			heapOid;
 	bool		concurrent;
+	bool		hypothetical;	/* DROP HYPOTHETICAL INDEX? */
 };
 
 /* Alter table target-type flags for ATSimplePermissions */
@@ -404,6 +406,7 @@ static void copy_relation_data(SMgrRelation rel, SMgrRelation dst,
 				   ForkNumber forkNum, char relpersistence);
 static const char *storage_name(char c);
 
+static void RemoveAllHypotheticalIndexes(DropBehavior behavior);
 static void RangeVarCallbackForDropRelation(const RangeVar *rel, Oid relOid,
 								Oid oldRelOid, void *arg);
 static void RangeVarCallbackForAlterRelation(const RangeVar *rv, Oid relid,
@@ -753,6 +756,13 @@ RemoveRelations(DropStmt *drop)
 	LOCKMODE	lockmode = AccessExclusiveLock;
 
 
+	/* DROP ALL HYPOTHETICAL INDEXES */
+	if (drop->hypothetical && drop->objects == NIL)
+	{
+		RemoveAllHypotheticalIndexes(drop->behavior);
+		return;
+	}
+
 	/* DROP CONCURRENTLY uses a weaker lock, and has some restrictions */
 	if (drop->concurrent)
 	{
@@ -819,6 +829,17 @@ RemoveRelations(DropStmt *drop)
 		ObjectAddress obj;
 		struct DropRelationCallbackState state;
 
+		/*
+		 * HYPOTHETICAL INDEX
+		 * SELF TUNING GROUP - PUC-RIO - 2015
+		 *
+		 * A session-private hypothetical index has nothing in the catalogs
+		 * to lock or delete; just forget it.
+		 */
+		if (drop->hypothetical &&
+			hypo_index_remove(rel->schemaname, rel->relname))
+			continue;
+
 		/*
 		 * These next few steps are a great deal like relation_openrv, but we
 		 * don't bother building a relcache entry since we don't need it.
@@ -835,6 +856,7 @@ RemoveRelations(DropStmt *drop)
 		state.relkind = relkind;
 		state.heapOid = InvalidOid;
 		state.concurrent = drop->concurrent;
+		state.hypothetical = drop->hypothetical;
 		relOid = RangeVarGetRelidExtended(rel, lockmode, true,
 										  false,
 										  RangeVarCallbackForDropRelation,
@@ -847,6 +869,7 @@ RemoveRelations(DropStmt *drop)
 			DropErrorMsgNonExistent(rel->relname, relkind, drop->missing_ok);
 			continue;
 		}
+
 		/* OK, we're ready to delete this one */
 		obj.classId = RelationRelationId;
 		obj.objectId = relOid;
@@ -860,6 +883,85 @@ RemoveRelations(DropStmt *drop)
 	free_object_addresses(objects);
 }
 
+/*
+ * RemoveAllHypotheticalIndexes
+ *		Implements DROP ALL HYPOTHETICAL INDEXES
+ *
+ * HYPOTHETICAL INDEX
+ * SELF TUNING GROUP - PUC-RIO - 2015
+ *
+ * Forgets the session's private hypothetical indexes, and drops every
+ * hypothetical index in the catalogs that the user may drop, found with a
+ * single pass over pg_index and deleted in a single
+ * performMultipleDeletions() call.  Indexes of other users are skipped
+ * rather than reported, so that an advisor can clean up after itself
+ * without knowing the names it used.
+ */
+static void
+RemoveAllHypotheticalIndexes(DropBehavior behavior)
+{
+	ObjectAddresses *objects;
+	Relation	indexRelation;
+	SysScanDesc scan;
+	ScanKeyData skey;
+	HeapTuple	tuple;
+
+	hypo_index_remove_all();
+
+	objects = new_object_addresses();
+
+	ScanKeyInit(&skey,
+				Anum_pg_index_indishypothetical,
+				BTEqualStrategyNumber, F_BOOLEQ,
+				BoolGetDatum(true));
+
+	indexRelation = heap_open(IndexRelationId, AccessShareLock);
+	scan = systable_beginscan(indexRelation, InvalidOid, false,
+							  SnapshotNow, 1, &skey);
+
+	while (HeapTupleIsValid(tuple = systable_getnext(scan)))
+	{
+		Form_pg_index index = (Form_pg_index) GETSTRUCT(tuple);
+		HeapTuple	classTuple;
+		Oid			nspOid;
+		ObjectAddress obj;
+
+		classTuple = SearchSysCache1(RELOID,
+									 ObjectIdGetDatum(index->indexrelid));
+		if (!HeapTupleIsValid(classTuple))
+			continue;			/* concurrently dropped */
+		nspOid = ((Form_pg_class) GETSTRUCT(classTuple))->relnamespace;
+		ReleaseSysCache(classTuple);
+
+		/* Allow DROP to either table owner or schema owner */
+		if (!pg_class_ownercheck(index->indexrelid, GetUserId()) &&
+			!pg_namespace_ownercheck(nspOid, GetUserId()))
+			continue;
+
+		/* Lock the table before the index, as DROP HYPOTHETICAL INDEX does */
+		LockRelationOid(index->indrelid, AccessShareLock);
+		LockRelationOid(index->indexrelid, AccessExclusiveLock);
+
+		/* dropped while we waited for the locks? */
+		if (!SearchSysCacheExists1(RELOID,
+								   ObjectIdGetDatum(index->indexrelid)))
+			continue;
+
+		obj.classId = RelationRelationId;
+		obj.objectId = index->indexrelid;
+		obj.objectSubId = 0;
+
+		add_exact_object_address(&obj, objects);
+	}
+
+	systable_endscan(scan);
+	heap_close(indexRelation, AccessShareLock);
+
+	performMultipleDeletions(objects, behavior, 0);
+
+	free_object_addresses(objects);
+}
+
 /*
  * Before acquiring a table lock, check whether we have sufficient rights.
  * In the case of DROP INDEX, also try to lock the table before the index.
@@ -879,6 +981,16 @@ RangeVarCallbackForDropRelation(const RangeVar *rel, Oid relOid, Oid oldRelOid,
 	heap_lockmode = state->concurrent ?
 		ShareUpdateExclusiveLock : AccessExclusiveLock;
 
+	/*
+	 * HYPOTHETICAL INDEX
+	 * SELF TUNING GROUP - PUC-RIO - 2015
+	 *
+	 * No query on the table ever uses a hypothetical index, so dropping one
+	 * only needs the table to stay put, like creating one.
+	 */
+	if (state->hypothetical)
+		heap_lockmode = AccessShareLock;
+
 	/*
 	 * If we previously locked some other index's heap, and the name we're
 	 * looking up no longer refers to that relation, release the now-useless
@@ -916,6 +1028,30 @@ RangeVarCallbackForDropRelation(const RangeVar *rel, Oid relOid, Oid oldRelOid,
 
 	ReleaseSysCache(tuple);
 
+	/*
+	 * DROP HYPOTHETICAL INDEX must not drop a real index.  Check before we
+	 * lock anything, so that a mistaken name doesn't block the table.
+	 */
+	if (state->hypothetical && relkind == RELKIND_INDEX)
+	{
+		HeapTuple	indexTuple;
+		bool		ishypothetical;
+
+		indexTuple = SearchSysCache1(INDEXRELID, ObjectIdGetDatum(relOid));
+		if (!HeapTupleIsValid(indexTuple))
+			return;				/* concurrently dropped */
+		ishypothetical =
+			((Form_pg_index) GETSTRUCT(indexTuple))->indishypothetical;
+		ReleaseSysCache(indexTuple);
+
+		if (!ishypothetical)
+			ereport(ERROR,
+					(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+					 errmsg("\"%s\" is not a hypothetical index",
+							rel->relname),
+					 errhint("Use DROP INDEX to remove an index.")));
+	}
+
 	/*
 	 * In DROP INDEX, attempt to acquire lock on the parent table before
 	 * locking the index.  index_drop() will need this anyway, and since
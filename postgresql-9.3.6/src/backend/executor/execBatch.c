@@ -0,0 +1,526 @@
+/*-------------------------------------------------------------------------
+ *
+ * execBatch.c
+ *	  Batch-at-a-time evaluation of sequential scans.
+ *
+ * With batch_execution on, a forward sequential scan under an MVCC snapshot
+ * fetches its rows EXEC_BATCH_SIZE at a time instead of one at a time.  The
+ * columns its quals compare are deformed into one array per column, and
+ * each qual clause of the form "column op constant", on int4, int8, float8
+ * or date, is evaluated over the whole batch by a loop specialized for the
+ * operator and type, which the compiler can unroll and vectorize.  Any
+ * other qual clause is left to the usual per-row ExecQual.  The rows that
+ * pass are then returned one at a time, so the nodes above the scan run
+ * as before; a plain Agg directly above it instead consumes whole batches,
+ * see nodeAgg.c.
+ *
+ * The rows of a batch stay on their heap pages, which the batch keeps
+ * pinned until the next batch is fetched.  To bound the pins, a batch ends
+ * early once it has rows on EXEC_BATCH_MAX_PAGES pages.
+ *
+ * Portions Copyright (c) 1996-2013, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/executor/execBatch.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <math.h>
+
+#include "executor/execBatch.h"
+#include "executor/executor.h"
+#include "nodes/nodeFuncs.h"
+#include "optimizer/planmain.h"
+#include "storage/bufmgr.h"
+#include "utils/fmgroids.h"
+
+
+/* GUC parameter */
+bool		batch_execution = false;
+
+/*
+ * The comparison functions evaluated on batches, and the types of their
+ * arguments
+ */
+typedef struct ExecBatchOperator
+{
+	Oid			funcid;
+	ExecBatchType lefttype;
+	ExecBatchType righttype;
+	ExecBatchOp op;
+} ExecBatchOperator;
+
+static const ExecBatchOperator batch_operators[] = {
+	{F_INT4LT, EXEC_BATCH_INT4, EXEC_BATCH_INT4, EXEC_BATCH_LT},
+	{F_INT4LE, EXEC_BATCH_INT4, EXEC_BATCH_INT4, EXEC_BATCH_LE},
+	{F_INT4EQ, EXEC_BATCH_INT4, EXEC_BATCH_INT4, EXEC_BATCH_EQ},
+	{F_INT4NE, EXEC_BATCH_INT4, EXEC_BATCH_INT4, EXEC_BATCH_NE},
+	{F_INT4GE, EXEC_BATCH_INT4, EXEC_BATCH_INT4, EXEC_BATCH_GE},
+	{F_INT4GT, EXEC_BATCH_INT4, EXEC_BATCH_INT4, EXEC_BATCH_GT},
+	{F_INT48LT, EXEC_BATCH_INT4, EXEC_BATCH_INT8, EXEC_BATCH_LT},
+	{F_INT48LE, EXEC_BATCH_INT4, EXEC_BATCH_INT8, EXEC_BATCH_LE},
+	{F_INT48EQ, EXEC_BATCH_INT4, EXEC_BATCH_INT8, EXEC_BATCH_EQ},
+	{F_INT48NE, EXEC_BATCH_INT4, EXEC_BATCH_INT8, EXEC_BATCH_NE},
+	{F_INT48GE, EXEC_BATCH_INT4, EXEC_BATCH_INT8, EXEC_BATCH_GE},
+	{F_INT48GT, EXEC_BATCH_INT4, EXEC_BATCH_INT8, EXEC_BATCH_GT},
+	{F_INT84LT, EXEC_BATCH_INT8, EXEC_BATCH_INT4, EXEC_BATCH_LT},
+	{F_INT84LE, EXEC_BATCH_INT8, EXEC_BATCH_INT4, EXEC_BATCH_LE},
+	{F_INT84EQ, EXEC_BATCH_INT8, EXEC_BATCH_INT4, EXEC_BATCH_EQ},
+	{F_INT84NE, EXEC_BATCH_INT8, EXEC_BATCH_INT4, EXEC_BATCH_NE},
+	{F_INT84GE, EXEC_BATCH_INT8, EXEC_BATCH_INT4, EXEC_BATCH_GE},
+	{F_INT84GT, EXEC_BATCH_INT8, EXEC_BATCH_INT4, EXEC_BATCH_GT},
+	{F_INT8LT, EXEC_BATCH_INT8, EXEC_BATCH_INT8, EXEC_BATCH_LT},
+	{F_INT8LE, EXEC_BATCH_INT8, EXEC_BATCH_INT8, EXEC_BATCH_LE},
+	{F_INT8EQ, EXEC_BATCH_INT8, EXEC_BATCH_INT8, EXEC_BATCH_EQ},
+	{F_INT8NE, EXEC_BATCH_INT8, EXEC_BATCH_INT8, EXEC_BATCH_NE},
+	{F_INT8GE, EXEC_BATCH_INT8, EXEC_BATCH_INT8, EXEC_BATCH_GE},
+	{F_INT8GT, EXEC_BATCH_INT8, EXEC_BATCH_INT8, EXEC_BATCH_GT},
+	{F_DATE_LT, EXEC_BATCH_INT4, EXEC_BATCH_INT4, EXEC_BATCH_LT},
+	{F_DATE_LE, EXEC_BATCH_INT4, EXEC_BATCH_INT4, EXEC_BATCH_LE},
+	{F_DATE_EQ, EXEC_BATCH_INT4, EXEC_BATCH_INT4, EXEC_BATCH_EQ},
+	{F_DATE_NE, EXEC_BATCH_INT4, EXEC_BATCH_INT4, EXEC_BATCH_NE},
+	{F_DATE_GE, EXEC_BATCH_INT4, EXEC_BATCH_INT4, EXEC_BATCH_GE},
+	{F_DATE_GT, EXEC_BATCH_INT4, EXEC_BATCH_INT4, EXEC_BATCH_GT},
+	{F_FLOAT8LT, EXEC_BATCH_FLOAT8, EXEC_BATCH_FLOAT8, EXEC_BATCH_LT},
+	{F_FLOAT8LE, EXEC_BATCH_FLOAT8, EXEC_BATCH_FLOAT8, EXEC_BATCH_LE},
+	{F_FLOAT8EQ, EXEC_BATCH_FLOAT8, EXEC_BATCH_FLOAT8, EXEC_BATCH_EQ},
+	{F_FLOAT8NE, EXEC_BATCH_FLOAT8, EXEC_BATCH_FLOAT8, EXEC_BATCH_NE},
+	{F_FLOAT8GE, EXEC_BATCH_FLOAT8, EXEC_BATCH_FLOAT8, EXEC_BATCH_GE},
+	{F_FLOAT8GT, EXEC_BATCH_FLOAT8, EXEC_BATCH_FLOAT8, EXEC_BATCH_GT}
+};
+
+/*
+ * Stands in for the value of a null, which the loops read all the same, so
+ * must be safe to dereference where int8 and float8 are by reference
+ */
+#ifdef USE_FLOAT8_BYVAL
+#define BATCH_NULL_DATUM	((Datum) 0)
+#else
+static const int64 batch_null_value = 0;
+
+#define BATCH_NULL_DATUM	PointerGetDatum(&batch_null_value)
+#endif
+
+static bool batch_compile_clause(ExecBatch *batch, Expr *clause,
+					 Index scanrelid);
+static void batch_alloc_rows(ExecBatch *batch);
+static void batch_deform(ExecBatch *batch);
+static void batch_compare(ExecBatch *batch, ExecBatchPred *pred);
+
+
+/*
+ * ExecInitBatch
+ *
+ * Set up batches for a sequential scan of scanrelid, whose rows have
+ * descriptor tupdesc.  The clauses of qual that can be evaluated on whole
+ * batches are compiled into the batch; the others are returned in
+ * *residual, to be evaluated a row at a time.
+ */
+ExecBatch *
+ExecInitBatch(EState *estate, TupleDesc tupdesc, Index scanrelid,
+			  List *qual, List **residual)
+{
+	ExecBatch  *batch;
+	ListCell   *l;
+
+	batch = (ExecBatch *) palloc0(sizeof(ExecBatch));
+	batch->mcxt = CurrentMemoryContext;
+	batch->slot = ExecInitExtraTupleSlot(estate);
+	ExecSetSlotDescriptor(batch->slot, tupdesc);
+	batch->preds = (ExecBatchPred *)
+		palloc(Max(list_length(qual), 1) * sizeof(ExecBatchPred));
+
+	*residual = NIL;
+	foreach(l, qual)
+	{
+		Expr	   *clause = (Expr *) lfirst(l);
+
+		if (!batch_compile_clause(batch, clause, scanrelid))
+			*residual = lappend(*residual, clause);
+	}
+
+	return batch;
+}
+
+/*
+ * batch_compile_clause
+ *
+ * Add clause to the batch's preds if it compares a column of the scan with
+ * a constant using one of batch_operators.
+ */
+static bool
+batch_compile_clause(ExecBatch *batch, Expr *clause, Index scanrelid)
+{
+	OpExpr	   *opexpr;
+	Node	   *leftop;
+	Node	   *rightop;
+	Var		   *var;
+	Const	   *con;
+	const ExecBatchOperator *oper = NULL;
+	ExecBatchType consttype;
+	ExecBatchPred *pred;
+	int			i;
+
+	if (!IsA(clause, OpExpr))
+		return false;
+	opexpr = (OpExpr *) clause;
+	if (list_length(opexpr->args) != 2)
+		return false;
+	set_opfuncid(opexpr);
+
+	for (i = 0; i < lengthof(batch_operators); i++)
+	{
+		if (batch_operators[i].funcid == opexpr->opfuncid)
+		{
+			oper = &batch_operators[i];
+			break;
+		}
+	}
+	if (oper == NULL)
+		return false;
+
+	leftop = (Node *) linitial(opexpr->args);
+	rightop = (Node *) lsecond(opexpr->args);
+	pred = &batch->preds[batch->npreds];
+	if (IsA(leftop, Var) && IsA(rightop, Const))
+	{
+		var = (Var *) leftop;
+		con = (Const *) rightop;
+		pred->type = oper->lefttype;
+		pred->op = oper->op;
+		consttype = oper->righttype;
+	}
+	else if (IsA(leftop, Const) && IsA(rightop, Var))
+	{
+		/* commute the clause to put the column on the left */
+		var = (Var *) rightop;
+		con = (Const *) leftop;
+		pred->type = oper->righttype;
+		consttype = oper->lefttype;
+		switch (oper->op)
+		{
+			case EXEC_BATCH_LT:
+				pred->op = EXEC_BATCH_GT;
+				break;
+			case EXEC_BATCH_LE:
+				pred->op = EXEC_BATCH_GE;
+				break;
+			case EXEC_BATCH_GE:
+				pred->op = EXEC_BATCH_LE;
+				break;
+			case EXEC_BATCH_GT:
+				pred->op = EXEC_BATCH_LT;
+				break;
+			default:
+				pred->op = oper->op;
+				break;
+		}
+	}
+	else
+		return false;
+
+	if (var->varno != scanrelid || var->varattno <= 0 ||
+		var->varlevelsup != 0)
+		return false;
+
+	/* a null constant makes the clause null; leave that to ExecQual */
+	if (con->constisnull)
+		return false;
+
+	switch (consttype)
+	{
+		case EXEC_BATCH_INT4:
+			pred->ival = (int64) DatumGetInt32(con->constvalue);
+			break;
+		case EXEC_BATCH_INT8:
+			pred->ival = DatumGetInt64(con->constvalue);
+			break;
+		case EXEC_BATCH_FLOAT8:
+			pred->fval = DatumGetFloat8(con->constvalue);
+			/* NaN sorts above everything, which the loops don't know */
+			if (isnan(pred->fval))
+				return false;
+			break;
+	}
+
+	pred->column = ExecBatchColumn(batch, var->varattno);
+	batch->npreds++;
+	return true;
+}
+
+/*
+ * ExecBatchColumn
+ *
+ * Have the batches deform scan attribute attnum, and return its index in
+ * the batch's columns.  Only valid before the first row is added.
+ */
+int
+ExecBatchColumn(ExecBatch *batch, AttrNumber attnum)
+{
+	MemoryContext oldcontext;
+	int			column;
+
+	Assert(batch->tuples == NULL);
+
+	for (column = 0; column < batch->ncolumns; column++)
+	{
+		if (batch->attnums[column] == attnum)
+			return column;
+	}
+
+	oldcontext = MemoryContextSwitchTo(batch->mcxt);
+	if (batch->ncolumns == 0)
+		batch->attnums = (AttrNumber *) palloc(sizeof(AttrNumber));
+	else
+		batch->attnums = (AttrNumber *)
+			repalloc(batch->attnums, (batch->ncolumns + 1) * sizeof(AttrNumber));
+	MemoryContextSwitchTo(oldcontext);
+
+	batch->attnums[column] = attnum;
+	batch->maxattr = Max(batch->maxattr, attnum);
+	batch->ncolumns++;
+
+	return column;
+}
+
+/*
+ * batch_alloc_rows
+ *
+ * Allocate the per-row arrays, on the first row added, so that a scan
+ * nobody batches costs nothing.
+ */
+static void
+batch_alloc_rows(ExecBatch *batch)
+{
+	MemoryContext oldcontext;
+	int			column;
+
+	oldcontext = MemoryContextSwitchTo(batch->mcxt);
+
+	batch->tuples = (HeapTupleData *)
+		palloc(EXEC_BATCH_SIZE * sizeof(HeapTupleData));
+	batch->buffers = (Buffer *) palloc(EXEC_BATCH_SIZE * sizeof(Buffer));
+	batch->sel = (int *) palloc(EXEC_BATCH_SIZE * sizeof(int));
+	batch->match = (bool *) palloc(EXEC_BATCH_SIZE * sizeof(bool));
+
+	batch->values = (Datum **) palloc(Max(batch->ncolumns, 1) * sizeof(Datum *));
+	batch->isnull = (bool **) palloc(Max(batch->ncolumns, 1) * sizeof(bool *));
+	for (column = 0; column < batch->ncolumns; column++)
+	{
+		batch->values[column] = (Datum *)
+			palloc(EXEC_BATCH_SIZE * sizeof(Datum));
+		batch->isnull[column] = (bool *)
+			palloc(EXEC_BATCH_SIZE * sizeof(bool));
+	}
+
+	MemoryContextSwitchTo(oldcontext);
+}
+
+/*
+ * ExecBatchAddRow
+ *
+ * Add a row returned by heap_getnext() to the batch, pinning its page.
+ * Returns false when the batch is full.
+ */
+bool
+ExecBatchAddRow(ExecBatch *batch, HeapTuple tuple, Buffer buffer)
+{
+	int			row;
+
+	if (batch->tuples == NULL)
+		batch_alloc_rows(batch);
+
+	Assert(batch->nrows < EXEC_BATCH_SIZE);
+	Assert(batch->npins < EXEC_BATCH_MAX_PAGES);
+
+	if (batch->npins == 0 || batch->pins[batch->npins - 1] != buffer)
+	{
+		IncrBufferRefCount(buffer);
+		batch->pins[batch->npins++] = buffer;
+	}
+
+	row = batch->nrows++;
+	batch->tuples[row] = *tuple;
+	batch->buffers[row] = buffer;
+
+	return batch->nrows < EXEC_BATCH_SIZE &&
+		batch->npins < EXEC_BATCH_MAX_PAGES;
+}
+
+/*
+ * ExecBatchQual
+ *
+ * Deform the columns of the rows added and evaluate the batch's preds on
+ * them, leaving the rows that pass in sel[].
+ */
+void
+ExecBatchQual(ExecBatch *batch)
+{
+	int			row;
+	int			i;
+
+	batch_deform(batch);
+
+	for (row = 0; row < batch->nrows; row++)
+		batch->sel[row] = row;
+	batch->nsel = batch->nrows;
+	batch->next = 0;
+
+	for (i = 0; i < batch->npreds && batch->nsel > 0; i++)
+		batch_compare(batch, &batch->preds[i]);
+}
+
+/*
+ * batch_deform
+ *
+ * Deform the batch's columns of each row into the column arrays.
+ */
+static void
+batch_deform(ExecBatch *batch)
+{
+	TupleTableSlot *slot = batch->slot;
+	int			row;
+	int			column;
+
+	if (batch->ncolumns == 0)
+		return;
+
+	for (row = 0; row < batch->nrows; row++)
+	{
+		/* the batch holds the page pinned, so the slot needn't */
+		ExecStoreTuple(&batch->tuples[row], slot, InvalidBuffer, false);
+		slot_getsomeattrs(slot, batch->maxattr);
+
+		for (column = 0; column < batch->ncolumns; column++)
+		{
+			int			attno = batch->attnums[column] - 1;
+
+			if (slot->tts_isnull[attno])
+			{
+				batch->values[column][row] = BATCH_NULL_DATUM;
+				batch->isnull[column][row] = true;
+			}
+			else
+			{
+				batch->values[column][row] = slot->tts_values[attno];
+				batch->isnull[column][row] = false;
+			}
+		}
+	}
+	ExecClearTuple(slot);
+}
+
+/*
+ * Fill match[] with "value op constant" for every row of the batch,
+ * whether or not it is still selected: a loop without indirection is what
+ * the compiler knows how to vectorize.
+ */
+#define BATCH_COMPARE_LOOP(getvalue, constval) \
+	do { \
+		switch (pred->op) \
+		{ \
+			case EXEC_BATCH_LT: \
+				for (row = 0; row < nrows; row++) \
+					match[row] = getvalue(values[row]) < (constval); \
+				break; \
+			case EXEC_BATCH_LE: \
+				for (row = 0; row < nrows; row++) \
+					match[row] = getvalue(values[row]) <= (constval); \
+				break; \
+			case EXEC_BATCH_EQ: \
+				for (row = 0; row < nrows; row++) \
+					match[row] = getvalue(values[row]) == (constval); \
+				break; \
+			case EXEC_BATCH_NE: \
+				for (row = 0; row < nrows; row++) \
+					match[row] = getvalue(values[row]) != (constval); \
+				break; \
+			case EXEC_BATCH_GE: \
+				for (row = 0; row < nrows; row++) \
+					match[row] = getvalue(values[row]) >= (constval); \
+				break; \
+			case EXEC_BATCH_GT: \
+				for (row = 0; row < nrows; row++) \
+					match[row] = getvalue(values[row]) > (constval); \
+				break; \
+		} \
+	} while (0)
+
+#define BATCH_GET_INT4(d)	((int64) DatumGetInt32(d))
+#define BATCH_GET_INT8(d)	DatumGetInt64(d)
+#define BATCH_GET_FLOAT8(d)	DatumGetFloat8(d)
+
+/*
+ * batch_compare
+ *
+ * Evaluate one pred on the batch, removing the rows it rejects from sel[].
+ * Like the comparison functions, a null column value makes it null, which
+ * rejects the row.
+ */
+static void
+batch_compare(ExecBatch *batch, ExecBatchPred *pred)
+{
+	Datum	   *values = batch->values[pred->column];
+	bool	   *isnull = batch->isnull[pred->column];
+	bool	   *match = batch->match;
+	int			nrows = batch->nrows;
+	int			nsel;
+	int			row;
+	int			i;
+
+	switch (pred->type)
+	{
+		case EXEC_BATCH_INT4:
+			BATCH_COMPARE_LOOP(BATCH_GET_INT4, pred->ival);
+			break;
+		case EXEC_BATCH_INT8:
+			BATCH_COMPARE_LOOP(BATCH_GET_INT8, pred->ival);
+			break;
+		case EXEC_BATCH_FLOAT8:
+			BATCH_COMPARE_LOOP(BATCH_GET_FLOAT8, pred->fval);
+
+			/*
+			 * float8 comparisons take NaN to be above every other value,
+			 * while C comparisons with NaN are false.  Only > and >= differ,
+			 * the constant not being NaN.
+			 */
+			if (pred->op == EXEC_BATCH_GE || pred->op == EXEC_BATCH_GT)
+			{
+				for (row = 0; row < nrows; row++)
+					match[row] |= isnan(DatumGetFloat8(values[row]));
+			}
+			break;
+	}
+
+	/* keep the selected rows that matched, without branching */
+	nsel = 0;
+	for (i = 0; i < batch->nsel; i++)
+	{
+		row = batch->sel[i];
+		batch->sel[nsel] = row;
+		nsel += (match[row] & !isnull[row]);
+	}
+	batch->nsel = nsel;
+}
+
+/*
+ * ExecBatchReset
+ *
+ * Forget the rows of the batch and release their pages.
+ */
+void
+ExecBatchReset(ExecBatch *batch)
+{
+	int			i;
+
+	for (i = 0; i < batch->npins; i++)
+		ReleaseBuffer(batch->pins[i]);
+	batch->npins = 0;
+	batch->nrows = 0;
+	batch->nsel = 0;
+	batch->next = 0;
+}
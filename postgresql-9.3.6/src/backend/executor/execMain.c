@@ -48,6 +48,7 @@
 #include "mb/pg_wchar.h"
 #include "miscadmin.h"
 #include "optimizer/clauses.h"
+#include "optimizer/hypoworkload.h"
 #include "parser/parsetree.h"
 #include "storage/bufmgr.h"
 #include "storage/lmgr.h"
@@ -439,6 +440,16 @@ standard_ExecutorEnd(QueryDesc *queryDesc)
 	Assert(estate->es_finished ||
 		   (estate->es_top_eflags & EXEC_FLAG_EXPLAIN_ONLY));
 
+	/*
+	 * HYPOTHETICAL INDEX
+	 * SELF TUNING GROUP - PUC-RIO - 2015
+	 *
+	 * Count the execution in the workload captured for the index advisor.
+	 */
+	if (hypothetical_workload_entries > 0 &&
+		!(estate->es_top_eflags & EXEC_FLAG_EXPLAIN_ONLY))
+		hypo_workload_count(queryDesc->plannedstmt->queryId);
+
 	/*
 	 * Switch into per-query memory context to run ExecEndPlan
 	 */
@@ -337,6 +337,9 @@ ExecInitNode(Plan *node, EState *estate, int eflags)
 	}
 	result->initPlan = subps;
 
+	/* Flatten the node's quals and targetlist into expression programs */
+	ExecCompilePlanExprs(result);
+
 	/* Set up instrumentation for this node if requested */
 	if (estate->es_instrument)
 		result->instrument = InstrAlloc(1, estate->es_instrument);
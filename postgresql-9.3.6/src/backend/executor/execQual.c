@@ -17,6 +17,7 @@
  *		ExecEvalExpr	- (now a macro) evaluate an expression, return a datum
  *		ExecEvalExprSwitchContext - same, but switch into eval memory context
  *		ExecQual		- return true/false if qualification is satisfied
+ *		ExecCompileExpr - flatten an expression into a linear program
  *		ExecProject		- form a new tuple by projecting the given tuple
  *
  *	 NOTES
@@ -5118,6 +5119,679 @@ ExecPrepareExpr(Expr *node, EState *estate)
 	return result;
 }
 
+/* ----------------------------------------------------------------
+ *					 Expression programs
+ *
+ * ExecCompileExpr flattens an initialized ExprState tree into a linear
+ * program of steps, which ExecEvalExprProgram runs in one loop instead of
+ * recursing through the evalfuncs of the tree.  Vars, constants, functions
+ * and operators that don't return sets, AND/OR/NOT and scalar NULL tests
+ * become steps of their own; any other subexpression stays a tree, which a
+ * step evaluates through its evalfunc.  Each step stores its result where
+ * its consumer reads it, so the arguments of a function are evaluated
+ * straight into its FunctionCallInfoData.
+ *
+ * ExecInitNode has the quals and targetlist of each plan node compiled,
+ * see ExecCompilePlanExprs.  Expression trees that other code picks apart,
+ * such as hash clauses, are left alone.
+ * ----------------------------------------------------------------
+ */
+
+/* GUC parameter */
+bool		compile_expressions = true;
+
+/* Use computed gotos to dispatch steps where the compiler has them */
+#ifdef __GNUC__
+#define EXPR_USE_COMPUTED_GOTO
+#endif
+
+typedef enum ExprStepOp
+{
+	EXPR_STEP_DONE,				/* return the result of the program */
+	EXPR_STEP_SCAN_VAR,			/* user attribute of ecxt_scantuple */
+	EXPR_STEP_INNER_VAR,		/* ... of ecxt_innertuple */
+	EXPR_STEP_OUTER_VAR,		/* ... of ecxt_outertuple */
+	EXPR_STEP_CONST,
+	EXPR_STEP_FUNC,				/* call a function on evaluated arguments */
+	EXPR_STEP_FUNC_STRICT2,		/* ... that is strict and takes two */
+	EXPR_STEP_AND,				/* after each argument of an AND */
+	EXPR_STEP_AND_END,			/* after an AND none of whose args was false */
+	EXPR_STEP_OR,				/* after each argument of an OR */
+	EXPR_STEP_OR_END,			/* after an OR none of whose args was true */
+	EXPR_STEP_NOT,
+	EXPR_STEP_IS_NULL,
+	EXPR_STEP_IS_NOT_NULL,
+	EXPR_STEP_TREE				/* evaluate an ExprState tree */
+} ExprStepOp;
+
+#define EXPR_STEP_LAST	EXPR_STEP_TREE
+
+typedef struct ExprStep
+{
+	ExprStepOp	opcode;
+	Datum	   *resvalue;		/* where to store the result of the step */
+	bool	   *resnull;
+	union
+	{
+		/* EXPR_STEP_*_VAR */
+		struct
+		{
+			ExprState  *state;	/* state of the Var, for its first fetch */
+			AttrNumber	attnum;
+			AttrNumber	maxattr;	/* deform the slot up to this one */
+		}			var;
+
+		/* EXPR_STEP_CONST */
+		struct
+		{
+			Datum		value;
+			bool		isnull;
+		}			constval;
+
+		/* EXPR_STEP_FUNC, EXPR_STEP_FUNC_STRICT2 */
+		struct
+		{
+			FuncExprState *fcache;	/* fcinfo_data holds the arguments */
+			Oid			funcid;
+			Oid			inputcollid;
+		}			func;
+
+		/* EXPR_STEP_AND, EXPR_STEP_OR and their ends */
+		struct
+		{
+			bool	   *anynull;	/* has any argument been null? */
+			bool		first;		/* step of the first argument? */
+			int			jumpdone;	/* step to go on at if decided */
+		}			boolexpr;
+
+		/* EXPR_STEP_TREE */
+		struct
+		{
+			ExprState  *state;
+		}			tree;
+	}			d;
+} ExprStep;
+
+/* working state of ExecCompileExpr */
+typedef struct ExprCompileState
+{
+	ExprStep   *steps;
+	int			nsteps;
+	int			maxsteps;
+	AttrNumber	maxattr[3];		/* highest attnum of each kind of Var step */
+} ExprCompileState;
+
+#define EXPR_VAR_SLOT(opcode)	((opcode) - EXPR_STEP_SCAN_VAR)
+
+static ExprStep *ExecExprAddStep(ExprCompileState *cstate, ExprStepOp opcode,
+				Datum *resvalue, bool *resnull);
+static void ExecCompileExprRec(ExprState *state, ExprCompileState *cstate,
+				   Datum *resvalue, bool *resnull);
+static Datum ExecEvalExprProgram(ExprProgramState *pstate,
+					ExprContext *econtext,
+					bool *isNull, ExprDoneCond *isDone);
+static void ExecExprFetchVar(ExprStep *op, TupleTableSlot *slot,
+				 ExprContext *econtext);
+static void ExecExprInitFunc(ExprStep *op, ExprContext *econtext);
+
+
+/*
+ * ExecCompileExpr
+ *
+ * Returns an ExprProgramState that evaluates the given ExprState tree, or
+ * the tree itself if flattening it gains nothing.  The tree must not be
+ * able to return a set.
+ */
+ExprState *
+ExecCompileExpr(ExprState *state)
+{
+	ExprProgramState *pstate;
+	ExprCompileState cstate;
+	int			i;
+
+	if (state == NULL || !compile_expressions ||
+		IsA(state, ExprProgramState) ||
+		expression_returns_set((Node *) state->expr))
+		return state;
+
+	pstate = makeNode(ExprProgramState);
+	pstate->xprstate.expr = state->expr;
+	pstate->xprstate.evalfunc = (ExprStateEvalFunc) ExecEvalExprProgram;
+
+	cstate.maxsteps = 16;
+	cstate.steps = (ExprStep *) palloc(cstate.maxsteps * sizeof(ExprStep));
+	cstate.nsteps = 0;
+	memset(cstate.maxattr, 0, sizeof(cstate.maxattr));
+
+	ExecCompileExprRec(state, &cstate, &pstate->resvalue, &pstate->resnull);
+
+	/* a single step is no faster than the tree */
+	if (cstate.nsteps < 2)
+	{
+		pfree(cstate.steps);
+		pfree(pstate);
+		return state;
+	}
+
+	ExecExprAddStep(&cstate, EXPR_STEP_DONE, NULL, NULL);
+
+	/* the first Var fetched from a slot deforms all that the program uses */
+	for (i = 0; i < cstate.nsteps; i++)
+	{
+		ExprStep   *step = &cstate.steps[i];
+
+		if (step->opcode == EXPR_STEP_SCAN_VAR ||
+			step->opcode == EXPR_STEP_INNER_VAR ||
+			step->opcode == EXPR_STEP_OUTER_VAR)
+			step->d.var.maxattr = cstate.maxattr[EXPR_VAR_SLOT(step->opcode)];
+	}
+
+	pstate->steps = cstate.steps;
+	pstate->nsteps = cstate.nsteps;
+
+	return (ExprState *) pstate;
+}
+
+/*
+ * ExecCompilePlanExprs
+ *
+ * Compile the quals and targetlist of a plan node that has just been
+ * initialized.  The GenericExprStates of the targetlist stay, as the
+ * node's projection has been set up with them.
+ */
+void
+ExecCompilePlanExprs(PlanState *planstate)
+{
+	ListCell   *l;
+
+	if (!compile_expressions)
+		return;
+
+	foreach(l, planstate->qual)
+		lfirst(l) = ExecCompileExpr((ExprState *) lfirst(l));
+
+	foreach(l, planstate->targetlist)
+	{
+		GenericExprState *gstate = (GenericExprState *) lfirst(l);
+
+		if (IsA(gstate, GenericExprState))
+			gstate->arg = ExecCompileExpr(gstate->arg);
+	}
+
+	switch (nodeTag(planstate))
+	{
+		case T_NestLoopState:
+		case T_MergeJoinState:
+		case T_HashJoinState:
+			foreach(l, ((JoinState *) planstate)->joinqual)
+				lfirst(l) = ExecCompileExpr((ExprState *) lfirst(l));
+			break;
+		default:
+			break;
+	}
+}
+
+/*
+ * Append a step to the program, to store its result at resvalue/resnull.
+ * Steps may move as the program grows, so refer to them by index until
+ * it is complete.
+ */
+static ExprStep *
+ExecExprAddStep(ExprCompileState *cstate, ExprStepOp opcode,
+				Datum *resvalue, bool *resnull)
+{
+	ExprStep   *step;
+
+	if (cstate->nsteps >= cstate->maxsteps)
+	{
+		cstate->maxsteps *= 2;
+		cstate->steps = (ExprStep *)
+			repalloc(cstate->steps, cstate->maxsteps * sizeof(ExprStep));
+	}
+
+	step = &cstate->steps[cstate->nsteps++];
+	memset(step, 0, sizeof(ExprStep));
+	step->opcode = opcode;
+	step->resvalue = resvalue;
+	step->resnull = resnull;
+
+	return step;
+}
+
+/*
+ * Append the steps that evaluate state, storing its value at
+ * resvalue/resnull.
+ */
+static void
+ExecCompileExprRec(ExprState *state, ExprCompileState *cstate,
+				   Datum *resvalue, bool *resnull)
+{
+	Expr	   *expr = state->expr;
+	ExprStep   *step;
+
+	/* Guard against stack overflow due to overly complex expressions */
+	check_stack_depth();
+
+	switch (nodeTag(expr))
+	{
+		case T_Var:
+			{
+				Var		   *variable = (Var *) expr;
+				ExprStepOp	opcode;
+
+				/* whole-row and system attributes stay trees */
+				if (variable->varattno <= 0)
+					break;
+
+				switch (variable->varno)
+				{
+					case INNER_VAR:
+						opcode = EXPR_STEP_INNER_VAR;
+						break;
+					case OUTER_VAR:
+						opcode = EXPR_STEP_OUTER_VAR;
+						break;
+					default:
+						opcode = EXPR_STEP_SCAN_VAR;
+						break;
+				}
+
+				step = ExecExprAddStep(cstate, opcode, resvalue, resnull);
+				step->d.var.state = state;
+				step->d.var.attnum = variable->varattno;
+				cstate->maxattr[EXPR_VAR_SLOT(opcode)] =
+					Max(cstate->maxattr[EXPR_VAR_SLOT(opcode)],
+						variable->varattno);
+				return;
+			}
+		case T_Const:
+			{
+				Const	   *con = (Const *) expr;
+
+				step = ExecExprAddStep(cstate, EXPR_STEP_CONST,
+									   resvalue, resnull);
+				step->d.constval.value = con->constvalue;
+				step->d.constval.isnull = con->constisnull;
+				return;
+			}
+		case T_FuncExpr:
+		case T_OpExpr:
+			{
+				FuncExprState *fcache = (FuncExprState *) state;
+				FunctionCallInfo fcinfo = &fcache->fcinfo_data;
+				Oid			funcid;
+				Oid			inputcollid;
+				ListCell   *arg;
+				int			nargs;
+
+				if (IsA(expr, FuncExpr))
+				{
+					funcid = ((FuncExpr *) expr)->funcid;
+					inputcollid = ((FuncExpr *) expr)->inputcollid;
+				}
+				else
+				{
+					funcid = ((OpExpr *) expr)->opfuncid;
+					inputcollid = ((OpExpr *) expr)->inputcollid;
+				}
+
+				/* init_fcache complains about too many arguments */
+				nargs = list_length(fcache->args);
+				if (nargs > FUNC_MAX_ARGS)
+					break;
+
+				nargs = 0;
+				foreach(arg, fcache->args)
+				{
+					ExecCompileExprRec((ExprState *) lfirst(arg), cstate,
+									   &fcinfo->arg[nargs],
+									   &fcinfo->argnull[nargs]);
+					nargs++;
+				}
+
+				step = ExecExprAddStep(cstate,
+									   (nargs == 2 && func_strict(funcid)) ?
+									   EXPR_STEP_FUNC_STRICT2 :
+									   EXPR_STEP_FUNC,
+									   resvalue, resnull);
+				step->d.func.fcache = fcache;
+				step->d.func.funcid = funcid;
+				step->d.func.inputcollid = inputcollid;
+				return;
+			}
+		case T_BoolExpr:
+			{
+				BoolExprState *bstate = (BoolExprState *) state;
+				ExprStepOp	opcode;
+				bool	   *anynull;
+				List	   *jumps = NIL;
+				ListCell   *arg;
+
+				if (((BoolExpr *) expr)->boolop == NOT_EXPR)
+				{
+					ExecCompileExprRec((ExprState *) linitial(bstate->args),
+									   cstate, resvalue, resnull);
+					ExecExprAddStep(cstate, EXPR_STEP_NOT, resvalue, resnull);
+					return;
+				}
+
+				opcode = (((BoolExpr *) expr)->boolop == AND_EXPR) ?
+					EXPR_STEP_AND : EXPR_STEP_OR;
+				anynull = (bool *) palloc0(sizeof(bool));
+
+				foreach(arg, bstate->args)
+				{
+					ExecCompileExprRec((ExprState *) lfirst(arg), cstate,
+									   resvalue, resnull);
+					step = ExecExprAddStep(cstate, opcode, resvalue, resnull);
+					step->d.boolexpr.anynull = anynull;
+					step->d.boolexpr.first = (jumps == NIL);
+					jumps = lappend_int(jumps, cstate->nsteps - 1);
+				}
+
+				step = ExecExprAddStep(cstate,
+									   (opcode == EXPR_STEP_AND) ?
+									   EXPR_STEP_AND_END : EXPR_STEP_OR_END,
+									   resvalue, resnull);
+				step->d.boolexpr.anynull = anynull;
+
+				/* an argument that decides the result skips the rest */
+				foreach(arg, jumps)
+					cstate->steps[lfirst_int(arg)].d.boolexpr.jumpdone =
+						cstate->nsteps;
+				list_free(jumps);
+				return;
+			}
+		case T_NullTest:
+			{
+				NullTestState *nstate = (NullTestState *) state;
+				NullTest   *ntest = (NullTest *) expr;
+
+				/* tests of rows look at their fields */
+				if (ntest->argisrow)
+					break;
+
+				ExecCompileExprRec(nstate->arg, cstate, resvalue, resnull);
+				ExecExprAddStep(cstate,
+								(ntest->nulltesttype == IS_NULL) ?
+								EXPR_STEP_IS_NULL : EXPR_STEP_IS_NOT_NULL,
+								resvalue, resnull);
+				return;
+			}
+		case T_RelabelType:
+			/* nothing to do at run time */
+			ExecCompileExprRec(((GenericExprState *) state)->arg, cstate,
+							   resvalue, resnull);
+			return;
+		default:
+			break;
+	}
+
+	/* Anything else is evaluated as a tree */
+	step = ExecExprAddStep(cstate, EXPR_STEP_TREE, resvalue, resnull);
+	step->d.tree.state = state;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecEvalExprProgram
+ *
+ *		Runs the steps of an expression program.
+ * ----------------------------------------------------------------
+ */
+#ifdef EXPR_USE_COMPUTED_GOTO
+#define EXPR_SWITCH()		goto *dispatch_table[op->opcode];
+#define EXPR_CASE(name)		CASE_##name:
+#define EXPR_DISPATCH()		goto *dispatch_table[op->opcode]
+#else
+#define EXPR_SWITCH()		starteval: switch (op->opcode)
+#define EXPR_CASE(name)		case name:
+#define EXPR_DISPATCH()		goto starteval
+#endif
+
+#define EXPR_NEXT() \
+	do { op++; EXPR_DISPATCH(); } while (0)
+#define EXPR_JUMP(stepno) \
+	do { op = &pstate->steps[stepno]; EXPR_DISPATCH(); } while (0)
+
+static Datum
+ExecEvalExprProgram(ExprProgramState *pstate, ExprContext *econtext,
+					bool *isNull, ExprDoneCond *isDone)
+{
+	ExprStep   *op = pstate->steps;
+
+#ifdef EXPR_USE_COMPUTED_GOTO
+	static const void *const dispatch_table[] = {
+		&&CASE_EXPR_STEP_DONE,
+		&&CASE_EXPR_STEP_SCAN_VAR,
+		&&CASE_EXPR_STEP_INNER_VAR,
+		&&CASE_EXPR_STEP_OUTER_VAR,
+		&&CASE_EXPR_STEP_CONST,
+		&&CASE_EXPR_STEP_FUNC,
+		&&CASE_EXPR_STEP_FUNC_STRICT2,
+		&&CASE_EXPR_STEP_AND,
+		&&CASE_EXPR_STEP_AND_END,
+		&&CASE_EXPR_STEP_OR,
+		&&CASE_EXPR_STEP_OR_END,
+		&&CASE_EXPR_STEP_NOT,
+		&&CASE_EXPR_STEP_IS_NULL,
+		&&CASE_EXPR_STEP_IS_NOT_NULL,
+		&&CASE_EXPR_STEP_TREE
+	};
+
+	StaticAssertStmt(lengthof(dispatch_table) == EXPR_STEP_LAST + 1,
+					 "dispatch_table out of step with ExprStepOp");
+#endif
+
+	if (isDone)
+		*isDone = ExprSingleResult;
+
+	EXPR_SWITCH()
+	{
+		EXPR_CASE(EXPR_STEP_DONE)
+		{
+			*isNull = pstate->resnull;
+			return pstate->resvalue;
+		}
+
+		EXPR_CASE(EXPR_STEP_SCAN_VAR)
+		{
+			ExecExprFetchVar(op, econtext->ecxt_scantuple, econtext);
+			EXPR_NEXT();
+		}
+
+		EXPR_CASE(EXPR_STEP_INNER_VAR)
+		{
+			ExecExprFetchVar(op, econtext->ecxt_innertuple, econtext);
+			EXPR_NEXT();
+		}
+
+		EXPR_CASE(EXPR_STEP_OUTER_VAR)
+		{
+			ExecExprFetchVar(op, econtext->ecxt_outertuple, econtext);
+			EXPR_NEXT();
+		}
+
+		EXPR_CASE(EXPR_STEP_CONST)
+		{
+			*op->resvalue = op->d.constval.value;
+			*op->resnull = op->d.constval.isnull;
+			EXPR_NEXT();
+		}
+
+		EXPR_CASE(EXPR_STEP_FUNC)
+		{
+			FunctionCallInfo fcinfo = &op->d.func.fcache->fcinfo_data;
+			PgStat_FunctionCallUsage fcusage;
+			int			i;
+
+			if (op->d.func.fcache->func.fn_oid == InvalidOid)
+				ExecExprInitFunc(op, econtext);
+
+			/* a strict function returns null for any null argument */
+			if (op->d.func.fcache->func.fn_strict)
+			{
+				for (i = 0; i < fcinfo->nargs; i++)
+				{
+					if (fcinfo->argnull[i])
+					{
+						*op->resvalue = (Datum) 0;
+						*op->resnull = true;
+						EXPR_NEXT();
+					}
+				}
+			}
+
+			pgstat_init_function_usage(fcinfo, &fcusage);
+
+			fcinfo->isnull = false;
+			*op->resvalue = FunctionCallInvoke(fcinfo);
+			*op->resnull = fcinfo->isnull;
+
+			pgstat_end_function_usage(&fcusage, true);
+			EXPR_NEXT();
+		}
+
+		EXPR_CASE(EXPR_STEP_FUNC_STRICT2)
+		{
+			FunctionCallInfo fcinfo = &op->d.func.fcache->fcinfo_data;
+			PgStat_FunctionCallUsage fcusage;
+
+			if (op->d.func.fcache->func.fn_oid == InvalidOid)
+				ExecExprInitFunc(op, econtext);
+
+			if (fcinfo->argnull[0] || fcinfo->argnull[1])
+			{
+				*op->resvalue = (Datum) 0;
+				*op->resnull = true;
+				EXPR_NEXT();
+			}
+
+			pgstat_init_function_usage(fcinfo, &fcusage);
+
+			fcinfo->isnull = false;
+			*op->resvalue = FunctionCallInvoke(fcinfo);
+			*op->resnull = fcinfo->isnull;
+
+			pgstat_end_function_usage(&fcusage, true);
+			EXPR_NEXT();
+		}
+
+		EXPR_CASE(EXPR_STEP_AND)
+		{
+			if (op->d.boolexpr.first)
+				*op->d.boolexpr.anynull = false;
+
+			/* a false argument makes the AND false, see ExecEvalAnd */
+			if (*op->resnull)
+				*op->d.boolexpr.anynull = true;
+			else if (!DatumGetBool(*op->resvalue))
+				EXPR_JUMP(op->d.boolexpr.jumpdone);
+			EXPR_NEXT();
+		}
+
+		EXPR_CASE(EXPR_STEP_AND_END)
+		{
+			*op->resnull = *op->d.boolexpr.anynull;
+			*op->resvalue = BoolGetDatum(!*op->d.boolexpr.anynull);
+			EXPR_NEXT();
+		}
+
+		EXPR_CASE(EXPR_STEP_OR)
+		{
+			if (op->d.boolexpr.first)
+				*op->d.boolexpr.anynull = false;
+
+			/* a true argument makes the OR true, see ExecEvalOr */
+			if (*op->resnull)
+				*op->d.boolexpr.anynull = true;
+			else if (DatumGetBool(*op->resvalue))
+				EXPR_JUMP(op->d.boolexpr.jumpdone);
+			EXPR_NEXT();
+		}
+
+		EXPR_CASE(EXPR_STEP_OR_END)
+		{
+			*op->resnull = *op->d.boolexpr.anynull;
+			*op->resvalue = BoolGetDatum(false);
+			EXPR_NEXT();
+		}
+
+		EXPR_CASE(EXPR_STEP_NOT)
+		{
+			if (!*op->resnull)
+				*op->resvalue = BoolGetDatum(!DatumGetBool(*op->resvalue));
+			EXPR_NEXT();
+		}
+
+		EXPR_CASE(EXPR_STEP_IS_NULL)
+		{
+			*op->resvalue = BoolGetDatum(*op->resnull);
+			*op->resnull = false;
+			EXPR_NEXT();
+		}
+
+		EXPR_CASE(EXPR_STEP_IS_NOT_NULL)
+		{
+			*op->resvalue = BoolGetDatum(!*op->resnull);
+			*op->resnull = false;
+			EXPR_NEXT();
+		}
+
+		EXPR_CASE(EXPR_STEP_TREE)
+		{
+			*op->resvalue = ExecEvalExpr(op->d.tree.state, econtext,
+										 op->resnull, NULL);
+			EXPR_NEXT();
+		}
+	}
+
+	elog(ERROR, "unrecognized expression step: %d", (int) op->opcode);
+	return (Datum) 0;			/* keep compiler quiet */
+}
+
+/*
+ * Fetch the value of a Var step from its slot.  The first fetch goes
+ * through the Var's own state, which checks the Var against the slot; see
+ * ExecEvalScalarVar.
+ */
+static void
+ExecExprFetchVar(ExprStep *op, TupleTableSlot *slot, ExprContext *econtext)
+{
+	AttrNumber	attnum = op->d.var.attnum;
+
+	if (op->d.var.state->evalfunc != ExecEvalScalarVarFast)
+	{
+		*op->resvalue = ExecEvalExpr(op->d.var.state, econtext,
+									 op->resnull, NULL);
+		return;
+	}
+
+	if (attnum > slot->tts_nvalid)
+		slot_getsomeattrs(slot, Min(op->d.var.maxattr,
+									slot->tts_tupleDescriptor->natts));
+
+	*op->resvalue = slot->tts_values[attnum - 1];
+	*op->resnull = slot->tts_isnull[attnum - 1];
+}
+
+/*
+ * Look up the function of a function step on its first call, as
+ * ExecEvalFunc and ExecEvalOper do.
+ */
+static void
+ExecExprInitFunc(ExprStep *op, ExprContext *econtext)
+{
+	FuncExprState *fcache = op->d.func.fcache;
+
+	init_fcache(op->d.func.funcid, op->d.func.inputcollid, fcache,
+				econtext->ecxt_per_query_memory, false);
+
+	if (fcache->func.fn_retset)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+}
+
 
 /* ----------------------------------------------------------------
  *					 ExecQual / ExecTargetList / ExecProject
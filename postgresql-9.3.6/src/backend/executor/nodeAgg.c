@@ -66,6 +66,27 @@
  *	  AggState is available as context in earlier releases (back to 8.1),
  *	  but direct examination of the node is needed to use it before 9.0.
  *
+ *	  In AGG_HASHED mode the planner's estimate of the number of groups can
+ *	  be far too low, so the hash table is not allowed to grow past work_mem.
+ *	  Once aggcontext holds more than that, the groups already in the table
+ *	  keep absorbing their input tuples, but an input tuple of any other
+ *	  group is written to one of several batch files, chosen by bits of its
+ *	  hash value, much as nodeHash.c does.  When the table has been emptied,
+ *	  it is rebuilt from each batch file in turn; a batch that overflows
+ *	  again is split further using the next bits of the hash value.  All
+ *	  tuples of a group share a hash value, so every group is aggregated in
+ *	  exactly one pass.
+ *
+ *	  In AGG_PLAIN mode directly above a sequential scan that fetches its
+ *	  tuples in batches (see execBatch.c), we take whole batches from the
+ *	  scan instead of a tuple at a time, if every aggregate can be advanced
+ *	  over a batch by a loop of its own: those whose transition function is
+ *	  one of count's, sum's and avg's over int4 and float8, or min's and
+ *	  max's over int4, int8, float8 and date, and whose argument is a plain
+ *	  column of the scan.  Each loop has the same effect as calling the
+ *	  transition function on each input value in turn, down to the order in
+ *	  which float8 values are added and the overflow errors raised.
+ *
  *
  * Portions Copyright (c) 1996-2013, PostgreSQL Global Development Group
  * Portions Copyright (c) 1994, Regents of the University of California
@@ -78,6 +99,8 @@
 
 #include "postgres.h"
 
+#include <math.h>
+
 #include "access/htup_details.h"
 #include "catalog/objectaccess.h"
 #include "catalog/pg_aggregate.h"
@@ -85,14 +108,19 @@
 #include "catalog/pg_type.h"
 #include "executor/executor.h"
 #include "executor/nodeAgg.h"
+#include "executor/nodeSeqscan.h"
 #include "miscadmin.h"
 #include "nodes/nodeFuncs.h"
 #include "optimizer/clauses.h"
 #include "optimizer/tlist.h"
 #include "parser/parse_agg.h"
 #include "parser/parse_coerce.h"
+#include "parser/parsetree.h"
+#include "storage/buffile.h"
 #include "utils/acl.h"
+#include "utils/array.h"
 #include "utils/builtins.h"
+#include "utils/fmgroids.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/syscache.h"
@@ -100,6 +128,45 @@
 #include "utils/datum.h"
 
 
+/*
+ * How an aggregate is advanced over a batch of a sequential scan, chosen by
+ * its transition function
+ */
+typedef enum AggBatchKind
+{
+	AGG_BATCH_NONE,				/* not supported */
+	AGG_BATCH_COUNT,			/* int8inc, int8inc_any */
+	AGG_BATCH_SUM_INT4,			/* int4_sum */
+	AGG_BATCH_SUM_FLOAT8,		/* float8pl */
+	AGG_BATCH_AVG_INT4,			/* int4_avg_accum */
+	AGG_BATCH_AVG_FLOAT8,		/* float8_accum */
+	AGG_BATCH_MIN,				/* int4smaller etc */
+	AGG_BATCH_MAX				/* int4larger etc */
+} AggBatchKind;
+
+static const struct
+{
+	Oid			transfn;
+	AggBatchKind kind;
+	ExecBatchType type;
+}	agg_batch_transfns[] =
+{
+	{F_INT8INC, AGG_BATCH_COUNT, EXEC_BATCH_INT8},
+	{F_INT8INC_ANY, AGG_BATCH_COUNT, EXEC_BATCH_INT8},
+	{F_INT4_SUM, AGG_BATCH_SUM_INT4, EXEC_BATCH_INT4},
+	{F_FLOAT8PL, AGG_BATCH_SUM_FLOAT8, EXEC_BATCH_FLOAT8},
+	{F_INT4_AVG_ACCUM, AGG_BATCH_AVG_INT4, EXEC_BATCH_INT4},
+	{F_FLOAT8_ACCUM, AGG_BATCH_AVG_FLOAT8, EXEC_BATCH_FLOAT8},
+	{F_INT4SMALLER, AGG_BATCH_MIN, EXEC_BATCH_INT4},
+	{F_INT4LARGER, AGG_BATCH_MAX, EXEC_BATCH_INT4},
+	{F_INT8SMALLER, AGG_BATCH_MIN, EXEC_BATCH_INT8},
+	{F_INT8LARGER, AGG_BATCH_MAX, EXEC_BATCH_INT8},
+	{F_FLOAT8SMALLER, AGG_BATCH_MIN, EXEC_BATCH_FLOAT8},
+	{F_FLOAT8LARGER, AGG_BATCH_MAX, EXEC_BATCH_FLOAT8},
+	{F_DATE_SMALLER, AGG_BATCH_MIN, EXEC_BATCH_INT4},
+	{F_DATE_LARGER, AGG_BATCH_MAX, EXEC_BATCH_INT4}
+};
+
 /*
  * AggStatePerAggData - per-aggregate working state for the Agg scan
  */
@@ -204,6 +271,15 @@ typedef struct AggStatePerAggData
 	 */
 
 	Tuplesortstate *sortstate;	/* sort object, if DISTINCT or ORDER BY */
+
+	/*
+	 * When the Agg node takes whole batches from its input, how this
+	 * aggregate is advanced over them, and the batch column holding its
+	 * argument (-1 for count(*)).
+	 */
+	AggBatchKind batchkind;
+	ExecBatchType batchtype;
+	int			batchcolumn;
 }	AggStatePerAggData;
 
 /*
@@ -253,6 +329,35 @@ typedef struct AggHashEntryData
 	AggStatePerGroupData pergroup[1];	/* VARIABLE LENGTH ARRAY */
 }	AggHashEntryData;	/* VARIABLE LENGTH STRUCT */
 
+/*
+ * Batch files of hashed aggregation that ran out of work_mem.
+ *
+ * While a pass over the input (or over a batch file) is spilling, the tuples
+ * of groups not in the hash table are written to nbatch files, chosen by the
+ * nbits bits of their hash value that follow the used_bits bits that already
+ * chose the batch being read.  Files are only created when first written.
+ */
+typedef struct AggHashSpillData
+{
+	int			used_bits;		/* hash bits that chose the input batch */
+	int			nbits;			/* hash bits that choose the output batch */
+	int			nbatch;			/* 1 << nbits */
+	BufFile   **files;			/* output batch files, or NULL */
+} AggHashSpillData;
+
+/*
+ * A batch file waiting to be aggregated.
+ */
+typedef struct AggHashBatchData
+{
+	BufFile    *file;			/* the spilled input tuples */
+	int			used_bits;		/* hash bits that chose this batch */
+} AggHashBatchData;
+
+/* limits on the number of batch files a spilling pass writes to */
+#define HASHAGG_MIN_BATCHES		4
+#define HASHAGG_MAX_BATCHES		32
+
 
 static void initialize_aggregates(AggState *aggstate,
 					  AggStatePerAgg peragg,
@@ -262,6 +367,32 @@ static void advance_transition_function(AggState *aggstate,
 							AggStatePerGroup pergroupstate,
 							FunctionCallInfoData *fcinfo);
 static void advance_aggregates(AggState *aggstate, AggStatePerGroup pergroup);
+static bool agg_batch_init(AggState *aggstate);
+static void advance_aggregates_batch(AggState *aggstate,
+						 AggStatePerGroup pergroup);
+static void agg_batch_store(AggState *aggstate, AggStatePerAgg peraggstate,
+				AggStatePerGroup pergroupstate, Datum newVal);
+static int agg_batch_start(AggStatePerAgg peraggstate,
+				AggStatePerGroup pergroupstate, ExecBatch *batch,
+				Datum *state);
+static void advance_batch_count(AggState *aggstate,
+					AggStatePerAgg peraggstate,
+					AggStatePerGroup pergroupstate, ExecBatch *batch);
+static void advance_batch_sum_int4(AggState *aggstate,
+					   AggStatePerAgg peraggstate,
+					   AggStatePerGroup pergroupstate, ExecBatch *batch);
+static void advance_batch_sum_float8(AggState *aggstate,
+						 AggStatePerAgg peraggstate,
+						 AggStatePerGroup pergroupstate, ExecBatch *batch);
+static void advance_batch_avg_int4(AggState *aggstate,
+					   AggStatePerAgg peraggstate,
+					   AggStatePerGroup pergroupstate, ExecBatch *batch);
+static void advance_batch_avg_float8(AggState *aggstate,
+						 AggStatePerAgg peraggstate,
+						 AggStatePerGroup pergroupstate, ExecBatch *batch);
+static void advance_batch_minmax(AggState *aggstate,
+					 AggStatePerAgg peraggstate,
+					 AggStatePerGroup pergroupstate, ExecBatch *batch);
 static void process_ordered_aggregate_single(AggState *aggstate,
 								 AggStatePerAgg peraggstate,
 								 AggStatePerGroup pergroupstate);
@@ -277,8 +408,16 @@ static bool find_unaggregated_cols_walker(Node *node, Bitmapset **colnos);
 static void build_hash_table(AggState *aggstate);
 static AggHashEntry lookup_hash_entry(AggState *aggstate,
 				  TupleTableSlot *inputslot);
+static void agg_hash_check_mem(AggState *aggstate);
+static uint32 agg_hash_value(AggState *aggstate, TupleTableSlot *slot);
+static void agg_spill_tuple(AggState *aggstate, TupleTableSlot *inputslot);
+static TupleTableSlot *agg_read_spilled_tuple(AggState *aggstate,
+					   BufFile *file);
+static void agg_finish_spill(AggState *aggstate);
+static void agg_release_spill(AggState *aggstate);
 static TupleTableSlot *agg_retrieve_direct(AggState *aggstate);
 static void agg_fill_hash_table(AggState *aggstate);
+static void agg_refill_hash_table(AggState *aggstate);
 static TupleTableSlot *agg_retrieve_hash_table(AggState *aggstate);
 static Datum GetAggInitVal(Datum textInitVal, Oid transtype);
 
@@ -542,6 +681,506 @@ advance_aggregates(AggState *aggstate, AggStatePerGroup pergroup)
 	}
 }
 
+/*
+ * agg_batch_init
+ *
+ * Decide whether the aggregates can be advanced over whole batches of the
+ * input; see the head of this file.  If so, have the input deform their
+ * arguments into batch columns and return true.
+ */
+static bool
+agg_batch_init(AggState *aggstate)
+{
+	PlanState  *outerPlan = outerPlanState(aggstate);
+	SeqScanState *scanstate;
+	Index		scanrelid;
+	AttrNumber *attnums;
+	int			aggno;
+
+	if (!IsA(outerPlan, SeqScanState) ||
+		((SeqScanState *) outerPlan)->batch == NULL ||
+		aggstate->numaggs == 0)
+		return false;
+	scanstate = (SeqScanState *) outerPlan;
+	scanrelid = ((Scan *) outerPlan->plan)->scanrelid;
+
+	attnums = (AttrNumber *) palloc(aggstate->numaggs * sizeof(AttrNumber));
+	for (aggno = 0; aggno < aggstate->numaggs; aggno++)
+	{
+		AggStatePerAgg peraggstate = &aggstate->peragg[aggno];
+		TargetEntry *tle;
+		Var		   *var;
+		int			i;
+
+		peraggstate->batchkind = AGG_BATCH_NONE;
+		for (i = 0; i < lengthof(agg_batch_transfns); i++)
+		{
+			if (agg_batch_transfns[i].transfn == peraggstate->transfn_oid)
+			{
+				peraggstate->batchkind = agg_batch_transfns[i].kind;
+				peraggstate->batchtype = agg_batch_transfns[i].type;
+				break;
+			}
+		}
+		if (peraggstate->batchkind == AGG_BATCH_NONE ||
+			peraggstate->numSortCols > 0)
+			return false;
+
+		/* the loops for count and avg start from the initial state */
+		if ((peraggstate->batchkind == AGG_BATCH_COUNT ||
+			 peraggstate->batchkind == AGG_BATCH_AVG_INT4 ||
+			 peraggstate->batchkind == AGG_BATCH_AVG_FLOAT8) &&
+			peraggstate->initValueIsNull)
+			return false;
+
+		/* count(*) */
+		if (peraggstate->numInputs == 0 &&
+			peraggstate->batchkind == AGG_BATCH_COUNT)
+		{
+			attnums[aggno] = InvalidAttrNumber;
+			continue;
+		}
+		if (peraggstate->numInputs != 1)
+			return false;
+
+		/* the argument must be a column of the scan, seen through its tlist */
+		tle = (TargetEntry *) linitial(peraggstate->aggref->args);
+		if (!IsA(tle->expr, Var) ||
+			((Var *) tle->expr)->varno != OUTER_VAR)
+			return false;
+		tle = get_tle_by_resno(outerPlan->plan->targetlist,
+							   ((Var *) tle->expr)->varattno);
+		if (tle == NULL || !IsA(tle->expr, Var))
+			return false;
+		var = (Var *) tle->expr;
+		if (var->varno != scanrelid || var->varattno <= 0 ||
+			var->varlevelsup != 0)
+			return false;
+		attnums[aggno] = var->varattno;
+	}
+
+	for (aggno = 0; aggno < aggstate->numaggs; aggno++)
+	{
+		AggStatePerAgg peraggstate = &aggstate->peragg[aggno];
+
+		if (attnums[aggno] == InvalidAttrNumber)
+			peraggstate->batchcolumn = -1;
+		else
+			peraggstate->batchcolumn = ExecBatchColumn(scanstate->batch,
+													   attnums[aggno]);
+	}
+	pfree(attnums);
+
+	return true;
+}
+
+/*
+ * Advance all aggregates over every batch of the input, in place of
+ * calling advance_aggregates for each input tuple.
+ *
+ * When called, CurrentMemoryContext should be the per-query context.
+ */
+static void
+advance_aggregates_batch(AggState *aggstate, AggStatePerGroup pergroup)
+{
+	SeqScanState *scanstate = (SeqScanState *) outerPlanState(aggstate);
+	ExprContext *tmpcontext = aggstate->tmpcontext;
+	ExecBatch  *batch;
+	int			aggno;
+
+	while ((batch = ExecSeqScanBatch(scanstate)) != NULL)
+	{
+		MemoryContext oldContext;
+
+		oldContext = MemoryContextSwitchTo(tmpcontext->ecxt_per_tuple_memory);
+
+		for (aggno = 0; aggno < aggstate->numaggs; aggno++)
+		{
+			AggStatePerAgg peraggstate = &aggstate->peragg[aggno];
+			AggStatePerGroup pergroupstate = &pergroup[aggno];
+
+			switch (peraggstate->batchkind)
+			{
+				case AGG_BATCH_COUNT:
+					advance_batch_count(aggstate, peraggstate,
+										pergroupstate, batch);
+					break;
+				case AGG_BATCH_SUM_INT4:
+					advance_batch_sum_int4(aggstate, peraggstate,
+										   pergroupstate, batch);
+					break;
+				case AGG_BATCH_SUM_FLOAT8:
+					advance_batch_sum_float8(aggstate, peraggstate,
+											 pergroupstate, batch);
+					break;
+				case AGG_BATCH_AVG_INT4:
+					advance_batch_avg_int4(aggstate, peraggstate,
+										   pergroupstate, batch);
+					break;
+				case AGG_BATCH_AVG_FLOAT8:
+					advance_batch_avg_float8(aggstate, peraggstate,
+											 pergroupstate, batch);
+					break;
+				case AGG_BATCH_MIN:
+				case AGG_BATCH_MAX:
+					advance_batch_minmax(aggstate, peraggstate,
+										 pergroupstate, batch);
+					break;
+				case AGG_BATCH_NONE:
+					elog(ERROR, "aggregate cannot be advanced over a batch");
+					break;
+			}
+		}
+
+		MemoryContextSwitchTo(oldContext);
+		ResetExprContext(tmpcontext);
+	}
+}
+
+/*
+ * Store a new transition value computed over a batch, copying it into the
+ * aggcontext if the transition type is pass-by-ref.
+ */
+static void
+agg_batch_store(AggState *aggstate, AggStatePerAgg peraggstate,
+				AggStatePerGroup pergroupstate, Datum newVal)
+{
+	if (!peraggstate->transtypeByVal)
+	{
+		MemoryContext oldContext;
+
+		oldContext = MemoryContextSwitchTo(aggstate->aggcontext);
+		newVal = datumCopy(newVal, false, peraggstate->transtypeLen);
+		MemoryContextSwitchTo(oldContext);
+		if (!pergroupstate->transValueIsNull)
+			pfree(DatumGetPointer(pergroupstate->transValue));
+	}
+	pergroupstate->transValue = newVal;
+	pergroupstate->transValueIsNull = false;
+	pergroupstate->noTransValue = false;
+}
+
+/*
+ * For an aggregate with a strict transition function, find the state to
+ * advance a batch from: as in advance_transition_function, the first
+ * non-null input becomes the state if there is none yet.  Returns the
+ * sel[] index of the first row left to advance over, or -1 if the batch
+ * leaves the state as it is.
+ */
+static int
+agg_batch_start(AggStatePerAgg peraggstate, AggStatePerGroup pergroupstate,
+				ExecBatch *batch, Datum *state)
+{
+	Datum	   *values = batch->values[peraggstate->batchcolumn];
+	bool	   *isnull = batch->isnull[peraggstate->batchcolumn];
+	int			i;
+
+	if (!pergroupstate->noTransValue)
+	{
+		/* a strict transition function doesn't advance a null state */
+		if (pergroupstate->transValueIsNull)
+			return -1;
+		*state = pergroupstate->transValue;
+		return 0;
+	}
+
+	for (i = 0; i < batch->nsel; i++)
+	{
+		int			row = batch->sel[i];
+
+		if (!isnull[row])
+		{
+			*state = values[row];
+			return i + 1;
+		}
+	}
+	return -1;
+}
+
+/*
+ * count(*) and count(any): int8inc and int8inc_any
+ */
+static void
+advance_batch_count(AggState *aggstate, AggStatePerAgg peraggstate,
+					AggStatePerGroup pergroupstate, ExecBatch *batch)
+{
+	int64		count;
+	int64		result;
+
+	if (peraggstate->batchcolumn < 0)
+		count = batch->nsel;
+	else
+	{
+		bool	   *isnull = batch->isnull[peraggstate->batchcolumn];
+		int			i;
+
+		count = 0;
+		for (i = 0; i < batch->nsel; i++)
+			count += !isnull[batch->sel[i]];
+	}
+
+	if (pergroupstate->transValueIsNull)
+		return;
+	result = DatumGetInt64(pergroupstate->transValue) + count;
+	if (result < 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+				 errmsg("bigint out of range")));
+	agg_batch_store(aggstate, peraggstate, pergroupstate,
+					Int64GetDatum(result));
+}
+
+/*
+ * sum(int4): int4_sum, which isn't strict but skips nulls, and makes the
+ * first non-null input its state
+ */
+static void
+advance_batch_sum_int4(AggState *aggstate, AggStatePerAgg peraggstate,
+					   AggStatePerGroup pergroupstate, ExecBatch *batch)
+{
+	Datum	   *values = batch->values[peraggstate->batchcolumn];
+	bool	   *isnull = batch->isnull[peraggstate->batchcolumn];
+	int64		sum = 0;
+	int			nvalues = 0;
+	int			i;
+
+	for (i = 0; i < batch->nsel; i++)
+	{
+		int			row = batch->sel[i];
+
+		sum += isnull[row] ? 0 : (int64) DatumGetInt32(values[row]);
+		nvalues += !isnull[row];
+	}
+
+	if (nvalues == 0)
+		return;
+	if (!pergroupstate->transValueIsNull)
+		sum += DatumGetInt64(pergroupstate->transValue);
+	agg_batch_store(aggstate, peraggstate, pergroupstate,
+					Int64GetDatum(sum));
+}
+
+/*
+ * sum(float8): float8pl, adding the values in input order
+ */
+static void
+advance_batch_sum_float8(AggState *aggstate, AggStatePerAgg peraggstate,
+						 AggStatePerGroup pergroupstate, ExecBatch *batch)
+{
+	Datum	   *values = batch->values[peraggstate->batchcolumn];
+	bool	   *isnull = batch->isnull[peraggstate->batchcolumn];
+	Datum		state;
+	float8		sum;
+	int			i;
+
+	i = agg_batch_start(peraggstate, pergroupstate, batch, &state);
+	if (i < 0)
+		return;
+	sum = DatumGetFloat8(state);
+
+	for (; i < batch->nsel; i++)
+	{
+		int			row = batch->sel[i];
+		float8		value;
+		float8		result;
+
+		if (isnull[row])
+			continue;
+		value = DatumGetFloat8(values[row]);
+		result = sum + value;
+		if (isinf(result) && !isinf(sum) && !isinf(value))
+			ereport(ERROR,
+					(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+					 errmsg("value out of range: overflow")));
+		sum = result;
+	}
+
+	agg_batch_store(aggstate, peraggstate, pergroupstate,
+					Float8GetDatum(sum));
+}
+
+/*
+ * avg(int4): int4_avg_accum, whose state is an int8 array of the count and
+ * the sum of the inputs
+ */
+static void
+advance_batch_avg_int4(AggState *aggstate, AggStatePerAgg peraggstate,
+					   AggStatePerGroup pergroupstate, ExecBatch *batch)
+{
+	Datum	   *values = batch->values[peraggstate->batchcolumn];
+	bool	   *isnull = batch->isnull[peraggstate->batchcolumn];
+	ArrayType  *transarray;
+	int64	   *transdata;
+	int64		sum = 0;
+	int64		count = 0;
+	int			i;
+
+	for (i = 0; i < batch->nsel; i++)
+	{
+		int			row = batch->sel[i];
+
+		sum += isnull[row] ? 0 : (int64) DatumGetInt32(values[row]);
+		count += !isnull[row];
+	}
+
+	if (count == 0 || pergroupstate->transValueIsNull)
+		return;
+
+	/* the state is ours to scribble on, as int4_avg_accum does */
+	transarray = DatumGetArrayTypeP(pergroupstate->transValue);
+	if (ARR_HASNULL(transarray) ||
+		ARR_SIZE(transarray) != ARR_OVERHEAD_NONULLS(1) + 2 * sizeof(int64))
+		elog(ERROR, "expected 2-element int8 array");
+	transdata = (int64 *) ARR_DATA_PTR(transarray);
+	transdata[0] += count;
+	transdata[1] += sum;
+
+	if (PointerGetDatum(transarray) != pergroupstate->transValue)
+		agg_batch_store(aggstate, peraggstate, pergroupstate,
+						PointerGetDatum(transarray));
+}
+
+/*
+ * avg(float8), and the variance and stddev aggregates: float8_accum, whose
+ * state is a float8 array of N, sum(X) and sum(X*X)
+ */
+static void
+advance_batch_avg_float8(AggState *aggstate, AggStatePerAgg peraggstate,
+						 AggStatePerGroup pergroupstate, ExecBatch *batch)
+{
+	Datum	   *values = batch->values[peraggstate->batchcolumn];
+	bool	   *isnull = batch->isnull[peraggstate->batchcolumn];
+	ArrayType  *transarray;
+	float8	   *transvalues;
+	float8		N,
+				sumX,
+				sumX2;
+	int			i;
+
+	if (pergroupstate->transValueIsNull)
+		return;
+
+	transarray = DatumGetArrayTypeP(pergroupstate->transValue);
+	if (ARR_NDIM(transarray) != 1 ||
+		ARR_DIMS(transarray)[0] != 3 ||
+		ARR_HASNULL(transarray) ||
+		ARR_ELEMTYPE(transarray) != FLOAT8OID)
+		elog(ERROR, "float8_accum: expected 3-element float8 array");
+	transvalues = (float8 *) ARR_DATA_PTR(transarray);
+	N = transvalues[0];
+	sumX = transvalues[1];
+	sumX2 = transvalues[2];
+
+	for (i = 0; i < batch->nsel; i++)
+	{
+		int			row = batch->sel[i];
+		float8		value;
+		float8		newSumX;
+		float8		newSumX2;
+
+		if (isnull[row])
+			continue;
+		value = DatumGetFloat8(values[row]);
+		N += 1.0;
+		newSumX = sumX + value;
+		newSumX2 = sumX2 + value * value;
+		if ((isinf(newSumX) && !isinf(sumX) && !isinf(value)) ||
+			(isinf(newSumX2) && !isinf(sumX2) && !isinf(value)))
+			ereport(ERROR,
+					(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+					 errmsg("value out of range: overflow")));
+		sumX = newSumX;
+		sumX2 = newSumX2;
+	}
+
+	transvalues[0] = N;
+	transvalues[1] = sumX;
+	transvalues[2] = sumX2;
+
+	if (PointerGetDatum(transarray) != pergroupstate->transValue)
+		agg_batch_store(aggstate, peraggstate, pergroupstate,
+						PointerGetDatum(transarray));
+}
+
+/*
+ * min() and max() over int4, int8, float8 and date: int4smaller and the
+ * like, which keep their state unless the input is smaller (larger)
+ */
+static void
+advance_batch_minmax(AggState *aggstate, AggStatePerAgg peraggstate,
+					 AggStatePerGroup pergroupstate, ExecBatch *batch)
+{
+	Datum	   *values = batch->values[peraggstate->batchcolumn];
+	bool	   *isnull = batch->isnull[peraggstate->batchcolumn];
+	bool		max = (peraggstate->batchkind == AGG_BATCH_MAX);
+	Datum		state;
+	int			start;
+	int			i;
+
+	start = agg_batch_start(peraggstate, pergroupstate, batch, &state);
+	if (start < 0)
+		return;
+
+	switch (peraggstate->batchtype)
+	{
+		case EXEC_BATCH_INT4:
+			{
+				int32		best = DatumGetInt32(state);
+
+				for (i = start; i < batch->nsel; i++)
+				{
+					int			row = batch->sel[i];
+					int32		value = DatumGetInt32(values[row]);
+
+					if (!isnull[row] && (max ? value > best : value < best))
+						best = value;
+				}
+				state = Int32GetDatum(best);
+			}
+			break;
+		case EXEC_BATCH_INT8:
+			{
+				int64		best = DatumGetInt64(state);
+
+				for (i = start; i < batch->nsel; i++)
+				{
+					int			row = batch->sel[i];
+					int64		value = DatumGetInt64(values[row]);
+
+					if (!isnull[row] && (max ? value > best : value < best))
+						best = value;
+				}
+				state = Int64GetDatum(best);
+			}
+			break;
+		case EXEC_BATCH_FLOAT8:
+			{
+				float8		best = DatumGetFloat8(state);
+
+				/*
+				 * float8larger keeps its state only if it compares greater,
+				 * so an equal input, 0 after -0 say, replaces it.
+				 */
+				for (i = start; i < batch->nsel; i++)
+				{
+					int			row = batch->sel[i];
+					float8		value = DatumGetFloat8(values[row]);
+					int			cmp;
+
+					if (isnull[row])
+						continue;
+					cmp = float8_cmp_internal(best, value);
+					if (max ? cmp <= 0 : cmp >= 0)
+						best = value;
+				}
+				state = Float8GetDatum(best);
+			}
+			break;
+	}
+
+	agg_batch_store(aggstate, peraggstate, pergroupstate, state);
+}
+
 
 /*
  * Run the transition function for a DISTINCT or ORDER BY aggregate
@@ -919,6 +1558,10 @@ hash_agg_entry_size(int numAggs)
  * Find or create a hashtable entry for the tuple group containing the
  * given tuple.
  *
+ * While the current pass is spilling, no entries are created: if the group
+ * isn't in the table already, the tuple is written to a batch file and NULL
+ * is returned.
+ *
  * When called, CurrentMemoryContext should be the per-query context.
  */
 static AggHashEntry
@@ -947,6 +1590,17 @@ lookup_hash_entry(AggState *aggstate, TupleTableSlot *inputslot)
 		hashslot->tts_isnull[varNumber] = inputslot->tts_isnull[varNumber];
 	}
 
+	if (aggstate->hash_spill != NULL)
+	{
+		/* only look for an existing entry */
+		entry = (AggHashEntry) LookupTupleHashEntry(aggstate->hashtable,
+													hashslot,
+													NULL);
+		if (entry == NULL)
+			agg_spill_tuple(aggstate, inputslot);
+		return entry;
+	}
+
 	/* find or create the hashtable entry using the filtered tuple */
 	entry = (AggHashEntry) LookupTupleHashEntry(aggstate->hashtable,
 												hashslot,
@@ -956,11 +1610,245 @@ lookup_hash_entry(AggState *aggstate, TupleTableSlot *inputslot)
 	{
 		/* initialize aggregates for new tuple group */
 		initialize_aggregates(aggstate, aggstate->peragg, entry->pergroup);
+
+		/* a new group is our cue to see whether we're past work_mem */
+		agg_hash_check_mem(aggstate);
 	}
 
 	return entry;
 }
 
+/*
+ * Start spilling if the hash table and transition values have outgrown
+ * work_mem.  This runs for every new group; memory contexts keep their
+ * allocated total up to date, so it costs no more than a few additions.
+ */
+static void
+agg_hash_check_mem(AggState *aggstate)
+{
+	Size		spaceUsed;
+	AggHashSpill spill;
+	long		buffers;
+	int			nbits;
+
+	spaceUsed = MemoryContextMemAllocated(aggstate->aggcontext, true);
+	if (spaceUsed > aggstate->hash_mem_peak)
+		aggstate->hash_mem_peak = spaceUsed;
+	if (spaceUsed <= work_mem * 1024L)
+		return;
+
+	/*
+	 * Let the buffers of the batch files take about a quarter of work_mem,
+	 * within limits.
+	 */
+	buffers = (work_mem * 1024L) / (4 * BLCKSZ);
+	nbits = 0;
+	while ((1 << nbits) < HASHAGG_MIN_BATCHES ||
+		   ((1 << (nbits + 1)) <= buffers &&
+			(1 << (nbits + 1)) <= HASHAGG_MAX_BATCHES))
+		nbits++;
+
+	/*
+	 * If the hash value has no bits left to split on, the groups can't be
+	 * told apart any further; keep them in memory.
+	 */
+	if (aggstate->hash_used_bits + nbits > 32)
+		return;
+
+	spill = (AggHashSpill) palloc(sizeof(AggHashSpillData));
+	spill->used_bits = aggstate->hash_used_bits;
+	spill->nbits = nbits;
+	spill->nbatch = 1 << nbits;
+	spill->files = (BufFile **) palloc0(spill->nbatch * sizeof(BufFile *));
+	aggstate->hash_spill = spill;
+}
+
+/*
+ * Compute the hash value of a tuple's grouping columns, the same way the
+ * hash table does.
+ */
+static uint32
+agg_hash_value(AggState *aggstate, TupleTableSlot *slot)
+{
+	Agg		   *node = (Agg *) aggstate->ss.ps.plan;
+	MemoryContext oldContext;
+	uint32		hashkey = 0;
+	int			i;
+
+	/* the hash functions may leak, so run them in per-tuple memory */
+	oldContext =
+		MemoryContextSwitchTo(aggstate->tmpcontext->ecxt_per_tuple_memory);
+
+	for (i = 0; i < node->numCols; i++)
+	{
+		Datum		attr;
+		bool		isNull;
+
+		/* rotate hashkey left 1 bit at each step */
+		hashkey = (hashkey << 1) | ((hashkey & 0x80000000) ? 1 : 0);
+
+		attr = slot_getattr(slot, node->grpColIdx[i], &isNull);
+
+		if (!isNull)			/* treat nulls as having hash key 0 */
+		{
+			uint32		hkey;
+
+			hkey = DatumGetUInt32(FunctionCall1(&aggstate->hashfunctions[i],
+												attr));
+			hashkey ^= hkey;
+		}
+	}
+
+	MemoryContextSwitchTo(oldContext);
+
+	return hashkey;
+}
+
+/*
+ * Write an input tuple to the batch file its hash value selects.
+ *
+ * The batch is chosen by the bits of the hash value just below those that
+ * chose the batch being read; the hash table itself uses the low bits.
+ */
+static void
+agg_spill_tuple(AggState *aggstate, TupleTableSlot *inputslot)
+{
+	AggHashSpill spill = aggstate->hash_spill;
+	uint32		hashvalue;
+	int			batchno;
+	MinimalTuple tuple;
+	BufFile    *file;
+	size_t		written;
+
+	hashvalue = agg_hash_value(aggstate, inputslot);
+	batchno = (int) ((hashvalue << spill->used_bits) >> (32 - spill->nbits));
+
+	file = spill->files[batchno];
+	if (file == NULL)
+	{
+		/* First write to this batch file, so open it. */
+		file = BufFileCreateTemp(false);
+		spill->files[batchno] = file;
+		aggstate->hash_batches_used++;
+	}
+
+	tuple = ExecFetchSlotMinimalTuple(inputslot);
+	written = BufFileWrite(file, (void *) tuple, tuple->t_len);
+	if (written != tuple->t_len)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+			   errmsg("could not write to hash-aggregate temporary file: %m")));
+	aggstate->hash_disk_used += tuple->t_len;
+}
+
+/*
+ * Read the next tuple from a batch file into hash_spill_slot.  Returns NULL
+ * at the end of the file.
+ */
+static TupleTableSlot *
+agg_read_spilled_tuple(AggState *aggstate, BufFile *file)
+{
+	TupleTableSlot *slot = aggstate->hash_spill_slot;
+	uint32		t_len;
+	size_t		nread;
+	MinimalTuple tuple;
+
+	nread = BufFileRead(file, (void *) &t_len, sizeof(t_len));
+	if (nread == 0)				/* end of file */
+	{
+		ExecClearTuple(slot);
+		return NULL;
+	}
+	if (nread != sizeof(t_len))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+			  errmsg("could not read from hash-aggregate temporary file: %m")));
+	tuple = (MinimalTuple) palloc(t_len);
+	tuple->t_len = t_len;
+	nread = BufFileRead(file,
+						(void *) ((char *) tuple + sizeof(uint32)),
+						t_len - sizeof(uint32));
+	if (nread != t_len - sizeof(uint32))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+			  errmsg("could not read from hash-aggregate temporary file: %m")));
+	return ExecStoreMinimalTuple(tuple, slot, true);
+}
+
+/*
+ * At the end of a pass, note its memory use and queue the batch files it
+ * wrote for later passes.
+ */
+static void
+agg_finish_spill(AggState *aggstate)
+{
+	AggHashSpill spill = aggstate->hash_spill;
+	Size		spaceUsed;
+	int			batchno;
+
+	/* transition values may have kept growing after we started spilling */
+	spaceUsed = MemoryContextMemAllocated(aggstate->aggcontext, true);
+	if (spaceUsed > aggstate->hash_mem_peak)
+		aggstate->hash_mem_peak = spaceUsed;
+
+	if (spill == NULL)
+		return;
+
+	for (batchno = 0; batchno < spill->nbatch; batchno++)
+	{
+		AggHashBatchData *batch;
+
+		if (spill->files[batchno] == NULL)
+			continue;
+
+		batch = (AggHashBatchData *) palloc(sizeof(AggHashBatchData));
+		batch->file = spill->files[batchno];
+		batch->used_bits = spill->used_bits + spill->nbits;
+		aggstate->hash_batches = lappend(aggstate->hash_batches, batch);
+	}
+
+	pfree(spill->files);
+	pfree(spill);
+	aggstate->hash_spill = NULL;
+	aggstate->hash_spilled = true;
+}
+
+/*
+ * Close all batch files, written or pending.
+ */
+static void
+agg_release_spill(AggState *aggstate)
+{
+	AggHashSpill spill = aggstate->hash_spill;
+	ListCell   *lc;
+
+	if (spill != NULL)
+	{
+		int			batchno;
+
+		for (batchno = 0; batchno < spill->nbatch; batchno++)
+		{
+			if (spill->files[batchno] != NULL)
+				BufFileClose(spill->files[batchno]);
+		}
+		pfree(spill->files);
+		pfree(spill);
+		aggstate->hash_spill = NULL;
+	}
+
+	foreach(lc, aggstate->hash_batches)
+	{
+		AggHashBatchData *batch = (AggHashBatchData *) lfirst(lc);
+
+		BufFileClose(batch->file);
+	}
+	list_free_deep(aggstate->hash_batches);
+	aggstate->hash_batches = NIL;
+
+	aggstate->hash_used_bits = 0;
+	aggstate->hash_spilled = false;
+}
+
 /*
  * ExecAgg -
  *
@@ -1055,7 +1943,7 @@ agg_retrieve_direct(AggState *aggstate)
 		 * If we don't already have the first tuple of the new group, fetch it
 		 * from the outer plan.
 		 */
-		if (aggstate->grp_firstTuple == NULL)
+		if (aggstate->grp_firstTuple == NULL && !aggstate->batch_agg)
 		{
 			outerslot = ExecProcNode(outerPlan);
 			if (!TupIsNull(outerslot))
@@ -1091,7 +1979,13 @@ agg_retrieve_direct(AggState *aggstate)
 		 */
 		initialize_aggregates(aggstate, peragg, pergroup);
 
-		if (aggstate->grp_firstTuple != NULL)
+		if (aggstate->batch_agg)
+		{
+			/* Not grouping, so the whole input goes into this one result */
+			advance_aggregates_batch(aggstate, pergroup);
+			aggstate->agg_done = true;
+		}
+		else if (aggstate->grp_firstTuple != NULL)
 		{
 			/*
 			 * Store the copied first input tuple in the tuple table slot
@@ -1247,18 +2141,67 @@ agg_fill_hash_table(AggState *aggstate)
 		/* Find or build hashtable entry for this tuple's group */
 		entry = lookup_hash_entry(aggstate, outerslot);
 
-		/* Advance the aggregates */
-		advance_aggregates(aggstate, entry->pergroup);
+		/* Advance the aggregates, unless the tuple was spilled */
+		if (entry != NULL)
+			advance_aggregates(aggstate, entry->pergroup);
 
 		/* Reset per-input-tuple context after each tuple */
 		ResetExprContext(tmpcontext);
 	}
 
+	/* Queue any batch files written for later passes */
+	agg_finish_spill(aggstate);
+
 	aggstate->table_filled = true;
 	/* Initialize to walk the hash table */
 	ResetTupleHashIterator(aggstate->hashtable, &aggstate->hashiter);
 }
 
+/*
+ * ExecAgg for hashed case: rebuild the hash table from the next batch file
+ * once the groups of the previous pass have all been returned
+ */
+static void
+agg_refill_hash_table(AggState *aggstate)
+{
+	ExprContext *tmpcontext = aggstate->tmpcontext;
+	AggHashBatchData *batch;
+	TupleTableSlot *slot;
+	AggHashEntry entry;
+
+	batch = (AggHashBatchData *) linitial(aggstate->hash_batches);
+	aggstate->hash_batches = list_delete_first(aggstate->hash_batches);
+
+	/* Release the groups of the previous pass and start an empty table */
+	MemoryContextResetAndDeleteChildren(aggstate->aggcontext);
+	build_hash_table(aggstate);
+	aggstate->hash_used_bits = batch->used_bits;
+
+	if (BufFileSeek(batch->file, 0, 0L, SEEK_SET))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+			 errmsg("could not rewind hash-aggregate temporary file: %m")));
+
+	while ((slot = agg_read_spilled_tuple(aggstate, batch->file)) != NULL)
+	{
+		/* set up for advance_aggregates call */
+		tmpcontext->ecxt_outertuple = slot;
+
+		entry = lookup_hash_entry(aggstate, slot);
+		if (entry != NULL)
+			advance_aggregates(aggstate, entry->pergroup);
+
+		ResetExprContext(tmpcontext);
+	}
+
+	BufFileClose(batch->file);
+	pfree(batch);
+
+	agg_finish_spill(aggstate);
+
+	ResetTupleHashIterator(aggstate->hashtable, &aggstate->hashiter);
+}
+
 /*
  * ExecAgg for hashed case: phase 2, retrieving groups from hash table
  */
@@ -1296,6 +2239,13 @@ agg_retrieve_hash_table(AggState *aggstate)
 		entry = (AggHashEntry) ScanTupleHashTable(&aggstate->hashiter);
 		if (entry == NULL)
 		{
+			/* Aggregate the next batch file, if any */
+			if (aggstate->hash_batches != NIL)
+			{
+				agg_refill_hash_table(aggstate);
+				continue;
+			}
+
 			/* No more entries in hashtable, so done */
 			aggstate->agg_done = TRUE;
 			return NULL;
@@ -1403,6 +2353,13 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 	aggstate->pergroup = NULL;
 	aggstate->grp_firstTuple = NULL;
 	aggstate->hashtable = NULL;
+	aggstate->hash_spill = NULL;
+	aggstate->hash_batches = NIL;
+	aggstate->hash_used_bits = 0;
+	aggstate->hash_spilled = false;
+	aggstate->hash_batches_used = 0;
+	aggstate->hash_disk_used = 0;
+	aggstate->hash_mem_peak = 0;
 
 	/*
 	 * Create expression contexts.  We need two, one for per-input-tuple
@@ -1434,6 +2391,7 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 	ExecInitScanTupleSlot(estate, &aggstate->ss);
 	ExecInitResultTupleSlot(estate, &aggstate->ss.ps);
 	aggstate->hashslot = ExecInitExtraTupleSlot(estate);
+	aggstate->hash_spill_slot = ExecInitExtraTupleSlot(estate);
 
 	/*
 	 * initialize child expressions
@@ -1527,6 +2485,9 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 		aggstate->table_filled = false;
 		/* Compute the columns we actually need to hash on */
 		aggstate->hash_needed = find_hash_columns(aggstate);
+		/* Spilled input tuples are read back in the input's format */
+		ExecSetSlotDescriptor(aggstate->hash_spill_slot,
+							  ExecGetResultType(outerPlanState(aggstate)));
 	}
 	else
 	{
@@ -1860,6 +2821,10 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 	/* Update numaggs to match number of unique aggregates found */
 	aggstate->numaggs = aggno + 1;
 
+	/* Take whole batches from a batched scan, if we can */
+	aggstate->batch_agg = (node->aggstrategy == AGG_PLAIN &&
+						   agg_batch_init(aggstate));
+
 	return aggstate;
 }
 
@@ -1894,6 +2859,9 @@ ExecEndAgg(AggState *node)
 			tuplesort_end(peraggstate->sortstate);
 	}
 
+	/* Close any batch files of hashed aggregation */
+	agg_release_spill(node);
+
 	/*
 	 * Free both the expr contexts.
 	 */
@@ -1934,13 +2902,17 @@ ExecReScanAgg(AggState *node)
 		/*
 		 * If we do have the hash table and the subplan does not have any
 		 * parameter changes, then we can just rescan the existing hash table;
-		 * no need to build it again.
+		 * no need to build it again.  That doesn't work if it spilled, since
+		 * the table only holds the groups of the last batch.
 		 */
-		if (node->ss.ps.lefttree->chgParam == NULL)
+		if (node->ss.ps.lefttree->chgParam == NULL && !node->hash_spilled)
 		{
 			ResetTupleHashIterator(node->hashtable, &node->hashiter);
 			return;
 		}
+
+		/* Discard any batch files */
+		agg_release_spill(node);
 	}
 
 	/* Make sure we have closed any open tuplesorts */
@@ -16,6 +16,7 @@
  * INTERFACE ROUTINES
  *		ExecSeqScan				sequentially scans a relation.
  *		ExecSeqNext				retrieve next tuple in sequential order.
+ *		ExecSeqScanBatch		retrieve next batch of qualifying tuples.
  *		ExecInitSeqScan			creates and initializes a seqscan node.
  *		ExecEndSeqScan			releases any storage allocated.
  *		ExecReScanSeqScan		rescans the relation
@@ -25,12 +26,17 @@
 #include "postgres.h"
 
 #include "access/relscan.h"
+#include "executor/execBatch.h"
 #include "executor/execdebug.h"
 #include "executor/nodeSeqscan.h"
+#include "miscadmin.h"
+#include "utils/memutils.h"
 #include "utils/rel.h"
 
 static void InitScanRelation(SeqScanState *node, EState *estate, int eflags);
 static TupleTableSlot *SeqNext(SeqScanState *node);
+static bool SeqFillBatch(SeqScanState *node);
+static TupleTableSlot *SeqNextBatch(SeqScanState *node);
 
 /* ----------------------------------------------------------------
  *						Scan Support
@@ -55,10 +61,10 @@ SeqNext(SeqScanState *node)
 	/*
 	 * get information from the estate and scan state
 	 */
-	scandesc = node->ss_currentScanDesc;
-	estate = node->ps.state;
+	scandesc = node->ss.ss_currentScanDesc;
+	estate = node->ss.ps.state;
 	direction = estate->es_direction;
-	slot = node->ss_ScanTupleSlot;
+	slot = node->ss.ss_ScanTupleSlot;
 
 	/*
 	 * get the next tuple from the table
@@ -85,6 +91,70 @@ SeqNext(SeqScanState *node)
 	return slot;
 }
 
+/* ----------------------------------------------------------------
+ *		SeqFillBatch
+ *
+ *		Fetches the next batch of tuples and evaluates the batch quals
+ *		on it.  Returns false at the end of the scan.
+ * ----------------------------------------------------------------
+ */
+static bool
+SeqFillBatch(SeqScanState *node)
+{
+	ExecBatch  *batch = node->batch;
+	HeapScanDesc scandesc = node->ss.ss_currentScanDesc;
+	HeapTuple	tuple;
+
+	ExecBatchReset(batch);
+
+	/* heap_getnext would start over after returning the last tuple */
+	while (!batch->done)
+	{
+		tuple = heap_getnext(scandesc, ForwardScanDirection);
+		if (tuple == NULL)
+			batch->done = true;
+		else if (!ExecBatchAddRow(batch, tuple, scandesc->rs_cbuf))
+			break;
+	}
+
+	if (batch->nrows == 0)
+		return false;
+
+	ExecBatchQual(batch);
+	InstrCountFiltered1(node, batch->nrows - batch->nsel);
+
+	return true;
+}
+
+/* ----------------------------------------------------------------
+ *		SeqNextBatch
+ *
+ *		Like SeqNext, but returns the tuples of the current batch that
+ *		passed the batch quals, fetching batches as needed.
+ * ----------------------------------------------------------------
+ */
+static TupleTableSlot *
+SeqNextBatch(SeqScanState *node)
+{
+	ExecBatch  *batch = node->batch;
+	TupleTableSlot *slot = node->ss.ss_ScanTupleSlot;
+	int			row;
+
+	while (batch->next >= batch->nsel)
+	{
+		ExecClearTuple(slot);
+		if (!SeqFillBatch(node))
+			return slot;
+	}
+
+	row = batch->sel[batch->next++];
+
+	return ExecStoreTuple(&batch->tuples[row],
+						  slot,
+						  batch->buffers[row],
+						  false);
+}
+
 /*
  * SeqRecheck -- access method routine to recheck a tuple in EvalPlanQual
  */
@@ -110,11 +180,87 @@ SeqRecheck(SeqScanState *node, TupleTableSlot *slot)
 TupleTableSlot *
 ExecSeqScan(SeqScanState *node)
 {
+	/*
+	 * Batches only pay off if there are batch quals; node->ss.ps.qual then
+	 * holds the rest of the quals.
+	 */
+	if (node->batch != NULL && node->batch->npreds > 0)
+		return ExecScan((ScanState *) node,
+						(ExecScanAccessMtd) SeqNextBatch,
+						(ExecScanRecheckMtd) SeqRecheck);
+
 	return ExecScan((ScanState *) node,
 					(ExecScanAccessMtd) SeqNext,
 					(ExecScanRecheckMtd) SeqRecheck);
 }
 
+/* ----------------------------------------------------------------
+ *		ExecSeqScanBatch(node)
+ *
+ *		Returns the next batch of tuples that pass all of the node's
+ *		quals, listed in the batch's sel[], or NULL at the end of the
+ *		scan.  This is for a parent that consumes whole batches instead
+ *		of calling ExecProcNode, so the node must have been set up for
+ *		batches, and its projection is up to the parent.
+ * ----------------------------------------------------------------
+ */
+ExecBatch *
+ExecSeqScanBatch(SeqScanState *node)
+{
+	ExecBatch  *batch = node->batch;
+	ExecBatch  *result = NULL;
+	List	   *qual = node->ss.ps.qual;
+	ExprContext *econtext = node->ss.ps.ps_ExprContext;
+	TupleTableSlot *slot = node->ss.ss_ScanTupleSlot;
+
+	Assert(batch != NULL);
+
+	/* what ExecProcNode would do for us */
+	CHECK_FOR_INTERRUPTS();
+
+	if (node->ss.ps.chgParam != NULL)
+		ExecReScan((PlanState *) node);
+
+	if (node->ss.ps.instrument)
+		InstrStartNode(node->ss.ps.instrument);
+
+	while (SeqFillBatch(node))
+	{
+		/* evaluate the quals that are not batch quals a tuple at a time */
+		if (qual)
+		{
+			int			nsel = 0;
+			int			i;
+
+			econtext->ecxt_scantuple = slot;
+			for (i = 0; i < batch->nsel; i++)
+			{
+				int			row = batch->sel[i];
+
+				ResetExprContext(econtext);
+				ExecStoreTuple(&batch->tuples[row], slot, InvalidBuffer, false);
+				if (ExecQual(qual, econtext, false))
+					batch->sel[nsel++] = row;
+			}
+			ExecClearTuple(slot);
+			InstrCountFiltered1(node, batch->nsel - nsel);
+			batch->nsel = nsel;
+		}
+
+		if (batch->nsel > 0)
+		{
+			result = batch;
+			break;
+		}
+	}
+
+	if (node->ss.ps.instrument)
+		InstrStopNode(node->ss.ps.instrument,
+					  result != NULL ? result->nsel : 0);
+
+	return result;
+}
+
 /* ----------------------------------------------------------------
  *		InitScanRelation
  *
@@ -132,7 +278,7 @@ InitScanRelation(SeqScanState *node, EState *estate, int eflags)
 	 * open that relation and acquire appropriate lock on it.
 	 */
 	currentRelation = ExecOpenScanRelation(estate,
-									  ((SeqScan *) node->ps.plan)->scanrelid,
+								   ((SeqScan *) node->ss.ps.plan)->scanrelid,
 										   eflags);
 
 	/* initialize a heapscan */
@@ -141,11 +287,11 @@ InitScanRelation(SeqScanState *node, EState *estate, int eflags)
 									 0,
 									 NULL);
 
-	node->ss_currentRelation = currentRelation;
-	node->ss_currentScanDesc = currentScanDesc;
+	node->ss.ss_currentRelation = currentRelation;
+	node->ss.ss_currentScanDesc = currentScanDesc;
 
 	/* and report the scan tuple slot's rowtype */
-	ExecAssignScanType(node, RelationGetDescr(currentRelation));
+	ExecAssignScanType(&node->ss, RelationGetDescr(currentRelation));
 }
 
 
@@ -157,6 +303,7 @@ SeqScanState *
 ExecInitSeqScan(SeqScan *node, EState *estate, int eflags)
 {
 	SeqScanState *scanstate;
+	List	   *qual;
 
 	/*
 	 * Once upon a time it was possible to have an outerPlan of a SeqScan, but
@@ -169,44 +316,63 @@ ExecInitSeqScan(SeqScan *node, EState *estate, int eflags)
 	 * create state structure
 	 */
 	scanstate = makeNode(SeqScanState);
-	scanstate->ps.plan = (Plan *) node;
-	scanstate->ps.state = estate;
+	scanstate->ss.ps.plan = (Plan *) node;
+	scanstate->ss.ps.state = estate;
 
 	/*
 	 * Miscellaneous initialization
 	 *
 	 * create expression context for node
 	 */
-	ExecAssignExprContext(estate, &scanstate->ps);
+	ExecAssignExprContext(estate, &scanstate->ss.ps);
 
 	/*
 	 * initialize child expressions
 	 */
-	scanstate->ps.targetlist = (List *)
+	scanstate->ss.ps.targetlist = (List *)
 		ExecInitExpr((Expr *) node->plan.targetlist,
 					 (PlanState *) scanstate);
-	scanstate->ps.qual = (List *)
-		ExecInitExpr((Expr *) node->plan.qual,
-					 (PlanState *) scanstate);
 
 	/*
 	 * tuple table initialization
 	 */
-	ExecInitResultTupleSlot(estate, &scanstate->ps);
-	ExecInitScanTupleSlot(estate, scanstate);
+	ExecInitResultTupleSlot(estate, &scanstate->ss.ps);
+	ExecInitScanTupleSlot(estate, &scanstate->ss);
 
 	/*
 	 * initialize scan relation
 	 */
 	InitScanRelation(scanstate, estate, eflags);
 
-	scanstate->ps.ps_TupFromTlist = false;
+	/*
+	 * Fetch the tuples a batch at a time if asked to, and if the scan only
+	 * runs forward under an MVCC snapshot: a batch is fetched ahead of the
+	 * tuples returned, and can't be rechecked by EvalPlanQual.  The quals
+	 * the batches don't evaluate are left for ExecQual.
+	 */
+	qual = node->plan.qual;
+	if (batch_execution &&
+		!(eflags & (EXEC_FLAG_BACKWARD | EXEC_FLAG_MARK)) &&
+		estate->es_epqTuple == NULL &&
+		scanstate->ss.ss_currentScanDesc->rs_pageatatime)
+		scanstate->batch =
+			ExecInitBatch(estate,
+						  RelationGetDescr(scanstate->ss.ss_currentRelation),
+						  node->scanrelid, qual, &qual);
+	else
+		scanstate->batch = NULL;
+
+	scanstate->ss.ps.qual = (List *)
+		ExecInitExpr((Expr *) qual,
+					 (PlanState *) scanstate);
+
+	scanstate->ss.ps.ps_TupFromTlist = false;
 
 	/*
 	 * Initialize result tuple type and projection info.
 	 */
-	ExecAssignResultTypeFromTL(&scanstate->ps);
-	ExecAssignScanProjectionInfo(scanstate);
+	ExecAssignResultTypeFromTL(&scanstate->ss.ps);
+	ExecAssignScanProjectionInfo(&scanstate->ss);
 
 	return scanstate;
 }
@@ -226,19 +392,25 @@ ExecEndSeqScan(SeqScanState *node)
 	/*
 	 * get information from node
 	 */
-	relation = node->ss_currentRelation;
-	scanDesc = node->ss_currentScanDesc;
+	relation = node->ss.ss_currentRelation;
+	scanDesc = node->ss.ss_currentScanDesc;
 
 	/*
 	 * Free the exprcontext
 	 */
-	ExecFreeExprContext(&node->ps);
+	ExecFreeExprContext(&node->ss.ps);
 
 	/*
 	 * clean out the tuple table
 	 */
-	ExecClearTuple(node->ps.ps_ResultTupleSlot);
-	ExecClearTuple(node->ss_ScanTupleSlot);
+	ExecClearTuple(node->ss.ps.ps_ResultTupleSlot);
+	ExecClearTuple(node->ss.ss_ScanTupleSlot);
+
+	/*
+	 * release the pages of the last batch
+	 */
+	if (node->batch)
+		ExecBatchReset(node->batch);
 
 	/*
 	 * close heap scan
@@ -267,7 +439,14 @@ ExecReScanSeqScan(SeqScanState *node)
 {
 	HeapScanDesc scan;
 
-	scan = node->ss_currentScanDesc;
+	scan = node->ss.ss_currentScanDesc;
+
+	if (node->batch)
+	{
+		ExecClearTuple(node->ss.ss_ScanTupleSlot);
+		ExecBatchReset(node->batch);
+		node->batch->done = false;
+	}
 
 	heap_rescan(scan,			/* scan desc */
 				NULL);			/* new scan keys */
@@ -284,7 +463,7 @@ ExecReScanSeqScan(SeqScanState *node)
 void
 ExecSeqMarkPos(SeqScanState *node)
 {
-	HeapScanDesc scan = node->ss_currentScanDesc;
+	HeapScanDesc scan = node->ss.ss_currentScanDesc;
 
 	heap_markpos(scan);
 }
@@ -298,7 +477,7 @@ ExecSeqMarkPos(SeqScanState *node)
 void
 ExecSeqRestrPos(SeqScanState *node)
 {
-	HeapScanDesc scan = node->ss_currentScanDesc;
+	HeapScanDesc scan = node->ss.ss_currentScanDesc;
 
 	/*
 	 * Clear any reference to the previously returned tuple.  This is needed
@@ -306,7 +485,7 @@ ExecSeqRestrPos(SeqScanState *node)
 	 * heap_restrpos will change; we'd have an internally inconsistent slot if
 	 * we didn't do this.
 	 */
-	ExecClearTuple(node->ss_ScanTupleSlot);
+	ExecClearTuple(node->ss.ss_ScanTupleSlot);
 
 	heap_restrpos(scan);
 }
@@ -2791,6 +2791,7 @@ _copyDropStmt(const DropStmt *from)
 	COPY_SCALAR_FIELD(behavior);
 	COPY_SCALAR_FIELD(missing_ok);
 	COPY_SCALAR_FIELD(concurrent);
+	COPY_SCALAR_FIELD(hypothetical);
 
 	return newnode;
 }
@@ -2865,6 +2866,8 @@ _copyIndexStmt(const IndexStmt *from)
      * Copy the hypothetical scalar field to the new IndexStmt
      */
     COPY_SCALAR_FIELD(hypothetical);
+	COPY_SCALAR_FIELD(temporary);
+	COPY_SCALAR_FIELD(oncommitdrop);
 
 	COPY_NODE_FIELD(excludeOpNames);
 	COPY_STRING_FIELD(idxcomment);
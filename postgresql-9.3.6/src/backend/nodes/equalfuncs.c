@@ -1134,6 +1134,7 @@ _equalDropStmt(const DropStmt *a, const DropStmt *b)
 	COMPARE_SCALAR_FIELD(behavior);
 	COMPARE_SCALAR_FIELD(missing_ok);
 	COMPARE_SCALAR_FIELD(concurrent);
+	COMPARE_SCALAR_FIELD(hypothetical);
 
 	return true;
 }
@@ -1198,7 +1199,9 @@ _equalIndexStmt(const IndexStmt *a, const IndexStmt *b)
      * SELF TUNING GROUP - PUC-RIO - 2015
      * Compare the hypothetical scalar field
      */
-    COMPARE_NODE_FIELD(hypothetical);
+    COMPARE_SCALAR_FIELD(hypothetical);
+	COMPARE_SCALAR_FIELD(temporary);
+	COMPARE_SCALAR_FIELD(oncommitdrop);
 
 	COMPARE_NODE_FIELD(excludeOpNames);
 	COMPARE_STRING_FIELD(idxcomment);
@@ -1781,6 +1781,7 @@ _outIndexOptInfo(StringInfo str, const IndexOptInfo *node)
 	WRITE_UINT_FIELD(pages);
 	WRITE_FLOAT_FIELD(tuples, "%.0f");
 	WRITE_INT_FIELD(tree_height);
+	WRITE_FLOAT_FIELD(allvisfrac, "%.6f");
 	WRITE_INT_FIELD(ncolumns);
 	/* array fields aren't really worth the trouble to print */
 	WRITE_OID_FIELD(relam);
@@ -1791,6 +1792,7 @@ _outIndexOptInfo(StringInfo str, const IndexOptInfo *node)
 	WRITE_BOOL_FIELD(unique);
 	WRITE_BOOL_FIELD(immediate);
 	WRITE_BOOL_FIELD(hypothetical);
+	WRITE_BOOL_FIELD(clustered);
 	/* we don't bother with fields copied from the pg_am entry */
 }
 
@@ -2021,6 +2023,9 @@ _outIndexStmt(StringInfo str, const IndexStmt *node)
 	WRITE_NODE_FIELD(indexParams);
 	WRITE_NODE_FIELD(options);
 	WRITE_NODE_FIELD(whereClause);
+	WRITE_BOOL_FIELD(hypothetical);
+	WRITE_BOOL_FIELD(temporary);
+	WRITE_BOOL_FIELD(oncommitdrop);
 	WRITE_NODE_FIELD(excludeOpNames);
 	WRITE_STRING_FIELD(idxcomment);
 	WRITE_OID_FIELD(indexOid);
@@ -26,6 +26,7 @@
 #include "optimizer/clauses.h"
 #include "optimizer/cost.h"
 #include "optimizer/geqo.h"
+#include "optimizer/hypotiming.h"
 #include "optimizer/pathnode.h"
 #include "optimizer/paths.h"
 #include "optimizer/plancat.h"
@@ -134,13 +135,17 @@ make_one_rel(PlannerInfo *root, List *joinlist)
 	/*
 	 * Generate access paths for the base rels.
 	 */
+	hypo_timing_enter(HYPO_PHASE_PATHS);
 	set_base_rel_sizes(root);
 	set_base_rel_pathlists(root);
+	hypo_timing_exit();
 
 	/*
 	 * Generate access paths for the entire join tree.
 	 */
+	hypo_timing_enter(HYPO_PHASE_JOIN_SEARCH);
 	rel = make_rel_from_joinlist(root, joinlist);
+	hypo_timing_exit();
 
 	/*
 	 * The result should join all and only the query's base rels.
@@ -258,6 +258,7 @@ cost_index(IndexPath *path, PlannerInfo *root, double loop_count)
 	Cost		cpu_per_tuple;
 	double		tuples_fetched;
 	double		pages_fetched;
+	double		allvisfrac;
 
 	/* Should only be applied to base relations */
 	Assert(IsA(baserel, RelOptInfo) &&
@@ -319,6 +320,18 @@ cost_index(IndexPath *path, PlannerInfo *root, double loop_count)
 							  &spc_random_page_cost,
 							  &spc_seq_page_cost);
 
+	/*
+	 * HYPOTHETICAL INDEX
+	 * SELF TUNING GROUP - PUC-RIO - 2015
+	 *
+	 * An index-only scan on a hypothetical index skips the heap pages the
+	 * visibility map marks all-visible now, see get_relation_info().
+	 */
+	if (index->hypothetical)
+		allvisfrac = index->allvisfrac;
+	else
+		allvisfrac = baserel->allvisfrac;
+
 	/*----------
 	 * Estimate number of main-table pages fetched, and compute I/O cost.
 	 *
@@ -362,7 +375,7 @@ cost_index(IndexPath *path, PlannerInfo *root, double loop_count)
 											root);
 
 		if (indexonly)
-			pages_fetched = ceil(pages_fetched * (1.0 - baserel->allvisfrac));
+			pages_fetched = ceil(pages_fetched * (1.0 - allvisfrac));
 
 		max_IO_cost = (pages_fetched * spc_random_page_cost) / loop_count;
 
@@ -384,7 +397,7 @@ cost_index(IndexPath *path, PlannerInfo *root, double loop_count)
 											root);
 
 		if (indexonly)
-			pages_fetched = ceil(pages_fetched * (1.0 - baserel->allvisfrac));
+			pages_fetched = ceil(pages_fetched * (1.0 - allvisfrac));
 
 		min_IO_cost = (pages_fetched * spc_random_page_cost) / loop_count;
 	}
@@ -400,7 +413,7 @@ cost_index(IndexPath *path, PlannerInfo *root, double loop_count)
 											root);
 
 		if (indexonly)
-			pages_fetched = ceil(pages_fetched * (1.0 - baserel->allvisfrac));
+			pages_fetched = ceil(pages_fetched * (1.0 - allvisfrac));
 
 		/* max_IO_cost is for the perfectly uncorrelated case (csquared=0) */
 		max_IO_cost = pages_fetched * spc_random_page_cost;
@@ -409,7 +422,7 @@ cost_index(IndexPath *path, PlannerInfo *root, double loop_count)
 		pages_fetched = ceil(indexSelectivity * (double) baserel->pages);
 
 		if (indexonly)
-			pages_fetched = ceil(pages_fetched * (1.0 - baserel->allvisfrac));
+			pages_fetched = ceil(pages_fetched * (1.0 - allvisfrac));
 
 		if (pages_fetched > 0)
 		{
@@ -1279,11 +1292,18 @@ cost_sort(Path *path, PlannerInfo *root,
 		 * We'll have to use a disk-based sort of all the tuples
 		 */
 		double		npages = ceil(input_bytes / BLCKSZ);
-		double		nruns = (input_bytes / sort_mem_bytes) * 0.5;
+		double		nruns = input_bytes / sort_mem_bytes;
 		double		mergeorder = tuplesort_merge_order(sort_mem_bytes);
 		double		log_runs;
 		double		npageaccesses;
 
+		/*
+		 * Replacement selection produces runs about twice the size of
+		 * sort_mem on average; quicksorted runs are just sort_mem.
+		 */
+		if (!sort_multiway_merge)
+			nruns *= 0.5;
+
 		/*
 		 * CPU costs
 		 *
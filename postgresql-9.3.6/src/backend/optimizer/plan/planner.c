@@ -27,6 +27,9 @@
 #endif
 #include "optimizer/clauses.h"
 #include "optimizer/cost.h"
+#include "optimizer/hypoindex.h"
+#include "optimizer/hypotiming.h"
+#include "optimizer/hypoworkload.h"
 #include "optimizer/pathnode.h"
 #include "optimizer/paths.h"
 #include "optimizer/plancat.h"
@@ -67,6 +70,8 @@ typedef struct
 } standard_qp_extra;
 
 /* Local functions */
+static PlannedStmt *planner_internal(Query *parse, int cursorOptions,
+				 ParamListInfo boundParams);
 static Node *preprocess_expression(PlannerInfo *root, Node *expr, int kind);
 static void preprocess_qual_conditions(PlannerInfo *root, Node *jtnode);
 static Plan *inheritance_planner(PlannerInfo *root);
@@ -131,11 +136,76 @@ PlannedStmt *
 planner(Query *parse, int cursorOptions, ParamListInfo boundParams)
 {
 	PlannedStmt *result;
+	bool		hypothetical = parse->hypothetical;
+
+	/*
+	 * HYPOTHETICAL INDEX
+	 * SELF TUNING GROUP - PUC-RIO - 2015
+	 *
+	 * Time the planning by phase when asked to; see hypotiming.c.
+	 */
+	if (!hypo_timing_start())
+		return planner_internal(parse, cursorOptions, boundParams);
+
+	PG_TRY();
+	{
+		result = planner_internal(parse, cursorOptions, boundParams);
+	}
+	PG_CATCH();
+	{
+		hypo_timing_abort();
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	hypo_timing_finish(hypothetical);
+
+	return result;
+}
+
+/*
+ * planner_internal
+ *		planner() proper: consult the hypothetical plan cache, then call the
+ *		hook or standard_planner().
+ */
+static PlannedStmt *
+planner_internal(Query *parse, int cursorOptions, ParamListInfo boundParams)
+{
+	PlannedStmt *result;
+	char	   *cachekey = NULL;
+	Oid		   *cacherelids = NULL;
+	int			cachenrelids = 0;
+
+	/*
+	 * HYPOTHETICAL INDEX
+	 * SELF TUNING GROUP - PUC-RIO - 2015
+	 *
+	 * Hypothetical planning of the same query under an unchanged index set
+	 * reuses the previous plan; see hypoplancache.c.  A planner_hook must
+	 * see every query, so nothing is cached while one is installed.
+	 */
+	if (parse->hypothetical && boundParams == NULL &&
+		hypothetical_plan_cache_size > 0 && planner_hook == NULL)
+	{
+		cachekey = hypo_plan_cache_key(parse, cursorOptions,
+									   &cacherelids, &cachenrelids);
+		result = hypo_plan_cache_lookup(cachekey);
+		if (result != NULL)
+		{
+			result->queryId = parse->queryId;
+			hypo_timing_cached();
+			return result;
+		}
+	}
 
 	if (planner_hook)
 		result = (*planner_hook) (parse, cursorOptions, boundParams);
 	else
 		result = standard_planner(parse, cursorOptions, boundParams);
+
+	if (cachekey != NULL)
+		hypo_plan_cache_store(cachekey, cacherelids, cachenrelids, result);
+
 	return result;
 }
 
@@ -155,6 +225,19 @@ standard_planner(Query *parse, int cursorOptions, ParamListInfo boundParams)
 		IsA(parse->utilityStmt, DeclareCursorStmt))
 		cursorOptions |= ((DeclareCursorStmt *) parse->utilityStmt)->options;
 
+	/*
+	 * HYPOTHETICAL INDEX
+	 * SELF TUNING GROUP - PUC-RIO - 2015
+	 *
+	 * When capturing the workload for the index advisor, identify the
+	 * statement by a fingerprint ignoring constants, unless a plugin has
+	 * already given it a queryId.  The PlannedStmt carries it on to
+	 * ExecutorEnd, which counts the executions.
+	 */
+	if (hypothetical_workload_entries > 0 && !parse->hypothetical &&
+		parse->queryId == 0)
+		parse->queryId = hypo_workload_query_id(parse);
+
 	/*
 	 * Set up global state for this planner invocation.  This data is needed
 	 * across all levels of sub-Query that might exist in the given command,
@@ -209,6 +292,9 @@ standard_planner(Query *parse, int cursorOptions, ParamListInfo boundParams)
 	top_plan = subquery_planner(glob, parse, NULL,
 								false, tuple_fraction, &root);
 
+	if (hypothetical_workload_entries > 0 && !parse->hypothetical)
+		hypo_workload_capture(root, parse->queryId);
+
 	/*
 	 * If creating a plan for a scrollable cursor, make sure it can run
 	 * backwards on demand.  Add a Material node at the top at need.
@@ -223,6 +309,7 @@ standard_planner(Query *parse, int cursorOptions, ParamListInfo boundParams)
 	Assert(glob->finalrtable == NIL);
 	Assert(glob->finalrowmarks == NIL);
 	Assert(glob->resultRelations == NIL);
+	hypo_timing_enter(HYPO_PHASE_SETREFS);
 	top_plan = set_plan_references(root, top_plan);
 	/* ... and the subplans (both regular subplans and initplans) */
 	Assert(list_length(glob->subplans) == list_length(glob->subroots));
@@ -233,6 +320,7 @@ standard_planner(Query *parse, int cursorOptions, ParamListInfo boundParams)
 
 		lfirst(lp) = set_plan_references(subroot, subplan);
 	}
+	hypo_timing_exit();
 
 	/* build the PlannedStmt result */
 	result = makeNode(PlannedStmt);
@@ -240,6 +328,7 @@ standard_planner(Query *parse, int cursorOptions, ParamListInfo boundParams)
 	result->commandType = parse->commandType;
    
 	result->queryId = parse->queryId;
+	result->hypothetical = parse->hypothetical;
 	result->hasReturning = (parse->returningList != NIL);
 	result->hasModifyingCTE = parse->hasModifyingCTE;
 	result->canSetTag = parse->canSetTag;
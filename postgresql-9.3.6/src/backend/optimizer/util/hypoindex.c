@@ -0,0 +1,2244 @@
+/*-------------------------------------------------------------------------
+ *
+ * hypoindex.c
+ *	  Session-private hypothetical indexes.
+ *
+ * HYPOTHETICAL INDEX
+ * SELF TUNING GROUP - PUC-RIO - 2015
+ *
+ * A catalog hypothetical index is a real pg_class/pg_index entry flagged with
+ * indishypothetical, so creating one costs WAL, catalog bloat and a relcache
+ * invalidation broadcast.  Index advisors create and drop thousands of
+ * candidates per tuning run, so when hypothetical_index_private is on,
+ * CREATE HYPOTHETICAL INDEX instead keeps the definition in backend memory.
+ * get_relation_info() turns these entries into IndexOptInfos for EXPLAIN
+ * HYPOTHETICAL, and nothing outside this backend ever learns about them.
+ *
+ * Private indexes are not transactional: they survive ROLLBACK and vanish
+ * when the session ends.
+ *
+ * Portions Copyright (c) 1996-2013, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/optimizer/util/hypoindex.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <math.h>
+
+#include "access/gin_private.h"
+#include "access/gist_private.h"
+#include "access/hash.h"
+#include "access/htup_details.h"
+#include "access/itup.h"
+#include "access/nbtree.h"
+#include "access/reloptions.h"
+#include "access/spgist.h"
+#include "access/sysattr.h"
+#include "access/transam.h"
+#include "access/tuptoaster.h"
+#include "access/visibilitymap.h"
+#include "access/xlog.h"
+#include "catalog/heap.h"
+#include "catalog/namespace.h"
+#include "catalog/pg_am.h"
+#include "catalog/pg_statistic.h"
+#include "catalog/pg_type.h"
+#include "commands/defrem.h"
+#include "commands/vacuum.h"
+#include "executor/executor.h"
+#include "nodes/makefuncs.h"
+#include "nodes/nodeFuncs.h"
+#include "optimizer/clauses.h"
+#include "optimizer/cost.h"
+#include "optimizer/hypoindex.h"
+#include "optimizer/pathnode.h"
+#include "optimizer/plancat.h"
+#include "optimizer/planmain.h"
+#include "optimizer/prep.h"
+#include "optimizer/var.h"
+#include "rewrite/rewriteManip.h"
+#include "storage/shmem.h"
+#include "storage/spin.h"
+#include "utils/builtins.h"
+#include "utils/datum.h"
+#include "utils/inval.h"
+#include "utils/guc.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+#include "utils/rel.h"
+#include "utils/sortsupport.h"
+#include "utils/syscache.h"
+
+
+/* GUC parameters */
+bool		hypothetical_index_private = false;
+char	   *hypothetical_disabled_indexes = NULL;
+
+/* All private hypothetical indexes of this session, in creation order */
+static List *hypoIndexes = NIL;
+
+/* OIDs of the private indexes created ON COMMIT DROP in this transaction */
+static List *hypoDropAtEOXact = NIL;
+
+/* Parent of the per-index memory contexts */
+static MemoryContext HypoIndexContext = NULL;
+
+/*
+ * While hypoVisibleOverride is set, the planner only sees the private
+ * indexes whose OIDs are in hypoVisibleOids.
+ */
+static bool hypoVisibleOverride = false;
+static List *hypoVisibleOids = NIL;
+
+/* Next fake OID to hand out, counting down from the top of the OID space */
+static Oid	hypoNextOid = OID_MAX;
+
+/* OIDs of the indexes hypothetical_disabled_indexes names, if valid */
+static List *hypoDisabledOids = NIL;
+static bool hypoDisabledValid = false;
+static bool hypoDisabledCallbackRegistered = false;
+
+/* rows sampled to estimate the width of an expression column */
+#define HYPO_EXPR_SAMPLE_ROWS	300
+
+/*
+ * Width and null fraction of a variable-width index expression, estimated
+ * from a sample of the table the first time an index on it is sized.
+ * Dropped on relcache invalidation of the table, which ANALYZE causes.
+ */
+typedef struct HypoExprStats
+{
+	Oid			relid;			/* table */
+	char	   *expr;			/* nodeToString() of the expression */
+	int32		width;			/* average width of non-null values */
+	double		nullfrac;		/* fraction of nulls */
+} HypoExprStats;
+
+/* rows sampled to estimate the statistics of a key combination */
+#define HYPO_KEY_SAMPLE_ROWS	(300 * default_statistics_target)
+
+/*
+ * Distinct counts and ordering correlation of the leading plain columns of
+ * a hypothetical index, estimated from a sample of the table the first time
+ * the planner costs a scan of it.  Dropped along with HypoExprStats.
+ */
+typedef struct HypoKeyStats
+{
+	Oid			relid;			/* table */
+	HypoKeyOrder key;			/* columns sampled */
+	HypoKeyOrder physical;		/* hypothetical table order, if nkeys > 0 */
+	double		ndistinct[INDEX_MAX_KEYS];	/* of each prefix, as stadistinct */
+	double		correlation;	/* of the order of all key columns */
+} HypoKeyStats;
+
+/* one sampled row, for sorting by the key or physical order columns */
+typedef struct HypoKeySample
+{
+	Datum	   *values;			/* of the key columns */
+	bool	   *isnull;
+	Datum	   *physvalues;		/* of the physical order columns */
+	bool	   *physisnull;
+	int			tupno;			/* position in the table order */
+} HypoKeySample;
+
+/* how to sort HypoKeySamples, see hypo_key_sample_cmp */
+typedef struct HypoKeySortState
+{
+	int			nkeys;
+	SortSupport ssup;
+	bool		physical;		/* sort by the physical order columns? */
+} HypoKeySortState;
+
+static List *hypoExprStats = NIL;
+static List *hypoKeyStats = NIL;
+static MemoryContext HypoExprStatsContext = NULL;
+
+static Oid	hypo_index_new_oid(void);
+static HypoIndex *hypo_index_find_by_name(const char *indexname);
+static void hypo_index_forget(HypoIndex *entry);
+static void hypo_index_disabled_callback(Datum arg, Oid relid);
+static double hypo_index_tuple_width(Relation heapRelation, int ncolumns,
+					   const int *indexkeys, List *indexprs);
+static void hypo_expr_stats(Relation heapRelation, Node *expr,
+				int32 *width, double *nullfrac);
+static bool hypo_key_order_equal(const HypoKeyOrder *a,
+					 const HypoKeyOrder *b);
+static HypoKeyStats *hypo_key_stats_sample(Relation heapRelation,
+					  const HypoKeyOrder *key,
+					  const HypoKeyOrder *physical);
+static SortSupport hypo_key_sort_support(Relation heapRelation,
+					  const HypoKeyOrder *order, MemoryContext cxt);
+static int	hypo_key_sample_cmp(const void *a, const void *b, void *arg);
+static MemoryContext hypo_sample_stats_context(void);
+static void hypo_sample_stats_callback(Datum arg, Oid relid);
+static const HypoAmModel *hypo_index_am_model(Oid relam);
+static void hypo_tree_estimate_size(Relation heapRelation, Oid relam,
+						int ncolumns, const int *indexkeys, List *indexprs,
+						int fillfactor, double tuples,
+						BlockNumber *pages, int *tree_height);
+static void hypo_hash_estimate_size(Relation heapRelation, Oid relam,
+						int ncolumns, const int *indexkeys, List *indexprs,
+						int fillfactor, double tuples,
+						BlockNumber *pages, int *tree_height);
+static void hypo_gin_estimate_size(Relation heapRelation, Oid relam,
+					   int ncolumns, const int *indexkeys, List *indexprs,
+					   int fillfactor, double tuples,
+					   BlockNumber *pages, int *tree_height);
+static void hypo_gin_get_stats(Relation heapRelation, Oid relam,
+				   int ncolumns, const int *indexkeys, List *indexprs,
+				   double tuples, void *result);
+
+/* Size and statistics models of the built-in access methods */
+static const HypoAmModel hypoBuiltinAmModels[] = {
+	{BTREE_AM_OID, hypo_tree_estimate_size, NULL},
+	{HASH_AM_OID, hypo_hash_estimate_size, NULL},
+	{GIST_AM_OID, hypo_tree_estimate_size, NULL},
+	{SPGIST_AM_OID, hypo_tree_estimate_size, NULL},
+	{GIN_AM_OID, hypo_gin_estimate_size, hypo_gin_get_stats}
+};
+
+/* Models registered by hypo_index_register_am() */
+static List *hypoAmModels = NIL;
+
+
+/*
+ * hypo_index_store
+ *		Remember a new private hypothetical index and return its fake OID.
+ *
+ * The arguments are what DefineIndex() has computed for index_create(), so
+ * all of the usual validation (columns, opclasses, collations, predicate and
+ * reloptions) has already happened.  If the caller chose the name itself
+ * (name_given is false) we quietly make it unique; otherwise a clash with a
+ * relation or another private index is an error, as for a real index.
+ */
+Oid
+hypo_index_store(Relation heapRelation,
+				 const char *indexRelationName,
+				 bool name_given,
+				 IndexInfo *indexInfo,
+				 Oid accessMethodId,
+				 Oid tableSpaceId,
+				 Oid *collationObjectId,
+				 Oid *classObjectId,
+				 int16 *coloptions,
+				 Datum reloptions)
+{
+	Oid			namespaceId = RelationGetNamespace(heapRelation);
+	int			ncolumns = indexInfo->ii_NumIndexAttrs;
+	HeapTuple	tuple;
+	Form_pg_am	amform;
+	MemoryContext indexcxt;
+	MemoryContext oldcxt;
+	HypoIndex  *entry;
+	char	   *indexname;
+	List	   *indexprs;
+	List	   *indpred;
+	int			i;
+
+	tuple = SearchSysCache1(AMOID, ObjectIdGetDatum(accessMethodId));
+	if (!HeapTupleIsValid(tuple))
+		elog(ERROR, "cache lookup failed for access method %u",
+			 accessMethodId);
+	amform = (Form_pg_am) GETSTRUCT(tuple);
+
+	/* Pick the name */
+	indexname = pstrdup(indexRelationName);
+	if (hypo_index_find_by_name(indexname) != NULL ||
+		OidIsValid(get_relname_relid(indexname, namespaceId)))
+	{
+		int			pass = 0;
+
+		if (name_given)
+			ereport(ERROR,
+					(errcode(ERRCODE_DUPLICATE_TABLE),
+					 errmsg("relation \"%s\" already exists",
+							indexRelationName)));
+
+		for (;;)
+		{
+			char		modlabel[NAMEDATALEN];
+
+			snprintf(modlabel, sizeof(modlabel), "%d", ++pass);
+			indexname = makeObjectName(indexRelationName, NULL, modlabel);
+			if (hypo_index_find_by_name(indexname) == NULL &&
+				!OidIsValid(get_relname_relid(indexname, namespaceId)))
+				break;
+			pfree(indexname);
+		}
+	}
+
+	/*
+	 * Preprocess expressions and predicate the same way the relcache does
+	 * for pg_index.indexprs and pg_index.indpred, so that the planner can
+	 * match them against similarly-processed qual clauses.
+	 */
+	indexprs = (List *) eval_const_expressions(NULL,
+										(Node *) indexInfo->ii_Expressions);
+	fix_opfuncids((Node *) indexprs);
+
+	indpred = NIL;
+	if (indexInfo->ii_Predicate != NIL)
+	{
+		Expr	   *pred = make_ands_explicit(indexInfo->ii_Predicate);
+
+		pred = (Expr *) eval_const_expressions(NULL, (Node *) pred);
+		pred = canonicalize_qual(pred);
+		indpred = make_ands_implicit(pred);
+		fix_opfuncids((Node *) indpred);
+	}
+
+	/* Everything about the entry lives in its own small context */
+	if (HypoIndexContext == NULL)
+		HypoIndexContext = AllocSetContextCreate(TopMemoryContext,
+												 "Hypothetical indexes",
+												 ALLOCSET_SMALL_MINSIZE,
+												 ALLOCSET_SMALL_INITSIZE,
+												 ALLOCSET_SMALL_MAXSIZE);
+	indexcxt = AllocSetContextCreate(HypoIndexContext,
+									 indexname,
+									 ALLOCSET_SMALL_MINSIZE,
+									 ALLOCSET_SMALL_INITSIZE,
+									 ALLOCSET_SMALL_MAXSIZE);
+	oldcxt = MemoryContextSwitchTo(indexcxt);
+
+	entry = (HypoIndex *) palloc0(sizeof(HypoIndex));
+
+	entry->oid = hypo_index_new_oid();
+	entry->name = pstrdup(indexname);
+	entry->relid = RelationGetRelid(heapRelation);
+	entry->relam = accessMethodId;
+	entry->reltablespace = tableSpaceId;
+	entry->ncolumns = ncolumns;
+	entry->indexkeys = (int *) palloc(sizeof(int) * ncolumns);
+	entry->keytypes = (Oid *) palloc(sizeof(Oid) * ncolumns);
+	entry->indexcollations = (Oid *) palloc(sizeof(Oid) * ncolumns);
+	entry->opfamily = (Oid *) palloc(sizeof(Oid) * ncolumns);
+	entry->opcintype = (Oid *) palloc(sizeof(Oid) * ncolumns);
+	entry->indoption = (int16 *) palloc(sizeof(int16) * ncolumns);
+
+	for (i = 0; i < ncolumns; i++)
+	{
+		AttrNumber	attnum = indexInfo->ii_KeyAttrNumbers[i];
+
+		entry->indexkeys[i] = attnum;
+		if (attnum > 0)
+			entry->keytypes[i] =
+				heapRelation->rd_att->attrs[attnum - 1]->atttypid;
+		else
+			entry->keytypes[i] = InvalidOid;
+		entry->indexcollations[i] = collationObjectId[i];
+		entry->opfamily[i] = get_opclass_family(classObjectId[i]);
+		entry->opcintype[i] = get_opclass_input_type(classObjectId[i]);
+		entry->indoption[i] = coloptions[i];
+	}
+
+	entry->indexprs = (List *) copyObject(indexprs);
+	entry->indpred = (List *) copyObject(indpred);
+	entry->unique = indexInfo->ii_Unique;
+	entry->clustered = indexInfo->ii_Clustered;
+	if (reloptions != (Datum) 0)
+		entry->reloptions = datumCopy(reloptions, false, -1);
+	entry->fillfactor =
+		hypo_index_fillfactor(accessMethodId,
+							  index_reloptions(amform->amoptions, reloptions,
+											   false));
+
+	entry->amcostestimate = amform->amcostestimate;
+	entry->amcanorder = amform->amcanorder;
+	entry->amcanorderbyop = amform->amcanorderbyop;
+	entry->amoptionalkey = amform->amoptionalkey;
+	entry->amsearcharray = amform->amsearcharray;
+	entry->amsearchnulls = amform->amsearchnulls;
+	entry->amhasgettuple = OidIsValid(amform->amgettuple);
+	entry->amhasgetbitmap = OidIsValid(amform->amgetbitmap);
+
+	entry->canreturn =
+		hypo_index_can_return(accessMethodId, entry->opfamily[0],
+							  entry->opcintype[0],
+							  (entry->indexkeys[0] != 0) ? entry->keytypes[0] :
+							  exprType((Node *) linitial(entry->indexprs)),
+							  entry->indexcollations[0]);
+
+	MemoryContextSwitchTo(HypoIndexContext);
+	hypoIndexes = lappend(hypoIndexes, entry);
+	MemoryContextSwitchTo(oldcxt);
+
+	ReleaseSysCache(tuple);
+
+	return entry->oid;
+}
+
+/*
+ * hypo_index_remove
+ *		Forget the private hypothetical index of the given name.
+ *
+ * Returns false if there is no such index, so that the caller can go on to
+ * look for a catalog hypothetical index.
+ */
+bool
+hypo_index_remove(const char *schemaname, const char *indexname)
+{
+	HypoIndex  *entry = hypo_index_lookup(schemaname, indexname);
+
+	if (entry == NULL)
+		return false;
+
+	hypo_index_forget(entry);
+	return true;
+}
+
+/*
+ * hypo_index_remove_oid
+ *		Forget the private hypothetical index with the given fake OID.
+ */
+bool
+hypo_index_remove_oid(Oid indexoid)
+{
+	HypoIndex  *entry = hypo_index_find(indexoid);
+
+	if (entry == NULL)
+		return false;
+
+	hypo_index_forget(entry);
+	return true;
+}
+
+/*
+ * hypo_index_remove_all
+ *		Forget every private hypothetical index, returning how many there
+ *		were.
+ */
+int
+hypo_index_remove_all(void)
+{
+	int			count = list_length(hypoIndexes);
+
+	while (hypoIndexes != NIL)
+		hypo_index_forget((HypoIndex *) linitial(hypoIndexes));
+
+	return count;
+}
+
+/*
+ * hypo_index_drop_at_eoxact
+ *		Forget the given private index when the transaction ends.
+ *
+ * This is ON COMMIT DROP for private indexes.  They don't take part in
+ * rollback, so they are forgotten at abort too, as if the creation had
+ * been rolled back.
+ */
+void
+hypo_index_drop_at_eoxact(Oid indexoid)
+{
+	MemoryContext oldcxt;
+
+	oldcxt = MemoryContextSwitchTo(TopMemoryContext);
+	hypoDropAtEOXact = lappend_oid(hypoDropAtEOXact, indexoid);
+	MemoryContextSwitchTo(oldcxt);
+}
+
+/*
+ * hypo_index_set_visible
+ *		Restrict the private indexes the planner sees to the given OIDs.
+ *
+ * This lets a caller cost several index configurations without creating
+ * and dropping indexes in between; NIL hides every private index.  Undo
+ * with hypo_index_reset_visible(), also on error.
+ */
+void
+hypo_index_set_visible(List *indexoids)
+{
+	MemoryContext oldcxt;
+
+	list_free(hypoVisibleOids);
+	oldcxt = MemoryContextSwitchTo(TopMemoryContext);
+	hypoVisibleOids = list_copy(indexoids);
+	MemoryContextSwitchTo(oldcxt);
+	hypoVisibleOverride = true;
+}
+
+/*
+ * hypo_index_reset_visible
+ *		Make all private indexes visible to the planner again.
+ */
+void
+hypo_index_reset_visible(void)
+{
+	list_free(hypoVisibleOids);
+	hypoVisibleOids = NIL;
+	hypoVisibleOverride = false;
+}
+
+/*
+ * hypo_index_is_disabled
+ *		Is indexoid one of the indexes hypothetical_disabled_indexes names?
+ *
+ * Hypothetical planning leaves those out, to show what dropping them
+ * would do.  The names are resolved to OIDs on first use after the setting
+ * or search_path changes or a relcache invalidation, which covers the
+ * indexes being dropped, renamed or created; names of no index are
+ * ignored, much as in search_path.
+ */
+bool
+hypo_index_is_disabled(Oid indexoid)
+{
+	if (hypothetical_disabled_indexes == NULL ||
+		hypothetical_disabled_indexes[0] == '\0')
+		return false;
+
+	if (!hypoDisabledValid)
+	{
+		char	   *rawname = pstrdup(hypothetical_disabled_indexes);
+		List	   *namelist;
+		List	   *oids = NIL;
+		ListCell   *lc;
+		MemoryContext oldcxt;
+
+		/* the check hook has made sure this works */
+		if (!SplitIdentifierString(rawname, ',', &namelist))
+			elog(ERROR, "invalid list syntax in hypothetical_disabled_indexes");
+
+		foreach(lc, namelist)
+		{
+			char	   *name = (char *) lfirst(lc);
+			char	   *dot;
+			RangeVar   *rv;
+			Oid			relid;
+
+			/*
+			 * SplitIdentifierString has already downcased and dequoted the
+			 * element, so only the schema qualification is left to split off.
+			 */
+			dot = strrchr(name, '.');
+			if (dot != NULL)
+			{
+				*dot = '\0';
+				rv = makeRangeVar(name, dot + 1, -1);
+			}
+			else
+				rv = makeRangeVar(NULL, name, -1);
+			relid = RangeVarGetRelid(rv, NoLock, true);
+			if (OidIsValid(relid) && get_rel_relkind(relid) == RELKIND_INDEX)
+				oids = lappend_oid(oids, relid);
+		}
+
+		if (!hypoDisabledCallbackRegistered)
+		{
+			CacheRegisterRelcacheCallback(hypo_index_disabled_callback,
+										  (Datum) 0);
+			hypoDisabledCallbackRegistered = true;
+		}
+
+		list_free(hypoDisabledOids);
+		oldcxt = MemoryContextSwitchTo(TopMemoryContext);
+		hypoDisabledOids = list_copy(oids);
+		MemoryContextSwitchTo(oldcxt);
+		hypoDisabledValid = true;
+
+		list_free(oids);
+		list_free(namelist);
+		pfree(rawname);
+	}
+
+	return list_member_oid(hypoDisabledOids, indexoid);
+}
+
+/*
+ * check_hook for hypothetical_disabled_indexes: the value must be a list
+ * of index names.  Whether they name indexes is only known at plan time.
+ */
+bool
+check_hypothetical_disabled_indexes(char **newval, void **extra,
+									GucSource source)
+{
+	char	   *rawname = pstrdup(*newval);
+	List	   *namelist;
+	bool		result;
+
+	result = SplitIdentifierString(rawname, ',', &namelist);
+	if (!result)
+		GUC_check_errdetail("List syntax is invalid.");
+
+	list_free(namelist);
+	pfree(rawname);
+	return result;
+}
+
+/*
+ * assign_hook for hypothetical_disabled_indexes
+ */
+void
+assign_hypothetical_disabled_indexes(const char *newval, void *extra)
+{
+	hypoDisabledValid = false;
+}
+
+/*
+ * hypo_index_invalidate_disabled
+ *		Resolve the disabled index names again on their next use.
+ *
+ * Called from the search_path assign hook, since unqualified names may now
+ * name other indexes.
+ */
+void
+hypo_index_invalidate_disabled(void)
+{
+	hypoDisabledValid = false;
+}
+
+/*
+ * Relcache invalidation callback: resolve the disabled index names again.
+ */
+static void
+hypo_index_disabled_callback(Datum arg, Oid relid)
+{
+	hypoDisabledValid = false;
+}
+
+/*
+ * hypo_index_lookup
+ *		Look up a private hypothetical index by name, or return NULL.
+ *
+ * If schemaname is given, the index's table must be in that schema.
+ */
+HypoIndex *
+hypo_index_lookup(const char *schemaname, const char *indexname)
+{
+	HypoIndex  *entry = hypo_index_find_by_name(indexname);
+
+	if (entry == NULL)
+		return NULL;
+
+	if (schemaname != NULL &&
+		get_rel_namespace(entry->relid) != LookupExplicitNamespace(schemaname, true))
+		return NULL;
+
+	return entry;
+}
+
+/*
+ * hypo_index_new_oid
+ *		Choose the fake OID of a new private hypothetical index.
+ *
+ * The OID only has to be distinct from every relation OID, so that EXPLAIN
+ * and the statistics lookups in selfuncs.c never confuse a private index
+ * with a real one.  GetNewObjectId() would guarantee that, but it advances
+ * the shared counter and WAL-logs XLOG_NEXTOID, which a hot standby cannot
+ * do.  Instead each backend counts down from the top of the OID space, far
+ * from where the shared counter normally is, and skips any OID pg_class or
+ * another private index already has.
+ */
+static Oid
+hypo_index_new_oid(void)
+{
+	for (;;)
+	{
+		Oid			oid = hypoNextOid--;
+
+		if (hypoNextOid < FirstNormalObjectId)
+			hypoNextOid = OID_MAX;
+
+		if (!SearchSysCacheExists1(RELOID, ObjectIdGetDatum(oid)) &&
+			hypo_index_find(oid) == NULL)
+			return oid;
+	}
+}
+
+/*
+ * hypo_index_find
+ *		Look up a private hypothetical index by its fake OID.
+ */
+HypoIndex *
+hypo_index_find(Oid indexoid)
+{
+	ListCell   *lc;
+
+	foreach(lc, hypoIndexes)
+	{
+		HypoIndex  *entry = (HypoIndex *) lfirst(lc);
+
+		if (entry->oid == indexoid)
+			return entry;
+	}
+	return NULL;
+}
+
+/*
+ * hypo_index_list_for_relation
+ *		Return the private hypothetical indexes that can be used on a table.
+ *
+ * Entries are matched by table OID, so one that references a column the
+ * table no longer has (or no longer has with the same type) is the leftover
+ * of a DROP/ALTER and is skipped.
+ */
+List *
+hypo_index_list_for_relation(Relation heapRelation)
+{
+	Oid			relid = RelationGetRelid(heapRelation);
+	int			natts = RelationGetNumberOfAttributes(heapRelation);
+	List	   *result = NIL;
+	ListCell   *lc;
+
+	foreach(lc, hypoIndexes)
+	{
+		HypoIndex  *entry = (HypoIndex *) lfirst(lc);
+		bool		usable = true;
+		int			i;
+
+		if (entry->relid != relid)
+			continue;
+		if (hypoVisibleOverride &&
+			!list_member_oid(hypoVisibleOids, entry->oid))
+			continue;
+
+		for (i = 0; i < entry->ncolumns; i++)
+		{
+			AttrNumber	attnum = entry->indexkeys[i];
+			Form_pg_attribute attr;
+
+			if (attnum <= 0)
+				continue;
+			if (attnum > natts)
+			{
+				usable = false;
+				break;
+			}
+			attr = heapRelation->rd_att->attrs[attnum - 1];
+			if (attr->attisdropped || attr->atttypid != entry->keytypes[i])
+			{
+				usable = false;
+				break;
+			}
+		}
+
+		if (usable)
+			result = lappend(result, entry);
+	}
+	return result;
+}
+
+/*
+ * hypo_index_forget
+ *		Unlink a private index and free everything it uses.
+ */
+static void
+hypo_index_forget(HypoIndex *entry)
+{
+	hypoIndexes = list_delete_ptr(hypoIndexes, entry);
+	hypoVisibleOids = list_delete_oid(hypoVisibleOids, entry->oid);
+	MemoryContextDelete(GetMemoryChunkContext(entry));
+}
+
+/*
+ * hypo_index_find_by_name
+ *		Private index names are unique across the whole session.
+ */
+static HypoIndex *
+hypo_index_find_by_name(const char *indexname)
+{
+	ListCell   *lc;
+
+	foreach(lc, hypoIndexes)
+	{
+		HypoIndex  *entry = (HypoIndex *) lfirst(lc);
+
+		if (strcmp(entry->name, indexname) == 0)
+			return entry;
+	}
+	return NULL;
+}
+
+/*
+ * hypo_index_fillfactor
+ *		Fill factor a hypothetical index would be built with.
+ *
+ * options is the parsed reloptions of the index, or NULL to get the access
+ * method's default.
+ */
+int
+hypo_index_fillfactor(Oid relam, bytea *options)
+{
+	int			defaultff;
+
+	switch (relam)
+	{
+		case BTREE_AM_OID:
+			defaultff = BTREE_DEFAULT_FILLFACTOR;
+			break;
+		case HASH_AM_OID:
+			defaultff = HASH_DEFAULT_FILLFACTOR;
+			break;
+		case GIST_AM_OID:
+			defaultff = GIST_DEFAULT_FILLFACTOR;
+			break;
+		case SPGIST_AM_OID:
+			defaultff = SPGIST_DEFAULT_FILLFACTOR;
+			break;
+		default:
+			/* GIN has no fillfactor option */
+			return 100;
+	}
+
+	/* these AMs all keep their options in StdRdOptions format */
+	return options ? ((StdRdOptions *) options)->fillfactor : defaultff;
+}
+
+/*
+ * hypo_index_can_return
+ *		Could a hypothetical index give back the values of its first column,
+ *		allowing index-only scans?
+ *
+ * amcanreturn takes the index relation, and spgcanreturn even reads the
+ * metapage, so it can't be asked about an index that has no storage.  We
+ * answer for it: btree always can, and SP-GiST can when the operator
+ * class's config function says so.  Other access methods are assumed not
+ * to.  atttype and collation are those of the index's only column, which
+ * is all SP-GiST supports.
+ */
+bool
+hypo_index_can_return(Oid relam, Oid opfamily, Oid opcintype, Oid atttype,
+					  Oid collation)
+{
+	Oid			configproc;
+	spgConfigIn in;
+	spgConfigOut out;
+
+	if (relam == BTREE_AM_OID)
+		return true;
+	if (relam != SPGIST_AM_OID)
+		return false;
+
+	configproc = get_opfamily_proc(opfamily, opcintype, opcintype,
+								   SPGIST_CONFIG_PROC);
+	if (!OidIsValid(configproc))
+		return false;
+
+	memset(&in, 0, sizeof(in));
+	memset(&out, 0, sizeof(out));
+	in.attType = atttype;
+	OidFunctionCall2Coll(configproc, collation,
+						 PointerGetDatum(&in), PointerGetDatum(&out));
+
+	return out.canReturnData;
+}
+
+/*
+ * hypo_index_allvisfrac
+ *		Fraction of the table's pages the visibility map has marked
+ *		all-visible right now.
+ *
+ * pg_class.relallvisible is only as recent as the last VACUUM, and a table
+ * that has only been read by sequential scans or bitmap scans gives no
+ * reason to keep it tidy.  An index-only scan on a hypothetical index is
+ * only worth what the heap fetches it saves, so count the visibility map
+ * instead; each map page covers some 65000 table pages.
+ */
+double
+hypo_index_allvisfrac(Relation heapRelation)
+{
+	BlockNumber nblocks = RelationGetNumberOfBlocks(heapRelation);
+	BlockNumber nallvisible;
+
+	if (nblocks == 0)
+		return 0;
+
+	nallvisible = visibilitymap_count(heapRelation);
+	if (nallvisible >= nblocks)
+		return 1;
+	return (double) nallvisible / nblocks;
+}
+
+/*
+ * hypo_index_tuple_width
+ *		Estimate the average size of one index tuple, line pointer included.
+ *
+ * Column widths and null fractions come from pg_statistic when the table
+ * has been analyzed, else from the type's typical width.  Expression columns
+ * of a fixed-width type take the type's width; variable-width ones are
+ * sampled by hypo_expr_stats().  We follow index_form_tuple(): short
+ * varlenas are stored unaligned with a 1-byte header, everything else at its
+ * typalign, and only tuples having a null get the null bitmap.
+ */
+static double
+hypo_index_tuple_width(Relation heapRelation, int ncolumns,
+					   const int *indexkeys, List *indexprs)
+{
+	Oid			relid = RelationGetRelid(heapRelation);
+	ListCell   *indexpr_item = list_head(indexprs);
+	Size		fullwidth = 0;	/* data width when no column is null */
+	double		datawidth = 0;	/* average data width */
+	double		nonullfrac = 1.0;	/* fraction of tuples without nulls */
+	double		nullwidth;
+	double		result;
+	int			i;
+
+	for (i = 0; i < ncolumns; i++)
+	{
+		AttrNumber	attnum = indexkeys[i];
+		int32		width;
+		double		nullfrac = 0.0;
+		int16		typlen;
+		char		typalign;
+
+		if (attnum != 0)
+		{
+			HeapTuple	statsTuple = NULL;
+
+			if (attnum > 0)
+			{
+				Form_pg_attribute attr = heapRelation->rd_att->attrs[attnum - 1];
+
+				typlen = attr->attlen;
+				typalign = attr->attalign;
+				width = get_typavgwidth(attr->atttypid, attr->atttypmod);
+			}
+			else
+			{
+				Form_pg_attribute attr = SystemAttributeDefinition(attnum,
+									heapRelation->rd_rel->relhasoids);
+
+				typlen = attr->attlen;
+				typalign = attr->attalign;
+				width = typlen;
+			}
+
+			statsTuple = SearchSysCache3(STATRELATTINH,
+										 ObjectIdGetDatum(relid),
+										 Int16GetDatum(attnum),
+										 BoolGetDatum(false));
+			if (HeapTupleIsValid(statsTuple))
+			{
+				Form_pg_statistic stats;
+
+				stats = (Form_pg_statistic) GETSTRUCT(statsTuple);
+				if (stats->stawidth > 0)
+					width = stats->stawidth;
+				nullfrac = stats->stanullfrac;
+				ReleaseSysCache(statsTuple);
+			}
+		}
+		else
+		{
+			Node	   *indexkey;
+			bool		typbyval;
+
+			if (indexpr_item == NULL)
+				elog(ERROR, "too few entries in indexprs list");
+			indexkey = (Node *) lfirst(indexpr_item);
+			indexpr_item = lnext(indexpr_item);
+
+			get_typlenbyvalalign(exprType(indexkey), &typlen, &typbyval,
+								 &typalign);
+			if (typlen > 0)
+				width = typlen;
+			else
+				hypo_expr_stats(heapRelation, indexkey, &width, &nullfrac);
+		}
+
+		nonullfrac *= (1.0 - nullfrac);
+
+		/* alignment padding is only paid for by non-null values */
+		if (typlen == -1 && width <= VARATT_SHORT_MAX)
+		{
+			fullwidth += width;
+			datawidth += (1.0 - nullfrac) * width;
+		}
+		else
+		{
+			fullwidth = att_align_nominal(fullwidth, typalign) + width;
+			datawidth += (1.0 - nullfrac) *
+				(att_align_nominal(datawidth, typalign) - datawidth + width);
+		}
+	}
+
+	/*
+	 * Tuples without nulls have fullwidth bytes of data; the rest have the
+	 * remainder of the average, which works out to nothing for a single
+	 * column.
+	 */
+	result = nonullfrac * MAXALIGN(sizeof(IndexTupleData) + fullwidth);
+	if (nonullfrac < 1.0)
+	{
+		nullwidth = (datawidth - nonullfrac * fullwidth) / (1.0 - nonullfrac);
+		nullwidth = Max(nullwidth, 0.0);
+		result += (1.0 - nonullfrac) *
+			MAXALIGN(sizeof(IndexTupleData) +
+					 sizeof(IndexAttributeBitMapData) +
+					 (Size) ceil(nullwidth));
+	}
+
+	return result + sizeof(ItemIdData);
+}
+
+/*
+ * hypo_expr_stats
+ *		Estimate the average width and the null fraction of a variable-width
+ *		index expression.
+ *
+ * Nothing has analyzed the expression, so evaluate it over a sample of the
+ * table as ANALYZE would for a real expression index, and remember the
+ * result for the rest of the session.  An empty table leaves us with the
+ * type's typical width.  As with CREATE INDEX, an expression that fails on
+ * some row raises its error here.
+ */
+static void
+hypo_expr_stats(Relation heapRelation, Node *expr,
+				int32 *width, double *nullfrac)
+{
+	Oid			relid = RelationGetRelid(heapRelation);
+	Relids		varnos = pull_varnos(expr);
+	MemoryContext samplecxt;
+	MemoryContext oldcxt;
+	HypoExprStats *entry;
+	HeapTuple  *rows;
+	int			numrows;
+	double		totalrows;
+	double		totaldeadrows;
+	double		totalwidth = 0;
+	int			nonnull = 0;
+	EState	   *estate;
+	ExprContext *econtext;
+	ExprState  *exprstate;
+	TupleTableSlot *slot;
+	char	   *exprstr;
+	int16		typlen;
+	bool		typbyval;
+	ListCell   *lc;
+	int			i;
+
+	/* the planner hands us Vars of its own range table entry */
+	if (bms_membership(varnos) == BMS_SINGLETON &&
+		bms_singleton_member(varnos) != 1)
+	{
+		expr = (Node *) copyObject(expr);
+		ChangeVarNodes(expr, bms_singleton_member(varnos), 1, 0);
+	}
+	exprstr = nodeToString(expr);
+
+	foreach(lc, hypoExprStats)
+	{
+		entry = (HypoExprStats *) lfirst(lc);
+		if (entry->relid == relid && strcmp(entry->expr, exprstr) == 0)
+		{
+			*width = entry->width;
+			*nullfrac = entry->nullfrac;
+			pfree(exprstr);
+			return;
+		}
+	}
+
+	get_typlenbyval(exprType(expr), &typlen, &typbyval);
+	*width = get_typavgwidth(exprType(expr), exprTypmod(expr));
+	*nullfrac = 0.0;
+
+	samplecxt = AllocSetContextCreate(CurrentMemoryContext,
+									  "Hypothetical expression sample",
+									  ALLOCSET_DEFAULT_MINSIZE,
+									  ALLOCSET_DEFAULT_INITSIZE,
+									  ALLOCSET_DEFAULT_MAXSIZE);
+	oldcxt = MemoryContextSwitchTo(samplecxt);
+
+	rows = (HeapTuple *) palloc(HYPO_EXPR_SAMPLE_ROWS * sizeof(HeapTuple));
+	numrows = acquire_sample_rows(heapRelation, DEBUG2, rows,
+								  HYPO_EXPR_SAMPLE_ROWS,
+								  &totalrows, &totaldeadrows);
+
+	estate = CreateExecutorState();
+	econtext = GetPerTupleExprContext(estate);
+	slot = MakeSingleTupleTableSlot(RelationGetDescr(heapRelation));
+	econtext->ecxt_scantuple = slot;
+	exprstate = ExecPrepareExpr((Expr *) expr, estate);
+
+	for (i = 0; i < numrows; i++)
+	{
+		Datum		value;
+		bool		isnull;
+
+		ExecStoreTuple(rows[i], slot, InvalidBuffer, false);
+		value = ExecEvalExprSwitchContext(exprstate, econtext, &isnull, NULL);
+		if (!isnull)
+		{
+			/* index_form_tuple() stores toasted values expanded */
+			if (typlen == -1)
+				totalwidth += toast_raw_datum_size(value);
+			else
+				totalwidth += datumGetSize(value, typbyval, typlen);
+			nonnull++;
+		}
+		ResetExprContext(econtext);
+	}
+
+	ExecDropSingleTupleTableSlot(slot);
+	FreeExecutorState(estate);
+
+	if (nonnull > 0)
+		*width = (int32) ceil(totalwidth / nonnull);
+	if (numrows > 0)
+		*nullfrac = 1.0 - (double) nonnull / numrows;
+
+	MemoryContextSwitchTo(hypo_sample_stats_context());
+	entry = (HypoExprStats *) palloc(sizeof(HypoExprStats));
+	entry->relid = relid;
+	entry->expr = pstrdup(exprstr);
+	entry->width = *width;
+	entry->nullfrac = *nullfrac;
+	hypoExprStats = lappend(hypoExprStats, entry);
+
+	MemoryContextSwitchTo(oldcxt);
+	MemoryContextDelete(samplecxt);
+	pfree(exprstr);
+}
+
+/*
+ * The memory context of the sampled statistics, created the first time they
+ * are needed along with their invalidation callback.
+ */
+static MemoryContext
+hypo_sample_stats_context(void)
+{
+	if (HypoExprStatsContext == NULL)
+	{
+		HypoExprStatsContext = AllocSetContextCreate(TopMemoryContext,
+									"Hypothetical sampled statistics",
+													 ALLOCSET_SMALL_MINSIZE,
+													 ALLOCSET_SMALL_INITSIZE,
+													 ALLOCSET_DEFAULT_MAXSIZE);
+		CacheRegisterRelcacheCallback(hypo_sample_stats_callback, (Datum) 0);
+	}
+
+	return HypoExprStatsContext;
+}
+
+/*
+ * Relcache invalidation callback: forget the sampled expressions and key
+ * combinations of the relation, or of all relations if relid is InvalidOid.
+ */
+static void
+hypo_sample_stats_callback(Datum arg, Oid relid)
+{
+	ListCell   *lc;
+	ListCell   *prev = NULL;
+	ListCell   *next;
+
+	for (lc = list_head(hypoExprStats); lc != NULL; lc = next)
+	{
+		HypoExprStats *entry = (HypoExprStats *) lfirst(lc);
+
+		next = lnext(lc);
+		if (relid == InvalidOid || entry->relid == relid)
+		{
+			hypoExprStats = list_delete_cell(hypoExprStats, lc, prev);
+			pfree(entry->expr);
+			pfree(entry);
+		}
+		else
+			prev = lc;
+	}
+
+	prev = NULL;
+	for (lc = list_head(hypoKeyStats); lc != NULL; lc = next)
+	{
+		HypoKeyStats *entry = (HypoKeyStats *) lfirst(lc);
+
+		next = lnext(lc);
+		if (relid == InvalidOid || entry->relid == relid)
+		{
+			hypoKeyStats = list_delete_cell(hypoKeyStats, lc, prev);
+			pfree(entry);
+		}
+		else
+			prev = lc;
+	}
+}
+
+/*
+ * hypo_index_register_am
+ *		Install the model of hypothetical indexes of an access method.
+ *
+ * estimate_size is called by hypo_index_estimate_size() and get_stats by
+ * hypo_index_get_stats(); either may be NULL to keep the built-in one.
+ * Meant to be called from the _PG_init() of the module providing the
+ * access method.
+ */
+void
+hypo_index_register_am(Oid relam, HypoAmEstimateSize estimate_size,
+					   HypoAmGetStats get_stats)
+{
+	HypoAmModel *model;
+	MemoryContext oldcxt;
+
+	oldcxt = MemoryContextSwitchTo(TopMemoryContext);
+	model = (HypoAmModel *) palloc(sizeof(HypoAmModel));
+	model->relam = relam;
+	model->estimate_size = estimate_size;
+	model->get_stats = get_stats;
+	hypoAmModels = lcons(model, hypoAmModels);
+	MemoryContextSwitchTo(oldcxt);
+}
+
+/*
+ * hypo_index_estimate_size
+ *		Estimate the size of a hypothetical index on heapRelation.
+ *
+ * indexkeys and indexprs describe the columns as in IndexOptInfo, tuples is
+ * the number of heap tuples the index would cover and fillfactor is from
+ * hypo_index_fillfactor().  Sets *pages to the total number of pages,
+ * metapage included, and *tree_height to the number of levels above the
+ * leaves, or -1 where the access method's cost estimate works it out
+ * itself, as get_relation_info() does for real indexes.
+ */
+void
+hypo_index_estimate_size(Relation heapRelation, Oid relam,
+						 int ncolumns, const int *indexkeys, List *indexprs,
+						 int fillfactor, double tuples,
+						 BlockNumber *pages, int *tree_height)
+{
+	const HypoAmModel *model = hypo_index_am_model(relam);
+	HypoAmEstimateSize estimate_size = hypo_tree_estimate_size;
+
+	if (model != NULL && model->estimate_size != NULL)
+		estimate_size = model->estimate_size;
+
+	*tree_height = -1;
+	(*estimate_size) (heapRelation, relam, ncolumns, indexkeys, indexprs,
+					  fillfactor, Max(tuples, 0.0), pages, tree_height);
+}
+
+/*
+ * hypo_index_get_stats
+ *		Fill in the statistics an access method's amcostestimate would read
+ *		from the index itself.
+ *
+ * Returns false if the access method has no such statistics.  For GIN,
+ * stats is a GinStatsData.
+ */
+bool
+hypo_index_get_stats(Relation heapRelation, Oid relam,
+					 int ncolumns, const int *indexkeys, List *indexprs,
+					 double tuples, void *stats)
+{
+	const HypoAmModel *model = hypo_index_am_model(relam);
+
+	if (model == NULL || model->get_stats == NULL)
+		return false;
+
+	(*model->get_stats) (heapRelation, relam, ncolumns, indexkeys, indexprs,
+						 Max(tuples, 0.0), stats);
+	return true;
+}
+
+/*
+ * hypo_index_predicate_tuples
+ *		Estimate how many of a table's tuples a partial index would cover.
+ *
+ * indpred is the implicit-AND predicate with the table's Vars numbered 1,
+ * as stored in the catalogs, and tuples the number of tuples in the table.
+ * get_relation_info() cannot hand us the real planner state because the
+ * relation isn't entered in it yet, so set up a one-table range table the
+ * way plan_cluster_use_sort() does, though without build_simple_rel(),
+ * which would come back here to size the index.
+ */
+double
+hypo_index_predicate_tuples(Relation heapRelation, List *indpred,
+							double tuples)
+{
+	Query	   *query;
+	PlannerGlobal *glob;
+	PlannerInfo *root;
+	RangeTblEntry *rte;
+	RelOptInfo *rel;
+	Selectivity sel;
+
+	if (indpred == NIL)
+		return tuples;
+	if (tuples <= 0)
+		return 0;
+
+	query = makeNode(Query);
+	query->commandType = CMD_SELECT;
+
+	glob = makeNode(PlannerGlobal);
+
+	root = makeNode(PlannerInfo);
+	root->parse = query;
+	root->glob = glob;
+	root->query_level = 1;
+	root->planner_cxt = CurrentMemoryContext;
+	root->wt_param_id = -1;
+
+	rte = makeNode(RangeTblEntry);
+	rte->rtekind = RTE_RELATION;
+	rte->relid = RelationGetRelid(heapRelation);
+	rte->relkind = RELKIND_RELATION;
+	rte->lateral = false;
+	rte->inh = false;
+	rte->inFromCl = true;
+	query->rtable = list_make1(rte);
+
+	setup_simple_rel_arrays(root);
+
+	rel = makeNode(RelOptInfo);
+	rel->reloptkind = RELOPT_BASEREL;
+	rel->relids = bms_make_singleton(1);
+	rel->relid = 1;
+	rel->rtekind = RTE_RELATION;
+	rel->tuples = tuples;
+	root->simple_rel_array[1] = rel;
+
+	sel = clauselist_selectivity(root, indpred, 1, JOIN_INNER, NULL);
+
+	return Min(clamp_row_est(tuples * sel), tuples);
+}
+
+/*
+ * hypo_index_key_order
+ *		Describe the order of the leading plain columns of a btree index.
+ *
+ * Stops at the first expression column; returns the number of columns
+ * described, 0 if the access method has no order.
+ */
+int
+hypo_index_key_order(IndexOptInfo *index, HypoKeyOrder *order)
+{
+	int			col;
+
+	memset(order, 0, sizeof(HypoKeyOrder));
+	if (index->sortopfamily == NULL)
+		return 0;
+
+	for (col = 0; col < index->ncolumns; col++)
+	{
+		Oid			sortop;
+
+		if (index->indexkeys[col] <= 0)
+			break;
+		sortop = get_opfamily_member(index->sortopfamily[col],
+									 index->opcintype[col],
+									 index->opcintype[col],
+									 index->reverse_sort[col] ?
+									 BTGreaterStrategyNumber :
+									 BTLessStrategyNumber);
+		if (!OidIsValid(sortop))
+			break;
+
+		order->attnums[col] = index->indexkeys[col];
+		order->sortops[col] = sortop;
+		order->collations[col] = index->indexcollations[col];
+		order->nulls_first[col] = index->nulls_first[col];
+	}
+	order->nkeys = col;
+
+	return col;
+}
+
+/*
+ * hypo_index_key_stats
+ *		Estimate the distinct counts and the ordering correlation of the key
+ *		columns of a hypothetical btree index.
+ *
+ * ANALYZE only keeps per-column statistics, so the planner would multiply
+ * the selectivities of equality quals on correlated columns, like city and
+ * zip code, and take the correlation of the first column for that of the
+ * whole index.  Instead, sample the table as ANALYZE does, sort the sample
+ * in index order and count the distinct values of every prefix of the key,
+ * and the correlation between that order and the table's.
+ *
+ * The table's order is the physical one, unless physical is given: then it
+ * is the order of those columns, as if the table had been clustered on
+ * them.  ndistinct[k] is set to the number of distinct values of the first
+ * k + 1 key columns in a table of tuples tuples.  The sample is taken once
+ * per session and combination of orders, until the table is analyzed or
+ * otherwise invalidated.  Returns false if there is no key column.
+ */
+bool
+hypo_index_key_stats(Relation heapRelation, const HypoKeyOrder *key,
+					 const HypoKeyOrder *physical, double tuples,
+					 double *ndistinct, double *correlation)
+{
+	Oid			relid = RelationGetRelid(heapRelation);
+	HypoKeyOrder none;
+	HypoKeyStats *entry = NULL;
+	ListCell   *lc;
+	int			k;
+
+	if (key->nkeys == 0)
+		return false;
+	if (physical == NULL)
+	{
+		memset(&none, 0, sizeof(HypoKeyOrder));
+		physical = &none;
+	}
+
+	foreach(lc, hypoKeyStats)
+	{
+		HypoKeyStats *candidate = (HypoKeyStats *) lfirst(lc);
+
+		if (candidate->relid == relid &&
+			hypo_key_order_equal(&candidate->key, key) &&
+			hypo_key_order_equal(&candidate->physical, physical))
+		{
+			entry = candidate;
+			break;
+		}
+	}
+
+	if (entry == NULL)
+		entry = hypo_key_stats_sample(heapRelation, key, physical);
+
+	for (k = 0; k < key->nkeys; k++)
+	{
+		if (entry->ndistinct[k] < 0)
+			ndistinct[k] = -entry->ndistinct[k] * tuples;
+		else
+			ndistinct[k] = entry->ndistinct[k];
+		ndistinct[k] = Max(ndistinct[k], 1.0);
+	}
+	*correlation = entry->correlation;
+
+	return true;
+}
+
+static bool
+hypo_key_order_equal(const HypoKeyOrder *a, const HypoKeyOrder *b)
+{
+	int			k;
+
+	if (a->nkeys != b->nkeys)
+		return false;
+	for (k = 0; k < a->nkeys; k++)
+	{
+		if (a->attnums[k] != b->attnums[k] ||
+			a->sortops[k] != b->sortops[k] ||
+			a->collations[k] != b->collations[k] ||
+			a->nulls_first[k] != b->nulls_first[k])
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * hypo_key_stats_sample
+ *		Sample the table for hypo_index_key_stats() and remember the result.
+ *
+ * The distinct counts use the Haas and Stokes estimator, and the
+ * correlation the formula of compute_scalar_stats(), so that they agree
+ * with what ANALYZE would find for a single column.
+ */
+static HypoKeyStats *
+hypo_key_stats_sample(Relation heapRelation, const HypoKeyOrder *key,
+					  const HypoKeyOrder *physical)
+{
+	TupleDesc	tupdesc = RelationGetDescr(heapRelation);
+	int			natts = tupdesc->natts;
+	int			nkeys = key->nkeys;
+	MemoryContext samplecxt;
+	MemoryContext oldcxt;
+	HypoKeyStats *entry;
+	HypoKeySortState keysort;
+	HypoKeySortState physsort;
+	HypoKeySample *samples;
+	HeapTuple  *rows;
+	Datum	   *values;
+	bool	   *isnull;
+	int			targrows = HYPO_KEY_SAMPLE_ROWS;
+	int			numrows;
+	double		totalrows;
+	double		totaldeadrows;
+	int			distinct[INDEX_MAX_KEYS];
+	int			singletons[INDEX_MAX_KEYS];
+	int			groupsize[INDEX_MAX_KEYS];
+	double		corr_xysum = 0;
+	int			i;
+	int			k;
+
+	samplecxt = AllocSetContextCreate(CurrentMemoryContext,
+									  "Hypothetical key sample",
+									  ALLOCSET_DEFAULT_MINSIZE,
+									  ALLOCSET_DEFAULT_INITSIZE,
+									  ALLOCSET_DEFAULT_MAXSIZE);
+	oldcxt = MemoryContextSwitchTo(samplecxt);
+
+	keysort.nkeys = nkeys;
+	keysort.ssup = hypo_key_sort_support(heapRelation, key, samplecxt);
+	keysort.physical = false;
+	physsort.nkeys = physical->nkeys;
+	physsort.ssup = hypo_key_sort_support(heapRelation, physical, samplecxt);
+	physsort.physical = true;
+
+	/* acquire_sample_rows() returns the rows in physical order */
+	rows = (HeapTuple *) palloc(targrows * sizeof(HeapTuple));
+	numrows = acquire_sample_rows(heapRelation, DEBUG2, rows, targrows,
+								  &totalrows, &totaldeadrows);
+
+	values = (Datum *) palloc(natts * sizeof(Datum));
+	isnull = (bool *) palloc(natts * sizeof(bool));
+	samples = (HypoKeySample *) palloc(Max(numrows, 1) * sizeof(HypoKeySample));
+	for (i = 0; i < numrows; i++)
+	{
+		heap_deform_tuple(rows[i], tupdesc, values, isnull);
+		samples[i].values = (Datum *) palloc(nkeys * sizeof(Datum));
+		samples[i].isnull = (bool *) palloc(nkeys * sizeof(bool));
+		for (k = 0; k < nkeys; k++)
+		{
+			samples[i].values[k] = values[key->attnums[k] - 1];
+			samples[i].isnull[k] = isnull[key->attnums[k] - 1];
+		}
+		samples[i].physvalues = (Datum *)
+			palloc(Max(physical->nkeys, 1) * sizeof(Datum));
+		samples[i].physisnull = (bool *)
+			palloc(Max(physical->nkeys, 1) * sizeof(bool));
+		for (k = 0; k < physical->nkeys; k++)
+		{
+			samples[i].physvalues[k] = values[physical->attnums[k] - 1];
+			samples[i].physisnull[k] = isnull[physical->attnums[k] - 1];
+		}
+		samples[i].tupno = i;
+	}
+
+	/* rank the rows in the hypothetical table order, if there is one */
+	if (physical->nkeys > 0)
+	{
+		qsort_arg(samples, numrows, sizeof(HypoKeySample),
+				  hypo_key_sample_cmp, &physsort);
+		for (i = 0; i < numrows; i++)
+			samples[i].tupno = i;
+	}
+
+	qsort_arg(samples, numrows, sizeof(HypoKeySample),
+			  hypo_key_sample_cmp, &keysort);
+
+	/*
+	 * Walk the sorted sample once: a row differing from the previous one
+	 * first in column k starts a new group for every prefix longer than k.
+	 */
+	for (k = 0; k < nkeys; k++)
+	{
+		distinct[k] = 0;
+		singletons[k] = 0;
+		groupsize[k] = 0;
+	}
+	for (i = 0; i < numrows; i++)
+	{
+		int			first = 0;
+
+		if (i > 0)
+		{
+			while (first < nkeys &&
+				   ApplySortComparator(samples[i - 1].values[first],
+									   samples[i - 1].isnull[first],
+									   samples[i].values[first],
+									   samples[i].isnull[first],
+									   &keysort.ssup[first]) == 0)
+				first++;
+		}
+		for (k = first; k < nkeys; k++)
+		{
+			if (groupsize[k] == 1)
+				singletons[k]++;
+			distinct[k]++;
+			groupsize[k] = 1;
+		}
+		for (k = 0; k < first; k++)
+			groupsize[k]++;
+
+		corr_xysum += ((double) i) * ((double) samples[i].tupno);
+	}
+
+	MemoryContextSwitchTo(oldcxt);
+
+	entry = (HypoKeyStats *) MemoryContextAllocZero(hypo_sample_stats_context(),
+													sizeof(HypoKeyStats));
+	entry->relid = RelationGetRelid(heapRelation);
+	entry->key = *key;
+	entry->physical = *physical;
+	for (k = 0; k < nkeys; k++)
+	{
+		double		stadistinct;
+
+		if (groupsize[k] == 1)
+			singletons[k]++;
+
+		if (numrows == 0)
+			stadistinct = 1.0;
+		else if (singletons[k] == numrows)
+			stadistinct = -1.0;		/* all values unique */
+		else if (singletons[k] == 0 || numrows >= totalrows)
+			stadistinct = distinct[k];	/* all values seen */
+		else
+		{
+			double		n = numrows;
+			double		f1 = singletons[k];
+			double		d = distinct[k];
+
+			stadistinct = (n * d) / ((n - f1) + f1 * n / totalrows);
+			if (stadistinct < d)
+				stadistinct = d;
+			if (stadistinct > totalrows)
+				stadistinct = totalrows;
+			stadistinct = floor(stadistinct + 0.5);
+		}
+
+		/* scale with the table if it looks like it would, as ANALYZE does */
+		if (stadistinct > 0.1 * totalrows)
+			stadistinct = -(stadistinct / totalrows);
+
+		entry->ndistinct[k] = stadistinct;
+	}
+
+	if (numrows > 1)
+	{
+		double		n = numrows;
+		double		corr_xsum = (n - 1) * n / 2.0;
+		double		corr_x2sum = (n - 1) * n * (2 * n - 1) / 6.0;
+
+		entry->correlation = (n * corr_xysum - corr_xsum * corr_xsum) /
+			(n * corr_x2sum - corr_xsum * corr_xsum);
+	}
+
+	MemoryContextSwitchTo(hypo_sample_stats_context());
+	hypoKeyStats = lappend(hypoKeyStats, entry);
+	MemoryContextSwitchTo(oldcxt);
+
+	MemoryContextDelete(samplecxt);
+
+	return entry;
+}
+
+/*
+ * Set up the comparators of the columns of an order.
+ */
+static SortSupport
+hypo_key_sort_support(Relation heapRelation, const HypoKeyOrder *order,
+					  MemoryContext cxt)
+{
+	SortSupport ssup;
+	int			k;
+
+	ssup = (SortSupport) palloc0(Max(order->nkeys, 1) *
+								 sizeof(SortSupportData));
+	for (k = 0; k < order->nkeys; k++)
+	{
+		ssup[k].ssup_cxt = cxt;
+		ssup[k].ssup_collation = order->collations[k];
+		ssup[k].ssup_nulls_first = order->nulls_first[k];
+		PrepareSortSupportFromOrderingOp(order->sortops[k], &ssup[k]);
+	}
+
+	return ssup;
+}
+
+/*
+ * qsort_arg comparator of sampled rows: the given order, then the table
+ * order, which is what gives ties their place in the correlation.
+ */
+static int
+hypo_key_sample_cmp(const void *a, const void *b, void *arg)
+{
+	const HypoKeySample *sa = (const HypoKeySample *) a;
+	const HypoKeySample *sb = (const HypoKeySample *) b;
+	HypoKeySortState *state = (HypoKeySortState *) arg;
+	int			k;
+
+	for (k = 0; k < state->nkeys; k++)
+	{
+		int			compare;
+
+		if (state->physical)
+			compare = ApplySortComparator(sa->physvalues[k],
+										  sa->physisnull[k],
+										  sb->physvalues[k],
+										  sb->physisnull[k],
+										  &state->ssup[k]);
+		else
+			compare = ApplySortComparator(sa->values[k], sa->isnull[k],
+										  sb->values[k], sb->isnull[k],
+										  &state->ssup[k]);
+		if (compare != 0)
+			return compare;
+	}
+
+	return sa->tupno - sb->tupno;
+}
+
+/*
+ * Find the model of relam, preferring registered ones to the built-in ones.
+ */
+static const HypoAmModel *
+hypo_index_am_model(Oid relam)
+{
+	ListCell   *lc;
+	int			i;
+
+	foreach(lc, hypoAmModels)
+	{
+		HypoAmModel *model = (HypoAmModel *) lfirst(lc);
+
+		if (model->relam == relam)
+			return model;
+	}
+
+	for (i = 0; i < lengthof(hypoBuiltinAmModels); i++)
+	{
+		if (hypoBuiltinAmModels[i].relam == relam)
+			return &hypoBuiltinAmModels[i];
+	}
+
+	return NULL;
+}
+
+/*
+ * Size of a tree of index tuples: btree, GiST, SP-GiST, and the default
+ * for access methods without a model.
+ */
+static void
+hypo_tree_estimate_size(Relation heapRelation, Oid relam,
+						int ncolumns, const int *indexkeys, List *indexprs,
+						int fillfactor, double tuples,
+						BlockNumber *pages, int *tree_height)
+{
+	double		itemsz;
+	Size		usable;
+	double		leafitems;
+	double		nleaves;
+	double		npages;
+
+	itemsz = hypo_index_tuple_width(heapRelation, ncolumns, indexkeys,
+									indexprs);
+
+	/*
+	 * Leaf pages are filled until less than (100 - fillfactor) percent of
+	 * the page is free, minus one slot for the high key.  All the tree AMs
+	 * have a special space about the size of a btree's.
+	 */
+	usable = BLCKSZ - MAXALIGN(SizeOfPageHeaderData) -
+		MAXALIGN(sizeof(BTPageOpaqueData));
+	leafitems = floor((usable - BLCKSZ * (100 - fillfactor) / 100.0) / itemsz) - 1;
+	leafitems = Max(leafitems, 1.0);
+	nleaves = Max(ceil(tuples / leafitems), 1.0);
+
+	/*
+	 * Upper levels hold one downlink per page of the level below and are
+	 * filled to BTREE_NONLEAF_FILLFACTOR.  Downlinks carry a full key, so
+	 * they are as wide as a leaf entry; GiST's union keys are too.  SP-GiST
+	 * trees are not balanced, so spgcostestimate gets no height.
+	 */
+	npages = nleaves;
+	if (nleaves > 1)
+	{
+		double		upperitems;
+		double		nlevel = nleaves;
+		int			height = 0;
+
+		upperitems = floor((usable - BLCKSZ * (100 - BTREE_NONLEAF_FILLFACTOR) / 100.0)
+						   / itemsz) - 1;
+		upperitems = Max(upperitems, 2.0);
+		while (nlevel > 1)
+		{
+			nlevel = ceil(nlevel / upperitems);
+			npages += nlevel;
+			height++;
+		}
+		if (relam == BTREE_AM_OID || relam == GIST_AM_OID)
+			*tree_height = height;
+	}
+	else if (relam == BTREE_AM_OID || relam == GIST_AM_OID)
+		*tree_height = 0;
+
+	/* metapage */
+	if (relam == BTREE_AM_OID || relam == SPGIST_AM_OID)
+		npages += 1;
+
+	*pages = (BlockNumber) Min(npages, (double) MaxBlockNumber);
+}
+
+/*
+ * Hash indexes store only the 4-byte hash code.  The build creates a
+ * power-of-2 number of buckets sized by the fill factor, plus the metapage
+ * and one bitmap page.
+ */
+static void
+hypo_hash_estimate_size(Relation heapRelation, Oid relam,
+						int ncolumns, const int *indexkeys, List *indexprs,
+						int fillfactor, double tuples,
+						BlockNumber *pages, int *tree_height)
+{
+	double		itemsz;
+	Size		usable;
+	double		leafitems;
+	double		nbuckets = 1;
+
+	itemsz = MAXALIGN(sizeof(IndexTupleData) + sizeof(uint32)) +
+		sizeof(ItemIdData);
+	usable = BLCKSZ - MAXALIGN(SizeOfPageHeaderData) -
+		MAXALIGN(sizeof(HashPageOpaqueData));
+	leafitems = Max(floor((usable * fillfactor / 100.0) / itemsz), 1.0);
+	while (nbuckets * leafitems < tuples)
+		nbuckets *= 2;
+
+	*pages = (BlockNumber) Min(nbuckets + 2, (double) MaxBlockNumber);
+}
+
+/*
+ * GIN's size is what its statistics add up to.
+ */
+static void
+hypo_gin_estimate_size(Relation heapRelation, Oid relam,
+					   int ncolumns, const int *indexkeys, List *indexprs,
+					   int fillfactor, double tuples,
+					   BlockNumber *pages, int *tree_height)
+{
+	GinStatsData stats;
+
+	hypo_gin_get_stats(heapRelation, relam, ncolumns, indexkeys, indexprs,
+					   tuples, &stats);
+	*pages = stats.nTotalPages;
+}
+
+/*
+ * Synthesize the statistics a GIN index keeps in its metapage.
+ *
+ * A GIN index has one entry per distinct element (key) of the indexed
+ * values, each with the list of heap TIDs containing it.  ANALYZE gathers
+ * for array and tsvector columns the most common elements with the
+ * fraction of rows containing each (MCELEM) and, for arrays, the average
+ * number of distinct elements per row (DECHIST).  tsvectors lack the
+ * latter, so it is taken as the column width over the width of an element
+ * with its WordEntry and a position.  Elements less common than the least
+ * common MCELEM entry are assumed to appear in half as many rows.
+ *
+ * Posting lists short enough stay inline in the entry tuple; longer ones,
+ * of keys in more than about GinMaxItemSize / sizeof(ItemPointerData) rows,
+ * become posting trees of data pages.  Without element statistics, as for
+ * expressions, every row is taken to have one key of its own, which is what
+ * gincostestimate() assumes of an index never vacuumed.
+ */
+static void
+hypo_gin_get_stats(Relation heapRelation, Oid relam,
+				   int ncolumns, const int *indexkeys, List *indexprs,
+				   double tuples, void *result)
+{
+	GinStatsData *stats = (GinStatsData *) result;
+	Size		usable;
+	double		maxinline;
+	double		nentries = 0;
+	double		entrybytes = 0;
+	double		databytes = 0;
+	double		entrypages;
+	double		datapages;
+	int			i;
+
+	usable = BLCKSZ - MAXALIGN(SizeOfPageHeaderData) -
+		MAXALIGN(sizeof(GinPageOpaqueData));
+	maxinline = GinMaxItemSize / sizeof(ItemPointerData);
+
+	for (i = 0; i < ncolumns; i++)
+	{
+		double		keywidth = 0;
+		double		keytuple;
+		double		nkeys;
+		double		postings;
+		double		rarepostings;
+		double		rarekeys = 0;
+		bool		have_stats = false;
+
+		if (indexkeys[i] > 0)
+		{
+			Form_pg_attribute attr = heapRelation->rd_att->attrs[indexkeys[i] - 1];
+			Oid			elemtype;
+			HeapTuple	statsTuple;
+
+			elemtype = (attr->atttypid == TSVECTOROID) ? TEXTOID :
+				get_base_element_type(attr->atttypid);
+
+			statsTuple = SearchSysCache3(STATRELATTINH,
+								 ObjectIdGetDatum(RelationGetRelid(heapRelation)),
+										 Int16GetDatum(indexkeys[i]),
+										 BoolGetDatum(false));
+			if (OidIsValid(elemtype) && HeapTupleIsValid(statsTuple))
+			{
+				Form_pg_statistic pgstat = (Form_pg_statistic) GETSTRUCT(statsTuple);
+				double		nonnull = tuples * (1.0 - pgstat->stanullfrac);
+				Datum	   *values;
+				int			nvalues;
+				float4	   *numbers;
+				int			nnumbers;
+				double		elemsperrow = 0;
+
+				if (get_attstatsslot(statsTuple, elemtype, -1,
+									 STATISTIC_KIND_MCELEM, InvalidOid,
+									 NULL,
+									 &values, &nvalues,
+									 &numbers, &nnumbers) &&
+					nvalues > 0 && nnumbers >= nvalues + 2)
+				{
+					int16		elemlen;
+					bool		elembyval;
+					double		mcefreqs = 0;
+					double		minfreq = numbers[nvalues];
+					int			j;
+
+					get_typlenbyval(elemtype, &elemlen, &elembyval);
+
+					nkeys = nvalues;
+					postings = 0;
+					for (j = 0; j < nvalues; j++)
+					{
+						double		count = numbers[j] * nonnull;
+
+						mcefreqs += numbers[j];
+						if (elemlen > 0)
+							keywidth += elemlen;
+						else
+							keywidth += VARSIZE_ANY(DatumGetPointer(values[j]));
+
+						/* posting list inline or in a posting tree */
+						if (count > maxinline)
+							databytes += count * sizeof(ItemPointerData);
+						else
+							entrybytes += count * sizeof(ItemPointerData);
+						postings += count;
+					}
+					keywidth /= nvalues;
+					free_attstatsslot(elemtype, values, nvalues,
+									  numbers, nnumbers);
+
+					if (get_attstatsslot(statsTuple, elemtype, -1,
+										 STATISTIC_KIND_DECHIST, InvalidOid,
+										 NULL,
+										 NULL, NULL,
+										 &numbers, &nnumbers) &&
+						nnumbers > 0)
+					{
+						elemsperrow = numbers[nnumbers - 1];
+						free_attstatsslot(elemtype, NULL, 0,
+										  numbers, nnumbers);
+					}
+					else
+						elemsperrow = pgstat->stawidth /
+							(keywidth + sizeof(uint32) + sizeof(uint16));
+					elemsperrow = Max(elemsperrow, mcefreqs);
+
+					/* the rest of the postings go to the rarer keys */
+					rarepostings = nonnull * elemsperrow - postings;
+					if (rarepostings > 0 && minfreq > 0)
+					{
+						rarekeys = rarepostings /
+							Max(nonnull * minfreq / 2.0, 1.0);
+						entrybytes += rarepostings * sizeof(ItemPointerData);
+					}
+					nkeys += rarekeys;
+					have_stats = true;
+				}
+			}
+			if (HeapTupleIsValid(statsTuple))
+				ReleaseSysCache(statsTuple);
+		}
+
+		if (!have_stats)
+		{
+			nkeys = tuples;
+			keywidth = (hypo_index_tuple_width(heapRelation, ncolumns,
+											   indexkeys, indexprs) -
+						sizeof(IndexTupleData) - sizeof(ItemIdData)) / ncolumns;
+			entrybytes += tuples * sizeof(ItemPointerData);
+		}
+
+		/* multi-column GIN indexes prefix keys with the column number */
+		keytuple = MAXALIGN(sizeof(IndexTupleData) +
+							(ncolumns > 1 ? sizeof(int16) : 0) +
+							Max(keywidth, 1.0)) + sizeof(ItemIdData);
+		entrybytes += nkeys * keytuple;
+		nentries += nkeys;
+	}
+
+	/* the entry tree gets one upper level per fanout of its keys */
+	entrypages = Max(ceil(entrybytes / usable), 1.0);
+	if (entrypages > 1)
+		entrypages += ceil(entrypages * (entrybytes / Max(nentries, 1.0)) /
+						   usable);
+	datapages = ceil(databytes / usable);
+
+	memset(stats, 0, sizeof(GinStatsData));
+	stats->nPendingPages = 0;
+	stats->nEntryPages = (BlockNumber) Min(entrypages, (double) MaxBlockNumber);
+	stats->nDataPages = (BlockNumber) Min(datapages, (double) MaxBlockNumber);
+	/* plus the metapage */
+	stats->nTotalPages = (BlockNumber) Min(entrypages + datapages + 1,
+										   (double) MaxBlockNumber);
+	stats->nEntries = (int64) nentries;
+	stats->ginVersion = GIN_CURRENT_VERSION;
+}
+
+/*
+ * hypo_index_attrs
+ *		Add the table columns an index uses, its predicate included, to
+ *		attrs, offset by FirstLowInvalidHeapAttributeNumber as in
+ *		RelationGetIndexAttrBitmap().
+ */
+Bitmapset *
+hypo_index_attrs(Bitmapset *attrs, int ncolumns, const int *indexkeys,
+				 List *indexprs, List *indpred)
+{
+	int			i;
+
+	for (i = 0; i < ncolumns; i++)
+	{
+		if (indexkeys[i] != 0)
+			attrs = bms_add_member(attrs,
+						  indexkeys[i] - FirstLowInvalidHeapAttributeNumber);
+	}
+	pull_varattnos((Node *) indexprs, 1, &attrs);
+	pull_varattnos((Node *) indpred, 1, &attrs);
+
+	return attrs;
+}
+
+/*
+ * hypo_index_write_cost
+ *		Estimate what maintaining a hypothetical index would cost a data
+ *		modifying statement.
+ *
+ * rows is the number of rows the statement inserts, updates or deletes and
+ * modifiedCols the columns an UPDATE assigns, offset by
+ * FirstLowInvalidHeapAttributeNumber as in RangeTblEntry.  hypoattrs holds
+ * the columns of all the table's hypothetical indexes that are considered
+ * together, built with hypo_index_attrs().  indpred is the predicate of a
+ * partial index, as for hypo_index_predicate_tuples(), and the other
+ * arguments describe the index as for hypo_index_estimate_size().
+ *
+ * Every inserted row, and every updated row that cannot be a HOT update,
+ * adds one index entry, though a partial index only gets the share of them
+ * its predicate covers in the table.  An update stays HOT only if it
+ * changes no indexed column, predicate columns included, so an index on a
+ * modified column makes updates that were HOT so far lose that, and then
+ * all of the table's indexes get a new entry too; those updates are counted
+ * in lost_hot.  If another hypothetical index is what spoils HOT, this one
+ * still gets the entries, but the lost updates are charged to the other.
+ * Deletes leave the index alone until VACUUM.
+ *
+ * Entries land on leaf pages in key order, so the pages dirtied follow
+ * Cardenas' formula for rows spread at random over the index, plus the
+ * pages the index grows by.  WAL holds one insert record per entry, about a
+ * page per split and, with full_page_writes, an image of every page dirtied,
+ * as happens when the statement is the first to touch them after a
+ * checkpoint.  Hash indexes are not WAL-logged.
+ */
+void
+hypo_index_write_cost(Relation heapRelation, Oid relam,
+					  int ncolumns, const int *indexkeys, List *indexprs,
+					  List *indpred, int fillfactor, CmdType operation,
+					  double rows, Bitmapset *modifiedCols,
+					  Bitmapset *hypoattrs, HypoIndexWriteCost *cost)
+{
+	BlockNumber heappages;
+	double		heaptuples;
+	double		tuples;
+	double		allvisfrac;
+	BlockNumber pages;
+	BlockNumber newpages;
+	int			tree_height;
+	double		itemsz;
+	double		splits;
+
+	memset(cost, 0, sizeof(HypoIndexWriteCost));
+	rows = Max(rows, 0.0);
+
+	if (operation == CMD_INSERT)
+		cost->entries = rows;
+	else if (operation == CMD_UPDATE)
+	{
+		Bitmapset  *indexattrs;
+
+		indexattrs = hypo_index_attrs(NULL, ncolumns, indexkeys,
+									  indexprs, indpred);
+
+		if (bms_overlap(modifiedCols,
+						RelationGetIndexAttrBitmap(heapRelation, false)))
+			cost->entries = rows;	/* not HOT anyway */
+		else if (bms_overlap(modifiedCols, indexattrs))
+		{
+			cost->entries = rows;
+			cost->lost_hot = rows;
+		}
+		else if (bms_overlap(modifiedCols, hypoattrs))
+			cost->entries = rows;	/* another hypothetical index spoils HOT */
+		bms_free(indexattrs);
+	}
+
+	if (cost->entries <= 0)
+		return;
+
+	estimate_rel_size(heapRelation, NULL, &heappages, &heaptuples,
+					  &allvisfrac);
+	tuples = hypo_index_predicate_tuples(heapRelation, indpred, heaptuples);
+	if (indpred != NIL)
+		cost->entries *= (heaptuples > 0) ? tuples / heaptuples : 0;
+	if (cost->entries <= 0)
+		return;
+
+	hypo_index_estimate_size(heapRelation, relam, ncolumns, indexkeys,
+							 indexprs, fillfactor, tuples,
+							 &pages, &tree_height);
+	hypo_index_estimate_size(heapRelation, relam, ncolumns, indexkeys,
+							 indexprs, fillfactor, tuples + cost->entries,
+							 &newpages, &tree_height);
+
+	splits = (newpages > pages) ? (double) (newpages - pages) : 0;
+	cost->pages = pages * (1.0 - exp(-cost->entries / (double) pages)) + splits;
+
+	if (relam == HASH_AM_OID)
+		return;
+
+	itemsz = hypo_index_tuple_width(heapRelation, ncolumns, indexkeys,
+									indexprs) - sizeof(ItemIdData);
+	cost->wal_bytes = cost->entries * (SizeOfXLogRecord + SizeOfBtreeInsert + itemsz) +
+		splits * (SizeOfXLogRecord + BLCKSZ);
+	if (fullPageWrites)
+		cost->wal_bytes += (cost->pages - splits) * BLCKSZ;
+}
+
+
+/*
+ * Catalog hypothetical indexes are not in any relcache index list that
+ * queries use, so creating or dropping one sends no relcache inval for its
+ * table.  Instead the hypothetical lists in the relcache (rd_hypindexlist)
+ * are stamped with hypo_index_generation(), and RelationGetIndexList_PUC()
+ * rebuilds them when it has moved on.  The generation combines a counter in
+ * shared memory, bumped when a transaction that created or dropped a catalog
+ * hypothetical index commits, and a backend-local one, bumped whenever this
+ * backend's own view changes: at the DDL itself and when it is rolled back.
+ * Backends that never plan EXPLAIN HYPOTHETICAL never look at either.
+ */
+typedef struct HypoIndexShared
+{
+	slock_t		mutex;			/* protects generation */
+	uint32		generation;		/* bumped by every committed change */
+} HypoIndexShared;
+
+static HypoIndexShared *hypoIndexShared = NULL;
+static uint32 hypoLocalGeneration = 0;
+static bool hypoXactChanged = false;
+
+/*
+ * Report shared-memory space needed by HypoIndexShmemInit
+ */
+Size
+HypoIndexShmemSize(void)
+{
+	return sizeof(HypoIndexShared);
+}
+
+/*
+ * Allocate and initialize the shared generation counter
+ */
+void
+HypoIndexShmemInit(void)
+{
+	bool		found;
+
+	hypoIndexShared = (HypoIndexShared *)
+		ShmemInitStruct("Hypothetical Index", HypoIndexShmemSize(), &found);
+
+	if (!found)
+	{
+		SpinLockInit(&hypoIndexShared->mutex);
+		hypoIndexShared->generation = 0;
+	}
+}
+
+/*
+ * hypo_index_generation
+ *		Current generation of the catalog hypothetical indexes, as seen by
+ *		this backend.
+ */
+uint64
+hypo_index_generation(void)
+{
+	uint32		shared;
+
+	SpinLockAcquire(&hypoIndexShared->mutex);
+	shared = hypoIndexShared->generation;
+	SpinLockRelease(&hypoIndexShared->mutex);
+
+	return ((uint64) shared << 32) | hypoLocalGeneration;
+}
+
+/*
+ * hypo_index_catalog_changed
+ *		Note that the current transaction created or dropped a catalog
+ *		hypothetical index.
+ */
+void
+hypo_index_catalog_changed(void)
+{
+	hypoXactChanged = true;
+	hypoLocalGeneration++;
+}
+
+/*
+ * AtEOXact_HypoIndex
+ *		Publish this transaction's hypothetical index changes at commit, or
+ *		forget them at abort.
+ *
+ * Must be called after the transaction is marked committed in the proc
+ * array, so that whoever sees the new generation also sees the change.
+ */
+void
+AtEOXact_HypoIndex(bool isCommit)
+{
+	ListCell   *lc;
+
+	/* private indexes created ON COMMIT DROP go away either way */
+	foreach(lc, hypoDropAtEOXact)
+		hypo_index_remove_oid(lfirst_oid(lc));
+	list_free(hypoDropAtEOXact);
+	hypoDropAtEOXact = NIL;
+
+	if (!hypoXactChanged)
+		return;
+
+	if (isCommit)
+	{
+		SpinLockAcquire(&hypoIndexShared->mutex);
+		hypoIndexShared->generation++;
+		SpinLockRelease(&hypoIndexShared->mutex);
+	}
+	else
+		hypoLocalGeneration++;
+
+	hypoXactChanged = false;
+}
+
+/*
+ * AtEOSubXact_HypoIndex
+ *		A subtransaction that is rolled back takes its changes with it.
+ *
+ * The top transaction stays marked as changed, which at worst publishes a
+ * generation nobody needed.
+ */
+void
+AtEOSubXact_HypoIndex(bool isCommit)
+{
+	if (!isCommit && hypoXactChanged)
+		hypoLocalGeneration++;
+}
+
+/*
+ * AtPrepare_HypoIndex
+ *		Nobody would publish the changes of a prepared transaction when it
+ *		is finally committed, so refuse to prepare one.
+ */
+void
+AtPrepare_HypoIndex(void)
+{
+	if (hypoXactChanged)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("cannot PREPARE a transaction that has created or dropped hypothetical indexes")));
+}
@@ -0,0 +1,462 @@
+/*-------------------------------------------------------------------------
+ *
+ * hypoplancache.c
+ *	  Per-backend cache of plans made for hypothetical planning.
+ *
+ * HYPOTHETICAL INDEX
+ * SELF TUNING GROUP - PUC-RIO - 2015
+ *
+ * An index advisor plans the same workload over and over, changing only
+ * the set of hypothetical indexes in between, and most configurations do
+ * not touch most of the tables a given query reads.  planner() therefore
+ * remembers the plans it made for hypothetical queries, keyed by
+ *
+ *	- the Query tree with parse locations left out, so the same statement
+ *	  matches wherever it appeared in its source text,
+ *	- for every table the query reads, its size in blocks and the OIDs of
+ *	  all of its indexes: real, catalog hypothetical and the visible
+ *	  session-private ones,
+ *	- the cursor options and the settings of the planner cost GUCs.
+ *
+ * A configuration change that leaves every table of a query alone thus
+ * gives back the previous plan without planning.  Relcache invalidations
+ * and new statistics evict the affected entries, as do changes to the
+ * functions a plan depends on (its invalItems, which the plan cache of
+ * utils/cache watches the same way), and the cache holds at most
+ * hypothetical_plan_cache_size plans, least recently used first out.
+ * Plans are not cached while a planner_hook is installed, as the hook
+ * would not see the cached queries.
+ *
+ * Portions Copyright (c) 1996-2013, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/optimizer/util/hypoplancache.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/hash.h"
+#include "access/heapam.h"
+#include "catalog/pg_class.h"
+#include "catalog/pg_inherits_fn.h"
+#include "lib/ilist.h"
+#include "lib/stringinfo.h"
+#include "miscadmin.h"
+#include "nodes/nodeFuncs.h"
+#include "optimizer/cost.h"
+#include "optimizer/geqo.h"
+#include "optimizer/hypoindex.h"
+#include "optimizer/paths.h"
+#include "optimizer/planmain.h"
+#include "storage/bufmgr.h"
+#include "utils/inval.h"
+#include "utils/memutils.h"
+#include "utils/rel.h"
+#include "utils/syscache.h"
+
+
+/* GUC parameter */
+int			hypothetical_plan_cache_size = 64;
+
+typedef struct HypoPlanCacheEntry
+{
+	dlist_node	node;			/* link in LRU list, most recent first */
+	MemoryContext context;		/* holds the entry and everything in it */
+	uint32		hash;			/* hash_any() of key */
+	char	   *key;			/* see hypo_plan_cache_key() */
+	int			nrelids;		/* tables the plan depends on */
+	Oid		   *relids;
+	PlannedStmt *plan;
+} HypoPlanCacheEntry;
+
+static dlist_head hypoPlanCache = DLIST_STATIC_INIT(hypoPlanCache);
+static int	hypoPlanCacheCount = 0;
+static MemoryContext HypoPlanCacheContext = NULL;
+
+static bool hypo_plan_cache_relids_walker(Node *node, List **relids);
+static int	oid_cmp(const void *a, const void *b);
+static void hypo_plan_cache_evict(HypoPlanCacheEntry *entry);
+static void hypo_plan_cache_relcache_callback(Datum arg, Oid relid);
+static void hypo_plan_cache_func_callback(Datum arg, int cacheid,
+							  uint32 hashvalue);
+static void hypo_plan_cache_syscache_callback(Datum arg, int cacheid,
+								  uint32 hashvalue);
+
+
+/*
+ * hypo_query_fingerprint
+ *		Print a Query tree without the ":location N" fields, which only tell
+ *		where in the source text a node came from, so the same statement
+ *		gives the same string wherever it was written.  With ignore_consts,
+ *		the values of Consts are left out too.
+ */
+char *
+hypo_query_fingerprint(Query *parse, bool ignore_consts)
+{
+	StringInfoData buf;
+	char	   *querystr;
+	char	   *src;
+
+	initStringInfo(&buf);
+
+	querystr = nodeToString(parse);
+	src = querystr;
+	while (*src)
+	{
+		if (strncmp(src, " :location ", 11) == 0)
+		{
+			src += 11;
+			if (*src == '-')
+				src++;
+			while (*src >= '0' && *src <= '9')
+				src++;
+			continue;
+		}
+		if (ignore_consts && strncmp(src, " :constvalue ", 13) == 0)
+		{
+			/* either "<>" or "length [ bytes ]", see _outDatum() */
+			src += 13;
+			if (strncmp(src, "<>", 2) == 0)
+				src += 2;
+			else
+			{
+				while (*src && *src != ']')
+					src++;
+				if (*src)
+					src++;
+			}
+			continue;
+		}
+		appendStringInfoChar(&buf, *src++);
+	}
+	pfree(querystr);
+
+	return buf.data;
+}
+
+/*
+ * hypo_plan_cache_key
+ *		Build the cache key of a query about to be planned.
+ *
+ * This must be called before planning, as the planner scribbles on the
+ * Query.  The sorted OIDs of the tables involved are returned in *relids
+ * and *nrelids, for the caller to pass on to hypo_plan_cache_store().
+ */
+char *
+hypo_plan_cache_key(Query *parse, int cursorOptions,
+					Oid **relids, int *nrelids)
+{
+	StringInfoData buf;
+	List	   *rellist = NIL;
+	char	   *querystr;
+	Oid		   *relarray;
+	int			nrels;
+	int			i;
+	ListCell   *lc;
+
+	initStringInfo(&buf);
+
+	querystr = hypo_query_fingerprint(parse, false);
+	appendStringInfoString(&buf, querystr);
+	pfree(querystr);
+
+	/* The tables it reads, each with its size and indexes */
+	(void) hypo_plan_cache_relids_walker((Node *) parse, &rellist);
+
+	nrels = 0;
+	relarray = (Oid *) palloc(sizeof(Oid) * Max(list_length(rellist), 1));
+	foreach(lc, rellist)
+		relarray[nrels++] = lfirst_oid(lc);
+	qsort(relarray, nrels, sizeof(Oid), oid_cmp);
+
+	for (i = 0; i < nrels; i++)
+	{
+		Relation	rel;
+		List	   *indexoids;
+		List	   *hypoindexes;
+		ListCell   *lc2;
+
+		if (i > 0 && relarray[i] == relarray[i - 1])
+			continue;
+
+		/* the rewriter or parse analysis has already locked it */
+		rel = relation_open(relarray[i], NoLock);
+
+		appendStringInfo(&buf, " |rel %u", relarray[i]);
+		if (rel->rd_rel->relkind == RELKIND_RELATION ||
+			rel->rd_rel->relkind == RELKIND_MATVIEW)
+			appendStringInfo(&buf, " %u", RelationGetNumberOfBlocks(rel));
+
+		indexoids = RelationGetIndexList_PUC(rel, true);
+		foreach(lc2, indexoids)
+		{
+			if (!hypo_index_is_disabled(lfirst_oid(lc2)))
+				appendStringInfo(&buf, " %u", lfirst_oid(lc2));
+		}
+		list_free(indexoids);
+
+		hypoindexes = hypo_index_list_for_relation(rel);
+		foreach(lc2, hypoindexes)
+			appendStringInfo(&buf, " %u", ((HypoIndex *) lfirst(lc2))->oid);
+		list_free(hypoindexes);
+
+		relation_close(rel, NoLock);
+	}
+
+	/* Cursor options and the settings costs depend on */
+	appendStringInfo(&buf, " |cursor %d", cursorOptions);
+	appendStringInfo(&buf, " |costs %g %g %g %g %g %d %d",
+					 seq_page_cost, random_page_cost, cpu_tuple_cost,
+					 cpu_index_tuple_cost, cpu_operator_cost,
+					 effective_cache_size, work_mem);
+	appendStringInfo(&buf, " |enable %d%d%d%d%d%d%d%d%d%d%d",
+					 enable_seqscan, enable_indexscan, enable_indexonlyscan,
+					 enable_bitmapscan, enable_tidscan, enable_sort,
+					 enable_hashagg, enable_nestloop, enable_material,
+					 enable_mergejoin, enable_hashjoin);
+	appendStringInfo(&buf, " |other %d %d %d %g %d %d %d %d %d %g %g",
+					 constraint_exclusion, from_collapse_limit,
+					 join_collapse_limit, cursor_tuple_fraction,
+					 enable_geqo, geqo_threshold, Geqo_effort,
+					 Geqo_pool_size, Geqo_generations,
+					 Geqo_selection_bias, Geqo_seed);
+
+	*relids = relarray;
+	*nrelids = nrels;
+	return buf.data;
+}
+
+/*
+ * hypo_plan_cache_lookup
+ *		Return a copy of the plan cached under key, or NULL.
+ */
+PlannedStmt *
+hypo_plan_cache_lookup(const char *key)
+{
+	uint32		hash;
+	dlist_iter	iter;
+
+	if (hypothetical_plan_cache_size <= 0)
+		return NULL;
+
+	hash = DatumGetUInt32(hash_any((const unsigned char *) key, strlen(key)));
+
+	dlist_foreach(iter, &hypoPlanCache)
+	{
+		HypoPlanCacheEntry *entry;
+
+		entry = dlist_container(HypoPlanCacheEntry, node, iter.cur);
+		if (entry->hash == hash && strcmp(entry->key, key) == 0)
+		{
+			dlist_move_head(&hypoPlanCache, &entry->node);
+			return (PlannedStmt *) copyObject(entry->plan);
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * hypo_plan_cache_store
+ *		Remember a plan under key, evicting the least recently used one if
+ *		the cache is full.
+ */
+void
+hypo_plan_cache_store(const char *key, Oid *relids, int nrelids,
+					  PlannedStmt *plan)
+{
+	MemoryContext cxt;
+	MemoryContext oldcxt;
+	HypoPlanCacheEntry *entry;
+
+	if (hypothetical_plan_cache_size <= 0)
+		return;
+
+	if (HypoPlanCacheContext == NULL)
+	{
+		HypoPlanCacheContext = AllocSetContextCreate(TopMemoryContext,
+											"Hypothetical plan cache",
+													 ALLOCSET_SMALL_MINSIZE,
+													 ALLOCSET_SMALL_INITSIZE,
+													 ALLOCSET_DEFAULT_MAXSIZE);
+		CacheRegisterRelcacheCallback(hypo_plan_cache_relcache_callback,
+									  (Datum) 0);
+		CacheRegisterSyscacheCallback(STATRELATTINH,
+									  hypo_plan_cache_syscache_callback,
+									  (Datum) 0);
+		CacheRegisterSyscacheCallback(TABLESPACEOID,
+									  hypo_plan_cache_syscache_callback,
+									  (Datum) 0);
+		/* as in plancache.c */
+		CacheRegisterSyscacheCallback(PROCOID,
+									  hypo_plan_cache_func_callback,
+									  (Datum) 0);
+		CacheRegisterSyscacheCallback(NAMESPACEOID,
+									  hypo_plan_cache_syscache_callback,
+									  (Datum) 0);
+		CacheRegisterSyscacheCallback(OPEROID,
+									  hypo_plan_cache_syscache_callback,
+									  (Datum) 0);
+		CacheRegisterSyscacheCallback(AMOPOPID,
+									  hypo_plan_cache_syscache_callback,
+									  (Datum) 0);
+	}
+
+	while (hypoPlanCacheCount >= hypothetical_plan_cache_size)
+		hypo_plan_cache_evict(dlist_container(HypoPlanCacheEntry, node,
+											  dlist_tail_node(&hypoPlanCache)));
+
+	cxt = AllocSetContextCreate(HypoPlanCacheContext,
+								"HypoPlanCacheEntry",
+								ALLOCSET_SMALL_MINSIZE,
+								ALLOCSET_SMALL_INITSIZE,
+								ALLOCSET_DEFAULT_MAXSIZE);
+	oldcxt = MemoryContextSwitchTo(cxt);
+
+	entry = (HypoPlanCacheEntry *) palloc(sizeof(HypoPlanCacheEntry));
+	entry->context = cxt;
+	entry->key = pstrdup(key);
+	entry->hash = DatumGetUInt32(hash_any((const unsigned char *) key,
+										  strlen(key)));
+	entry->nrelids = nrelids;
+	entry->relids = (Oid *) palloc(sizeof(Oid) * Max(nrelids, 1));
+	memcpy(entry->relids, relids, sizeof(Oid) * nrelids);
+	entry->plan = (PlannedStmt *) copyObject(plan);
+
+	MemoryContextSwitchTo(oldcxt);
+
+	dlist_push_head(&hypoPlanCache, &entry->node);
+	hypoPlanCacheCount++;
+}
+
+/*
+ * hypo_plan_cache_reset
+ *		Throw away every cached plan.
+ */
+void
+hypo_plan_cache_reset(void)
+{
+	while (!dlist_is_empty(&hypoPlanCache))
+		hypo_plan_cache_evict(dlist_container(HypoPlanCacheEntry, node,
+											  dlist_head_node(&hypoPlanCache)));
+}
+
+/*
+ * Collect the OIDs of all tables a query reads, including those in
+ * subqueries, CTEs and sublinks, and the children of inheritance parents.
+ */
+static bool
+hypo_plan_cache_relids_walker(Node *node, List **relids)
+{
+	if (node == NULL)
+		return false;
+	if (IsA(node, RangeTblEntry))
+	{
+		RangeTblEntry *rte = (RangeTblEntry *) node;
+
+		if (rte->rtekind == RTE_RELATION)
+		{
+			if (rte->inh)
+				*relids = list_concat(*relids,
+									  find_all_inheritors(rte->relid,
+														  NoLock, NULL));
+			else
+				*relids = lappend_oid(*relids, rte->relid);
+		}
+		return false;
+	}
+	if (IsA(node, Query))
+		return query_tree_walker((Query *) node,
+								 hypo_plan_cache_relids_walker,
+								 (void *) relids,
+								 QTW_EXAMINE_RTES);
+	return expression_tree_walker(node, hypo_plan_cache_relids_walker,
+								  (void *) relids);
+}
+
+static int
+oid_cmp(const void *a, const void *b)
+{
+	Oid			oa = *((const Oid *) a);
+	Oid			ob = *((const Oid *) b);
+
+	if (oa == ob)
+		return 0;
+	return (oa > ob) ? 1 : -1;
+}
+
+static void
+hypo_plan_cache_evict(HypoPlanCacheEntry *entry)
+{
+	dlist_delete(&entry->node);
+	hypoPlanCacheCount--;
+	MemoryContextDelete(entry->context);
+}
+
+/*
+ * A table changed: drop the plans that read it.
+ */
+static void
+hypo_plan_cache_relcache_callback(Datum arg, Oid relid)
+{
+	dlist_mutable_iter iter;
+
+	if (!OidIsValid(relid))
+	{
+		hypo_plan_cache_reset();
+		return;
+	}
+
+	dlist_foreach_modify(iter, &hypoPlanCache)
+	{
+		HypoPlanCacheEntry *entry;
+
+		entry = dlist_container(HypoPlanCacheEntry, node, iter.cur);
+		if (bsearch(&relid, entry->relids, entry->nrelids, sizeof(Oid),
+					oid_cmp) != NULL)
+			hypo_plan_cache_evict(entry);
+	}
+}
+
+/*
+ * A function changed: drop the plans whose invalItems name it, or all of
+ * them if hashvalue is zero.
+ */
+static void
+hypo_plan_cache_func_callback(Datum arg, int cacheid, uint32 hashvalue)
+{
+	dlist_mutable_iter iter;
+
+	dlist_foreach_modify(iter, &hypoPlanCache)
+	{
+		HypoPlanCacheEntry *entry;
+		ListCell   *lc;
+
+		entry = dlist_container(HypoPlanCacheEntry, node, iter.cur);
+		foreach(lc, entry->plan->invalItems)
+		{
+			PlanInvalItem *item = (PlanInvalItem *) lfirst(lc);
+
+			if (item->cacheId != cacheid)
+				continue;
+			if (hashvalue == 0 || item->hashValue == hashvalue)
+			{
+				hypo_plan_cache_evict(entry);
+				break;
+			}
+		}
+	}
+}
+
+/*
+ * New statistics, tablespace cost settings, or a change to a schema,
+ * operator or operator family member: start over.
+ */
+static void
+hypo_plan_cache_syscache_callback(Datum arg, int cacheid, uint32 hashvalue)
+{
+	hypo_plan_cache_reset();
+}
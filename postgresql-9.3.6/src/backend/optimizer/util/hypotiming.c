@@ -0,0 +1,302 @@
+/*-------------------------------------------------------------------------
+ *
+ * hypotiming.c
+ *	  Planning time broken down by planner phase.
+ *
+ * HYPOTHETICAL INDEX
+ * SELF TUNING GROUP - PUC-RIO - 2015
+ *
+ * An index advisor plans the same workload under thousands of index
+ * configurations, so it needs to know where hypothetical planning spends
+ * its time.  planner() times a planning when hypothetical_planner_timing is
+ * on or EXPLAIN (SUMMARY) asked for it, and the planner marks the phases
+ * it enters with hypo_timing_enter() and hypo_timing_exit().  Phases nest,
+ * selectivity estimation inside path generation for instance, and each
+ * phase is charged only the time not spent in a phase nested inside it; the
+ * clock is only read when the phase actually changes.
+ *
+ * The times of the last planning are kept for EXPLAIN, and with
+ * hypothetical_planner_timing on they are also added to totals in shared
+ * memory, one for regular and one for hypothetical planning, which
+ * pg_stat_planner_phases shows.
+ *
+ * Portions Copyright (c) 1996-2013, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/optimizer/util/hypotiming.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "optimizer/hypotiming.h"
+#include "portability/instr_time.h"
+#include "storage/shmem.h"
+#include "storage/spin.h"
+
+
+/* GUC parameter */
+bool		hypothetical_planner_timing = false;
+
+const char *const hypo_phase_names[HYPO_NUM_PHASES] = {
+	"Other",
+	"Catalog",
+	"Selectivity",
+	"Paths",
+	"Join Search",
+	"Setrefs"
+};
+
+/* deeper nesting is charged to the phase at this depth */
+#define HYPO_TIMING_MAX_DEPTH	64
+
+typedef struct HypoTimingShared
+{
+	slock_t		mutex;			/* protects times */
+	HypoPlannerTimes times[HYPO_TIMING_KINDS];
+} HypoTimingShared;
+
+static HypoTimingShared *hypoTiming = NULL;
+
+/* state of the planning being timed */
+static bool timingRequested = false;
+static bool timingActive = false;
+static bool timingCached = false;
+static int	timingDepth = 0;
+static HypoPlannerPhase timingStack[HYPO_TIMING_MAX_DEPTH];
+static instr_time timingStart;
+static instr_time timingLast;
+static instr_time timingAccum[HYPO_NUM_PHASES];
+
+/* times of the last planning timed */
+static HypoPlannerTimes timingLastPlanning;
+
+
+/*
+ * Report shared-memory space needed by HypoTimingShmemInit
+ */
+Size
+HypoTimingShmemSize(void)
+{
+	return sizeof(HypoTimingShared);
+}
+
+/*
+ * Allocate and initialize the cumulative times
+ */
+void
+HypoTimingShmemInit(void)
+{
+	bool		found;
+
+	hypoTiming = (HypoTimingShared *)
+		ShmemInitStruct("Hypothetical Planner Timing", HypoTimingShmemSize(),
+						&found);
+
+	if (!found)
+	{
+		SpinLockInit(&hypoTiming->mutex);
+		memset(hypoTiming->times, 0, sizeof(hypoTiming->times));
+	}
+}
+
+/*
+ * hypo_timing_request
+ *		Time the next planning even if hypothetical_planner_timing is off.
+ */
+void
+hypo_timing_request(void)
+{
+	timingRequested = true;
+}
+
+/*
+ * hypo_timing_start
+ *		Start timing a planning, if wanted.
+ *
+ * Returns true if the caller must end it with hypo_timing_finish() or
+ * hypo_timing_abort().  A planning started while another one is timed, as
+ * for a query run by a function the planner evaluates, is part of that one.
+ */
+bool
+hypo_timing_start(void)
+{
+	int			i;
+
+	if (timingActive ||
+		!(hypothetical_planner_timing || timingRequested))
+		return false;
+
+	timingRequested = false;
+	timingActive = true;
+	timingCached = false;
+	timingDepth = 0;
+	for (i = 0; i < HYPO_NUM_PHASES; i++)
+		INSTR_TIME_SET_ZERO(timingAccum[i]);
+	INSTR_TIME_SET_CURRENT(timingStart);
+	timingLast = timingStart;
+
+	return true;
+}
+
+/*
+ * Phase currently being timed
+ */
+static HypoPlannerPhase
+hypo_timing_current(void)
+{
+	if (timingDepth == 0)
+		return HYPO_PHASE_OTHER;
+	return timingStack[Min(timingDepth, HYPO_TIMING_MAX_DEPTH) - 1];
+}
+
+/*
+ * hypo_timing_enter
+ *		Enter a planner phase; must be paired with hypo_timing_exit().
+ */
+void
+hypo_timing_enter(HypoPlannerPhase phase)
+{
+	HypoPlannerPhase current;
+	instr_time	now;
+
+	if (!timingActive)
+		return;
+
+	current = hypo_timing_current();
+	if (timingDepth < HYPO_TIMING_MAX_DEPTH)
+		timingStack[timingDepth] = phase;
+	else
+		phase = current;
+	timingDepth++;
+
+	if (phase == current)
+		return;
+
+	INSTR_TIME_SET_CURRENT(now);
+	INSTR_TIME_ACCUM_DIFF(timingAccum[current], now, timingLast);
+	timingLast = now;
+}
+
+/*
+ * hypo_timing_exit
+ *		Leave the phase entered last.
+ */
+void
+hypo_timing_exit(void)
+{
+	HypoPlannerPhase phase;
+	instr_time	now;
+
+	if (!timingActive || timingDepth == 0)
+		return;
+
+	phase = hypo_timing_current();
+	timingDepth--;
+	if (phase == hypo_timing_current())
+		return;
+
+	INSTR_TIME_SET_CURRENT(now);
+	INSTR_TIME_ACCUM_DIFF(timingAccum[phase], now, timingLast);
+	timingLast = now;
+}
+
+/*
+ * hypo_timing_cached
+ *		Note that the planning being timed was answered by the hypothetical
+ *		plan cache.
+ */
+void
+hypo_timing_cached(void)
+{
+	timingCached = true;
+}
+
+/*
+ * hypo_timing_finish
+ *		Stop timing a planning, remember its times and, if
+ *		hypothetical_planner_timing is on, add them to the totals.
+ */
+void
+hypo_timing_finish(bool hypothetical)
+{
+	HypoPlannerTimes *last = &timingLastPlanning;
+	instr_time	now;
+	int			i;
+
+	Assert(timingActive);
+
+	INSTR_TIME_SET_CURRENT(now);
+	INSTR_TIME_ACCUM_DIFF(timingAccum[hypo_timing_current()], now,
+						  timingLast);
+	INSTR_TIME_SUBTRACT(now, timingStart);
+
+	last->plannings = 1;
+	last->cached = timingCached ? 1 : 0;
+	last->total_ms = INSTR_TIME_GET_MILLISEC(now);
+	for (i = 0; i < HYPO_NUM_PHASES; i++)
+		last->phase_ms[i] = INSTR_TIME_GET_MILLISEC(timingAccum[i]);
+
+	timingActive = false;
+
+	if (hypothetical_planner_timing)
+	{
+		HypoPlannerTimes *total;
+
+		SpinLockAcquire(&hypoTiming->mutex);
+		total = &hypoTiming->times[hypothetical ? HYPO_TIMING_HYPOTHETICAL :
+								   HYPO_TIMING_REGULAR];
+		total->plannings += last->plannings;
+		total->cached += last->cached;
+		total->total_ms += last->total_ms;
+		for (i = 0; i < HYPO_NUM_PHASES; i++)
+			total->phase_ms[i] += last->phase_ms[i];
+		SpinLockRelease(&hypoTiming->mutex);
+	}
+}
+
+/*
+ * hypo_timing_abort
+ *		Stop timing a planning that failed.
+ */
+void
+hypo_timing_abort(void)
+{
+	timingActive = false;
+}
+
+/*
+ * hypo_timing_last
+ *		Times of the last planning timed in this backend.
+ */
+void
+hypo_timing_last(HypoPlannerTimes *times)
+{
+	*times = timingLastPlanning;
+}
+
+/*
+ * hypo_timing_snapshot
+ *		Copy the cumulative times, HYPO_TIMING_KINDS of them.
+ */
+void
+hypo_timing_snapshot(HypoPlannerTimes *times)
+{
+	SpinLockAcquire(&hypoTiming->mutex);
+	memcpy(times, hypoTiming->times, sizeof(hypoTiming->times));
+	SpinLockRelease(&hypoTiming->mutex);
+}
+
+/*
+ * hypo_timing_reset
+ *		Zero the cumulative times.
+ */
+void
+hypo_timing_reset(void)
+{
+	SpinLockAcquire(&hypoTiming->mutex);
+	memset(hypoTiming->times, 0, sizeof(hypoTiming->times));
+	SpinLockRelease(&hypoTiming->mutex);
+}
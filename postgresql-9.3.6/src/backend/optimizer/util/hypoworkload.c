@@ -0,0 +1,717 @@
+/*-------------------------------------------------------------------------
+ *
+ * hypoworkload.c
+ *	  Capture of the columns planned statements restrict and join on.
+ *
+ * HYPOTHETICAL INDEX
+ * SELF TUNING GROUP - PUC-RIO - 2015
+ *
+ * When hypothetical_workload_entries is set, standard_planner() hands every
+ * statement it plans to hypo_workload_capture(), which records the columns
+ * of ordinary tables appearing in the restriction clauses (baserestrictinfo
+ * and constant equivalence classes) and join clauses (joininfo and the other
+ * equivalence classes) of every query level, and ExecutorEnd counts the
+ * executions.  Statements are identified by the Query's queryId, which
+ * standard_planner() fills with hypo_workload_query_id() unless a plugin has
+ * set one already.  Like pg_stat_statements, that jumbles the node tags and
+ * the identifying fields of the Query tree in one walk, leaving out the
+ * values of constants.
+ *
+ * The statements live in a fixed-size ring in shared memory; once it is
+ * full, each new statement replaces the oldest one.  The ring serves the
+ * whole cluster, so statements are keyed by database and queryid, and
+ * relation OIDs are only ever read back in the database that captured
+ * them.  A shared hash table maps each key to its slot, so a statement is
+ * found without scanning the ring.  HypoWorkloadLock protects the hash table and the slots: it is
+ * taken shared to look a statement up and exclusive to add or remove one.
+ * The execution counts are bumped under the shared lock, so each slot has a
+ * spinlock of its own for them.  The index advisor reads the ring directly,
+ * so candidate generation needs neither statement logs nor reparsing.
+ *
+ * Portions Copyright (c) 1996-2013, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/optimizer/util/hypoworkload.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/hash.h"
+#include "access/sysattr.h"
+#include "access/transam.h"
+#include "miscadmin.h"
+#include "nodes/makefuncs.h"
+#include "nodes/nodeFuncs.h"
+#include "optimizer/hypoworkload.h"
+#include "optimizer/var.h"
+#include "parser/parsetree.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include "storage/spin.h"
+#include "utils/hsearch.h"
+#include "utils/lsyscache.h"
+
+
+/* GUC parameter */
+int			hypothetical_workload_entries = 0;
+
+/* Size of the buffer the Query tree is jumbled into before hashing */
+#define HYPO_JUMBLE_SIZE		1024
+
+typedef struct HypoJumbleState
+{
+	unsigned char jumble[HYPO_JUMBLE_SIZE];
+	Size		jumble_len;		/* bytes used in jumble[] */
+} HypoJumbleState;
+
+#define HYPO_JUMBLE(item) \
+	hypo_jumble_append(jstate, (const unsigned char *) &(item), sizeof(item))
+
+typedef struct HypoWorkloadSlot
+{
+	slock_t		mutex;			/* protects stmt.calls */
+	HypoWorkloadStatement stmt;	/* key.queryid 0 means unused */
+} HypoWorkloadSlot;
+
+typedef struct HypoWorkloadEntry
+{
+	HypoWorkloadKey key;		/* hash key of entry - MUST BE FIRST */
+	int			slot;			/* index of its slot in the ring */
+} HypoWorkloadEntry;
+
+typedef struct HypoWorkloadShared
+{
+	uint64		next;			/* slot to fill next, modulo the size */
+	HypoWorkloadSlot slots[1];	/* VARIABLE LENGTH ARRAY */
+} HypoWorkloadShared;
+
+static HypoWorkloadShared *hypoWorkload = NULL;
+static HTAB *hypoWorkloadHash = NULL;
+
+static void hypo_jumble_append(HypoJumbleState *jstate,
+				   const unsigned char *item, Size size);
+static bool hypo_jumble_walker(Node *node, HypoJumbleState *jstate);
+static void hypo_workload_capture_root(PlannerInfo *root,
+						   HypoWorkloadStatement *stmt);
+static void hypo_workload_add_vars(PlannerInfo *root, Node *clause,
+					   Index relid, char kind,
+					   HypoWorkloadStatement *stmt);
+static void hypo_workload_add_column(PlannerInfo *root, Node *expr, char kind,
+						 HypoWorkloadStatement *stmt);
+
+
+/*
+ * Report shared-memory space needed by HypoWorkloadShmemInit
+ */
+Size
+HypoWorkloadShmemSize(void)
+{
+	Size		size;
+
+	if (hypothetical_workload_entries <= 0)
+		return 0;
+
+	size = add_size(offsetof(HypoWorkloadShared, slots),
+					mul_size(sizeof(HypoWorkloadSlot),
+							 hypothetical_workload_entries));
+	size = add_size(size, hash_estimate_size(hypothetical_workload_entries,
+											 sizeof(HypoWorkloadEntry)));
+	return size;
+}
+
+/*
+ * Allocate and initialize the workload ring and its hash table
+ */
+void
+HypoWorkloadShmemInit(void)
+{
+	HASHCTL		info;
+	bool		found;
+	int			i;
+
+	if (hypothetical_workload_entries <= 0)
+		return;
+
+	hypoWorkload = (HypoWorkloadShared *)
+		ShmemInitStruct("Hypothetical Workload",
+						add_size(offsetof(HypoWorkloadShared, slots),
+								 mul_size(sizeof(HypoWorkloadSlot),
+										  hypothetical_workload_entries)),
+						&found);
+
+	if (!found)
+	{
+		hypoWorkload->next = 0;
+		for (i = 0; i < hypothetical_workload_entries; i++)
+		{
+			SpinLockInit(&hypoWorkload->slots[i].mutex);
+			memset(&hypoWorkload->slots[i].stmt, 0,
+				   sizeof(HypoWorkloadStatement));
+		}
+	}
+
+	MemSet(&info, 0, sizeof(info));
+	info.keysize = sizeof(HypoWorkloadKey);
+	info.entrysize = sizeof(HypoWorkloadEntry);
+	info.hash = tag_hash;
+	hypoWorkloadHash = ShmemInitHash("Hypothetical Workload Hash",
+									 hypothetical_workload_entries,
+									 hypothetical_workload_entries,
+									 &info,
+									 HASH_ELEM | HASH_FUNCTION);
+}
+
+/*
+ * hypo_workload_query_id
+ *		Compute the queryId identifying a statement in the ring.
+ *
+ * Statements differing only in their constants get the same queryId.
+ */
+uint32
+hypo_workload_query_id(Query *query)
+{
+	HypoJumbleState jstate;
+	uint32		queryid;
+
+	jstate.jumble_len = 0;
+	(void) hypo_jumble_walker((Node *) query, &jstate);
+
+	queryid = DatumGetUInt32(hash_any(jstate.jumble, jstate.jumble_len));
+
+	/* zero means "no queryId", so don't hand it out */
+	if (queryid == 0)
+		queryid = 1;
+
+	return queryid;
+}
+
+/*
+ * hypo_workload_capture
+ *		Record the columns a just-planned statement restricts and joins on.
+ *
+ * root is the top-level PlannerInfo; subqueries and sublinks are reached
+ * through it.  A statement already in the ring is left alone.
+ */
+void
+hypo_workload_capture(PlannerInfo *root, uint32 queryid)
+{
+	HypoWorkloadStatement stmt;
+	HypoWorkloadKey key;
+	HypoWorkloadEntry *entry;
+	ListCell   *lc;
+
+	if (hypoWorkload == NULL || queryid == 0)
+		return;
+
+	key.dbid = MyDatabaseId;
+	key.queryid = queryid;
+
+	LWLockAcquire(HypoWorkloadLock, LW_SHARED);
+	entry = (HypoWorkloadEntry *) hash_search(hypoWorkloadHash, &key,
+											  HASH_FIND, NULL);
+	LWLockRelease(HypoWorkloadLock);
+	if (entry != NULL)
+		return;
+
+	memset(&stmt, 0, sizeof(stmt));
+	hypo_workload_capture_root(root, &stmt);
+	foreach(lc, root->glob->subroots)
+		hypo_workload_capture_root((PlannerInfo *) lfirst(lc), &stmt);
+
+	/* nothing an index could help with */
+	if (stmt.ncolumns == 0)
+		return;
+
+	stmt.key = key;
+
+	LWLockAcquire(HypoWorkloadLock, LW_EXCLUSIVE);
+
+	/* another backend may have captured it meanwhile */
+	if (hash_search(hypoWorkloadHash, &key, HASH_FIND, NULL) == NULL)
+	{
+		int			i = hypoWorkload->next++ % hypothetical_workload_entries;
+		HypoWorkloadSlot *slot = &hypoWorkload->slots[i];
+
+		/* evict the statement the slot held, keeping the hash in bounds */
+		if (slot->stmt.key.queryid != 0)
+			hash_search(hypoWorkloadHash, &slot->stmt.key,
+						HASH_REMOVE, NULL);
+
+		entry = (HypoWorkloadEntry *) hash_search(hypoWorkloadHash, &key,
+												  HASH_ENTER, NULL);
+		entry->slot = i;
+		slot->stmt = stmt;
+	}
+
+	LWLockRelease(HypoWorkloadLock);
+}
+
+/*
+ * hypo_workload_count
+ *		Count one execution of a captured statement.
+ */
+void
+hypo_workload_count(uint32 queryid)
+{
+	HypoWorkloadKey key;
+	HypoWorkloadEntry *entry;
+
+	if (hypoWorkload == NULL || queryid == 0)
+		return;
+
+	key.dbid = MyDatabaseId;
+	key.queryid = queryid;
+
+	LWLockAcquire(HypoWorkloadLock, LW_SHARED);
+
+	entry = (HypoWorkloadEntry *) hash_search(hypoWorkloadHash, &key,
+											  HASH_FIND, NULL);
+	if (entry != NULL)
+	{
+		/* use volatile pointer to prevent code rearrangement */
+		volatile HypoWorkloadSlot *slot = &hypoWorkload->slots[entry->slot];
+
+		SpinLockAcquire(&slot->mutex);
+		slot->stmt.calls++;
+		SpinLockRelease(&slot->mutex);
+	}
+
+	LWLockRelease(HypoWorkloadLock);
+}
+
+/*
+ * hypo_workload_snapshot
+ *		Return a palloc'd copy of the statements captured in this database.
+ */
+HypoWorkloadStatement *
+hypo_workload_snapshot(int *nstatements)
+{
+	HypoWorkloadStatement *result;
+	int			n = 0;
+	int			i;
+
+	*nstatements = 0;
+	if (hypoWorkload == NULL)
+		return NULL;
+
+	result = (HypoWorkloadStatement *)
+		palloc(sizeof(HypoWorkloadStatement) * hypothetical_workload_entries);
+
+	LWLockAcquire(HypoWorkloadLock, LW_SHARED);
+
+	for (i = 0; i < hypothetical_workload_entries; i++)
+	{
+		volatile HypoWorkloadSlot *slot = &hypoWorkload->slots[i];
+
+		/* other databases' relation OIDs mean nothing here */
+		if (slot->stmt.key.queryid == 0 ||
+			slot->stmt.key.dbid != MyDatabaseId)
+			continue;
+
+		result[n] = hypoWorkload->slots[i].stmt;
+
+		/* the count may be changing under the shared lock */
+		SpinLockAcquire(&slot->mutex);
+		result[n].calls = slot->stmt.calls;
+		SpinLockRelease(&slot->mutex);
+
+		n++;
+	}
+
+	LWLockRelease(HypoWorkloadLock);
+
+	*nstatements = n;
+	return result;
+}
+
+/*
+ * hypo_workload_reset
+ *		Forget all captured statements.
+ */
+void
+hypo_workload_reset(void)
+{
+	int			i;
+
+	if (hypoWorkload == NULL)
+		return;
+
+	LWLockAcquire(HypoWorkloadLock, LW_EXCLUSIVE);
+
+	for (i = 0; i < hypothetical_workload_entries; i++)
+	{
+		HypoWorkloadSlot *slot = &hypoWorkload->slots[i];
+
+		if (slot->stmt.key.queryid != 0)
+			hash_search(hypoWorkloadHash, &slot->stmt.key,
+						HASH_REMOVE, NULL);
+		memset(&slot->stmt, 0, sizeof(HypoWorkloadStatement));
+	}
+
+	LWLockRelease(HypoWorkloadLock);
+}
+
+/*
+ * Append a value to the jumble, hashing the buffer down whenever it fills.
+ */
+static void
+hypo_jumble_append(HypoJumbleState *jstate, const unsigned char *item,
+				   Size size)
+{
+	unsigned char *jumble = jstate->jumble;
+	Size		jumble_len = jstate->jumble_len;
+
+	while (size > 0)
+	{
+		Size		part_size;
+
+		if (jumble_len >= HYPO_JUMBLE_SIZE)
+		{
+			uint32		start_hash = hash_any(jumble, HYPO_JUMBLE_SIZE);
+
+			memcpy(jumble, &start_hash, sizeof(start_hash));
+			jumble_len = sizeof(start_hash);
+		}
+		part_size = Min(size, HYPO_JUMBLE_SIZE - jumble_len);
+		memcpy(jumble + jumble_len, item, part_size);
+		jumble_len += part_size;
+		item += part_size;
+		size -= part_size;
+	}
+	jstate->jumble_len = jumble_len;
+}
+
+/*
+ * Jumble the tag of each node and the fields that set it apart from other
+ * nodes of its type.  Constants contribute their type only, and parse
+ * locations nothing.  The walkers recurse into everything else.
+ */
+static bool
+hypo_jumble_walker(Node *node, HypoJumbleState *jstate)
+{
+	if (node == NULL)
+		return false;
+
+	check_stack_depth();
+
+	HYPO_JUMBLE(node->type);
+
+	switch (nodeTag(node))
+	{
+		case T_Query:
+			{
+				Query	   *query = (Query *) node;
+
+				HYPO_JUMBLE(query->commandType);
+				/* the walkers leave these clause lists alone */
+				(void) hypo_jumble_walker((Node *) query->groupClause, jstate);
+				(void) hypo_jumble_walker((Node *) query->windowClause, jstate);
+				(void) hypo_jumble_walker((Node *) query->distinctClause,
+										  jstate);
+				(void) hypo_jumble_walker((Node *) query->sortClause, jstate);
+				return query_tree_walker(query, hypo_jumble_walker,
+										 (void *) jstate, QTW_EXAMINE_RTES);
+			}
+		case T_RangeTblEntry:
+			{
+				RangeTblEntry *rte = (RangeTblEntry *) node;
+
+				HYPO_JUMBLE(rte->rtekind);
+				switch (rte->rtekind)
+				{
+					case RTE_RELATION:
+						HYPO_JUMBLE(rte->relid);
+						break;
+					case RTE_JOIN:
+						HYPO_JUMBLE(rte->jointype);
+						break;
+					case RTE_CTE:
+						hypo_jumble_append(jstate,
+										   (const unsigned char *) rte->ctename,
+										   strlen(rte->ctename) + 1);
+						HYPO_JUMBLE(rte->ctelevelsup);
+						break;
+					default:
+						break;
+				}
+				/* range_table_walker goes on into its contents */
+				return false;
+			}
+		case T_SortGroupClause:
+			{
+				SortGroupClause *sgc = (SortGroupClause *) node;
+
+				HYPO_JUMBLE(sgc->tleSortGroupRef);
+				HYPO_JUMBLE(sgc->eqop);
+				HYPO_JUMBLE(sgc->sortop);
+				HYPO_JUMBLE(sgc->nulls_first);
+				return false;
+			}
+		case T_WindowClause:
+			{
+				WindowClause *wc = (WindowClause *) node;
+
+				HYPO_JUMBLE(wc->winref);
+				HYPO_JUMBLE(wc->frameOptions);
+				(void) hypo_jumble_walker((Node *) wc->partitionClause, jstate);
+				(void) hypo_jumble_walker((Node *) wc->orderClause, jstate);
+				(void) hypo_jumble_walker(wc->startOffset, jstate);
+				(void) hypo_jumble_walker(wc->endOffset, jstate);
+				return false;
+			}
+		case T_Var:
+			{
+				Var		   *var = (Var *) node;
+
+				HYPO_JUMBLE(var->varno);
+				HYPO_JUMBLE(var->varattno);
+				HYPO_JUMBLE(var->varlevelsup);
+			}
+			break;
+		case T_Const:
+			HYPO_JUMBLE(((Const *) node)->consttype);
+			break;
+		case T_Param:
+			{
+				Param	   *p = (Param *) node;
+
+				HYPO_JUMBLE(p->paramkind);
+				HYPO_JUMBLE(p->paramid);
+				HYPO_JUMBLE(p->paramtype);
+			}
+			break;
+		case T_Aggref:
+			HYPO_JUMBLE(((Aggref *) node)->aggfnoid);
+			break;
+		case T_WindowFunc:
+			HYPO_JUMBLE(((WindowFunc *) node)->winfnoid);
+			HYPO_JUMBLE(((WindowFunc *) node)->winref);
+			break;
+		case T_FuncExpr:
+			HYPO_JUMBLE(((FuncExpr *) node)->funcid);
+			break;
+		case T_OpExpr:
+		case T_DistinctExpr:
+		case T_NullIfExpr:
+			HYPO_JUMBLE(((OpExpr *) node)->opno);
+			break;
+		case T_ScalarArrayOpExpr:
+			HYPO_JUMBLE(((ScalarArrayOpExpr *) node)->opno);
+			HYPO_JUMBLE(((ScalarArrayOpExpr *) node)->useOr);
+			break;
+		case T_BoolExpr:
+			HYPO_JUMBLE(((BoolExpr *) node)->boolop);
+			break;
+		case T_SubLink:
+			HYPO_JUMBLE(((SubLink *) node)->subLinkType);
+			break;
+		case T_FieldSelect:
+			HYPO_JUMBLE(((FieldSelect *) node)->fieldnum);
+			break;
+		case T_RelabelType:
+			HYPO_JUMBLE(((RelabelType *) node)->resulttype);
+			break;
+		case T_CoerceViaIO:
+			HYPO_JUMBLE(((CoerceViaIO *) node)->resulttype);
+			break;
+		case T_ArrayCoerceExpr:
+			HYPO_JUMBLE(((ArrayCoerceExpr *) node)->resulttype);
+			break;
+		case T_ConvertRowtypeExpr:
+			HYPO_JUMBLE(((ConvertRowtypeExpr *) node)->resulttype);
+			break;
+		case T_CoerceToDomain:
+			HYPO_JUMBLE(((CoerceToDomain *) node)->resulttype);
+			break;
+		case T_CollateExpr:
+			HYPO_JUMBLE(((CollateExpr *) node)->collOid);
+			break;
+		case T_RowCompareExpr:
+			HYPO_JUMBLE(((RowCompareExpr *) node)->rctype);
+			break;
+		case T_MinMaxExpr:
+			HYPO_JUMBLE(((MinMaxExpr *) node)->op);
+			break;
+		case T_NullTest:
+			HYPO_JUMBLE(((NullTest *) node)->nulltesttype);
+			break;
+		case T_BooleanTest:
+			HYPO_JUMBLE(((BooleanTest *) node)->booltesttype);
+			break;
+		case T_TargetEntry:
+			HYPO_JUMBLE(((TargetEntry *) node)->resno);
+			HYPO_JUMBLE(((TargetEntry *) node)->ressortgroupref);
+			break;
+		case T_RangeTblRef:
+			HYPO_JUMBLE(((RangeTblRef *) node)->rtindex);
+			break;
+		case T_JoinExpr:
+			HYPO_JUMBLE(((JoinExpr *) node)->jointype);
+			HYPO_JUMBLE(((JoinExpr *) node)->isNatural);
+			HYPO_JUMBLE(((JoinExpr *) node)->rtindex);
+			break;
+		case T_SetOperationStmt:
+			HYPO_JUMBLE(((SetOperationStmt *) node)->op);
+			HYPO_JUMBLE(((SetOperationStmt *) node)->all);
+			break;
+		default:
+			break;
+	}
+
+	return expression_tree_walker(node, hypo_jumble_walker, (void *) jstate);
+}
+
+/*
+ * Collect the columns of one query level, and of the subqueries planned
+ * as part of it.
+ */
+static void
+hypo_workload_capture_root(PlannerInfo *root, HypoWorkloadStatement *stmt)
+{
+	ListCell   *lc;
+	int			i;
+
+	/* Equivalence classes hold the mergejoinable equalities */
+	foreach(lc, root->eq_classes)
+	{
+		EquivalenceClass *ec = (EquivalenceClass *) lfirst(lc);
+		char		kind;
+		ListCell   *lc2;
+
+		if (ec->ec_has_const)
+			kind = HYPO_CLAUSE_EQUALITY;
+		else if (bms_membership(ec->ec_relids) == BMS_MULTIPLE)
+			kind = HYPO_CLAUSE_JOIN;
+		else
+			continue;
+
+		foreach(lc2, ec->ec_members)
+		{
+			EquivalenceMember *em = (EquivalenceMember *) lfirst(lc2);
+
+			if (!em->em_is_child && !em->em_is_const)
+				hypo_workload_add_column(root, (Node *) em->em_expr, kind,
+										 stmt);
+		}
+	}
+
+	for (i = 1; i < root->simple_rel_array_size; i++)
+	{
+		RelOptInfo *rel = root->simple_rel_array[i];
+
+		if (rel == NULL || rel->reloptkind != RELOPT_BASEREL)
+			continue;
+
+		if (rel->rtekind == RTE_SUBQUERY && rel->subroot != NULL)
+		{
+			hypo_workload_capture_root(rel->subroot, stmt);
+			continue;
+		}
+		if (rel->rtekind != RTE_RELATION)
+			continue;
+
+		foreach(lc, rel->baserestrictinfo)
+		{
+			RestrictInfo *rinfo = (RestrictInfo *) lfirst(lc);
+			Node	   *clause = (Node *) rinfo->clause;
+
+			if (IsA(clause, OpExpr) &&
+				list_length(((OpExpr *) clause)->args) == 2)
+			{
+				OpExpr	   *opexpr = (OpExpr *) clause;
+				char	   *opname = get_opname(opexpr->opno);
+				char		kind = HYPO_CLAUSE_RESTRICTION;
+
+				if (opname != NULL && strcmp(opname, "=") == 0)
+					kind = HYPO_CLAUSE_EQUALITY;
+				hypo_workload_add_column(root, linitial(opexpr->args), kind,
+										 stmt);
+				hypo_workload_add_column(root, lsecond(opexpr->args), kind,
+										 stmt);
+			}
+			else
+				hypo_workload_add_vars(root, clause, rel->relid,
+									   HYPO_CLAUSE_RESTRICTION, stmt);
+		}
+
+		foreach(lc, rel->joininfo)
+		{
+			RestrictInfo *rinfo = (RestrictInfo *) lfirst(lc);
+
+			hypo_workload_add_vars(root, (Node *) rinfo->clause, rel->relid,
+								   HYPO_CLAUSE_JOIN, stmt);
+		}
+	}
+}
+
+/*
+ * Add every column of base relation relid that clause references.
+ */
+static void
+hypo_workload_add_vars(PlannerInfo *root, Node *clause, Index relid,
+					   char kind, HypoWorkloadStatement *stmt)
+{
+	Bitmapset  *attnos = NULL;
+	int			attno;
+
+	pull_varattnos(clause, relid, &attnos);
+	while ((attno = bms_first_member(attnos)) >= 0)
+	{
+		Var		   *var;
+
+		attno += FirstLowInvalidHeapAttributeNumber;
+		if (attno <= 0)
+			continue;
+
+		var = makeVar(relid, attno, InvalidOid, -1, InvalidOid, 0);
+		hypo_workload_add_column(root, (Node *) var, kind, stmt);
+	}
+	bms_free(attnos);
+}
+
+/*
+ * Add expr to the statement if it is a user column of an ordinary table
+ * outside the system catalogs, and not there yet.
+ */
+static void
+hypo_workload_add_column(PlannerInfo *root, Node *expr, char kind,
+						 HypoWorkloadStatement *stmt)
+{
+	Var		   *var;
+	RangeTblEntry *rte;
+	int			i;
+
+	while (expr && IsA(expr, RelabelType))
+		expr = (Node *) ((RelabelType *) expr)->arg;
+	if (expr == NULL || !IsA(expr, Var))
+		return;
+
+	var = (Var *) expr;
+	if (var->varlevelsup != 0 || var->varattno <= 0 ||
+		var->varno >= root->simple_rel_array_size)
+		return;
+
+	rte = root->simple_rte_array[var->varno];
+	if (rte == NULL || rte->rtekind != RTE_RELATION ||
+		rte->relid < FirstNormalObjectId)
+		return;
+
+	for (i = 0; i < stmt->ncolumns; i++)
+	{
+		if (stmt->columns[i].relid == rte->relid &&
+			stmt->columns[i].attnum == var->varattno &&
+			stmt->columns[i].kind == kind)
+			return;
+	}
+
+	if (stmt->ncolumns >= HYPO_WORKLOAD_MAX_COLUMNS)
+		return;
+
+	stmt->columns[stmt->ncolumns].relid = rte->relid;
+	stmt->columns[stmt->ncolumns].attnum = var->varattno;
+	stmt->columns[stmt->ncolumns].kind = kind;
+	stmt->ncolumns++;
+}
@@ -32,6 +32,8 @@
 #include "nodes/makefuncs.h"
 #include "optimizer/clauses.h"
 #include "optimizer/cost.h"
+#include "optimizer/hypoindex.h"
+#include "optimizer/hypotiming.h"
 #include "optimizer/plancat.h"
 #include "optimizer/predtest.h"
 #include "optimizer/prep.h"
@@ -39,9 +41,11 @@
 #include "parser/parsetree.h"
 #include "rewrite/rewriteManip.h"
 #include "storage/bufmgr.h"
+#include "storage/lmgr.h"
 #include "utils/lsyscache.h"
 #include "utils/rel.h"
 #include "utils/snapmgr.h"
+#include "utils/syscache.h"
 
 
 /* GUC parameter */
@@ -57,6 +61,8 @@ static List *get_relation_constraints(PlannerInfo *root,
 						 bool include_notnull);
 static List *build_index_tlist(PlannerInfo *root, IndexOptInfo *index,
 				  Relation heapRelation);
+static List *get_private_hypothetical_indexes(PlannerInfo *root,
+								 Relation relation, RelOptInfo *rel);
 
 
 /*
@@ -91,6 +97,9 @@ get_relation_info(PlannerInfo *root, Oid relationObjectId, bool inhparent,
 	bool		hasindex;
 	List	   *indexinfos = NIL;
 
+	/* HYPOTHETICAL INDEX: charge the catalog lookups to their own phase */
+	hypo_timing_enter(HYPO_PHASE_CATALOG);
+
 	/*
 	 * We need not lock the relation since it was already locked, either by
 	 * the rewriter or when expand_inherited_rtentry() added it to the query's
@@ -134,9 +143,20 @@ get_relation_info(PlannerInfo *root, Oid relationObjectId, bool inhparent,
 	else
 		hasindex = relation->rd_rel->relhasindex;
 
+	/*
+	 * HYPOTHETICAL INDEX
+	 * SELF TUNING GROUP - PUC-RIO - 2015
+	 *
+	 * CREATE HYPOTHETICAL INDEX leaves relhasindex alone, see index_create().
+	 */
+	if (root->parse->hypothetical && !inhparent &&
+		!(IgnoreSystemIndexes && IsSystemClass(relation->rd_rel)))
+		hasindex = true;
+
     if (hasindex)
 	{
 		List	   *indexoidlist;
+		bool		hashypothetical;
 		ListCell   *l;
 		LOCKMODE	lmode;
 
@@ -147,6 +167,8 @@ get_relation_info(PlannerInfo *root, Oid relationObjectId, bool inhparent,
          * That information is in the Query structure of parse
         */
         indexoidlist = RelationGetIndexList_PUC(relation,root->parse->hypothetical);
+		hashypothetical = root->parse->hypothetical &&
+			relation->rd_hashypothetical;
 
 		/*
 		 * For each index, we get the same type of lock that the executor will
@@ -170,6 +192,33 @@ get_relation_info(PlannerInfo *root, Oid relationObjectId, bool inhparent,
 			int			ncolumns;
 			int			i;
 
+			/*
+			 * HYPOTHETICAL INDEX
+			 * SELF TUNING GROUP - PUC-RIO - 2015
+			 *
+			 * Hypothetical planning can also be asked to pretend an
+			 * existing index has been dropped.
+			 */
+			if (root->parse->hypothetical && hypo_index_is_disabled(indexoid))
+				continue;
+
+			/*
+			 * DROP HYPOTHETICAL INDEX doesn't lock the table against us, so
+			 * a hypothetical index in the list may be gone by the time we
+			 * get its lock.  Skip it then, as if we had come a bit later.
+			 * The table lock keeps real indexes in place, so a list without
+			 * hypothetical entries needs no such check.
+			 */
+			if (hashypothetical)
+			{
+				LockRelationOid(indexoid, lmode);
+				if (!SearchSysCacheExists1(RELOID, ObjectIdGetDatum(indexoid)))
+				{
+					UnlockRelationOid(indexoid, lmode);
+					continue;
+				}
+			}
+
 			/*
 			 * Extract info from the relation descriptor for the index.
 			 */
@@ -215,98 +264,25 @@ get_relation_info(PlannerInfo *root, Oid relationObjectId, bool inhparent,
                 info->opfamily = (Oid *) palloc(sizeof(Oid) * ncolumns);
                 info->opcintype = (Oid *) palloc(sizeof(Oid) * ncolumns);
                 
-                /**
-                * HYPOTHETICAL INDEX
-                * SELF TUNING GROUP - PUC-RIO - 2015
-                *
-                * Variable declaration to estimate hypothetical index size
-                */
-
-                int32 tmp_typmod;
-                int totalcolumnsize, columnsize, keysize, entrysize, pagents, leaves, precision, scale;
-                totalcolumnsize = 0;
-
-
                 for (i = 0; i < ncolumns; i++)
                 {
                     info->indexkeys[i] = index->indkey.values[i];
                     info->indexcollations[i] = indexRelation->rd_indcollation[i];
                     info->opfamily[i] = indexRelation->rd_opfamily[i];
                     info->opcintype[i] = indexRelation->rd_opcintype[i];
-                    /**
-                    * HYPOTHETICAL INDEX
-                    * SELF TUNING GROUP - PUC-RIO - 2015
-                    *
-                    * Get column size to estimate hypothetical index size in Bytes
-                    */
-                    switch (indexRelation->rd_opcintype[i])
-                    {
-                            case BITOID:			// Type = bit
-                                columnsize = ((indexRelation->rd_att->attrs[i]->atttypmod)/8);
-                                break;
-                            case BOOLOID:			// Type = boolean
-                            case FLOAT4OID:			// Type = real
-                                columnsize = 4;
-                                break;
-                            case INT2OID:			// Type = smallint
-                                columnsize = 2;
-                                break;
-                            case INT4OID: 			// Type = integer = serial
-                                columnsize = (indexRelation->rd_att->attrs[i]->attlen);
-                                break;
-                            case FLOAT8OID:			// Type = double precision
-                            case INT8OID:			// Type = bigint = bigserial
-                                columnsize = 8;
-                                break;
-                            case BPCHAROID:			// Type = bpchar = character [(n)]
-                            case CHAROID:			// Type = character [(n)]
-                            case VARCHAROID:		// Type = varchar = character varying [(n)]
-                            case NAMEOID:			// Type = name
-                            case TEXTOID: 			// Type = text = character varying [(n)]
-                                columnsize = (indexRelation->rd_att->attrs[i]->atttypmod) - VARHDRSZ;
-                                break;
-                            case NUMERICOID:		// Type = numeric [(precision, scale)]
-                                tmp_typmod = ((indexRelation->rd_att->attrs[i]->atttypmod) - VARHDRSZ);
-                                precision = (tmp_typmod >> 16) & 0xffff;
-                                scale = tmp_typmod & 0xffff;
-                                if (precision <= 4)
-                                    columnsize = 2;
-                                else
-                                    if (precision <= 9)
-                                        columnsize = 4;
-                                    else
-                                        if (precision <= 18)
-                                            columnsize = 8;
-                                        else
-                                            columnsize = 4 + 2 * ( (int) ( ( (precision - scale) + 3) / 4) + (int) ( (scale + 3) / 4) + 1);
-                                break;
-                            case TIMEOID:			// Type = time = time without time zone
-                            case ABSTIMEOID:		// Type = abstime = time without time zone
-                            case DATEOID:			// Type = date = time without time zone
-                            case RELTIMEOID:		// Type = relativetime = time without time zone
-                                columnsize = 8;
-                                break;
-                            case INTERVALOID:		// Type = interval
-                            case TINTERVALOID: 		// Type = time interval
-                            case TIMETZOID:			// Type = time with time zone
-                                columnsize = 12;
-                                break;
-                            case TIMESTAMPOID:		// Type = timestamp
-                            case TIMESTAMPTZOID:	// Type = timestamp without time zone
-                                columnsize = 8;
-                                break;
-                            case VARBITOID:			// Type = bit varying
-                                columnsize = ((indexRelation->rd_att->attrs[i]->atttypmod)/8);
-                                break;
-                            default:
-                                columnsize = 4;
-                    }
-                    totalcolumnsize = totalcolumnsize + columnsize;
                 }
 
                 info->relam = indexRelation->rd_rel->relam;
                 info->amcostestimate = indexRelation->rd_am->amcostestimate;
-                info->canreturn = index_can_return(indexRelation);
+                /* HYPOTHETICAL INDEX: amcanreturn may need the index's storage */
+                if (index->indishypothetical)
+                    info->canreturn =
+                        hypo_index_can_return(info->relam, info->opfamily[0],
+                                              info->opcintype[0],
+                                              indexRelation->rd_att->attrs[0]->atttypid,
+                                              info->indexcollations[0]);
+                else
+                    info->canreturn = index_can_return(indexRelation);
                 info->amcanorderbyop = indexRelation->rd_am->amcanorderbyop;
                 info->amoptionalkey = indexRelation->rd_am->amoptionalkey;
                 info->amsearcharray = indexRelation->rd_am->amsearcharray;
@@ -433,32 +409,22 @@ get_relation_info(PlannerInfo *root, Oid relationObjectId, bool inhparent,
                 * HYPOTHETICAL INDEX
                 * SELF TUNING GROUP - PUC-RIO - 2015
                 *
-                * For hypothetical indexes, correct pages and tuples information.
-                * Page information is refined in selfunc.c for btrees
-                * We first approximating based on IBM Informix Dynamic Server Performance Guide
+                * A hypothetical index has no storage, so estimate the size it
+                * would have from the column statistics.  This also gives us
+                * the btree height.  A partial index only covers the tuples
+                * its predicate selects.
                 */
                 if (index->indishypothetical)
                 {
-
-                    //To estimate the number of index pages
-                    //Add up the total widths of the indexed column or columns (totalColumnSize). Add 4 to colsize to obtain keysize.
-                    keysize = (ncolumns * 4) + totalcolumnsize;
-
-                    //Estimate the size of a typical index entry. We consider the worst case - For fragmented tables
-                    entrysize = keysize + 9 + 4;
-
-                    //Estimate the number of entries per index page
-                    //pagefree = 8192 (page size) - 20 (page header size) = 8172
-                    pagents = trunc(8172/entrysize);
-
-                    //Estimate the number of leaf pages
-                    leaves = ceil(rel->tuples/pagents);
-
-                    //leaves = hypothetical pages size
-                    info->pages = leaves;
-                    //relation tuples = hypothetical tuples size
-                    info->tuples = rel->tuples;
-
+                    info->tuples = hypo_index_predicate_tuples(relation,
+                                        RelationGetIndexPredicate(indexRelation),
+                                                               rel->tuples);
+                    hypo_index_estimate_size(relation, info->relam, ncolumns,
+                                             info->indexkeys, info->indexprs,
+                                             hypo_index_fillfactor(info->relam,
+                                                                   indexRelation->rd_options),
+                                             info->tuples,
+                                             &info->pages, &info->tree_height);
                 }
                 else
                 {
@@ -485,29 +451,25 @@ get_relation_info(PlannerInfo *root, Oid relationObjectId, bool inhparent,
                  * Get information whether the index is or not hypothetical
                  */
                 info->hypothetical = index->indishypothetical; /* SELF TUNING GROUP */
+                info->clustered = index->indishypothetical &&
+                    index->indisclustered;
 
                 indexinfos = lcons(info, indexinfos); /* SELF TUNING GROUP */
 // marca de error
 
-            if (info->relam == BTREE_AM_OID)
+            if (index->indishypothetical)
             {
-				/* For btrees, get tree height while we have the index open */
-
                 /**
                  * HYPOTHETICAL INDEX
                  * SELF TUNING GROUP - PUC-RIO - 2015
                  *
-                 * Hypothetical Index don't have height
+                 * tree_height was estimated along with the size above
                  */
-                if(!index->indishypothetical){
-                    info->tree_height = _bt_getrootheight(indexRelation);
-                }
-                else{
-                    info->tree_height=-1;
-                }
-
-
-
+            }
+            else if (info->relam == BTREE_AM_OID)
+            {
+				/* For btrees, get tree height while we have the index open */
+                info->tree_height = _bt_getrootheight(indexRelation);
             }
             else
             {
@@ -527,6 +489,45 @@ get_relation_info(PlannerInfo *root, Oid relationObjectId, bool inhparent,
         }
         list_free(indexoidlist);
     }
+
+    /**
+     * HYPOTHETICAL INDEX
+     * SELF TUNING GROUP - PUC-RIO - 2015
+     *
+     * Session-private hypothetical indexes have no pg_index entry, so they
+     * are considered even if relhasindex is false.
+     */
+    if (root->parse->hypothetical && !inhparent &&
+        !(IgnoreSystemIndexes && IsSystemClass(relation->rd_rel)))
+        indexinfos = list_concat(get_private_hypothetical_indexes(root, relation, rel),
+                                 indexinfos);
+
+    /*
+     * HYPOTHETICAL INDEX
+     * SELF TUNING GROUP - PUC-RIO - 2015
+     *
+     * If a hypothetical index could be scanned index-only, cost its heap
+     * fetches with the current visibility map.  Real indexes keep the
+     * relation's figure from pg_class, see cost_index().
+     */
+    if (root->parse->hypothetical && !inhparent)
+    {
+        ListCell   *l;
+        double      allvisfrac = -1;
+
+        foreach(l, indexinfos)
+        {
+            IndexOptInfo *info = (IndexOptInfo *) lfirst(l);
+
+            if (info->hypothetical && info->canreturn)
+            {
+                if (allvisfrac < 0)
+                    allvisfrac = hypo_index_allvisfrac(relation);
+                info->allvisfrac = allvisfrac;
+            }
+        }
+    }
+
     rel->indexlist = indexinfos;
 
 	/* Grab the fdwroutine info using the relcache, while we have it */
@@ -547,8 +548,123 @@ get_relation_info(PlannerInfo *root, Oid relationObjectId, bool inhparent,
     if (get_relation_info_hook)
         (*get_relation_info_hook) (root, relationObjectId, inhparent, rel);
 
+    hypo_timing_exit();
    }
 
+/**
+ * HYPOTHETICAL INDEX
+ * SELF TUNING GROUP - PUC-RIO - 2015
+ *
+ * get_private_hypothetical_indexes
+ *		Build IndexOptInfos for the session-private hypothetical indexes of
+ *		a relation.
+ *
+ * This mirrors what get_relation_info() does for catalog indexes, taking
+ * everything from the HypoIndex entry instead of an open index relation.
+ */
+static List *
+get_private_hypothetical_indexes(PlannerInfo *root, Relation relation,
+								 RelOptInfo *rel)
+{
+	Index		varno = rel->relid;
+	List	   *hypoindexes;
+	List	   *indexinfos = NIL;
+	ListCell   *l;
+
+	hypoindexes = hypo_index_list_for_relation(relation);
+
+	foreach(l, hypoindexes)
+	{
+		HypoIndex  *entry = (HypoIndex *) lfirst(l);
+		IndexOptInfo *info;
+		int			ncolumns = entry->ncolumns;
+		int			i;
+
+		info = makeNode(IndexOptInfo);
+
+		info->indexoid = entry->oid;
+		info->reltablespace = entry->reltablespace;
+		info->rel = rel;
+		info->ncolumns = ncolumns;
+		info->indexkeys = (int *) palloc(sizeof(int) * ncolumns);
+		info->indexcollations = (Oid *) palloc(sizeof(Oid) * ncolumns);
+		info->opfamily = (Oid *) palloc(sizeof(Oid) * ncolumns);
+		info->opcintype = (Oid *) palloc(sizeof(Oid) * ncolumns);
+
+		for (i = 0; i < ncolumns; i++)
+		{
+			info->indexkeys[i] = entry->indexkeys[i];
+			info->indexcollations[i] = entry->indexcollations[i];
+			info->opfamily[i] = entry->opfamily[i];
+			info->opcintype[i] = entry->opcintype[i];
+		}
+
+		info->relam = entry->relam;
+		info->amcostestimate = entry->amcostestimate;
+		info->canreturn = entry->canreturn;
+		info->amcanorderbyop = entry->amcanorderbyop;
+		info->amoptionalkey = entry->amoptionalkey;
+		info->amsearcharray = entry->amsearcharray;
+		info->amsearchnulls = entry->amsearchnulls;
+		info->amhasgettuple = entry->amhasgettuple;
+		info->amhasgetbitmap = entry->amhasgetbitmap;
+
+		/*
+		 * Only btree is both amcanorder and allowed here, so its opfamilies
+		 * double as the sort ordering opfamilies.
+		 */
+		if (entry->amcanorder)
+		{
+			info->sortopfamily = info->opfamily;
+			info->reverse_sort = (bool *) palloc(sizeof(bool) * ncolumns);
+			info->nulls_first = (bool *) palloc(sizeof(bool) * ncolumns);
+
+			for (i = 0; i < ncolumns; i++)
+			{
+				int16		opt = entry->indoption[i];
+
+				info->reverse_sort[i] = (opt & INDOPTION_DESC) != 0;
+				info->nulls_first[i] = (opt & INDOPTION_NULLS_FIRST) != 0;
+			}
+		}
+		else
+		{
+			info->sortopfamily = NULL;
+			info->reverse_sort = NULL;
+			info->nulls_first = NULL;
+		}
+
+		/* Same varno fix-up as for relcache copies */
+		info->indexprs = (List *) copyObject(entry->indexprs);
+		info->indpred = (List *) copyObject(entry->indpred);
+		if (info->indexprs && varno != 1)
+			ChangeVarNodes((Node *) info->indexprs, 1, varno, 0);
+		if (info->indpred && varno != 1)
+			ChangeVarNodes((Node *) info->indpred, 1, varno, 0);
+
+		info->indextlist = build_index_tlist(root, info, relation);
+
+		info->predOK = false;	/* set later in indxpath.c */
+		info->unique = entry->unique;
+		info->immediate = true;
+
+		info->tuples = hypo_index_predicate_tuples(relation, entry->indpred,
+												   rel->tuples);
+		hypo_index_estimate_size(relation, info->relam, ncolumns,
+								 info->indexkeys, info->indexprs,
+								 entry->fillfactor, info->tuples,
+								 &info->pages, &info->tree_height);
+		info->hypothetical = true;
+		info->clustered = entry->clustered;
+
+		indexinfos = lcons(info, indexinfos);
+	}
+
+	list_free(hypoindexes);
+
+	return indexinfos;
+}
+
 /*
  * estimate_rel_size - estimate # pages and # tuples in a table or index
  *
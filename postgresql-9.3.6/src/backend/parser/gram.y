@@ -375,6 +375,7 @@ static Node *makeRecursiveViewSelect(char *relname, List *aliases, Node *query);
 
 %type <boolean> opt_instead
 %type <boolean> opt_unique opt_concurrently opt_verbose opt_full
+%type <boolean> opt_hypo_temp opt_hypo_on_commit /* HYPOTHETICAL INDEX */
 %type <boolean> opt_freeze opt_default opt_recheck
 %type <defelt>	opt_binary opt_oids copy_delimiter
 
@@ -5102,6 +5103,43 @@ DropStmt:	DROP drop_type IF_P EXISTS any_name_list opt_drop_behavior
 					n->concurrent = false;
 					$$ = (Node *)n;
 				}
+			/* HYPOTHETICAL INDEX SELF TUNING GROUP - PUC-RIO - 2015 */
+			| DROP HYPOTHETICAL INDEX IF_P EXISTS any_name_list opt_drop_behavior
+				{
+					DropStmt *n = makeNode(DropStmt);
+					n->removeType = OBJECT_INDEX;
+					n->missing_ok = TRUE;
+					n->objects = $6;
+					n->arguments = NIL;
+					n->behavior = $7;
+					n->concurrent = false;
+					n->hypothetical = true;
+					$$ = (Node *)n;
+				}
+			| DROP HYPOTHETICAL INDEX any_name_list opt_drop_behavior
+				{
+					DropStmt *n = makeNode(DropStmt);
+					n->removeType = OBJECT_INDEX;
+					n->missing_ok = FALSE;
+					n->objects = $4;
+					n->arguments = NIL;
+					n->behavior = $5;
+					n->concurrent = false;
+					n->hypothetical = true;
+					$$ = (Node *)n;
+				}
+			| DROP ALL HYPOTHETICAL INDEXES opt_drop_behavior
+				{
+					DropStmt *n = makeNode(DropStmt);
+					n->removeType = OBJECT_INDEX;
+					n->missing_ok = TRUE;
+					n->objects = NIL;
+					n->arguments = NIL;
+					n->behavior = $5;
+					n->concurrent = false;
+					n->hypothetical = true;
+					$$ = (Node *)n;
+				}
 			| DROP INDEX CONCURRENTLY any_name_list opt_drop_behavior
 				{
 					DropStmt *n = makeNode(DropStmt);
@@ -5131,11 +5169,6 @@ drop_type:	TABLE									{ $$ = OBJECT_TABLE; }
 			| SEQUENCE								{ $$ = OBJECT_SEQUENCE; }
 			| VIEW									{ $$ = OBJECT_VIEW; }
 			| MATERIALIZED VIEW						{ $$ = OBJECT_MATVIEW; }
-                        | HYPOTHETICAL INDEX
-                            {
-                            /* HYPOTHETICAL INDEX SELF TUNING GROUP - PUC-RIO - 2015 */
-                                $$ = OBJECT_INDEX;
-                            }
                         | INDEX                                                         { $$ = OBJECT_INDEX; }
 			| FOREIGN TABLE							{ $$ = OBJECT_FOREIGN_TABLE; }
 			| EVENT TRIGGER 						{ $$ = OBJECT_EVENT_TRIGGER; }
@@ -6077,21 +6110,24 @@ defacl_privilege_target:
  *****************************************************************************/
  /* HYPOTHETICAL INDEX SELF TUNING GROUP - PUC-RIO - 2015 */
 
-IndexStmt:	CREATE HYPOTHETICAL opt_unique INDEX opt_concurrently opt_index_name
-			ON qualified_name access_method_clause '(' index_params ')'
-			opt_reloptions OptTableSpace where_clause
+IndexStmt:	CREATE opt_hypo_temp HYPOTHETICAL opt_unique INDEX opt_concurrently
+			opt_index_name ON qualified_name access_method_clause
+			'(' index_params ')' opt_reloptions OptTableSpace where_clause
+			opt_hypo_on_commit
 				{
                                         IndexStmt *n = makeNode(IndexStmt);
                                         n->hypothetical = true;
-                                        n->unique = $3;
-                                        n->concurrent = $5;
-                                        n->idxname = $6;
-                                        n->relation = $8;
-                                        n->accessMethod = $9;
-                                        n->indexParams = $11;
-                                        n->options = $13;
-                                        n->tableSpace = $14;
-                                        n->whereClause = $15;
+                                        n->temporary = $2;
+                                        n->unique = $4;
+                                        n->concurrent = $6;
+                                        n->idxname = $7;
+                                        n->relation = $9;
+                                        n->accessMethod = $10;
+                                        n->indexParams = $12;
+                                        n->options = $14;
+                                        n->tableSpace = $15;
+                                        n->whereClause = $16;
+                                        n->oncommitdrop = $17;
 					n->excludeOpNames = NIL;
 					n->idxcomment = NULL;
 					n->indexOid = InvalidOid;
@@ -6134,6 +6170,18 @@ opt_unique:
 			| /*EMPTY*/								{ $$ = FALSE; }
 		;
 
+/* HYPOTHETICAL INDEX SELF TUNING GROUP - PUC-RIO - 2015 */
+opt_hypo_temp:
+			TEMPORARY								{ $$ = TRUE; }
+			| TEMP									{ $$ = TRUE; }
+			| /*EMPTY*/								{ $$ = FALSE; }
+		;
+
+opt_hypo_on_commit:
+			ON COMMIT DROP							{ $$ = TRUE; }
+			| /*EMPTY*/								{ $$ = FALSE; }
+		;
+
 opt_concurrently:
 			CONCURRENTLY							{ $$ = TRUE; }
 			| /*EMPTY*/								{ $$ = FALSE; }
@@ -8675,6 +8723,14 @@ ExplainStmt:
 					n->options = NIL;
 					$$ = (Node *) n;
 				}
+		| EXPLAIN HYPOTHETICAL '(' explain_option_list ')' ExplainableStmt
+				{
+					ExplainStmt *n = makeNode(ExplainStmt);
+					n->hypothetical = true;
+					n->query = $6;
+					n->options = $4;
+					$$ = (Node *) n;
+				}
                 | EXPLAIN ExplainableStmt
                 {
                         ExplainStmt *n = makeNode(ExplainStmt);
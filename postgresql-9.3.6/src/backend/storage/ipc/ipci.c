@@ -22,6 +22,9 @@
 #include "access/twophase.h"
 #include "commands/async.h"
 #include "miscadmin.h"
+#include "optimizer/hypoindex.h"
+#include "optimizer/hypotiming.h"
+#include "optimizer/hypoworkload.h"
 #include "pgstat.h"
 #include "postmaster/autovacuum.h"
 #include "postmaster/bgwriter.h"
@@ -127,6 +130,9 @@ CreateSharedMemoryAndSemaphores(bool makePrivate, int port)
 		size = add_size(size, BTreeShmemSize());
 		size = add_size(size, SyncScanShmemSize());
 		size = add_size(size, AsyncShmemSize());
+		size = add_size(size, HypoWorkloadShmemSize());
+		size = add_size(size, HypoIndexShmemSize());
+		size = add_size(size, HypoTimingShmemSize());
 #ifdef EXEC_BACKEND
 		size = add_size(size, ShmemBackendArraySize());
 #endif
@@ -236,6 +242,9 @@ CreateSharedMemoryAndSemaphores(bool makePrivate, int port)
 	BTreeShmemInit();
 	SyncScanShmemInit();
 	AsyncShmemInit();
+	HypoWorkloadShmemInit();
+	HypoIndexShmemInit();
+	HypoTimingShmemInit();
 
 #ifdef EXEC_BACKEND
 
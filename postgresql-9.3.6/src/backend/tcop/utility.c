@@ -53,6 +53,7 @@
 #include "commands/vacuum.h"
 #include "commands/view.h"
 #include "miscadmin.h"
+#include "optimizer/hypoindex.h"
 #include "parser/parse_utilcmd.h"
 #include "postmaster/bgwriter.h"
 #include "rewrite/rewriteDefine.h"
@@ -159,7 +160,6 @@ check_xact_readonly(Node *parsetree)
 		case T_CreateDomainStmt:
 		case T_CreateFunctionStmt:
 		case T_CreateRoleStmt:
-		case T_IndexStmt:
 		case T_CreatePLangStmt:
 		case T_CreateOpClassStmt:
 		case T_CreateOpFamilyStmt:
@@ -204,6 +204,21 @@ check_xact_readonly(Node *parsetree)
 		case T_SecLabelStmt:
 			PreventCommandIfReadOnly(CreateCommandTag(parsetree));
 			break;
+
+			/*
+			 * HYPOTHETICAL INDEX
+			 * SELF TUNING GROUP - PUC-RIO - 2015
+			 *
+			 * A session-private hypothetical index is only kept in backend
+			 * memory, so it can be created in a read-only transaction and on
+			 * a hot standby.
+			 */
+		case T_IndexStmt:
+			if (((IndexStmt *) parsetree)->hypothetical &&
+				hypothetical_index_private)
+				break;
+			PreventCommandIfReadOnly(CreateCommandTag(parsetree));
+			break;
 		default:
 			/* do nothing */
 			break;
@@ -1123,6 +1138,18 @@ ProcessUtilitySlow(Node *parsetree,
 					 */
 					lockmode = stmt->concurrent ? ShareUpdateExclusiveLock
 						: ShareLock;
+
+					/*
+					 * HYPOTHETICAL INDEX
+					 * SELF TUNING GROUP - PUC-RIO - 2015
+					 *
+					 * A hypothetical index only needs the table to stay put
+					 * while DefineIndex() looks at it, so it takes no lock
+					 * that DML or another CREATE HYPOTHETICAL INDEX would
+					 * wait for.
+					 */
+					if (stmt->hypothetical)
+						lockmode = AccessShareLock;
 					relid =
 						RangeVarGetRelidExtended(stmt->relation, lockmode,
 												 false, false,
@@ -14,6 +14,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 
+#include "access/genam.h"
 #include "access/heapam.h"
 #include "access/htup_details.h"
 #include "catalog/catalog.h"
@@ -23,11 +24,14 @@
 #include "commands/tablespace.h"
 #include "common/relpath.h"
 #include "miscadmin.h"
+#include "optimizer/hypoindex.h"
+#include "optimizer/plancat.h"
 #include "storage/fd.h"
 #include "utils/acl.h"
 #include "utils/builtins.h"
 #include "utils/numeric.h"
 #include "utils/rel.h"
+#include "utils/relcache.h"
 #include "utils/relmapper.h"
 #include "utils/syscache.h"
 
@@ -512,6 +516,82 @@ pg_total_relation_size(PG_FUNCTION_ARGS)
 	PG_RETURN_INT64(size);
 }
 
+/*
+ * HYPOTHETICAL INDEX
+ * SELF TUNING GROUP - PUC-RIO - 2015
+ *
+ * Estimated size of a hypothetical index, in bytes.  This is the figure
+ * the planner costs the index with, so it can be checked against the size
+ * of the same index actually built.  Session-private indexes are looked up
+ * first, then hypothetical indexes in the catalogs.
+ */
+Datum
+pg_hypothetical_index_size(PG_FUNCTION_ARGS)
+{
+	text	   *indexname = PG_GETARG_TEXT_P(0);
+	RangeVar   *rv;
+	HypoIndex  *hypoindex;
+	Relation	heapRel;
+	Relation	indexRel = NULL;
+	BlockNumber heappages;
+	double		tuples;
+	double		allvisfrac;
+	BlockNumber pages;
+	int			tree_height;
+
+	rv = makeRangeVarFromNameList(textToQualifiedNameList(indexname));
+
+	hypoindex = hypo_index_lookup(rv->schemaname, rv->relname);
+	if (hypoindex != NULL)
+		heapRel = heap_open(hypoindex->relid, AccessShareLock);
+	else
+	{
+		indexRel = index_open(RangeVarGetRelid(rv, AccessShareLock, false),
+							  AccessShareLock);
+		if (!indexRel->rd_index->indishypothetical)
+			ereport(ERROR,
+					(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+					 errmsg("\"%s\" is not a hypothetical index",
+							RelationGetRelationName(indexRel))));
+		heapRel = heap_open(indexRel->rd_index->indrelid, AccessShareLock);
+	}
+
+	estimate_rel_size(heapRel, NULL, &heappages, &tuples, &allvisfrac);
+
+	if (hypoindex != NULL)
+		hypo_index_estimate_size(heapRel, hypoindex->relam,
+								 hypoindex->ncolumns, hypoindex->indexkeys,
+								 hypoindex->indexprs, hypoindex->fillfactor,
+								 hypo_index_predicate_tuples(heapRel,
+														hypoindex->indpred,
+															 tuples),
+								 &pages, &tree_height);
+	else
+	{
+		int			ncolumns = indexRel->rd_index->indnatts;
+		int		   *indexkeys = (int *) palloc(sizeof(int) * ncolumns);
+		int			i;
+
+		for (i = 0; i < ncolumns; i++)
+			indexkeys[i] = indexRel->rd_index->indkey.values[i];
+
+		hypo_index_estimate_size(heapRel, indexRel->rd_rel->relam,
+								 ncolumns, indexkeys,
+								 RelationGetIndexExpressions(indexRel),
+								 hypo_index_fillfactor(indexRel->rd_rel->relam,
+													   indexRel->rd_options),
+								 hypo_index_predicate_tuples(heapRel,
+									  RelationGetIndexPredicate(indexRel),
+															 tuples),
+								 &pages, &tree_height);
+		index_close(indexRel, AccessShareLock);
+	}
+
+	heap_close(heapRel, AccessShareLock);
+
+	PG_RETURN_INT64((int64) pages * BLCKSZ);
+}
+
 /*
  * formatting with size units
  */
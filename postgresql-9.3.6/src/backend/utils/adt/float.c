@@ -69,7 +69,6 @@ int			extra_float_digits = 0;		/* Added to DBL_DIG or FLT_DIG */
 
 
 static int	float4_cmp_internal(float4 a, float4 b);
-static int	float8_cmp_internal(float8 a, float8 b);
 
 #ifndef HAVE_CBRT
 /*
@@ -1045,7 +1044,7 @@ btfloat4sortsupport(PG_FUNCTION_ARGS)
 /*
  *		float8{eq,ne,lt,le,gt,ge}		- float8/float8 comparison operations
  */
-static int
+int
 float8_cmp_internal(float8 a, float8 b)
 {
 	/*
@@ -0,0 +1,1190 @@
+/*-------------------------------------------------------------------------
+ *
+ * hypofuncs.c
+ *	  SQL-callable functions for hypothetical indexes.
+ *
+ * HYPOTHETICAL INDEX
+ * SELF TUNING GROUP - PUC-RIO - 2015
+ *
+ * Portions Copyright (c) 1996-2013, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/utils/adt/hypofuncs.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/heapam.h"
+#include "access/htup_details.h"
+#include "catalog/namespace.h"
+#include "catalog/pg_am.h"
+#include "catalog/pg_class.h"
+#include "catalog/pg_type.h"
+#include "commands/defrem.h"
+#include "commands/tablecmds.h"
+#include "funcapi.h"
+#include "lib/stringinfo.h"
+#include "miscadmin.h"
+#include "nodes/nodeFuncs.h"
+#include "nodes/plannodes.h"
+#include "optimizer/hypoindex.h"
+#include "optimizer/hypotiming.h"
+#include "optimizer/hypoworkload.h"
+#include "optimizer/plancat.h"
+#include "optimizer/planner.h"
+#include "optimizer/tlist.h"
+#include "parser/parse_utilcmd.h"
+#include "parser/parsetree.h"
+#include "tcop/tcopprot.h"
+#include "utils/array.h"
+#include "utils/builtins.h"
+#include "utils/guc.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+
+
+/*
+ * Columns a query level restricts, joins or sorts on, for one table.
+ */
+typedef struct HypoColumnGroup
+{
+	Oid			relid;
+	List	   *eqattnos;		/* columns compared with = or IN */
+	List	   *otherattnos;	/* other restricted or sorted columns */
+} HypoColumnGroup;
+
+typedef struct HypoColumnContext
+{
+	List	   *rtable;			/* range table of the query level */
+	List	   *groups;			/* HypoColumnGroups of the query level */
+	List	  **allgroups;		/* where finished levels go */
+} HypoColumnContext;
+
+/*
+ * An index the advisor considers.
+ */
+typedef struct HypoCandidate
+{
+	Oid			relid;
+	List	   *attnos;			/* index columns, in order */
+	char	   *indexdef;		/* CREATE INDEX statement */
+	Oid			indexoid;		/* the private hypothetical index */
+	int64		size;			/* estimated size in bytes */
+	bool		chosen;
+} HypoCandidate;
+
+static List *hypo_text_array_to_list(ArrayType *array);
+static List *hypo_prepare_workload(List *querystrings);
+static double hypo_querytrees_cost(List *querytrees, Oid indexoid,
+					 bool *uses_index, MemoryContext plan_ctx);
+static double hypo_workload_cost(List *workload, MemoryContext plan_ctx);
+static void hypo_drop_candidates(List *indexoids);
+static Oid	hypo_define_candidate(const char *indexdef);
+static int64 hypo_candidate_size(Oid indexoid);
+static void hypo_collect_columns(Query *query, List **allgroups);
+static bool hypo_collect_columns_walker(Node *node, HypoColumnContext *context);
+static void hypo_note_column(HypoColumnContext *context, Node *expr,
+				 bool equality);
+static List *hypo_add_candidate(List *candidates, Oid relid, List *attnos);
+static List *hypo_add_captured_columns(List *groups);
+static bool hypo_plan_uses_index(Plan *plan, Oid indexoid);
+static bool hypo_plan_list_uses_index(List *plans, Oid indexoid);
+
+
+/*
+ * hypothetical_index_costs
+ *		Cost a workload under a series of hypothetical index configurations.
+ *
+ * indexes holds CREATE [HYPOTHETICAL] INDEX statements and queries holds
+ * the workload.  Each query is parsed, analyzed and rewritten only once.
+ * The candidates become session-private hypothetical indexes, and for every
+ * configuration the planner is shown just that configuration's candidate;
+ * configuration 0 has no candidate.  Real and catalog hypothetical indexes
+ * stay visible throughout, while the session's own private indexes are
+ * hidden for the duration of the call.
+ *
+ * Returns one row per configuration and query, with the total estimated
+ * cost (summed over the queries a rule rewrite may produce) and whether the
+ * plan scans the candidate index.
+ */
+Datum
+hypothetical_index_costs(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	List	   *indexdefs;
+	List	   *querystrings;
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext per_query_ctx;
+	MemoryContext plan_ctx;
+	MemoryContext oldcontext;
+	List	   *workload;
+	List	   *candidates = NIL;
+	ListCell   *lc;
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not " \
+						"allowed in this context")));
+
+	indexdefs = hypo_text_array_to_list(PG_GETARG_ARRAYTYPE_P(0));
+	querystrings = hypo_text_array_to_list(PG_GETARG_ARRAYTYPE_P(1));
+
+	workload = hypo_prepare_workload(querystrings);
+
+	/* need to build tuplestore in query context */
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	tupdesc = CreateTemplateTupleDesc(4, false);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 1, "candidate",
+					   INT4OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 2, "query",
+					   INT4OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 3, "total_cost",
+					   FLOAT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 4, "uses_candidate",
+					   BOOLOID, -1, 0);
+
+	tupstore =
+		tuplestore_begin_heap(rsinfo->allowedModes & SFRM_Materialize_Random,
+							  false, work_mem);
+
+	MemoryContextSwitchTo(oldcontext);
+
+	plan_ctx = AllocSetContextCreate(CurrentMemoryContext,
+									 "hypothetical_index_costs",
+									 ALLOCSET_DEFAULT_MINSIZE,
+									 ALLOCSET_DEFAULT_INITSIZE,
+									 ALLOCSET_DEFAULT_MAXSIZE);
+
+	/*
+	 * Private indexes do not go away on abort, so make sure the candidates
+	 * do not outlive this call whatever happens.
+	 */
+	PG_TRY();
+	{
+		int			ncandidates;
+		int			candidate;
+
+		foreach(lc, indexdefs)
+			candidates = lappend_oid(candidates,
+									 hypo_define_candidate((char *) lfirst(lc)));
+
+		ncandidates = list_length(candidates);
+		for (candidate = 0; candidate <= ncandidates; candidate++)
+		{
+			Oid			indexoid = InvalidOid;
+			int			queryno = 0;
+
+			if (candidate > 0)
+			{
+				indexoid = list_nth_oid(candidates, candidate - 1);
+				hypo_index_set_visible(list_make1_oid(indexoid));
+			}
+			else
+				hypo_index_set_visible(NIL);
+
+			foreach(lc, workload)
+			{
+				double		total_cost;
+				bool		uses_candidate;
+				Datum		values[4];
+				bool		nulls[4];
+
+				queryno++;
+				total_cost = hypo_querytrees_cost((List *) lfirst(lc), indexoid,
+												  &uses_candidate, plan_ctx);
+
+				values[0] = Int32GetDatum(candidate);
+				values[1] = Int32GetDatum(queryno);
+				values[2] = Float8GetDatum(total_cost);
+				values[3] = BoolGetDatum(uses_candidate);
+				memset(nulls, 0, sizeof(nulls));
+				tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+			}
+		}
+	}
+	PG_CATCH();
+	{
+		hypo_drop_candidates(candidates);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	hypo_drop_candidates(candidates);
+
+	MemoryContextDelete(plan_ctx);
+
+	/* clean up and return the tuplestore */
+	tuplestore_donestoring(tupstore);
+
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	return (Datum) 0;
+}
+
+/*
+ * hypothetical_index_advisor
+ *		Recommend indexes for a workload within a storage budget.
+ *
+ * Candidate columns are taken from the WHERE and JOIN conditions and the
+ * ORDER BY of every query level of the workload.  Each such column becomes
+ * a single-column btree candidate, and the columns one query level uses on
+ * one table give a multi-column candidate: the columns compared for
+ * equality first, then one other column, at most three in all.
+ *
+ * All candidates are created as session-private hypothetical indexes and
+ * sized with the same estimate EXPLAIN HYPOTHETICAL uses.  The selection is
+ * the usual greedy knapsack heuristic: starting from the existing indexes,
+ * repeatedly add the candidate with the largest workload cost reduction per
+ * byte that still fits in the budget, until no candidate helps any more.
+ * Every step plans the whole workload, which the hypothetical plan cache
+ * keeps cheap for queries not touching the candidate's table.
+ *
+ * If the workload capture is on, the columns captured statements use on
+ * the tables of the given workload are considered too, one group of
+ * columns per statement and table.
+ *
+ * Returns the chosen CREATE INDEX statements in the order they were picked,
+ * with their estimated size and the cost reduction they brought when picked.
+ */
+Datum
+hypothetical_index_advisor(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	List	   *querystrings;
+	int64		budget = PG_GETARG_INT64(1);
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext per_query_ctx;
+	MemoryContext plan_ctx;
+	MemoryContext oldcontext;
+	List	   *workload;
+	List	   *groups = NIL;
+	List	   *candidates = NIL;
+	List	   *indexoids = NIL;
+	ListCell   *lc;
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not " \
+						"allowed in this context")));
+
+	if (budget < 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("storage budget must not be negative")));
+
+	querystrings = hypo_text_array_to_list(PG_GETARG_ARRAYTYPE_P(0));
+	workload = hypo_prepare_workload(querystrings);
+
+	/* Collect the interesting columns, before planning scribbles on them */
+	foreach(lc, workload)
+	{
+		ListCell   *lc2;
+
+		foreach(lc2, (List *) lfirst(lc))
+			hypo_collect_columns((Query *) lfirst(lc2), &groups);
+	}
+	groups = hypo_add_captured_columns(groups);
+
+	/* Turn them into candidates */
+	foreach(lc, groups)
+	{
+		HypoColumnGroup *group = (HypoColumnGroup *) lfirst(lc);
+		List	   *multi;
+		ListCell   *lc2;
+
+		foreach(lc2, group->eqattnos)
+			candidates = hypo_add_candidate(candidates, group->relid,
+											list_make1_int(lfirst_int(lc2)));
+		foreach(lc2, group->otherattnos)
+			candidates = hypo_add_candidate(candidates, group->relid,
+											list_make1_int(lfirst_int(lc2)));
+
+		multi = list_copy(group->eqattnos);
+		foreach(lc2, group->otherattnos)
+		{
+			if (!list_member_int(multi, lfirst_int(lc2)))
+			{
+				multi = lappend_int(multi, lfirst_int(lc2));
+				break;
+			}
+		}
+		multi = list_truncate(multi, 3);
+		if (list_length(multi) > 1)
+			candidates = hypo_add_candidate(candidates, group->relid, multi);
+	}
+
+	/* need to build tuplestore in query context */
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	tupdesc = CreateTemplateTupleDesc(3, false);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 1, "indexdef",
+					   TEXTOID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 2, "size",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 3, "benefit",
+					   FLOAT8OID, -1, 0);
+
+	tupstore =
+		tuplestore_begin_heap(rsinfo->allowedModes & SFRM_Materialize_Random,
+							  false, work_mem);
+
+	MemoryContextSwitchTo(oldcontext);
+
+	plan_ctx = AllocSetContextCreate(CurrentMemoryContext,
+									 "hypothetical_index_advisor",
+									 ALLOCSET_DEFAULT_MINSIZE,
+									 ALLOCSET_DEFAULT_INITSIZE,
+									 ALLOCSET_DEFAULT_MAXSIZE);
+
+	PG_TRY();
+	{
+		List	   *chosen = NIL;
+		double		current_cost;
+		int64		remaining = budget;
+
+		foreach(lc, candidates)
+		{
+			HypoCandidate *cand = (HypoCandidate *) lfirst(lc);
+
+			cand->indexoid = hypo_define_candidate(cand->indexdef);
+			indexoids = lappend_oid(indexoids, cand->indexoid);
+			cand->size = hypo_candidate_size(cand->indexoid);
+		}
+
+		hypo_index_set_visible(NIL);
+		current_cost = hypo_workload_cost(workload, plan_ctx);
+
+		for (;;)
+		{
+			HypoCandidate *best = NULL;
+			double		best_cost = 0;
+			double		best_ratio = 0;
+			Datum		values[3];
+			bool		nulls[3];
+
+			CHECK_FOR_INTERRUPTS();
+
+			foreach(lc, candidates)
+			{
+				HypoCandidate *cand = (HypoCandidate *) lfirst(lc);
+				double		cost;
+				double		ratio;
+
+				if (cand->chosen || cand->size > remaining)
+					continue;
+
+				hypo_index_set_visible(lappend_oid(list_copy(chosen),
+												   cand->indexoid));
+				cost = hypo_workload_cost(workload, plan_ctx);
+				ratio = (current_cost - cost) / (double) Max(cand->size, 1);
+				if (ratio > best_ratio)
+				{
+					best = cand;
+					best_cost = cost;
+					best_ratio = ratio;
+				}
+			}
+
+			if (best == NULL)
+				break;
+
+			best->chosen = true;
+			chosen = lappend_oid(chosen, best->indexoid);
+			remaining -= best->size;
+
+			values[0] = CStringGetTextDatum(best->indexdef);
+			values[1] = Int64GetDatum(best->size);
+			values[2] = Float8GetDatum(current_cost - best_cost);
+			memset(nulls, 0, sizeof(nulls));
+			tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+
+			current_cost = best_cost;
+		}
+	}
+	PG_CATCH();
+	{
+		hypo_drop_candidates(indexoids);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	hypo_drop_candidates(indexoids);
+
+	MemoryContextDelete(plan_ctx);
+
+	/* clean up and return the tuplestore */
+	tuplestore_donestoring(tupstore);
+
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	return (Datum) 0;
+}
+
+/*
+ * Deconstruct a text[] into a List of C strings, rejecting NULLs.
+ */
+static List *
+hypo_text_array_to_list(ArrayType *array)
+{
+	Datum	   *elems;
+	bool	   *nulls;
+	int			nelems;
+	List	   *result = NIL;
+	int			i;
+
+	deconstruct_array(array, TEXTOID, -1, false, 'i',
+					  &elems, &nulls, &nelems);
+	for (i = 0; i < nelems; i++)
+	{
+		if (nulls[i])
+			ereport(ERROR,
+					(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+					 errmsg("array must not contain null values")));
+		result = lappend(result, TextDatumGetCString(elems[i]));
+	}
+	return result;
+}
+
+/*
+ * hypothetical_workload
+ *		Show the statements captured for the index advisor in the current
+ *		database, one row per column.
+ */
+Datum
+hypothetical_workload(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext per_query_ctx;
+	MemoryContext oldcontext;
+	HypoWorkloadStatement *stmts;
+	int			nstmts;
+	int			i;
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not " \
+						"allowed in this context")));
+
+	/* need to build tuplestore in query context */
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	tupdesc = CreateTemplateTupleDesc(5, false);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 1, "queryid",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 2, "calls",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 3, "relid",
+					   OIDOID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 4, "attnum",
+					   INT2OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 5, "clause",
+					   TEXTOID, -1, 0);
+
+	tupstore =
+		tuplestore_begin_heap(rsinfo->allowedModes & SFRM_Materialize_Random,
+							  false, work_mem);
+
+	MemoryContextSwitchTo(oldcontext);
+
+	stmts = hypo_workload_snapshot(&nstmts);
+	for (i = 0; i < nstmts; i++)
+	{
+		int			j;
+
+		for (j = 0; j < stmts[i].ncolumns; j++)
+		{
+			HypoWorkloadColumn *col = &stmts[i].columns[j];
+			Datum		values[5];
+			bool		nulls[5];
+			const char *clause;
+
+			switch (col->kind)
+			{
+				case HYPO_CLAUSE_EQUALITY:
+					clause = "equality";
+					break;
+				case HYPO_CLAUSE_JOIN:
+					clause = "join";
+					break;
+				default:
+					clause = "restriction";
+					break;
+			}
+
+			values[0] = Int64GetDatum((int64) stmts[i].key.queryid);
+			values[1] = Int64GetDatum(stmts[i].calls);
+			values[2] = ObjectIdGetDatum(col->relid);
+			values[3] = Int16GetDatum(col->attnum);
+			values[4] = CStringGetTextDatum(clause);
+			memset(nulls, 0, sizeof(nulls));
+			tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+		}
+	}
+
+	/* clean up and return the tuplestore */
+	tuplestore_donestoring(tupstore);
+
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	return (Datum) 0;
+}
+
+/*
+ * hypothetical_workload_reset
+ *		Forget the statements captured for the index advisor.
+ */
+Datum
+hypothetical_workload_reset(PG_FUNCTION_ARGS)
+{
+	if (!superuser())
+		ereport(ERROR,
+				(errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+				 errmsg("must be superuser to reset the captured workload")));
+
+	hypo_workload_reset();
+
+	PG_RETURN_VOID();
+}
+
+/*
+ * pg_stat_get_planner_phases
+ *		Cumulative planning time by planner phase, one row for regular and
+ *		one for hypothetical planning.
+ */
+Datum
+pg_stat_get_planner_phases(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext per_query_ctx;
+	MemoryContext oldcontext;
+	HypoPlannerTimes times[HYPO_TIMING_KINDS];
+	int			kind;
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not " \
+						"allowed in this context")));
+
+	/* need to build tuplestore in query context */
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	tupdesc = CreateTemplateTupleDesc(4 + HYPO_NUM_PHASES, false);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 1, "kind",
+					   TEXTOID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 2, "plannings",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 3, "cached",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 4, "total_time",
+					   FLOAT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 5, "catalog_time",
+					   FLOAT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 6, "selectivity_time",
+					   FLOAT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 7, "paths_time",
+					   FLOAT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 8, "join_search_time",
+					   FLOAT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 9, "setrefs_time",
+					   FLOAT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 10, "other_time",
+					   FLOAT8OID, -1, 0);
+
+	tupstore =
+		tuplestore_begin_heap(rsinfo->allowedModes & SFRM_Materialize_Random,
+							  false, work_mem);
+
+	MemoryContextSwitchTo(oldcontext);
+
+	hypo_timing_snapshot(times);
+	for (kind = 0; kind < HYPO_TIMING_KINDS; kind++)
+	{
+		Datum		values[4 + HYPO_NUM_PHASES];
+		bool		nulls[4 + HYPO_NUM_PHASES];
+
+		values[0] = CStringGetTextDatum(kind == HYPO_TIMING_HYPOTHETICAL ?
+										"hypothetical" : "regular");
+		values[1] = Int64GetDatum(times[kind].plannings);
+		values[2] = Int64GetDatum(times[kind].cached);
+		values[3] = Float8GetDatum(times[kind].total_ms);
+		values[4] = Float8GetDatum(times[kind].phase_ms[HYPO_PHASE_CATALOG]);
+		values[5] = Float8GetDatum(times[kind].phase_ms[HYPO_PHASE_SELECTIVITY]);
+		values[6] = Float8GetDatum(times[kind].phase_ms[HYPO_PHASE_PATHS]);
+		values[7] = Float8GetDatum(times[kind].phase_ms[HYPO_PHASE_JOIN_SEARCH]);
+		values[8] = Float8GetDatum(times[kind].phase_ms[HYPO_PHASE_SETREFS]);
+		values[9] = Float8GetDatum(times[kind].phase_ms[HYPO_PHASE_OTHER]);
+		memset(nulls, 0, sizeof(nulls));
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+
+	/* clean up and return the tuplestore */
+	tuplestore_donestoring(tupstore);
+
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	return (Datum) 0;
+}
+
+/*
+ * pg_stat_reset_planner_phases
+ *		Zero the cumulative planning times.
+ */
+Datum
+pg_stat_reset_planner_phases(PG_FUNCTION_ARGS)
+{
+	if (!superuser())
+		ereport(ERROR,
+				(errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+				 errmsg("must be superuser to reset planner phase statistics")));
+
+	hypo_timing_reset();
+
+	PG_RETURN_VOID();
+}
+
+/*
+ * Parse, analyze and rewrite a workload, giving one list of Query trees per
+ * query string.  The planner scribbles on its input, so callers must plan
+ * copies of these.
+ */
+static List *
+hypo_prepare_workload(List *querystrings)
+{
+	List	   *workload = NIL;
+	ListCell   *lc;
+
+	foreach(lc, querystrings)
+	{
+		char	   *sql = (char *) lfirst(lc);
+		List	   *querytrees = NIL;
+		ListCell   *lc2;
+
+		foreach(lc2, pg_parse_query(sql))
+		{
+			Node	   *parsetree = (Node *) lfirst(lc2);
+
+			querytrees = list_concat(querytrees,
+									 pg_analyze_and_rewrite(parsetree, sql,
+															NULL, 0));
+		}
+
+		foreach(lc2, querytrees)
+		{
+			Query	   *query = (Query *) lfirst(lc2);
+
+			if (query->commandType == CMD_UTILITY)
+				ereport(ERROR,
+						(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+						 errmsg("utility statements cannot be costed: \"%s\"",
+								sql)));
+			query->hypothetical = true;
+		}
+
+		workload = lappend(workload, querytrees);
+	}
+
+	return workload;
+}
+
+/*
+ * Total estimated cost of the Query trees one query string rewrote into,
+ * under the current set of visible private indexes.  If uses_index is not
+ * NULL, it is set to whether any of the plans scans indexoid.
+ */
+static double
+hypo_querytrees_cost(List *querytrees, Oid indexoid, bool *uses_index,
+					 MemoryContext plan_ctx)
+{
+	double		total_cost = 0;
+	MemoryContext oldcontext;
+	ListCell   *lc;
+
+	if (uses_index)
+		*uses_index = false;
+
+	oldcontext = MemoryContextSwitchTo(plan_ctx);
+
+	foreach(lc, querytrees)
+	{
+		Query	   *query = copyObject(lfirst(lc));
+		PlannedStmt *plan;
+
+		plan = planner(query, 0, NULL);
+		total_cost += plan->planTree->total_cost;
+		if (uses_index && OidIsValid(indexoid) &&
+			(hypo_plan_uses_index(plan->planTree, indexoid) ||
+			 hypo_plan_list_uses_index(plan->subplans, indexoid)))
+			*uses_index = true;
+	}
+
+	MemoryContextSwitchTo(oldcontext);
+	MemoryContextReset(plan_ctx);
+
+	return total_cost;
+}
+
+/*
+ * Total estimated cost of a whole workload.
+ */
+static double
+hypo_workload_cost(List *workload, MemoryContext plan_ctx)
+{
+	double		total_cost = 0;
+	ListCell   *lc;
+
+	foreach(lc, workload)
+		total_cost += hypo_querytrees_cost((List *) lfirst(lc), InvalidOid,
+										   NULL, plan_ctx);
+	return total_cost;
+}
+
+/*
+ * Remove the candidates and make every private index visible again.
+ * Private indexes do not go away on abort, so this runs on error too.
+ */
+static void
+hypo_drop_candidates(List *indexoids)
+{
+	ListCell   *lc;
+
+	hypo_index_reset_visible();
+	foreach(lc, indexoids)
+		hypo_index_remove_oid(lfirst_oid(lc));
+}
+
+/*
+ * Create one candidate as a session-private hypothetical index, the same
+ * way CREATE HYPOTHETICAL INDEX would with hypothetical_index_private on.
+ */
+static Oid
+hypo_define_candidate(const char *indexdef)
+{
+	List	   *parsetrees = pg_parse_query(indexdef);
+	IndexStmt  *stmt;
+	Oid			relid;
+	Oid			indexoid;
+	int			save_nestlevel;
+
+	if (list_length(parsetrees) != 1 ||
+		!IsA(linitial(parsetrees), IndexStmt))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("candidate is not a single CREATE INDEX statement: \"%s\"",
+						indexdef)));
+
+	stmt = (IndexStmt *) linitial(parsetrees);
+	stmt->hypothetical = true;
+
+	relid = RangeVarGetRelidExtended(stmt->relation, AccessShareLock,
+									 false, false,
+									 RangeVarCallbackOwnsRelation,
+									 NULL);
+	stmt = transformIndexStmt(relid, stmt, indexdef);
+
+	save_nestlevel = NewGUCNestLevel();
+	(void) set_config_option("hypothetical_index_private", "on",
+							 PGC_USERSET, PGC_S_SESSION,
+							 GUC_ACTION_SAVE, true, 0);
+
+	indexoid = DefineIndex(relid, stmt, InvalidOid,
+						   false, true, false, true);
+
+	AtEOXact_GUC(true, save_nestlevel);
+
+	return indexoid;
+}
+
+/*
+ * Does the plan tree scan the given index anywhere?
+ */
+static bool
+hypo_plan_uses_index(Plan *plan, Oid indexoid)
+{
+	if (plan == NULL)
+		return false;
+
+	switch (nodeTag(plan))
+	{
+		case T_IndexScan:
+			if (((IndexScan *) plan)->indexid == indexoid)
+				return true;
+			break;
+		case T_IndexOnlyScan:
+			if (((IndexOnlyScan *) plan)->indexid == indexoid)
+				return true;
+			break;
+		case T_BitmapIndexScan:
+			if (((BitmapIndexScan *) plan)->indexid == indexoid)
+				return true;
+			break;
+		case T_Append:
+			return hypo_plan_list_uses_index(((Append *) plan)->appendplans,
+											 indexoid);
+		case T_MergeAppend:
+			return hypo_plan_list_uses_index(((MergeAppend *) plan)->mergeplans,
+											 indexoid);
+		case T_BitmapAnd:
+			return hypo_plan_list_uses_index(((BitmapAnd *) plan)->bitmapplans,
+											 indexoid);
+		case T_BitmapOr:
+			return hypo_plan_list_uses_index(((BitmapOr *) plan)->bitmapplans,
+											 indexoid);
+		case T_ModifyTable:
+			return hypo_plan_list_uses_index(((ModifyTable *) plan)->plans,
+											 indexoid);
+		case T_SubqueryScan:
+			return hypo_plan_uses_index(((SubqueryScan *) plan)->subplan,
+										indexoid);
+		default:
+			break;
+	}
+
+	return hypo_plan_uses_index(plan->lefttree, indexoid) ||
+		hypo_plan_uses_index(plan->righttree, indexoid);
+}
+
+static bool
+hypo_plan_list_uses_index(List *plans, Oid indexoid)
+{
+	ListCell   *lc;
+
+	foreach(lc, plans)
+	{
+		if (hypo_plan_uses_index((Plan *) lfirst(lc), indexoid))
+			return true;
+	}
+	return false;
+}
+
+/*
+ * Estimated size in bytes of a candidate, as pg_hypothetical_index_size()
+ * would report it.
+ */
+static int64
+hypo_candidate_size(Oid indexoid)
+{
+	HypoIndex  *hypoindex = hypo_index_find(indexoid);
+	Relation	heapRel;
+	BlockNumber heappages;
+	double		tuples;
+	double		allvisfrac;
+	BlockNumber pages;
+	int			tree_height;
+
+	Assert(hypoindex != NULL);
+
+	heapRel = heap_open(hypoindex->relid, AccessShareLock);
+	estimate_rel_size(heapRel, NULL, &heappages, &tuples, &allvisfrac);
+	hypo_index_estimate_size(heapRel, hypoindex->relam,
+							 hypoindex->ncolumns, hypoindex->indexkeys,
+							 hypoindex->indexprs, hypoindex->fillfactor,
+							 hypo_index_predicate_tuples(heapRel,
+														 hypoindex->indpred,
+														 tuples),
+							 &pages, &tree_height);
+	heap_close(heapRel, AccessShareLock);
+
+	return (int64) pages * BLCKSZ;
+}
+
+/*
+ * Collect the columns of ordinary tables that a query, and every subquery,
+ * CTE and sublink in it, restricts, joins or sorts on.  Each query level
+ * adds one HypoColumnGroup per table to *allgroups.
+ */
+static void
+hypo_collect_columns(Query *query, List **allgroups)
+{
+	HypoColumnContext context;
+	ListCell   *lc;
+
+	context.rtable = query->rtable;
+	context.groups = NIL;
+	context.allgroups = allgroups;
+
+	(void) hypo_collect_columns_walker((Node *) query->jointree, &context);
+
+	foreach(lc, query->sortClause)
+	{
+		SortGroupClause *sortcl = (SortGroupClause *) lfirst(lc);
+
+		hypo_note_column(&context,
+						 get_sortgroupclause_expr(sortcl, query->targetList),
+						 false);
+	}
+
+	*allgroups = list_concat(*allgroups, context.groups);
+
+	foreach(lc, query->rtable)
+	{
+		RangeTblEntry *rte = (RangeTblEntry *) lfirst(lc);
+
+		if (rte->rtekind == RTE_SUBQUERY)
+			hypo_collect_columns(rte->subquery, allgroups);
+	}
+
+	foreach(lc, query->cteList)
+	{
+		CommonTableExpr *cte = (CommonTableExpr *) lfirst(lc);
+
+		hypo_collect_columns((Query *) cte->ctequery, allgroups);
+	}
+}
+
+static bool
+hypo_collect_columns_walker(Node *node, HypoColumnContext *context)
+{
+	if (node == NULL)
+		return false;
+
+	if (IsA(node, OpExpr) &&
+		list_length(((OpExpr *) node)->args) == 2)
+	{
+		OpExpr	   *opexpr = (OpExpr *) node;
+		char	   *opname = get_opname(opexpr->opno);
+		bool		equality = (opname != NULL && strcmp(opname, "=") == 0);
+
+		hypo_note_column(context, linitial(opexpr->args), equality);
+		hypo_note_column(context, lsecond(opexpr->args), equality);
+	}
+	else if (IsA(node, ScalarArrayOpExpr))
+	{
+		ScalarArrayOpExpr *saop = (ScalarArrayOpExpr *) node;
+		char	   *opname = get_opname(saop->opno);
+
+		hypo_note_column(context, linitial(saop->args),
+						 saop->useOr && opname != NULL &&
+						 strcmp(opname, "=") == 0);
+	}
+	else if (IsA(node, NullTest))
+		hypo_note_column(context, (Node *) ((NullTest *) node)->arg, false);
+	else if (IsA(node, SubLink))
+	{
+		SubLink    *sublink = (SubLink *) node;
+
+		hypo_collect_columns((Query *) sublink->subselect, context->allgroups);
+		return hypo_collect_columns_walker(sublink->testexpr, context);
+	}
+
+	return expression_tree_walker(node, hypo_collect_columns_walker,
+								  (void *) context);
+}
+
+/*
+ * Remember expr if it is a user column of an ordinary table of the current
+ * query level whose type btree can index.
+ */
+static void
+hypo_note_column(HypoColumnContext *context, Node *expr, bool equality)
+{
+	Var		   *var;
+	RangeTblEntry *rte;
+	HypoColumnGroup *group = NULL;
+	char		relkind;
+	ListCell   *lc;
+
+	while (expr && IsA(expr, RelabelType))
+		expr = (Node *) ((RelabelType *) expr)->arg;
+	if (expr == NULL || !IsA(expr, Var))
+		return;
+
+	var = (Var *) expr;
+	if (var->varlevelsup != 0 || var->varattno <= 0)
+		return;
+
+	rte = rt_fetch(var->varno, context->rtable);
+	if (rte->rtekind != RTE_RELATION)
+		return;
+	relkind = get_rel_relkind(rte->relid);
+	if (relkind != RELKIND_RELATION && relkind != RELKIND_MATVIEW)
+		return;
+	if (!OidIsValid(GetDefaultOpClass(var->vartype, BTREE_AM_OID)))
+		return;
+
+	foreach(lc, context->groups)
+	{
+		if (((HypoColumnGroup *) lfirst(lc))->relid == rte->relid)
+		{
+			group = (HypoColumnGroup *) lfirst(lc);
+			break;
+		}
+	}
+	if (group == NULL)
+	{
+		group = (HypoColumnGroup *) palloc0(sizeof(HypoColumnGroup));
+		group->relid = rte->relid;
+		context->groups = lappend(context->groups, group);
+	}
+
+	if (equality)
+	{
+		group->eqattnos = list_append_unique_int(group->eqattnos,
+												 var->varattno);
+		group->otherattnos = list_delete_int(group->otherattnos,
+											 var->varattno);
+	}
+	else if (!list_member_int(group->eqattnos, var->varattno))
+		group->otherattnos = list_append_unique_int(group->otherattnos,
+													var->varattno);
+}
+
+/*
+ * Add a btree candidate on the given columns, unless there already is one.
+ */
+static List *
+hypo_add_candidate(List *candidates, Oid relid, List *attnos)
+{
+	HypoCandidate *cand;
+	StringInfoData buf;
+	ListCell   *lc;
+
+	foreach(lc, candidates)
+	{
+		cand = (HypoCandidate *) lfirst(lc);
+		if (cand->relid == relid && equal(cand->attnos, attnos))
+			return candidates;
+	}
+
+	initStringInfo(&buf);
+	appendStringInfo(&buf, "CREATE INDEX ON %s (",
+					 quote_qualified_identifier(get_namespace_name(get_rel_namespace(relid)),
+												get_rel_name(relid)));
+	foreach(lc, attnos)
+	{
+		if (lc != list_head(attnos))
+			appendStringInfoString(&buf, ", ");
+		appendStringInfoString(&buf,
+							   quote_identifier(get_relid_attribute_name(relid,
+															 lfirst_int(lc))));
+	}
+	appendStringInfoChar(&buf, ')');
+
+	cand = (HypoCandidate *) palloc0(sizeof(HypoCandidate));
+	cand->relid = relid;
+	cand->attnos = attnos;
+	cand->indexdef = buf.data;
+	cand->indexoid = InvalidOid;
+
+	return lappend(candidates, cand);
+}
+
+/*
+ * Add the columns captured statements use on the tables groups already
+ * mentions.
+ */
+static List *
+hypo_add_captured_columns(List *groups)
+{
+	HypoWorkloadStatement *stmts;
+	int			nstmts;
+	List	   *relids = NIL;
+	List	   *result = groups;
+	ListCell   *lc;
+	int			i;
+
+	stmts = hypo_workload_snapshot(&nstmts);
+	if (nstmts == 0)
+		return groups;
+
+	foreach(lc, groups)
+		relids = list_append_unique_oid(relids,
+										((HypoColumnGroup *) lfirst(lc))->relid);
+
+	for (i = 0; i < nstmts; i++)
+	{
+		List	   *stmtgroups = NIL;
+		int			j;
+
+		for (j = 0; j < stmts[i].ncolumns; j++)
+		{
+			HypoWorkloadColumn *col = &stmts[i].columns[j];
+			HypoColumnGroup *group = NULL;
+			Oid			atttype;
+
+			if (!list_member_oid(relids, col->relid))
+				continue;
+
+			/* the column may have been dropped or changed since */
+			atttype = get_atttype(col->relid, col->attnum);
+			if (!OidIsValid(atttype) ||
+				!OidIsValid(GetDefaultOpClass(atttype, BTREE_AM_OID)))
+				continue;
+
+			foreach(lc, stmtgroups)
+			{
+				if (((HypoColumnGroup *) lfirst(lc))->relid == col->relid)
+				{
+					group = (HypoColumnGroup *) lfirst(lc);
+					break;
+				}
+			}
+			if (group == NULL)
+			{
+				group = (HypoColumnGroup *) palloc0(sizeof(HypoColumnGroup));
+				group->relid = col->relid;
+				stmtgroups = lappend(stmtgroups, group);
+			}
+
+			if (col->kind == HYPO_CLAUSE_EQUALITY)
+			{
+				group->eqattnos = list_append_unique_int(group->eqattnos,
+														 col->attnum);
+				group->otherattnos = list_delete_int(group->otherattnos,
+													 col->attnum);
+			}
+			else if (!list_member_int(group->eqattnos, col->attnum))
+				group->otherattnos = list_append_unique_int(group->otherattnos,
+															col->attnum);
+		}
+
+		result = list_concat(result, stmtgroups);
+	}
+
+	return result;
+}
@@ -35,6 +35,7 @@
 #include "utils/builtins.h"
 #include "utils/int8.h"
 #include "utils/numeric.h"
+#include "utils/sortsupport.h"
 
 /* ----------
  * Uncomment the following to enable compilation of dump_numeric()
@@ -394,6 +395,11 @@ static double numeric_to_double_no_overflow(Numeric num);
 static double numericvar_to_double_no_overflow(NumericVar *var);
 
 static int	cmp_numerics(Numeric num1, Numeric num2);
+static int	numeric_fast_cmp(Datum x, Datum y, SortSupport ssup);
+#if SIZEOF_DATUM == 8 && NBASE == 10000
+static int	numeric_cmp_abbrev(Datum x, Datum y, SortSupport ssup);
+static Datum numeric_abbrev_convert(Datum original, SortSupport ssup);
+#endif
 static int	cmp_var(NumericVar *var1, NumericVar *var2);
 static int cmp_var_common(const NumericDigit *var1digits, int var1ndigits,
 			   int var1weight, int var1sign,
@@ -1347,6 +1353,115 @@ numeric_cmp(PG_FUNCTION_ARGS)
 	PG_RETURN_INT32(result);
 }
 
+/*
+ * Sort support strategy routine
+ *
+ * Where a Datum has 64 bits, the leading sort key can be abbreviated to an
+ * int64 that orders numerics as cmp_numerics() does, though not strictly:
+ * a 7-bit weight above the first four NBASE digits, 14 bits each, negated
+ * for negative values.  Weights out of range saturate, and NaN shares the
+ * largest abbreviation with the largest values, so that such ties are left
+ * to the authoritative comparator.
+ */
+Datum
+numeric_sortsupport(PG_FUNCTION_ARGS)
+{
+	SortSupport ssup = (SortSupport) PG_GETARG_POINTER(0);
+
+	ssup->comparator = numeric_fast_cmp;
+
+#if SIZEOF_DATUM == 8 && NBASE == 10000
+	if (ssup->abbreviate)
+	{
+		ssup->abbrev_full_comparator = ssup->comparator;
+		ssup->comparator = numeric_cmp_abbrev;
+		ssup->abbrev_converter = numeric_abbrev_convert;
+	}
+#endif
+
+	PG_RETURN_VOID();
+}
+
+static int
+numeric_fast_cmp(Datum x, Datum y, SortSupport ssup)
+{
+	Numeric		num1 = DatumGetNumeric(x);
+	Numeric		num2 = DatumGetNumeric(y);
+	int			result;
+
+	result = cmp_numerics(num1, num2);
+
+	/* We can't afford to leak memory here. */
+	if (PointerGetDatum(num1) != x)
+		pfree(num1);
+	if (PointerGetDatum(num2) != y)
+		pfree(num2);
+
+	return result;
+}
+
+#if SIZEOF_DATUM == 8 && NBASE == 10000
+
+/* weights representable in the abbreviation */
+#define NUMERIC_ABBREV_WEIGHT_MIN	(-44)
+#define NUMERIC_ABBREV_WEIGHT_MAX	83
+#define NUMERIC_ABBREV_MAX			INT64CONST(0x7FFFFFFFFFFFFFFF)
+
+static int
+numeric_cmp_abbrev(Datum x, Datum y, SortSupport ssup)
+{
+	int64		a = (int64) x;
+	int64		b = (int64) y;
+
+	if (a > b)
+		return 1;
+	else if (a == b)
+		return 0;
+	else
+		return -1;
+}
+
+static Datum
+numeric_abbrev_convert(Datum original, SortSupport ssup)
+{
+	Numeric		num = DatumGetNumeric(original);
+	int64		result;
+
+	if (NUMERIC_IS_NAN(num))
+		result = NUMERIC_ABBREV_MAX;
+	else if (NUMERIC_NDIGITS(num) == 0)
+		result = 0;
+	else
+	{
+		NumericDigit *digits = NUMERIC_DIGITS(num);
+		int			ndigits = NUMERIC_NDIGITS(num);
+		int			weight = NUMERIC_WEIGHT(num);
+		int			i;
+
+		if (weight > NUMERIC_ABBREV_WEIGHT_MAX)
+			result = NUMERIC_ABBREV_MAX;
+		else if (weight < NUMERIC_ABBREV_WEIGHT_MIN)
+			result = 1;			/* still above zero */
+		else
+		{
+			result = weight - NUMERIC_ABBREV_WEIGHT_MIN;
+			for (i = 0; i < 4; i++)
+				result = (result << 14) | (i < ndigits ? digits[i] : 0);
+		}
+
+		if (NUMERIC_SIGN(num) == NUMERIC_NEG)
+			result = -result;
+	}
+
+	/* We can't afford to leak memory here. */
+	if (PointerGetDatum(num) != original)
+		pfree(num);
+
+	return (Datum) result;
+}
+
+#endif   /* SIZEOF_DATUM == 8 && NBASE == 10000 */
+
 
 Datum
 numeric_eq(PG_FUNCTION_ARGS)
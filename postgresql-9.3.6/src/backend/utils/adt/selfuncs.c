@@ -114,6 +114,7 @@
 #include "nodes/nodeFuncs.h"
 #include "optimizer/clauses.h"
 #include "optimizer/cost.h"
+#include "optimizer/hypoindex.h"
 #include "optimizer/pathnode.h"
 #include "optimizer/paths.h"
 #include "optimizer/plancat.h"
@@ -6246,6 +6247,13 @@ btcostestimate(PG_FUNCTION_ARGS)
 	bool		found_saop;
 	bool		found_is_null_op;
 	double		num_sa_scans;
+	List	   *eqQualCols;
+	List	   *boundQualCols;
+	IndexOptInfo *clusterIndex;
+	int			eqPrefix;
+	double		keyCorrelation = 0.0;
+	bool		haveKeyStats = false;
+	Selectivity keyCorrection = 1.0;
 	ListCell   *lcc,
 			   *lci;
 
@@ -6272,6 +6280,8 @@ btcostestimate(PG_FUNCTION_ARGS)
 	found_saop = false;
 	found_is_null_op = false;
 	num_sa_scans = 1;
+	eqQualCols = NIL;
+	boundQualCols = NIL;
 	forboth(lcc, path->indexquals, lci, path->indexqualcols)
 	{
 		RestrictInfo *rinfo = (RestrictInfo *) lfirst(lcc);
@@ -6357,7 +6367,11 @@ btcostestimate(PG_FUNCTION_ARGS)
 												   index->opfamily[indexcol]);
 			Assert(op_strategy != 0);	/* not a member of opfamily?? */
 			if (op_strategy == BTEqualStrategyNumber)
+			{
 				eqQualHere = true;
+				if (IsA(clause, OpExpr))
+					eqQualCols = list_append_unique_int(eqQualCols, indexcol);
+			}
 		}
 		else if (is_null_op)
 		{
@@ -6374,6 +6388,111 @@ btcostestimate(PG_FUNCTION_ARGS)
 				num_sa_scans *= alength;
 		}
 		indexBoundQuals = lappend(indexBoundQuals, rinfo);
+		boundQualCols = lappend_int(boundQualCols, indexcol);
+	}
+
+	/*
+	 * HYPOTHETICAL INDEX
+	 * SELF TUNING GROUP - PUC-RIO - 2015
+	 *
+	 * A hypothetical index has no statistics of its own, and the planner
+	 * would multiply the selectivities of '=' quals on correlated leading
+	 * columns.  Sample the key combination instead (see
+	 * hypo_index_key_stats), and scale the rows matching the leading
+	 * column's quals by the average number of distinct values the following
+	 * columns take for each of its values.  The correction applies to
+	 * numIndexTuples and to the index selectivity alike.
+	 *
+	 * A hypothetical index declared clustered stands for a CLUSTER of the
+	 * table on it: its own scans read the heap in order, and the
+	 * correlation of the other indexes is sampled against its order rather
+	 * than the table's current one.
+	 */
+	clusterIndex = NULL;
+	foreach(lcc, index->rel->indexlist)
+	{
+		IndexOptInfo *other = (IndexOptInfo *) lfirst(lcc);
+
+		if (other->clustered)
+		{
+			clusterIndex = other;
+			break;
+		}
+	}
+	if (index->clustered)
+	{
+		keyCorrelation = 1.0;
+		haveKeyStats = true;
+	}
+	if ((index->hypothetical && index->ncolumns > 1) ||
+		(clusterIndex != NULL && clusterIndex != index))
+	{
+		RangeTblEntry *rte = planner_rt_fetch(index->rel->relid, root);
+		HypoKeyOrder key;
+		HypoKeyOrder physical;
+		HypoKeyOrder *order = NULL;
+		double		ndistinct[INDEX_MAX_KEYS];
+		double		sampledCorrelation;
+		Relation	heapRel;
+		int			nkeys;
+
+		nkeys = hypo_index_key_order(index, &key);
+		if (clusterIndex != NULL && clusterIndex != index &&
+			hypo_index_key_order(clusterIndex, &physical) > 0)
+			order = &physical;
+
+		/* one column has ANALYZE's statistics, unless the order changes */
+		if (nkeys > 1 || (nkeys > 0 && order != NULL))
+		{
+			heapRel = heap_open(rte->relid, NoLock);
+			(void) hypo_index_key_stats(heapRel, &key, order,
+										index->rel->tuples,
+										ndistinct, &sampledCorrelation);
+			heap_close(heapRel, NoLock);
+
+			if (!index->clustered)
+			{
+				keyCorrelation = sampledCorrelation;
+				haveKeyStats = true;
+			}
+		}
+		else
+			nkeys = 0;
+
+		eqPrefix = 0;
+		if (index->hypothetical)
+		{
+			while (eqPrefix < nkeys &&
+				   list_member_int(eqQualCols, eqPrefix))
+				eqPrefix++;
+		}
+		if (eqPrefix > 1)
+		{
+			List	   *leadingQuals = NIL;
+			List	   *prefixQuals = NIL;
+			Selectivity independent;
+			Selectivity correlated;
+
+			forboth(lcc, indexBoundQuals, lci, boundQualCols)
+			{
+				if (lfirst_int(lci) == 0)
+					leadingQuals = lappend(leadingQuals, lfirst(lcc));
+				if (lfirst_int(lci) < eqPrefix)
+					prefixQuals = lappend(prefixQuals, lfirst(lcc));
+			}
+
+			independent = clauselist_selectivity(root, prefixQuals,
+												 index->rel->relid,
+												 JOIN_INNER, NULL);
+			correlated = clauselist_selectivity(root, leadingQuals,
+												index->rel->relid,
+												JOIN_INNER, NULL) *
+				ndistinct[0] / ndistinct[eqPrefix - 1];
+			CLAMP_PROBABILITY(correlated);
+
+			if (independent > 0)
+				keyCorrection = correlated / independent;
+		}
 	}
 
 	/*
@@ -6404,7 +6523,9 @@ btcostestimate(PG_FUNCTION_ARGS)
 												  index->rel->relid,
 												  JOIN_INNER,
 												  NULL);
-		numIndexTuples = btreeSelectivity * index->rel->tuples;
+		numIndexTuples = btreeSelectivity * keyCorrection *
+			index->rel->tuples;
+		numIndexTuples = Min(numIndexTuples, index->rel->tuples);
 
 		/*
 		 * As in genericcostestimate(), we have to adjust for any
@@ -6422,6 +6543,12 @@ btcostestimate(PG_FUNCTION_ARGS)
 
 	genericcostestimate(root, path, loop_count, &costs);
 
+	if (keyCorrection != 1.0)
+	{
+		costs.indexSelectivity *= keyCorrection;
+		CLAMP_PROBABILITY(costs.indexSelectivity);
+	}
+
 	/*
 	 * Add a CPU-cost component to represent the costs of initial btree
 	 * descent.  We don't charge any I/O cost for touching upper btree levels,
@@ -6464,7 +6591,12 @@ btcostestimate(PG_FUNCTION_ARGS)
 	 */
 	MemSet(&vardata, 0, sizeof(vardata));
 
-	if (index->indexkeys[0] != 0)
+	if (haveKeyStats)
+	{
+		/* sampled the index's way, reverse_sort included, or clustered */
+		costs.indexCorrelation = keyCorrelation;
+	}
+	else if (index->indexkeys[0] != 0)
 	{
 		/* Simple variable --- look to stats for the underlying table */
 		RangeTblEntry *rte = planner_rt_fetch(index->rel->relid, root);
@@ -7095,11 +7227,32 @@ gincostestimate(PG_FUNCTION_ARGS)
 	GinStatsData ginStats;
 
 	/*
-	 * Obtain statistic information from the meta page
+	 * Obtain statistic information from the meta page.
+	 *
+	 * HYPOTHETICAL INDEX
+	 * SELF TUNING GROUP - PUC-RIO - 2015
+	 *
+	 * A hypothetical index has no meta page; synthesize the statistics from
+	 * those of the table instead.
 	 */
-	indexRel = index_open(index->indexoid, AccessShareLock);
-	ginGetStats(indexRel, &ginStats);
-	index_close(indexRel, AccessShareLock);
+	if (index->hypothetical)
+	{
+		Relation	heapRel;
+
+		heapRel = heap_open(planner_rt_fetch(index->rel->relid, root)->relid,
+							NoLock);
+		if (!hypo_index_get_stats(heapRel, index->relam, index->ncolumns,
+								  index->indexkeys, index->indexprs,
+								  index->tuples, &ginStats))
+			memset(&ginStats, 0, sizeof(ginStats));
+		heap_close(heapRel, NoLock);
+	}
+	else
+	{
+		indexRel = index_open(index->indexoid, AccessShareLock);
+		ginGetStats(indexRel, &ginStats);
+		index_close(indexRel, AccessShareLock);
+	}
 
 	numEntryPages = ginStats.nEntryPages;
 	numDataPages = ginStats.nDataPages;
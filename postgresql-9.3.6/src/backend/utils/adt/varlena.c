@@ -16,7 +16,9 @@
 
 #include <ctype.h>
 #include <limits.h>
+#include <math.h>
 
+#include "access/hash.h"
 #include "access/tuptoaster.h"
 #include "catalog/pg_collation.h"
 #include "catalog/pg_type.h"
@@ -29,6 +31,7 @@
 #include "utils/bytea.h"
 #include "utils/lsyscache.h"
 #include "utils/pg_locale.h"
+#include "utils/sortsupport.h"
 
 
 /* GUC variable */
@@ -1683,6 +1686,289 @@ bttextcmp(PG_FUNCTION_ARGS)
 	PG_RETURN_INT32(result);
 }
 
+/*
+ * Sort support for text
+ *
+ * The leading sort key can be abbreviated to the first sizeof(Datum) bytes
+ * of the string, packed big-endian so that comparing the abbreviations as
+ * unsigned integers agrees with memcmp().  That orders strings as the C
+ * collation does; under other collations the bytes abbreviated are those of
+ * the strxfrm() blob instead, if TRUST_STRXFRM is defined.  Strings sharing
+ * their first bytes get equal abbreviations, so the abort routine compares
+ * how many distinct abbreviations and distinct strings it has seen, counted
+ * by linear counting over a hash of each, and gives up when the
+ * abbreviations resolve too few comparisons to pay for themselves.
+ */
+
+/* bits in each linear counting bitmap */
+#define TEXT_ABBREV_BITMAP_BITS		(1 << 14)
+
+typedef struct
+{
+	bool		collate_c;		/* comparing with memcmp()? */
+	char	   *buf;			/* NUL-terminated copy for strxfrm() */
+	int			buflen;
+	char	   *xfrmbuf;		/* strxfrm() output */
+	int			xfrmbuflen;
+#ifdef HAVE_LOCALE_T
+	pg_locale_t locale;
+#endif
+	/* linear counting bitmaps of abbreviations and strings seen */
+	uint8		abbr_seen[TEXT_ABBREV_BITMAP_BITS / BITS_PER_BYTE];
+	uint8		full_seen[TEXT_ABBREV_BITMAP_BITS / BITS_PER_BYTE];
+} TextSortSupport;
+
+static int	bttextfastcmp_c(Datum x, Datum y, SortSupport ssup);
+static int	bttextfastcmp_locale(Datum x, Datum y, SortSupport ssup);
+static int	bttextcmp_abbrev(Datum x, Datum y, SortSupport ssup);
+static Datum bttext_abbrev_convert(Datum original, SortSupport ssup);
+static bool bttext_abbrev_abort(int memtupcount, SortSupport ssup);
+
+Datum
+bttextsortsupport(PG_FUNCTION_ARGS)
+{
+	SortSupport ssup = (SortSupport) PG_GETARG_POINTER(0);
+	Oid			collid = ssup->ssup_collation;
+	bool		collate_c = lc_collate_is_c(collid);
+	bool		abbreviate = ssup->abbreviate;
+	TextSortSupport *tss;
+	MemoryContext oldcontext;
+
+	oldcontext = MemoryContextSwitchTo(ssup->ssup_cxt);
+
+	ssup->comparator = collate_c ? bttextfastcmp_c : bttextfastcmp_locale;
+
+	/*
+	 * Without a trustworthy strxfrm(), only the C collation can be
+	 * abbreviated.  Windows can't use strxfrm() on UTF-8 at all, and an
+	 * invalid collation will be complained about by the comparator.
+	 */
+	if (!collate_c)
+	{
+#if defined(TRUST_STRXFRM) && !defined(WIN32)
+		if (!OidIsValid(collid))
+			abbreviate = false;
+#else
+		abbreviate = false;
+#endif
+	}
+
+	if (abbreviate)
+	{
+		tss = (TextSortSupport *) palloc0(sizeof(TextSortSupport));
+		tss->collate_c = collate_c;
+#ifdef HAVE_LOCALE_T
+		if (!collate_c && collid != DEFAULT_COLLATION_OID)
+			tss->locale = pg_newlocale_from_collation(collid);
+#endif
+		ssup->ssup_extra = tss;
+
+		ssup->abbrev_full_comparator = ssup->comparator;
+		ssup->comparator = bttextcmp_abbrev;
+		ssup->abbrev_converter = bttext_abbrev_convert;
+		ssup->abbrev_abort = bttext_abbrev_abort;
+	}
+
+	MemoryContextSwitchTo(oldcontext);
+
+	PG_RETURN_VOID();
+}
+
+static int
+bttextfastcmp_c(Datum x, Datum y, SortSupport ssup)
+{
+	text	   *arg1 = DatumGetTextPP(x);
+	text	   *arg2 = DatumGetTextPP(y);
+	int			len1 = VARSIZE_ANY_EXHDR(arg1);
+	int			len2 = VARSIZE_ANY_EXHDR(arg2);
+	int			result;
+
+	result = memcmp(VARDATA_ANY(arg1), VARDATA_ANY(arg2), Min(len1, len2));
+	if (result == 0 && len1 != len2)
+		result = (len1 < len2) ? -1 : 1;
+
+	/* We can't afford to leak memory here. */
+	if (PointerGetDatum(arg1) != x)
+		pfree(arg1);
+	if (PointerGetDatum(arg2) != y)
+		pfree(arg2);
+
+	return result;
+}
+
+static int
+bttextfastcmp_locale(Datum x, Datum y, SortSupport ssup)
+{
+	text	   *arg1 = DatumGetTextPP(x);
+	text	   *arg2 = DatumGetTextPP(y);
+	int			result;
+
+	result = text_cmp(arg1, arg2, ssup->ssup_collation);
+
+	/* We can't afford to leak memory here. */
+	if (PointerGetDatum(arg1) != x)
+		pfree(arg1);
+	if (PointerGetDatum(arg2) != y)
+		pfree(arg2);
+
+	return result;
+}
+
+static int
+bttextcmp_abbrev(Datum x, Datum y, SortSupport ssup)
+{
+	/* abbreviations compare as unsigned integers */
+	if (x > y)
+		return 1;
+	else if (x == y)
+		return 0;
+	else
+		return -1;
+}
+
+/*
+ * Pack the first sizeof(Datum) bytes of a string into a Datum, most
+ * significant byte first, padding short strings with zero bytes.
+ */
+static Datum
+bttext_pack_prefix(const char *str, int len)
+{
+	Datum		res = 0;
+	int			i;
+
+	for (i = 0; i < (int) sizeof(Datum); i++)
+	{
+		res <<= BITS_PER_BYTE;
+		if (i < len)
+			res |= (unsigned char) str[i];
+	}
+
+	return res;
+}
+
+/*
+ * Note a hash value in a linear counting bitmap
+ */
+static void
+bttext_note_hash(uint8 *bitmap, uint32 hash)
+{
+	hash %= TEXT_ABBREV_BITMAP_BITS;
+	bitmap[hash / BITS_PER_BYTE] |= 1 << (hash % BITS_PER_BYTE);
+}
+
+static Datum
+bttext_abbrev_convert(Datum original, SortSupport ssup)
+{
+	TextSortSupport *tss = (TextSortSupport *) ssup->ssup_extra;
+	text	   *authoritative = DatumGetTextPP(original);
+	char	   *str = VARDATA_ANY(authoritative);
+	int			len = VARSIZE_ANY_EXHDR(authoritative);
+	Datum		res;
+
+	bttext_note_hash(tss->full_seen,
+					 DatumGetUInt32(hash_any((unsigned char *) str, len)));
+
+	if (tss->collate_c)
+		res = bttext_pack_prefix(str, len);
+	else
+	{
+#if defined(TRUST_STRXFRM) && !defined(WIN32)
+		Size		xfrmlen;
+
+		if (len >= tss->buflen)
+		{
+			if (tss->buf)
+				pfree(tss->buf);
+			tss->buflen = Max(len + 1, tss->buflen * 2);
+			tss->buf = MemoryContextAlloc(ssup->ssup_cxt, tss->buflen);
+		}
+		memcpy(tss->buf, str, len);
+		tss->buf[len] = '\0';
+
+		for (;;)
+		{
+#ifdef HAVE_LOCALE_T
+			if (tss->locale)
+				xfrmlen = strxfrm_l(tss->xfrmbuf, tss->buf,
+									tss->xfrmbuflen, tss->locale);
+			else
+#endif
+				xfrmlen = strxfrm(tss->xfrmbuf, tss->buf, tss->xfrmbuflen);
+
+			if (xfrmlen < (Size) tss->xfrmbuflen)
+				break;
+
+			/* the blob didn't fit; grow the buffer and transform again */
+			if (tss->xfrmbuf)
+				pfree(tss->xfrmbuf);
+			tss->xfrmbuflen = Max((int) xfrmlen + 1, tss->xfrmbuflen * 2);
+			tss->xfrmbuf = MemoryContextAlloc(ssup->ssup_cxt,
+											  tss->xfrmbuflen);
+		}
+
+		res = bttext_pack_prefix(tss->xfrmbuf, xfrmlen);
+#else
+		elog(ERROR, "text abbreviation requires the C collation");
+		res = (Datum) 0;		/* keep compiler quiet */
+#endif
+	}
+
+	bttext_note_hash(tss->abbr_seen,
+					 DatumGetUInt32(hash_any((unsigned char *) &res,
+											 sizeof(Datum))));
+
+	/* We can't afford to leak memory here. */
+	if (PointerGetDatum(authoritative) != original)
+		pfree(authoritative);
+
+	return res;
+}
+
+/*
+ * Estimate the number of distinct values noted in a linear counting bitmap
+ */
+static double
+bttext_estimate_distinct(const uint8 *bitmap)
+{
+	int			zeroes = 0;
+	int			i;
+
+	for (i = 0; i < TEXT_ABBREV_BITMAP_BITS; i++)
+	{
+		if ((bitmap[i / BITS_PER_BYTE] & (1 << (i % BITS_PER_BYTE))) == 0)
+			zeroes++;
+	}
+
+	/* a full bitmap only tells us there are a great many */
+	if (zeroes == 0)
+		zeroes = 1;
+
+	return -(double) TEXT_ABBREV_BITMAP_BITS *
+		log((double) zeroes / TEXT_ABBREV_BITMAP_BITS);
+}
+
+static bool
+bttext_abbrev_abort(int memtupcount, SortSupport ssup)
+{
+	TextSortSupport *tss = (TextSortSupport *) ssup->ssup_extra;
+	double		abbr_card;
+	double		full_card;
+
+	/* too few strings to judge by */
+	if (memtupcount < 100)
+		return false;
+
+	abbr_card = bttext_estimate_distinct(tss->abbr_seen);
+	full_card = bttext_estimate_distinct(tss->full_seen);
+
+	/*
+	 * Keep abbreviating while the abbreviations tell apart at least a
+	 * twentieth of the distinct strings; a sort of few distinct strings
+	 * loses little by it either way.
+	 */
+	return abbr_card < full_card * 0.05;
+}
+
 
 Datum
 text_larger(PG_FUNCTION_ARGS)
@@ -59,6 +59,7 @@
 #include "common/relpath.h"
 #include "miscadmin.h"
 #include "optimizer/clauses.h"
+#include "optimizer/hypoindex.h"
 #include "optimizer/planmain.h"
 #include "optimizer/prep.h"
 #include "optimizer/var.h"
@@ -1828,6 +1829,7 @@ RelationDestroyRelation(Relation relation)
 	if (--relation->rd_att->tdrefcount == 0)
 		FreeTupleDesc(relation->rd_att);
 	list_free(relation->rd_indexlist);
+	list_free(relation->rd_hypindexlist);
 	bms_free(relation->rd_indexattr);
 	bms_free(relation->rd_keyattr);
 	FreeTriggerDesc(relation->trigdesc);
@@ -2416,6 +2418,9 @@ AtEOXact_cleanup(Relation relation, bool isCommit)
 	{
 		list_free(relation->rd_indexlist);
 		relation->rd_indexlist = NIL;
+		list_free(relation->rd_hypindexlist);
+		relation->rd_hypindexlist = NIL;
+		relation->rd_hashypothetical = false;
 		relation->rd_oidindex = InvalidOid;
 		relation->rd_indexvalid = 0;
 	}
@@ -2514,6 +2519,9 @@ AtEOSubXact_cleanup(Relation relation, bool isCommit,
 	{
 		list_free(relation->rd_indexlist);
 		relation->rd_indexlist = NIL;
+		list_free(relation->rd_hypindexlist);
+		relation->rd_hypindexlist = NIL;
+		relation->rd_hashypothetical = false;
 		relation->rd_oidindex = InvalidOid;
 		relation->rd_indexvalid = 0;
 	}
@@ -3459,6 +3467,20 @@ CheckConstraintFetch(Relation relation)
  * of the index list.  rd_oidindex is valid when rd_indexvalid isn't zero;
  * it is the pg_class OID of a unique index on OID when the relation has one,
  * and InvalidOid if there is no such index.
+ *
+ * HYPOTHETICAL INDEX
+ * SELF TUNING GROUP - PUC-RIO - 2015
+ *
+ * The same pg_index scan also fills rd_hypindexlist, which additionally
+ * contains the relation's hypothetical indexes, and rd_hashypothetical, which
+ * tells whether there are any.  Both lists share rd_indexvalid, so they are
+ * recomputed together after a relcache inval, and neither kind of request
+ * has to look at the individual indexes.  CREATE/DROP HYPOTHETICAL INDEX do
+ * not invalidate the parent table, though, so that backends which never
+ * plan hypothetically are left alone; a request for the hypothetical list
+ * also recomputes it once hypo_index_generation() has moved on from
+ * rd_hypgeneration.  Right after such a request, rd_hashypothetical lets
+ * the caller skip the per-index work that only hypothetical indexes need.
  */
 List *
 RelationGetIndexList(Relation relation){ // PUC Rio 2015
@@ -3473,46 +3495,33 @@ RelationGetIndexList_PUC(Relation relation, bool hypothetical)
 	ScanKeyData skey;
 	HeapTuple	htup;
 	List	   *result;
+	List	   *hypresult;
 	Oid			oidIndex;
 	MemoryContext oldcxt;
-    ListCell   *l;
+	uint64		generation;
 
+	/* Quick exit if we already computed the lists. */
+	if (relation->rd_indexvalid == 2 ||
+		(relation->rd_indexvalid != 0 &&
+		 (!hypothetical ||
+		  relation->rd_hypgeneration == hypo_index_generation())))
+		return list_copy(hypothetical ? relation->rd_hypindexlist :
+						 relation->rd_indexlist);
 
-	/* Quick exit if we already computed the list. */
-    /**
-    * HYPOTHETICAL INDEX
-    * SELF TUNING GROUP - PUC-RIO - 2015
-    *
-    * if we are going to consider hypothetical index then re-do index lis.
-    * if we are'n consider hypothetical index only re-do index list if we have any hipothetical index in the list
-    */
-    if(!hypothetical)
-    {
-        bool found=false;
-        foreach(l, relation->rd_indexlist)
-        {
-            Oid			indexOid = (Oid)lfirst_oid(l);
-            Relation	indexDesc;
-
-            indexDesc = index_open(indexOid, AccessShareLock);
-            if(indexDesc->rd_index->indishypothetical)
-            {
-                found=true;
-                index_close(indexDesc,AccessShareLock);
-                break;
-            }
-            index_close(indexDesc,AccessShareLock);
-        }
-        if (relation->rd_indexvalid != 0 && !found)
-            return list_copy(relation->rd_indexlist);
-    }
-	/*
-	 * We build the list we intend to return (in the caller's context) while
-	 * doing the scan.  After successfully completing the scan, we copy that
-	 * list into the relcache entry.  This avoids cache-context memory leakage
-	 * if we get some sort of error partway through.
+	/*
+	 * Take the generation before scanning, so that a change committed while
+	 * we scan makes the next request scan again.
+	 */
+	generation = hypo_index_generation();
+
+	/*
+	 * We build the lists we intend to return (in the caller's context) while
+	 * doing the scan.  After successfully completing the scan, we copy those
+	 * lists into the relcache entry.  This avoids cache-context memory
+	 * leakage if we get some sort of error partway through.
 	 */
 	result = NIL;
+	hypresult = NIL;
 	oidIndex = InvalidOid;
 
 	/* Prepare to scan pg_index for entries having indrelid = this rel. */
@@ -3532,17 +3541,6 @@ RelationGetIndexList_PUC(Relation relation, bool hypothetical)
 		oidvector  *indclass;
 		bool		isnull;
 
-
-        if(index->indishypothetical &&!hypothetical){
-            /**
-            * HYPOTHETICAL INDEX
-            * SELF TUNING GROUP - PUC-RIO - 2015
-            *
-            * Only consider hypothetical index in case of HYPOTHETICAL keyword
-            */
-            continue;
-        }
-
 		/*
 		 * Ignore any indexes that are currently being dropped.  This will
 		 * prevent them from being searched, inserted into, or considered in
@@ -3552,6 +3550,17 @@ RelationGetIndexList_PUC(Relation relation, bool hypothetical)
 		if (!IndexIsLive(index))
 			continue;
 
+		/*
+		 * HYPOTHETICAL INDEX
+		 * SELF TUNING GROUP - PUC-RIO - 2015
+		 *
+		 * Hypothetical indexes only go into the list used by the HYPOTHETICAL
+		 * keyword; they can never be the OID index either.
+		 */
+		hypresult = insert_ordered_oid(hypresult, index->indexrelid);
+		if (index->indishypothetical)
+			continue;
+
 		/* Add index's OID to result list in the proper order */
 		result = insert_ordered_oid(result, index->indexrelid);
 
@@ -3568,25 +3577,43 @@ RelationGetIndexList_PUC(Relation relation, bool hypothetical)
 		indclass = (oidvector *) DatumGetPointer(indclassDatum);
 
 		/* Check to see if it is a unique, non-partial btree index on OID */
-        if (IndexIsValid(index) &&
+		if (IndexIsValid(index) &&
 			index->indnatts == 1 &&
 			index->indisunique && index->indimmediate &&
 			index->indkey.values[0] == ObjectIdAttributeNumber &&
 			indclass->values[0] == OID_BTREE_OPS_OID &&
-            heap_attisnull(htup, Anum_pg_index_indpred))
+			heap_attisnull(htup, Anum_pg_index_indpred))
 			oidIndex = index->indexrelid;
 	}
 
 	systable_endscan(indscan);
 	heap_close(indrel, AccessShareLock);
 
-	/* Now save a copy of the completed list in the relcache entry. */
+	/*
+	 * Now save a copy of the completed lists in the relcache entry, replacing
+	 * those of an older hypothetical generation.
+	 */
+	if (relation->rd_indexvalid != 0)
+	{
+		list_free(relation->rd_indexlist);
+		list_free(relation->rd_hypindexlist);
+	}
 	oldcxt = MemoryContextSwitchTo(CacheMemoryContext);
 	relation->rd_indexlist = list_copy(result);
+	relation->rd_hypindexlist = list_copy(hypresult);
+	relation->rd_hashypothetical =
+		(list_length(hypresult) != list_length(result));
+	relation->rd_hypgeneration = generation;
 	relation->rd_oidindex = oidIndex;
 	relation->rd_indexvalid = 1;
 	MemoryContextSwitchTo(oldcxt);
 
+	if (hypothetical)
+	{
+		list_free(result);
+		return hypresult;
+	}
+	list_free(hypresult);
 	return result;
 }
 
@@ -3657,6 +3684,12 @@ RelationSetIndexList(Relation relation, List *indexIds, Oid oidIndex)
 	/* Okay to replace old list */
 	list_free(relation->rd_indexlist);
 	relation->rd_indexlist = indexIds;
+	/* HYPOTHETICAL INDEX: the forced list never includes hypothetical ones */
+	oldcxt = MemoryContextSwitchTo(CacheMemoryContext);
+	list_free(relation->rd_hypindexlist);
+	relation->rd_hypindexlist = list_copy(indexIds);
+	MemoryContextSwitchTo(oldcxt);
+	relation->rd_hashypothetical = false;
 	relation->rd_oidindex = oidIndex;
 	relation->rd_indexvalid = 2;	/* mark list as forced */
 	/* Flag relation as needing eoxact cleanup (to reset the list) */
@@ -4476,6 +4509,9 @@ load_relcache_init_file(bool shared)
 			rel->rd_refcnt = 0;
 		rel->rd_indexvalid = 0;
 		rel->rd_indexlist = NIL;
+		rel->rd_hypindexlist = NIL;
+		rel->rd_hashypothetical = false;
+		rel->rd_hypgeneration = 0;
 		rel->rd_indexattr = NULL;
 		rel->rd_keyattr = NULL;
 		rel->rd_oidindex = InvalidOid;
@@ -36,6 +36,8 @@
 #include "commands/vacuum.h"
 #include "commands/variable.h"
 #include "commands/trigger.h"
+#include "executor/execBatch.h"
+#include "executor/executor.h"
 #include "funcapi.h"
 #include "libpq/auth.h"
 #include "libpq/be-fsstubs.h"
@@ -44,6 +46,9 @@
 #include "miscadmin.h"
 #include "optimizer/cost.h"
 #include "optimizer/geqo.h"
+#include "optimizer/hypoindex.h"
+#include "optimizer/hypotiming.h"
+#include "optimizer/hypoworkload.h"
 #include "optimizer/paths.h"
 #include "optimizer/planmain.h"
 #include "parser/parse_expr.h"
@@ -76,6 +81,7 @@
 #include "utils/portal.h"
 #include "utils/ps_status.h"
 #include "utils/snapmgr.h"
+#include "utils/tuplesort.h"
 #include "utils/tzparser.h"
 #include "utils/xml.h"
 
@@ -711,6 +717,15 @@ static struct config_bool ConfigureNamesBool[] =
 		true,
 		NULL, NULL, NULL
 	},
+	{
+		{"sort_multiway_merge", PGC_USERSET, RESOURCES_MEM,
+			gettext_noop("Builds external sort runs by quicksort and merges them with a loser tree."),
+			gettext_noop("Otherwise runs are built by replacement selection and merged with a heap.")
+		},
+		&sort_multiway_merge,
+		false,
+		NULL, NULL, NULL
+	},
 	{
 		{"enable_hashagg", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Enables the planner's use of hashed aggregation plans."),
@@ -756,6 +771,36 @@ static struct config_bool ConfigureNamesBool[] =
 		true,
 		NULL, NULL, NULL
 	},
+	{
+		{"compile_expressions", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Flattens the quals and target lists of plan nodes into linear programs."),
+			gettext_noop("Otherwise their expression trees are evaluated recursively.")
+		},
+		&compile_expressions,
+		true,
+		NULL, NULL, NULL
+	},
+	{
+		{"batch_execution", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Executes sequential scans and plain aggregates over them a batch of rows at a time."),
+			gettext_noop("Qual clauses comparing an int4, int8, float8 or date column "
+						 "with a constant are evaluated on whole batches.")
+		},
+		&batch_execution,
+		false,
+		NULL, NULL, NULL
+	},
+	{
+		/* HYPOTHETICAL INDEX SELF TUNING GROUP - PUC-RIO - 2015 */
+		{"hypothetical_index_private", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Keeps hypothetical indexes in session memory instead of the system catalogs."),
+			gettext_noop("Such indexes are visible only to the creating session "
+						 "and are not affected by transaction rollback.")
+		},
+		&hypothetical_index_private,
+		false,
+		NULL, NULL, NULL
+	},
 	{
 		{"geqo", PGC_USERSET, QUERY_TUNING_GEQO,
 			gettext_noop("Enables genetic query optimization."),
@@ -1033,6 +1078,17 @@ static struct config_bool ConfigureNamesBool[] =
 		false,
 		NULL, NULL, NULL
 	},
+	{
+		/* HYPOTHETICAL INDEX SELF TUNING GROUP - PUC-RIO - 2015 */
+		{"hypothetical_planner_timing", PGC_SUSET, STATS_COLLECTOR,
+			gettext_noop("Collects planning time statistics by planner phase."),
+			gettext_noop("Regular and hypothetical planning are counted "
+						 "separately in pg_stat_planner_phases.")
+		},
+		&hypothetical_planner_timing,
+		false,
+		NULL, NULL, NULL
+	},
 
 	{
 		{"update_process_title", PGC_SUSET, STATS_COLLECTOR,
@@ -1505,6 +1561,26 @@ static struct config_int ConfigureNamesInt[] =
 		100, 1, 10000,
 		NULL, NULL, NULL
 	},
+	{
+		{"hypothetical_workload_entries", PGC_POSTMASTER, STATS_COLLECTOR,
+			gettext_noop("Sets the number of statements kept for the index advisor."),
+			gettext_noop("The columns planned statements restrict and join on "
+						 "are captured in shared memory. Zero disables the capture.")
+		},
+		&hypothetical_workload_entries,
+		0, 0, INT_MAX / 1024,
+		NULL, NULL, NULL
+	},
+	{
+		{"hypothetical_plan_cache_size", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Sets the number of hypothetical plans kept per session."),
+			gettext_noop("Planning a query again under the same index set "
+						 "reuses the kept plan. Zero disables the cache.")
+		},
+		&hypothetical_plan_cache_size,
+		64, 0, INT_MAX,
+		NULL, NULL, NULL
+	},
 	{
 		{"from_collapse_limit", PGC_USERSET, QUERY_TUNING_OTHER,
 			gettext_noop("Sets the FROM-list size beyond which subqueries "
@@ -2664,6 +2740,19 @@ static struct config_string ConfigureNamesString[] =
 		check_default_tablespace, NULL, NULL
 	},
 
+	{
+		/* HYPOTHETICAL INDEX SELF TUNING GROUP - PUC-RIO - 2015 */
+		{"hypothetical_disabled_indexes", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Sets the indexes hypothetical planning treats as dropped."),
+			gettext_noop("EXPLAIN HYPOTHETICAL and the hypothetical index "
+						 "functions plan as if these indexes did not exist."),
+			GUC_LIST_INPUT | GUC_LIST_QUOTE
+		},
+		&hypothetical_disabled_indexes,
+		"",
+		check_hypothetical_disabled_indexes, assign_hypothetical_disabled_indexes, NULL
+	},
+
 	{
 		{"temp_tablespaces", PGC_USERSET, CLIENT_CONN_STATEMENT,
 			gettext_noop("Sets the tablespace(s) to use for temporary tables and sort files."),
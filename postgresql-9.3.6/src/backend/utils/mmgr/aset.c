@@ -146,6 +146,7 @@ typedef struct AllocSetContext
 	Size		nextBlockSize;	/* next block size to allocate */
 	Size		allocChunkLimit;	/* effective chunk size limit */
 	AllocBlock	keeper;			/* if not NULL, keep this block over resets */
+	Size		memAllocated;	/* total size of the blocks in the set */
 } AllocSetContext;
 
 typedef AllocSetContext *AllocSet;
@@ -218,6 +219,7 @@ static void AllocSetDelete(MemoryContext context);
 static Size AllocSetGetChunkSpace(MemoryContext context, void *pointer);
 static bool AllocSetIsEmpty(MemoryContext context);
 static void AllocSetStats(MemoryContext context, int level);
+static Size AllocSetMemAllocated(MemoryContext context);
 
 #ifdef MEMORY_CONTEXT_CHECKING
 static void AllocSetCheck(MemoryContext context);
@@ -235,7 +237,8 @@ static MemoryContextMethods AllocSetMethods = {
 	AllocSetDelete,
 	AllocSetGetChunkSpace,
 	AllocSetIsEmpty,
-	AllocSetStats
+	AllocSetStats,
+	AllocSetMemAllocated
 #ifdef MEMORY_CONTEXT_CHECKING
 	,AllocSetCheck
 #endif
@@ -422,6 +425,7 @@ AllocSetContextCreate(MemoryContext parent,
 		block->endptr = ((char *) block) + blksize;
 		block->next = context->blocks;
 		context->blocks = block;
+		context->memAllocated += blksize;
 		/* Mark block as not to be released at reset time */
 		context->keeper = block;
 	}
@@ -501,6 +505,7 @@ AllocSetReset(MemoryContext context)
 		else
 		{
 			/* Normal case, release the block */
+			set->memAllocated -= block->endptr - ((char *) block);
 #ifdef CLOBBER_FREED_MEMORY
 			/* Wipe freed memory for debugging purposes */
 			memset(block, 0x7F, block->freeptr - ((char *) block));
@@ -539,6 +544,7 @@ AllocSetDelete(MemoryContext context)
 	MemSetAligned(set->freelist, 0, sizeof(set->freelist));
 	set->blocks = NULL;
 	set->keeper = NULL;
+	set->memAllocated = 0;
 
 	while (block != NULL)
 	{
@@ -590,6 +596,7 @@ AllocSetAlloc(MemoryContext context, Size size)
 		}
 		block->aset = set;
 		block->freeptr = block->endptr = ((char *) block) + blksize;
+		set->memAllocated += blksize;
 
 		chunk = (AllocChunk) (((char *) block) + ALLOC_BLOCKHDRSZ);
 		chunk->aset = set;
@@ -770,6 +777,7 @@ AllocSetAlloc(MemoryContext context, Size size)
 		block->aset = set;
 		block->freeptr = ((char *) block) + ALLOC_BLOCKHDRSZ;
 		block->endptr = ((char *) block) + blksize;
+		set->memAllocated += blksize;
 
 		/*
 		 * If this is the first block of the set, make it the "keeper" block.
@@ -859,6 +867,7 @@ AllocSetFree(MemoryContext context, void *pointer)
 			set->blocks = block->next;
 		else
 			prevblock->next = block->next;
+		set->memAllocated -= block->endptr - ((char *) block);
 #ifdef CLOBBER_FREED_MEMORY
 		/* Wipe freed memory for debugging purposes */
 		memset(block, 0x7F, block->freeptr - ((char *) block));
@@ -940,6 +949,7 @@ AllocSetRealloc(MemoryContext context, void *pointer, Size size)
 		AllocBlock	prevblock = NULL;
 		Size		chksize;
 		Size		blksize;
+		Size		oldblksize;
 
 		while (block != NULL)
 		{
@@ -957,6 +967,7 @@ AllocSetRealloc(MemoryContext context, void *pointer, Size size)
 		/* Do the realloc */
 		chksize = MAXALIGN(size);
 		blksize = chksize + ALLOC_BLOCKHDRSZ + ALLOC_CHUNKHDRSZ;
+		oldblksize = block->endptr - ((char *) block);
 		block = (AllocBlock) realloc(block, blksize);
 		if (block == NULL)
 		{
@@ -968,6 +979,8 @@ AllocSetRealloc(MemoryContext context, void *pointer, Size size)
 							   (unsigned long) size)));
 		}
 		block->freeptr = block->endptr = ((char *) block) + blksize;
+		set->memAllocated -= oldblksize;
+		set->memAllocated += blksize;
 
 		/* Update pointers since block has likely been moved */
 		chunk = (AllocChunk) (((char *) block) + ALLOC_BLOCKHDRSZ);
@@ -1093,6 +1106,22 @@ AllocSetStats(MemoryContext context, int level)
 			totalspace - freespace);
 }
 
+/*
+ * AllocSetMemAllocated
+ *		Returns the space obtained from malloc by an allocset.
+ *
+ * The total is kept up to date as blocks come and go, so callers such as
+ * hashed aggregation can check it after every allocation they care about
+ * without walking the blocks list.
+ */
+static Size
+AllocSetMemAllocated(MemoryContext context)
+{
+	AllocSet	set = (AllocSet) context;
+
+	return set->memAllocated;
+}
+
 
 #ifdef MEMORY_CONTEXT_CHECKING
 
@@ -1110,6 +1139,7 @@ AllocSetCheck(MemoryContext context)
 	AllocSet	set = (AllocSet) context;
 	char	   *name = set->header.name;
 	AllocBlock	block;
+	Size		totalspace = 0;
 
 	for (block = set->blocks; block != NULL; block = block->next)
 	{
@@ -1183,7 +1213,14 @@ AllocSetCheck(MemoryContext context)
 		if ((blk_data + (nchunks * ALLOC_CHUNKHDRSZ)) != blk_used)
 			elog(WARNING, "problem in alloc set %s: found inconsistent memory block %p",
 				 name, block);
+
+		totalspace += block->endptr - ((char *) block);
 	}
+
+	if (totalspace != set->memAllocated)
+		elog(WARNING, "problem in alloc set %s: blocks add up to %lu bytes, not %lu",
+			 name, (unsigned long) totalspace,
+			 (unsigned long) set->memAllocated);
 }
 
 #endif   /* MEMORY_CONTEXT_CHECKING */
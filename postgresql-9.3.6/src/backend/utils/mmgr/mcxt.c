@@ -380,6 +380,36 @@ MemoryContextIsEmpty(MemoryContext context)
 	return (*context->methods->is_empty) (context);
 }
 
+/*
+ * MemoryContextMemAllocated
+ *		Total space obtained from malloc by a memory context, and by its
+ *		descendants if recurse is true.
+ *
+ * This counts whole blocks, free space included, so it is what the context
+ * really costs; it is meant for callers that must stay within work_mem.
+ */
+Size
+MemoryContextMemAllocated(MemoryContext context, bool recurse)
+{
+	Size		total;
+
+	AssertArg(MemoryContextIsValid(context));
+
+	total = (*context->methods->mem_allocated) (context);
+
+	if (recurse)
+	{
+		MemoryContext child;
+
+		for (child = context->firstchild;
+			 child != NULL;
+			 child = child->nextchild)
+			total += MemoryContextMemAllocated(child, true);
+	}
+
+	return total;
+}
+
 /*
  * MemoryContextStats
  *		Print statistics about the named context and all its descendants.
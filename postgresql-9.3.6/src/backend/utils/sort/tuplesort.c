@@ -86,6 +86,18 @@
  * we preread from a tape, so as to maintain the locality of access described
  * above.  Nonetheless, with large workMem we can have many tapes.
  *
+ * With sort_multiway_merge, both phases trade Knuth's tape economy for fewer
+ * cache misses and branches.  Instead of replacement selection, which walks
+ * a heap far larger than the CPU caches once per tuple, we fill workMem,
+ * quicksort it and write it out as one run, and repeat.  Runs come out about
+ * half as long, but the merge order we can afford means that any sort of less
+ * than roughly workMem * M is still merged in a single pass.  Merges pick the
+ * next tuple with a tree of losers (Knuth's 5.4.1L) rather than a heap: each
+ * input tape owns a leaf, and replacing the tuple just output costs one
+ * comparison per level of the tree, against about two for a heap sift-up,
+ * with no data-dependent choice of which child to descend to.  The tape
+ * distribution and prereading are the same in both modes.
+ *
  *
  * Portions Copyright (c) 1996-2013, PostgreSQL Global Development Group
  * Portions Copyright (c) 1994, Regents of the University of California
@@ -132,6 +144,8 @@ bool		trace_sort = false;
 bool		optimize_bounded_sort = true;
 #endif
 
+bool		sort_multiway_merge = false;
+
 
 /*
  * The objects we actually sort are SortTuple structs.  These contain
@@ -147,10 +161,16 @@ bool		optimize_bounded_sort = true;
  * case where the first key determines the comparison result.  Note that
  * for a pass-by-reference datatype, datum1 points into the "tuple" storage.
  *
+ * When the first key's opclass supports abbreviated keys (see sortsupport.h),
+ * datum1 holds the abbreviation instead while the tuples are in memory, and
+ * comparisons that the abbreviations leave tied fetch the original value
+ * from the tuple.  Tuples read back from tape carry no abbreviation.
+ *
  * When sorting single Datums, the data value is represented directly by
  * datum1/isnull1.  If the datatype is pass-by-reference and isnull1 is false,
  * then datum1 points to a separately palloc'd data value that is also pointed
- * to by the "tuple" pointer; otherwise "tuple" is NULL.
+ * to by the "tuple" pointer, unless datum1 is an abbreviation of it;
+ * otherwise "tuple" is NULL.
  *
  * While building initial runs, tupindex holds the tuple's run number.  During
  * merge passes, we re-use it to hold the input tape number that each tuple in
@@ -215,6 +235,7 @@ struct Tuplesortstate
 	long		allowedMem;		/* total memory allowed, in bytes */
 	int			maxTapes;		/* number of tapes (Knuth's T) */
 	int			tapeRange;		/* maxTapes-1 (Knuth's P) */
+	bool		multiway;		/* quicksorted runs, loser tree merges? */
 	MemoryContext sortcontext;	/* memory context holding all sort data */
 	LogicalTapeSet *tapeset;	/* logtape.c object for tapes in a temp file */
 
@@ -272,6 +293,11 @@ struct Tuplesortstate
 	 * heap --- during merge passes, memtuples[] entries beyond tapeRange are
 	 * never in the heap and are used to hold pre-read tuples.)  In state
 	 * SORTEDONTAPE, the array is not used.
+	 *
+	 * In multiway mode, BUILDRUNS instead keeps the unsorted tuples of the
+	 * next run, and during merges memtuples[i] is the leaf of the loser tree
+	 * for tape i, with tupindex -1 once the tape's run is exhausted;
+	 * memtupcount then counts the leaves not yet exhausted.
 	 */
 	SortTuple  *memtuples;		/* array of SortTuple structs */
 	int			memtupcount;	/* number of tuples currently present */
@@ -312,6 +338,14 @@ struct Tuplesortstate
 	int			mergefreelist;	/* head of freelist of recycled slots */
 	int			mergefirstfree; /* first slot never used in this merge */
 
+	/*
+	 * In multiway mode, the loser tree over the maxTapes leaves in
+	 * memtuples[]: mergetree[0] is the tape whose tuple comes out next, and
+	 * each inner node n, with children 2n and 2n+1 and leaf i at position
+	 * maxTapes+i, holds the tape that lost the comparison there.
+	 */
+	int		   *mergetree;
+
 	/*
 	 * Variables for Algorithm D.  Note that destTape is a "logical" tape
 	 * number, ie, an index into the tp_xxx[] arrays.  Be careful to keep
@@ -340,18 +374,25 @@ struct Tuplesortstate
 	bool		markpos_eof;	/* saved "eof_reached" */
 
 	/*
-	 * These variables are specific to the MinimalTuple case; they are set by
-	 * tuplesort_begin_heap and used only by the MinimalTuple routines.
+	 * The sort keys of the MinimalTuple, btree IndexTuple and Datum cases;
+	 * tupDesc is specific to the MinimalTuple case.
 	 */
 	TupleDesc	tupDesc;
 	SortSupport sortKeys;		/* array of length nKeys */
 
 	/*
 	 * This variable is shared by the single-key MinimalTuple case and the
-	 * Datum case (which both use qsort_ssup()).  Otherwise it's NULL.
+	 * Datum case (which both use qsort_ssup()), when the key isn't
+	 * abbreviated.  Otherwise it's NULL.
 	 */
 	SortSupport onlyKey;
 
+	/*
+	 * While the first key is abbreviated, the number of tuples at which to
+	 * next ask its opclass whether abbreviation is still worth it.
+	 */
+	int			abbrevNext;
+
 	/*
 	 * These variables are specific to the CLUSTER case; they are set by
 	 * tuplesort_begin_cluster.  Note CLUSTER also uses tupDesc and
@@ -368,7 +409,7 @@ struct Tuplesortstate
 	Relation	indexRel;		/* index being built */
 
 	/* These are specific to the index_btree subcase: */
-	ScanKey		indexScanKey;
+	ScanKey		indexScanKey;	/* only used by the CLUSTER case */
 	bool		enforceUnique;	/* complain if we find duplicate tuples */
 
 	/* These are specific to the index_hash subcase: */
@@ -456,9 +497,17 @@ static void selectnewtape(Tuplesortstate *state);
 static void mergeruns(Tuplesortstate *state);
 static void mergeonerun(Tuplesortstate *state);
 static void beginmerge(Tuplesortstate *state);
+static SortTuple *merge_top(Tuplesortstate *state);
+static void merge_replace_top(Tuplesortstate *state, int srcTape,
+				  SortTuple *newtup);
+static bool mergetree_precedes(Tuplesortstate *state, int a, int b);
+static void mergetree_build(Tuplesortstate *state);
+static void mergetree_replay(Tuplesortstate *state, int srcTape);
 static void mergepreread(Tuplesortstate *state);
 static void mergeprereadone(Tuplesortstate *state, int srcTape);
 static void dumptuples(Tuplesortstate *state, bool alltuples);
+static void dumpbatch(Tuplesortstate *state);
+static void tuplesort_sort_memtuples(Tuplesortstate *state);
 static void make_bounded_heap(Tuplesortstate *state);
 static void sort_bounded_heap(Tuplesortstate *state);
 static void tuplesort_heap_insert(Tuplesortstate *state, SortTuple *tuple,
@@ -500,7 +549,9 @@ static void writetup_datum(Tuplesortstate *state, int tapenum,
 static void readtup_datum(Tuplesortstate *state, SortTuple *stup,
 			  int tapenum, unsigned int len);
 static void reversedirection_datum(Tuplesortstate *state);
+static void reversedirection_cluster(Tuplesortstate *state);
 static void free_sort_tuple(Tuplesortstate *state, SortTuple *stup);
+static bool consider_abort_common(Tuplesortstate *state);
 
 /*
  * Special versions of qsort just for SortTuple objects.  qsort_tuple() sorts
@@ -590,6 +641,10 @@ tuplesort_begin_common(int workMem, bool randomAccess)
 
 	state->result_tape = -1;	/* flag that result tape has not been formed */
 
+	state->abbrevNext = 10;
+
+	state->multiway = sort_multiway_merge;
+
 	MemoryContextSwitchTo(oldcontext);
 
 	return state;
@@ -647,11 +702,17 @@ tuplesort_begin_heap(TupleDesc tupDesc,
 		sortKey->ssup_collation = sortCollations[i];
 		sortKey->ssup_nulls_first = nullsFirstFlags[i];
 		sortKey->ssup_attno = attNums[i];
+		/* only the leading key has a datum1 slot to abbreviate into */
+		sortKey->abbreviate = (i == 0);
 
 		PrepareSortSupportFromOrderingOp(sortOperators[i], sortKey);
 	}
 
-	if (nkeys == 1)
+	/*
+	 * The single-key case can use qsort_ssup() unless the key is
+	 * abbreviated, in which case ties need the original values.
+	 */
+	if (nkeys == 1 && !state->sortKeys->abbrev_converter)
 		state->onlyKey = state->sortKeys;
 
 	MemoryContextSwitchTo(oldcontext);
@@ -691,7 +752,7 @@ tuplesort_begin_cluster(TupleDesc tupDesc,
 	state->copytup = copytup_cluster;
 	state->writetup = writetup_cluster;
 	state->readtup = readtup_cluster;
-	state->reversedirection = reversedirection_index_btree;
+	state->reversedirection = reversedirection_cluster;
 
 	state->indexInfo = BuildIndexInfo(indexRel);
 	state->indexScanKey = _bt_mkscankey_nodata(indexRel);
@@ -727,7 +788,9 @@ tuplesort_begin_index_btree(Relation heapRel,
 							int workMem, bool randomAccess)
 {
 	Tuplesortstate *state = tuplesort_begin_common(workMem, randomAccess);
+	ScanKey		indexScanKey;
 	MemoryContext oldcontext;
+	int			i;
 
 	oldcontext = MemoryContextSwitchTo(state->sortcontext);
 
@@ -755,9 +818,38 @@ tuplesort_begin_index_btree(Relation heapRel,
 
 	state->heapRel = heapRel;
 	state->indexRel = indexRel;
-	state->indexScanKey = _bt_mkscankey_nodata(indexRel);
 	state->enforceUnique = enforceUnique;
 
+	indexScanKey = _bt_mkscankey_nodata(indexRel);
+
+	/* Prepare SortSupport data for each column */
+	state->sortKeys = (SortSupport) palloc0(state->nKeys *
+											sizeof(SortSupportData));
+
+	for (i = 0; i < state->nKeys; i++)
+	{
+		SortSupport sortKey = state->sortKeys + i;
+		ScanKey		scanKey = indexScanKey + i;
+		int16		strategy;
+
+		sortKey->ssup_cxt = CurrentMemoryContext;
+		sortKey->ssup_collation = scanKey->sk_collation;
+		sortKey->ssup_nulls_first =
+			(scanKey->sk_flags & SK_BT_NULLS_FIRST) != 0;
+		sortKey->ssup_attno = scanKey->sk_attno;
+		/* only the leading key has a datum1 slot to abbreviate into */
+		sortKey->abbreviate = (i == 0);
+
+		AssertState(sortKey->ssup_attno != 0);
+
+		strategy = (scanKey->sk_flags & SK_BT_DESC) != 0 ?
+			BTGreaterStrategyNumber : BTLessStrategyNumber;
+
+		PrepareSortSupportFromIndexRel(indexRel, strategy, sortKey);
+	}
+
+	_bt_freeskey(indexScanKey);
+
 	MemoryContextSwitchTo(oldcontext);
 
 	return state;
@@ -835,20 +927,33 @@ tuplesort_begin_datum(Oid datumType, Oid sortOperator, Oid sortCollation,
 
 	state->datumType = datumType;
 
-	/* Prepare SortSupport data */
-	state->onlyKey = (SortSupport) palloc0(sizeof(SortSupportData));
-
-	state->onlyKey->ssup_cxt = CurrentMemoryContext;
-	state->onlyKey->ssup_collation = sortCollation;
-	state->onlyKey->ssup_nulls_first = nullsFirstFlag;
-
-	PrepareSortSupportFromOrderingOp(sortOperator, state->onlyKey);
-
 	/* lookup necessary attributes of the datum type */
 	get_typlenbyval(datumType, &typlen, &typbyval);
 	state->datumTypeLen = typlen;
 	state->datumTypeByVal = typbyval;
 
+	/* Prepare SortSupport data */
+	state->sortKeys = (SortSupport) palloc0(sizeof(SortSupportData));
+
+	state->sortKeys->ssup_cxt = CurrentMemoryContext;
+	state->sortKeys->ssup_collation = sortCollation;
+	state->sortKeys->ssup_nulls_first = nullsFirstFlag;
+
+	/*
+	 * Abbreviation keeps the original value in "tuple", so it is only
+	 * possible for pass-by-reference types.
+	 */
+	state->sortKeys->abbreviate = !typbyval;
+
+	PrepareSortSupportFromOrderingOp(sortOperator, state->sortKeys);
+
+	/*
+	 * The qsort_ssup() shortcut only compares datum1, so it can't be used
+	 * with abbreviated keys.
+	 */
+	if (!state->sortKeys->abbrev_converter)
+		state->onlyKey = state->sortKeys;
+
 	MemoryContextSwitchTo(oldcontext);
 
 	return state;
@@ -1169,10 +1274,44 @@ tuplesort_putdatum(Tuplesortstate *state, Datum val, bool isNull)
 	}
 	else
 	{
-		stup.datum1 = datumCopy(val, false, state->datumTypeLen);
+		Datum		original = datumCopy(val, false, state->datumTypeLen);
+
 		stup.isnull1 = false;
-		stup.tuple = DatumGetPointer(stup.datum1);
+		stup.tuple = DatumGetPointer(original);
 		USEMEM(state, GetMemoryChunkSpace(stup.tuple));
+
+		if (!state->sortKeys->abbrev_converter)
+		{
+			stup.datum1 = original;
+		}
+		else if (!consider_abort_common(state))
+		{
+			/* Store abbreviated key representation */
+			stup.datum1 = state->sortKeys->abbrev_converter(original,
+															state->sortKeys);
+		}
+		else
+		{
+			/* Abort abbreviation */
+			int			i;
+
+			stup.datum1 = original;
+
+			/*
+			 * Set state to be consistent with never trying abbreviation.
+			 *
+			 * Alter datum1 representation in already-copied tuples, so as to
+			 * ensure a consistent representation (current tuple was just
+			 * handled).  Note that we rely on all tuples copied so far
+			 * actually being contained within memtuples array.
+			 */
+			for (i = 0; i < state->memtupcount; i++)
+			{
+				SortTuple  *mtup = &state->memtuples[i];
+
+				mtup->datum1 = PointerGetDatum(mtup->tuple);
+			}
+		}
 	}
 
 	puttuple_common(state, &stup);
@@ -1242,9 +1381,13 @@ puttuple_common(Tuplesortstate *state, SortTuple *tuple)
 			inittapes(state);
 
 			/*
-			 * Dump tuples until we are back under the limit.
+			 * Dump tuples until we are back under the limit; in multiway
+			 * mode, that's all of them, as the first run.
 			 */
-			dumptuples(state, false);
+			if (state->multiway)
+				dumpbatch(state);
+			else
+				dumptuples(state, false);
 			break;
 
 		case TSS_BOUNDED:
@@ -1274,6 +1417,18 @@ puttuple_common(Tuplesortstate *state, SortTuple *tuple)
 
 		case TSS_BUILDRUNS:
 
+			/*
+			 * In multiway mode, just collect the tuples of the next run until
+			 * memory or the memtuples[] array is full.
+			 */
+			if (state->multiway)
+			{
+				state->memtuples[state->memtupcount++] = *tuple;
+				if (LACKMEM(state) || state->memtupcount >= state->memtupsize)
+					dumpbatch(state);
+				break;
+			}
+
 			/*
 			 * Insert the tuple into the heap, with run number currentRun if
 			 * it can go into the current run, else run number currentRun+1.
@@ -1327,18 +1482,7 @@ tuplesort_performsort(Tuplesortstate *state)
 			 * We were able to accumulate all the tuples within the allowed
 			 * amount of memory.  Just qsort 'em and we're done.
 			 */
-			if (state->memtupcount > 1)
-			{
-				/* Can we use the single-key sort function? */
-				if (state->onlyKey != NULL)
-					qsort_ssup(state->memtuples, state->memtupcount,
-							   state->onlyKey);
-				else
-					qsort_tuple(state->memtuples,
-								state->memtupcount,
-								state->comparetup,
-								state);
-			}
+			tuplesort_sort_memtuples(state);
 			state->current = 0;
 			state->eof_reached = false;
 			state->markpos_offset = 0;
@@ -1369,7 +1513,10 @@ tuplesort_performsort(Tuplesortstate *state)
 			 * run (or, if !randomAccess, one run per tape). Note that
 			 * mergeruns sets the correct state->status.
 			 */
-			dumptuples(state, true);
+			if (!state->multiway)
+				dumptuples(state, true);
+			else if (state->memtupcount > 0)
+				dumpbatch(state);
 			mergeruns(state);
 			state->eof_reached = false;
 			state->markpos_block = 0L;
@@ -1549,12 +1696,13 @@ tuplesort_gettuple_common(Tuplesortstate *state, bool forward,
 			 */
 			if (state->memtupcount > 0)
 			{
-				int			srcTape = state->memtuples[0].tupindex;
+				SortTuple  *top = merge_top(state);
+				int			srcTape = top->tupindex;
 				Size		tuplen;
 				int			tupIndex;
-				SortTuple  *newtup;
+				SortTuple  *newtup = NULL;
 
-				*stup = state->memtuples[0];
+				*stup = *top;
 				/* returned tuple is no longer counted in our memory space */
 				if (stup->tuple)
 				{
@@ -1562,7 +1710,6 @@ tuplesort_gettuple_common(Tuplesortstate *state, bool forward,
 					state->availMem += tuplen;
 					state->mergeavailmem[srcTape] += tuplen;
 				}
-				tuplesort_heap_siftup(state, false);
 				if ((tupIndex = state->mergenext[srcTape]) == 0)
 				{
 					/*
@@ -1572,23 +1719,25 @@ tuplesort_gettuple_common(Tuplesortstate *state, bool forward,
 					 * tape that's run dry.  See mergepreread() comments.
 					 */
 					mergeprereadone(state, srcTape);
-
-					/*
-					 * if still no data, we've reached end of run on this tape
-					 */
-					if ((tupIndex = state->mergenext[srcTape]) == 0)
-						return true;
+					tupIndex = state->mergenext[srcTape];
+				}
+				/* pull next preread tuple from list, if any */
+				if (tupIndex != 0)
+				{
+					newtup = &state->memtuples[tupIndex];
+					state->mergenext[srcTape] = newtup->tupindex;
+					if (state->mergenext[srcTape] == 0)
+						state->mergelast[srcTape] = 0;
+				}
+				/* no newtup means we've reached end of run on this tape */
+				merge_replace_top(state, srcTape, newtup);
+				if (newtup != NULL)
+				{
+					/* put the now-unused memtuples entry on the freelist */
+					newtup->tupindex = state->mergefreelist;
+					state->mergefreelist = tupIndex;
+					state->mergeavailslots[srcTape]++;
 				}
-				/* pull next preread tuple from list, insert in heap */
-				newtup = &state->memtuples[tupIndex];
-				state->mergenext[srcTape] = newtup->tupindex;
-				if (state->mergenext[srcTape] == 0)
-					state->mergelast[srcTape] = 0;
-				tuplesort_heap_insert(state, newtup, srcTape, false);
-				/* put the now-unused memtuples entry on the freelist */
-				newtup->tupindex = state->mergefreelist;
-				state->mergefreelist = tupIndex;
-				state->mergeavailslots[srcTape]++;
 				return true;
 			}
 			return false;
@@ -1696,10 +1845,12 @@ tuplesort_getdatum(Tuplesortstate *state, bool forward,
 	}
 	else
 	{
+		/* use stup.tuple because stup.datum1 may be an abbreviation */
 		if (should_free)
-			*val = stup.datum1;
+			*val = PointerGetDatum(stup.tuple);
 		else
-			*val = datumCopy(stup.datum1, false, state->datumTypeLen);
+			*val = datumCopy(PointerGetDatum(stup.tuple), false,
+							 state->datumTypeLen);
 		*isNull = false;
 	}
 
@@ -1804,24 +1955,32 @@ inittapes(Tuplesortstate *state)
 	state->tp_dummy = (int *) palloc0(maxTapes * sizeof(int));
 	state->tp_tapenum = (int *) palloc0(maxTapes * sizeof(int));
 
-	/*
-	 * Convert the unsorted contents of memtuples[] into a heap. Each tuple is
-	 * marked as belonging to run number zero.
-	 *
-	 * NOTE: we pass false for checkIndex since there's no point in comparing
-	 * indexes in this step, even though we do intend the indexes to be part
-	 * of the sort key...
-	 */
-	ntuples = state->memtupcount;
-	state->memtupcount = 0;		/* make the heap empty */
-	for (j = 0; j < ntuples; j++)
+	if (state->multiway)
+	{
+		/* the unsorted contents of memtuples[] become the first run as is */
+		state->mergetree = (int *) palloc0(maxTapes * sizeof(int));
+	}
+	else
 	{
-		/* Must copy source tuple to avoid possible overwrite */
-		SortTuple	stup = state->memtuples[j];
+		/*
+		 * Convert the unsorted contents of memtuples[] into a heap. Each
+		 * tuple is marked as belonging to run number zero.
+		 *
+		 * NOTE: we pass false for checkIndex since there's no point in
+		 * comparing indexes in this step, even though we do intend the
+		 * indexes to be part of the sort key...
+		 */
+		ntuples = state->memtupcount;
+		state->memtupcount = 0; /* make the heap empty */
+		for (j = 0; j < ntuples; j++)
+		{
+			/* Must copy source tuple to avoid possible overwrite */
+			SortTuple	stup = state->memtuples[j];
 
-		tuplesort_heap_insert(state, &stup, 0, false);
+			tuplesort_heap_insert(state, &stup, 0, false);
+		}
+		Assert(state->memtupcount == ntuples);
 	}
-	Assert(state->memtupcount == ntuples);
 
 	state->currentRun = 0;
 
@@ -1911,6 +2070,18 @@ mergeruns(Tuplesortstate *state)
 		return;
 	}
 
+	/*
+	 * Tuples read back from tape don't have their abbreviated keys, so the
+	 * merge must compare the original values.
+	 */
+	if (state->sortKeys != NULL && state->sortKeys->abbrev_converter != NULL)
+	{
+		state->sortKeys->comparator = state->sortKeys->abbrev_full_comparator;
+		state->sortKeys->abbrev_converter = NULL;
+		state->sortKeys->abbrev_abort = NULL;
+		state->sortKeys->abbrev_full_comparator = NULL;
+	}
+
 	/* End of step D2: rewind all output tapes to prepare for merging */
 	for (tapenum = 0; tapenum < state->tapeRange; tapenum++)
 		LogicalTapeRewind(state->tapeset, tapenum, false);
@@ -2044,31 +2215,36 @@ mergeonerun(Tuplesortstate *state)
 	{
 		/* write the tuple to destTape */
 		priorAvail = state->availMem;
-		srcTape = state->memtuples[0].tupindex;
-		WRITETUP(state, destTape, &state->memtuples[0]);
+		tup = merge_top(state);
+		srcTape = tup->tupindex;
+		WRITETUP(state, destTape, tup);
 		/* writetup adjusted total free space, now fix per-tape space */
 		spaceFreed = state->availMem - priorAvail;
 		state->mergeavailmem[srcTape] += spaceFreed;
-		/* compact the heap */
-		tuplesort_heap_siftup(state, false);
 		if ((tupIndex = state->mergenext[srcTape]) == 0)
 		{
 			/* out of preloaded data on this tape, try to read more */
 			mergepreread(state);
-			/* if still no data, we've reached end of run on this tape */
-			if ((tupIndex = state->mergenext[srcTape]) == 0)
-				continue;
+			tupIndex = state->mergenext[srcTape];
+		}
+		/* pull next preread tuple from list, if any */
+		tup = NULL;
+		if (tupIndex != 0)
+		{
+			tup = &state->memtuples[tupIndex];
+			state->mergenext[srcTape] = tup->tupindex;
+			if (state->mergenext[srcTape] == 0)
+				state->mergelast[srcTape] = 0;
+		}
+		/* no tup means we've reached end of run on this tape */
+		merge_replace_top(state, srcTape, tup);
+		if (tup != NULL)
+		{
+			/* put the now-unused memtuples entry on the freelist */
+			tup->tupindex = state->mergefreelist;
+			state->mergefreelist = tupIndex;
+			state->mergeavailslots[srcTape]++;
 		}
-		/* pull next preread tuple from list, insert in heap */
-		tup = &state->memtuples[tupIndex];
-		state->mergenext[srcTape] = tup->tupindex;
-		if (state->mergenext[srcTape] == 0)
-			state->mergelast[srcTape] = 0;
-		tuplesort_heap_insert(state, tup, srcTape, false);
-		/* put the now-unused memtuples entry on the freelist */
-		tup->tupindex = state->mergefreelist;
-		state->mergefreelist = tupIndex;
-		state->mergeavailslots[srcTape]++;
 	}
 
 	/*
@@ -2130,7 +2306,19 @@ beginmerge(Tuplesortstate *state)
 	memset(state->mergelast, 0,
 		   state->maxTapes * sizeof(*state->mergelast));
 	state->mergefreelist = 0;	/* nothing in the freelist */
-	state->mergefirstfree = activeTapes;		/* 1st slot avail for preread */
+
+	/*
+	 * The 1st slot avail for preread follows the merge heap, or in multiway
+	 * mode the leaves of the loser tree, all of which start out exhausted.
+	 */
+	if (state->multiway)
+	{
+		state->mergefirstfree = state->maxTapes;
+		for (srcTape = 0; srcTape < state->maxTapes; srcTape++)
+			state->memtuples[srcTape].tupindex = -1;
+	}
+	else
+		state->mergefirstfree = activeTapes;
 
 	/*
 	 * Initialize space allocation to let each active input tape have an equal
@@ -2167,13 +2355,150 @@ beginmerge(Tuplesortstate *state)
 			state->mergenext[srcTape] = tup->tupindex;
 			if (state->mergenext[srcTape] == 0)
 				state->mergelast[srcTape] = 0;
-			tuplesort_heap_insert(state, tup, srcTape, false);
+			if (state->multiway)
+			{
+				state->memtuples[srcTape] = *tup;
+				state->memtuples[srcTape].tupindex = srcTape;
+				state->memtupcount++;
+			}
+			else
+				tuplesort_heap_insert(state, tup, srcTape, false);
 			/* put the now-unused memtuples entry on the freelist */
 			tup->tupindex = state->mergefreelist;
 			state->mergefreelist = tupIndex;
 			state->mergeavailslots[srcTape]++;
 		}
 	}
+
+	if (state->multiway)
+		mergetree_build(state);
+}
+
+/*
+ * merge_top - the tuple to come out of the merge next
+ *
+ * Its tupindex is the tape it was read from.
+ */
+static SortTuple *
+merge_top(Tuplesortstate *state)
+{
+	Assert(state->memtupcount > 0);
+
+	if (state->multiway)
+		return &state->memtuples[state->mergetree[0]];
+	return &state->memtuples[0];
+}
+
+/*
+ * merge_replace_top - replace the tuple just taken from the merge
+ *
+ * newtup is the next tuple of the same tape, srcTape, or NULL if its run is
+ * exhausted.  The caller remains responsible for newtup's memtuples[] slot.
+ */
+static void
+merge_replace_top(Tuplesortstate *state, int srcTape, SortTuple *newtup)
+{
+	if (!state->multiway)
+	{
+		tuplesort_heap_siftup(state, false);
+		if (newtup != NULL)
+			tuplesort_heap_insert(state, newtup, srcTape, false);
+		return;
+	}
+
+	if (newtup != NULL)
+	{
+		state->memtuples[srcTape] = *newtup;
+		state->memtuples[srcTape].tupindex = srcTape;
+	}
+	else
+	{
+		state->memtuples[srcTape].tupindex = -1;
+		state->memtupcount--;
+	}
+	mergetree_replay(state, srcTape);
+}
+
+/*
+ * mergetree_precedes - does the leaf of tape a come out before that of b?
+ *
+ * Exhausted leaves come out after everything else.
+ */
+static bool
+mergetree_precedes(Tuplesortstate *state, int a, int b)
+{
+	SortTuple  *memtuples = state->memtuples;
+
+	if (memtuples[b].tupindex < 0)
+		return true;
+	if (memtuples[a].tupindex < 0)
+		return false;
+	return COMPARETUP(state, &memtuples[a], &memtuples[b]) <= 0;
+}
+
+/*
+ * mergetree_build - build the loser tree over freshly loaded leaves
+ *
+ * Plays the tournament bottom-up, keeping each match's winner in a
+ * scratch array and its loser in the tree.
+ */
+static void
+mergetree_build(Tuplesortstate *state)
+{
+	int			nleaves = state->maxTapes;
+	int		   *tree = state->mergetree;
+	int		   *winners;
+	int			node;
+
+	winners = (int *) palloc(2 * nleaves * sizeof(int));
+	for (node = 0; node < nleaves; node++)
+		winners[nleaves + node] = node;
+
+	for (node = nleaves - 1; node > 0; node--)
+	{
+		int			left = winners[2 * node];
+		int			right = winners[2 * node + 1];
+
+		if (mergetree_precedes(state, left, right))
+		{
+			winners[node] = left;
+			tree[node] = right;
+		}
+		else
+		{
+			winners[node] = right;
+			tree[node] = left;
+		}
+	}
+	tree[0] = (nleaves > 1) ? winners[1] : 0;
+
+	pfree(winners);
+}
+
+/*
+ * mergetree_replay - restore the loser tree after a leaf changed
+ *
+ * Only the leaf of the previous winner, srcTape, can have changed, so its
+ * new tuple just replays the matches on the path to the root.
+ */
+static void
+mergetree_replay(Tuplesortstate *state, int srcTape)
+{
+	int		   *tree = state->mergetree;
+	int			winner = srcTape;
+	int			node;
+
+	for (node = (state->maxTapes + srcTape) / 2; node > 0; node /= 2)
+	{
+		if (mergetree_precedes(state, tree[node], winner))
+		{
+			int			loser = winner;
+
+			winner = tree[node];
+			tree[node] = loser;
+		}
+	}
+	tree[0] = winner;
 }
 
 /*
@@ -2327,6 +2652,66 @@ dumptuples(Tuplesortstate *state, bool alltuples)
 	}
 }
 
+/*
+ * dumpbatch - quicksort the tuples in memory and write them out as a run
+ *
+ * This is how multiway mode builds its runs, instead of dumptuples().  The
+ * caller has collected a workMem's worth of tuples in memtuples[], or the
+ * last of the input.
+ */
+static void
+dumpbatch(Tuplesortstate *state)
+{
+	int			destTape;
+	int			i;
+
+	Assert(state->status == TSS_BUILDRUNS);
+	Assert(state->memtupcount > 0);
+
+	/* Every run but the first starts on a new tape, per Algorithm D */
+	if (state->currentRun > 0)
+		selectnewtape(state);
+	destTape = state->tp_tapenum[state->destTape];
+
+	tuplesort_sort_memtuples(state);
+
+	for (i = 0; i < state->memtupcount; i++)
+		WRITETUP(state, destTape, &state->memtuples[i]);
+	state->memtupcount = 0;
+
+	markrunend(state, destTape);
+	state->currentRun++;
+	state->tp_runs[state->destTape]++;
+	state->tp_dummy[state->destTape]--; /* per Alg D step D2 */
+
+#ifdef TRACE_SORT
+	if (trace_sort)
+		elog(LOG, "finished writing run %d to tape %d: %s",
+			 state->currentRun, state->destTape,
+			 pg_rusage_show(&state->ru_start));
+#endif
+}
+
+/*
+ * tuplesort_sort_memtuples - quicksort all the tuples in memtuples[]
+ */
+static void
+tuplesort_sort_memtuples(Tuplesortstate *state)
+{
+	if (state->memtupcount > 1)
+	{
+		/* Can we use the single-key sort function? */
+		if (state->onlyKey != NULL)
+			qsort_ssup(state->memtuples, state->memtupcount,
+					   state->onlyKey);
+		else
+			qsort_tuple(state->memtuples,
+						state->memtupcount,
+						state->comparetup,
+						state);
+	}
+}
+
 /*
  * tuplesort_rescan		- rewind and replay the scan
  */
@@ -2778,6 +3163,12 @@ comparetup_heap(const SortTuple *a, const SortTuple *b, Tuplesortstate *state)
 	int			nkey;
 	int32		compare;
 
+	AttrNumber	attno;
+	Datum		datum1,
+				datum2;
+	bool		isnull1,
+				isnull2;
+
 	/* Compare the leading sort key */
 	compare = ApplySortComparator(a->datum1, a->isnull1,
 								  b->datum1, b->isnull1,
@@ -2791,14 +3182,26 @@ comparetup_heap(const SortTuple *a, const SortTuple *b, Tuplesortstate *state)
 	rtup.t_len = ((MinimalTuple) b->tuple)->t_len + MINIMAL_TUPLE_OFFSET;
 	rtup.t_data = (HeapTupleHeader) ((char *) b->tuple - MINIMAL_TUPLE_OFFSET);
 	tupDesc = state->tupDesc;
+
+	/* Equal abbreviations say nothing; compare the original values */
+	if (sortKey->abbrev_converter)
+	{
+		attno = sortKey->ssup_attno;
+
+		datum1 = heap_getattr(&ltup, attno, tupDesc, &isnull1);
+		datum2 = heap_getattr(&rtup, attno, tupDesc, &isnull2);
+
+		compare = ApplySortAbbrevFullComparator(datum1, isnull1,
+												datum2, isnull2,
+												sortKey);
+		if (compare != 0)
+			return compare;
+	}
+
 	sortKey++;
 	for (nkey = 1; nkey < state->nKeys; nkey++, sortKey++)
 	{
-		AttrNumber	attno = sortKey->ssup_attno;
-		Datum		datum1,
-					datum2;
-		bool		isnull1,
-					isnull2;
+		attno = sortKey->ssup_attno;
 
 		datum1 = heap_getattr(&ltup, attno, tupDesc, &isnull1);
 		datum2 = heap_getattr(&rtup, attno, tupDesc, &isnull2);
@@ -2823,6 +3226,7 @@ copytup_heap(Tuplesortstate *state, SortTuple *stup, void *tup)
 	TupleTableSlot *slot = (TupleTableSlot *) tup;
 	MinimalTuple tuple;
 	HeapTupleData htup;
+	Datum		original;
 
 	/* copy the tuple into sort storage */
 	tuple = ExecCopySlotMinimalTuple(slot);
@@ -2831,10 +3235,58 @@ copytup_heap(Tuplesortstate *state, SortTuple *stup, void *tup)
 	/* set up first-column key value */
 	htup.t_len = tuple->t_len + MINIMAL_TUPLE_OFFSET;
 	htup.t_data = (HeapTupleHeader) ((char *) tuple - MINIMAL_TUPLE_OFFSET);
-	stup->datum1 = heap_getattr(&htup,
-								state->sortKeys[0].ssup_attno,
-								state->tupDesc,
-								&stup->isnull1);
+	original = heap_getattr(&htup,
+							state->sortKeys[0].ssup_attno,
+							state->tupDesc,
+							&stup->isnull1);
+
+	if (!state->sortKeys->abbrev_converter || stup->isnull1)
+	{
+		/*
+		 * Store ordinary Datum representation, or NULL value.  If there is a
+		 * converter it won't expect NULL values, and cost model is not
+		 * required to account for NULL, so in that case we avoid calling
+		 * converter and just set datum1 to "void" representation (to be
+		 * consistent).
+		 */
+		stup->datum1 = original;
+	}
+	else if (!consider_abort_common(state))
+	{
+		/* Store abbreviated key representation */
+		stup->datum1 = state->sortKeys->abbrev_converter(original,
+														 state->sortKeys);
+	}
+	else
+	{
+		/* Abort abbreviation */
+		int			i;
+
+		stup->datum1 = original;
+
+		/*
+		 * Set state to be consistent with never trying abbreviation.
+		 *
+		 * Alter datum1 representation in already-copied tuples, so as to
+		 * ensure a consistent representation (current tuple was just
+		 * handled).  Note that we rely on all tuples copied so far actually
+		 * being contained within memtuples array.
+		 */
+		for (i = 0; i < state->memtupcount; i++)
+		{
+			SortTuple  *mtup = &state->memtuples[i];
+
+			htup.t_len = ((MinimalTuple) mtup->tuple)->t_len +
+				MINIMAL_TUPLE_OFFSET;
+			htup.t_data = (HeapTupleHeader) ((char *) mtup->tuple -
+											 MINIMAL_TUPLE_OFFSET);
+
+			mtup->datum1 = heap_getattr(&htup,
+										state->sortKeys[0].ssup_attno,
+										state->tupDesc,
+										&mtup->isnull1);
+		}
+	}
 }
 
 static void
@@ -3079,6 +3531,18 @@ readtup_cluster(Tuplesortstate *state, SortTuple *stup,
 									&stup->isnull1);
 }
 
+static void
+reversedirection_cluster(Tuplesortstate *state)
+{
+	ScanKey		scanKey = state->indexScanKey;
+	int			nkey;
+
+	for (nkey = 0; nkey < state->nKeys; nkey++, scanKey++)
+	{
+		scanKey->sk_flags ^= (SK_BT_DESC | SK_BT_NULLS_FIRST);
+	}
+}
+
 
 /*
  * Routines specialized for IndexTuple case
@@ -3098,7 +3562,7 @@ comparetup_index_btree(const SortTuple *a, const SortTuple *b,
 	 * whether any null fields are present.  Also see the special treatment
 	 * for equal keys at the end.
 	 */
-	ScanKey		scanKey = state->indexScanKey;
+	SortSupport sortKey = state->sortKeys;
 	IndexTuple	tuple1;
 	IndexTuple	tuple2;
 	int			keysz;
@@ -3106,39 +3570,50 @@ comparetup_index_btree(const SortTuple *a, const SortTuple *b,
 	bool		equal_hasnull = false;
 	int			nkey;
 	int32		compare;
+	Datum		datum1,
+				datum2;
+	bool		isnull1,
+				isnull2;
 
 	/* Compare the leading sort key */
-	compare = inlineApplySortFunction(&scanKey->sk_func, scanKey->sk_flags,
-									  scanKey->sk_collation,
-									  a->datum1, a->isnull1,
-									  b->datum1, b->isnull1);
+	compare = ApplySortComparator(a->datum1, a->isnull1,
+								  b->datum1, b->isnull1,
+								  sortKey);
 	if (compare != 0)
 		return compare;
 
-	/* they are equal, so we only need to examine one null flag */
-	if (a->isnull1)
-		equal_hasnull = true;
-
 	/* Compare additional sort keys */
 	tuple1 = (IndexTuple) a->tuple;
 	tuple2 = (IndexTuple) b->tuple;
 	keysz = state->nKeys;
 	tupDes = RelationGetDescr(state->indexRel);
-	scanKey++;
-	for (nkey = 2; nkey <= keysz; nkey++, scanKey++)
+
+	/* Equal abbreviations say nothing; compare the original values */
+	if (sortKey->abbrev_converter)
 	{
-		Datum		datum1,
-					datum2;
-		bool		isnull1,
-					isnull2;
+		datum1 = index_getattr(tuple1, 1, tupDes, &isnull1);
+		datum2 = index_getattr(tuple2, 1, tupDes, &isnull2);
+
+		compare = ApplySortAbbrevFullComparator(datum1, isnull1,
+												datum2, isnull2,
+												sortKey);
+		if (compare != 0)
+			return compare;
+	}
 
+	/* they are equal, so we only need to examine one null flag */
+	if (a->isnull1)
+		equal_hasnull = true;
+
+	sortKey++;
+	for (nkey = 2; nkey <= keysz; nkey++, sortKey++)
+	{
 		datum1 = index_getattr(tuple1, nkey, tupDes, &isnull1);
 		datum2 = index_getattr(tuple2, nkey, tupDes, &isnull2);
 
-		compare = inlineApplySortFunction(&scanKey->sk_func, scanKey->sk_flags,
-										  scanKey->sk_collation,
-										  datum1, isnull1,
-										  datum2, isnull2);
+		compare = ApplySortComparator(datum1, isnull1,
+									  datum2, isnull2,
+									  sortKey);
 		if (compare != 0)
 			return compare;		/* done when we find unequal attributes */
 
@@ -3262,6 +3737,7 @@ copytup_index(Tuplesortstate *state, SortTuple *stup, void *tup)
 	IndexTuple	tuple = (IndexTuple) tup;
 	unsigned int tuplen = IndexTupleSize(tuple);
 	IndexTuple	newtuple;
+	Datum		original;
 
 	/* copy the tuple into sort storage */
 	newtuple = (IndexTuple) palloc(tuplen);
@@ -3269,10 +3745,56 @@ copytup_index(Tuplesortstate *state, SortTuple *stup, void *tup)
 	USEMEM(state, GetMemoryChunkSpace(newtuple));
 	stup->tuple = (void *) newtuple;
 	/* set up first-column key value */
-	stup->datum1 = index_getattr(newtuple,
-								 1,
-								 RelationGetDescr(state->indexRel),
-								 &stup->isnull1);
+	original = index_getattr(newtuple,
+							 1,
+							 RelationGetDescr(state->indexRel),
+							 &stup->isnull1);
+
+	/* the hash index case has no sort keys, and never abbreviates */
+	if (!state->sortKeys || !state->sortKeys->abbrev_converter ||
+		stup->isnull1)
+	{
+		/*
+		 * Store ordinary Datum representation, or NULL value.  If there is a
+		 * converter it won't expect NULL values, and cost model is not
+		 * required to account for NULL, so in that case we avoid calling
+		 * converter and just set datum1 to "void" representation (to be
+		 * consistent).
+		 */
+		stup->datum1 = original;
+	}
+	else if (!consider_abort_common(state))
+	{
+		/* Store abbreviated key representation */
+		stup->datum1 = state->sortKeys->abbrev_converter(original,
+														 state->sortKeys);
+	}
+	else
+	{
+		/* Abort abbreviation */
+		int			i;
+
+		stup->datum1 = original;
+
+		/*
+		 * Set state to be consistent with never trying abbreviation.
+		 *
+		 * Alter datum1 representation in already-copied tuples, so as to
+		 * ensure a consistent representation (current tuple was just
+		 * handled).  Note that we rely on all tuples copied so far actually
+		 * being contained within memtuples array.
+		 */
+		for (i = 0; i < state->memtupcount; i++)
+		{
+			SortTuple  *mtup = &state->memtuples[i];
+
+			tuple = (IndexTuple) mtup->tuple;
+			mtup->datum1 = index_getattr(tuple,
+										 1,
+										 RelationGetDescr(state->indexRel),
+										 &mtup->isnull1);
+		}
+	}
 }
 
 static void
@@ -3318,12 +3840,13 @@ readtup_index(Tuplesortstate *state, SortTuple *stup,
 static void
 reversedirection_index_btree(Tuplesortstate *state)
 {
-	ScanKey		scanKey = state->indexScanKey;
+	SortSupport sortKey = state->sortKeys;
 	int			nkey;
 
-	for (nkey = 0; nkey < state->nKeys; nkey++, scanKey++)
+	for (nkey = 0; nkey < state->nKeys; nkey++, sortKey++)
 	{
-		scanKey->sk_flags ^= (SK_BT_DESC | SK_BT_NULLS_FIRST);
+		sortKey->ssup_reverse = !sortKey->ssup_reverse;
+		sortKey->ssup_nulls_first = !sortKey->ssup_nulls_first;
 	}
 }
 
@@ -3342,9 +3865,23 @@ reversedirection_index_hash(Tuplesortstate *state)
 static int
 comparetup_datum(const SortTuple *a, const SortTuple *b, Tuplesortstate *state)
 {
-	return ApplySortComparator(a->datum1, a->isnull1,
-							   b->datum1, b->isnull1,
-							   state->onlyKey);
+	int			compare;
+
+	compare = ApplySortComparator(a->datum1, a->isnull1,
+								  b->datum1, b->isnull1,
+								  state->sortKeys);
+	if (compare != 0)
+		return compare;
+
+	/* if we have abbreviations, then "tuple" has the original value */
+	if (state->sortKeys->abbrev_converter)
+		compare = ApplySortAbbrevFullComparator(PointerGetDatum(a->tuple),
+												a->isnull1,
+												PointerGetDatum(b->tuple),
+												b->isnull1,
+												state->sortKeys);
+
+	return compare;
 }
 
 static void
@@ -3373,8 +3910,10 @@ writetup_datum(Tuplesortstate *state, int tapenum, SortTuple *stup)
 	}
 	else
 	{
-		waddr = DatumGetPointer(stup->datum1);
-		tuplen = datumGetSize(stup->datum1, false, state->datumTypeLen);
+		/* stup->datum1 may be an abbreviation; the value is in "tuple" */
+		waddr = stup->tuple;
+		tuplen = datumGetSize(PointerGetDatum(stup->tuple), false,
+							  state->datumTypeLen);
 		Assert(tuplen != 0);
 	}
 
@@ -3436,8 +3975,61 @@ readtup_datum(Tuplesortstate *state, SortTuple *stup,
 static void
 reversedirection_datum(Tuplesortstate *state)
 {
-	state->onlyKey->ssup_reverse = !state->onlyKey->ssup_reverse;
-	state->onlyKey->ssup_nulls_first = !state->onlyKey->ssup_nulls_first;
+	state->sortKeys->ssup_reverse = !state->sortKeys->ssup_reverse;
+	state->sortKeys->ssup_nulls_first = !state->sortKeys->ssup_nulls_first;
+}
+
+/*
+ * consider_abort_common - ask the opclass whether to stop abbreviating
+ *
+ * Called by the copytup routines before abbreviating a tuple's first key.
+ * The opclass is asked at exponentially growing tuple counts, and only while
+ * all the tuples are still in memory.  Returns true if abbreviation has just
+ * been given up, in which case the caller must put the original values back
+ * into datum1 of the tuples already in memtuples.
+ */
+static bool
+consider_abort_common(Tuplesortstate *state)
+{
+	Assert(state->sortKeys[0].abbrev_converter != NULL);
+	Assert(state->sortKeys[0].abbrev_full_comparator != NULL);
+
+	/* opclasses whose abbreviations are always worth it have no abort */
+	if (state->sortKeys[0].abbrev_abort == NULL)
+		return false;
+
+	/*
+	 * Check effectiveness of abbreviation optimization.  Consider aborting
+	 * when still within memory limit.
+	 */
+	if (state->status == TSS_INITIAL &&
+		state->memtupcount >= state->abbrevNext)
+	{
+		state->abbrevNext *= 2;
+
+		/*
+		 * Check opclass-supplied abbreviation abort routine.  It may indicate
+		 * that abbreviation should not proceed.
+		 */
+		if (!state->sortKeys->abbrev_abort(state->memtupcount,
+										   state->sortKeys))
+			return false;
+
+		/*
+		 * Finally, restore authoritative comparator, and indicate that
+		 * abbreviation is not in play by setting abbrev_converter to NULL
+		 */
+		state->sortKeys[0].comparator = state->sortKeys[0].abbrev_full_comparator;
+		state->sortKeys[0].abbrev_converter = NULL;
+		/* Not strictly necessary, but be tidy */
+		state->sortKeys[0].abbrev_abort = NULL;
+		state->sortKeys[0].abbrev_full_comparator = NULL;
+
+		/* Give up - expect original pass-by-value representation */
+		return true;
+	}
+
+	return false;
 }
 
 /*
@@ -610,6 +610,8 @@ DATA(insert OID = 3135 ( btnamesortsupport PGNSP PGUID 12 1 0 0 0 f f f f t f i
 DESCR("sort support");
 DATA(insert OID = 360 (  bttextcmp		   PGNSP PGUID 12 1 0 0 0 f f f f t f i 2 0 23 "25 25" _null_ _null_ _null_ _null_ bttextcmp _null_ _null_ _null_ ));
 DESCR("less-equal-greater");
+DATA(insert OID = 3184 ( bttextsortsupport PGNSP PGUID 12 1 0 0 0 f f f f t f i 1 0 2278 "2281" _null_ _null_ _null_ _null_ bttextsortsupport _null_ _null_ _null_ ));
+DESCR("sort support");
 DATA(insert OID = 377 (  cash_cmp		   PGNSP PGUID 12 1 0 0 0 f f f f t f i 2 0 23 "790 790" _null_ _null_ _null_ _null_ cash_cmp _null_ _null_ _null_ ));
 DESCR("less-equal-greater");
 DATA(insert OID = 380 (  btreltimecmp	   PGNSP PGUID 12 1 0 0 0 f f f f t f i 2 0 23 "703 703" _null_ _null_ _null_ _null_ btreltimecmp _null_ _null_ _null_ ));
@@ -2266,6 +2268,8 @@ DATA(insert OID = 1767 ( numeric_larger			PGNSP PGUID 12 1 0 0 0 f f f f t f i 2
 DESCR("larger of two");
 DATA(insert OID = 1769 ( numeric_cmp			PGNSP PGUID 12 1 0 0 0 f f f f t f i 2 0 23 "1700 1700" _null_ _null_ _null_ _null_ numeric_cmp _null_ _null_ _null_ ));
 DESCR("less-equal-greater");
+DATA(insert OID = 3185 ( numeric_sortsupport	PGNSP PGUID 12 1 0 0 0 f f f f t f i 1 0 2278 "2281" _null_ _null_ _null_ _null_ numeric_sortsupport _null_ _null_ _null_ ));
+DESCR("sort support");
 DATA(insert OID = 1771 ( numeric_uminus			PGNSP PGUID 12 1 0 0 0 f f f f t f i 1 0 1700 "1700" _null_ _null_ _null_ _null_ numeric_uminus _null_ _null_ _null_ ));
 DATA(insert OID = 1779 ( int8					PGNSP PGUID 12 1 0 0 0 f f f f t f i 1 0 20 "1700" _null_ _null_ _null_ _null_ numeric_int8 _null_ _null_ _null_ ));
 DESCR("convert numeric to int8");
@@ -3444,6 +3448,20 @@ DATA(insert OID = 2997 ( pg_table_size			PGNSP PGUID 12 1 0 0 0 f f f f t f v 1
 DESCR("disk space usage for the specified table, including TOAST, free space and visibility map");
 DATA(insert OID = 2998 ( pg_indexes_size		PGNSP PGUID 12 1 0 0 0 f f f f t f v 1 0 20 "2205" _null_ _null_ _null_ _null_ pg_indexes_size _null_ _null_ _null_ ));
 DESCR("disk space usage for all indexes attached to the specified table");
+DATA(insert OID = 3177 ( pg_hypothetical_index_size	PGNSP PGUID 12 1 0 0 0 f f f f t f v 1 0 20 "25" _null_ _null_ _null_ _null_ pg_hypothetical_index_size _null_ _null_ _null_ ));
+DESCR("estimated disk space a hypothetical index would use");
+DATA(insert OID = 3178 ( hypothetical_index_costs	PGNSP PGUID 12 1000 1000 0 0 f f f f t t v 2 0 2249 "1009 1009" "{1009,1009,23,23,701,16}" "{i,i,o,o,o,o}" "{indexes,queries,candidate,query,total_cost,uses_candidate}" _null_ hypothetical_index_costs _null_ _null_ _null_ ));
+DESCR("estimated workload costs under hypothetical index configurations");
+DATA(insert OID = 3179 ( hypothetical_index_advisor	PGNSP PGUID 12 1000 100 0 0 f f f f t t v 2 0 2249 "1009 20" "{1009,20,25,20,701}" "{i,i,o,o,o}" "{queries,budget,indexdef,size,benefit}" _null_ hypothetical_index_advisor _null_ _null_ _null_ ));
+DESCR("recommend indexes for a workload within a storage budget");
+DATA(insert OID = 3180 ( hypothetical_workload	PGNSP PGUID 12 1 100 0 0 f f f f t t v 0 0 2249 "" "{20,20,26,21,25}" "{o,o,o,o,o}" "{queryid,calls,relid,attnum,clause}" _null_ hypothetical_workload _null_ _null_ _null_ ));
+DESCR("statements captured for the index advisor");
+DATA(insert OID = 3181 ( hypothetical_workload_reset	PGNSP PGUID 12 1 0 0 0 f f f f f f v 0 0 2278 "" _null_ _null_ _null_ _null_ hypothetical_workload_reset _null_ _null_ _null_ ));
+DESCR("forget the statements captured for the index advisor");
+DATA(insert OID = 3182 ( pg_stat_get_planner_phases	PGNSP PGUID 12 1 2 0 0 f f f f t t v 0 0 2249 "" "{25,20,20,701,701,701,701,701,701,701}" "{o,o,o,o,o,o,o,o,o,o}" "{kind,plannings,cached,total_time,catalog_time,selectivity_time,paths_time,join_search_time,setrefs_time,other_time}" _null_ pg_stat_get_planner_phases _null_ _null_ _null_ ));
+DESCR("statistics: cumulative planning time by planner phase");
+DATA(insert OID = 3183 ( pg_stat_reset_planner_phases	PGNSP PGUID 12 1 0 0 0 f f f f f f v 0 0 2278 "" _null_ _null_ _null_ _null_ pg_stat_reset_planner_phases _null_ _null_ _null_ ));
+DESCR("statistics: reset cumulative planning time by planner phase");
 DATA(insert OID = 2999 ( pg_relation_filenode	PGNSP PGUID 12 1 0 0 0 f f f f t f s 1 0 26 "2205" _null_ _null_ _null_ _null_ pg_relation_filenode _null_ _null_ _null_ ));
 DESCR("filenode identifier of relation");
 DATA(insert OID = 3034 ( pg_relation_filepath	PGNSP PGUID 12 1 0 0 0 f f f f t f s 1 0 25 "2205" _null_ _null_ _null_ _null_ pg_relation_filepath _null_ _null_ _null_ ));
@@ -4160,6 +4178,8 @@ DATA(insert OID = 2958 (  uuid_gt		   PGNSP PGUID 12 1 0 0 0 f f f t t f i 2 0 1
 DATA(insert OID = 2959 (  uuid_ne		   PGNSP PGUID 12 1 0 0 0 f f f t t f i 2 0 16 "2950 2950" _null_ _null_ _null_ _null_ uuid_ne _null_ _null_ _null_ ));
 DATA(insert OID = 2960 (  uuid_cmp		   PGNSP PGUID 12 1 0 0 0 f f f f t f i 2 0 23 "2950 2950" _null_ _null_ _null_ _null_ uuid_cmp _null_ _null_ _null_ ));
 DESCR("less-equal-greater");
+DATA(insert OID = 3186 ( uuid_sortsupport   PGNSP PGUID 12 1 0 0 0 f f f f t f i 1 0 2278 "2281" _null_ _null_ _null_ _null_ uuid_sortsupport _null_ _null_ _null_ ));
+DESCR("sort support");
 DATA(insert OID = 2961 (  uuid_recv		   PGNSP PGUID 12 1 0 0 0 f f f f t f i 1 0 2950 "2281" _null_ _null_ _null_ _null_ uuid_recv _null_ _null_ _null_ ));
 DESCR("I/O");
 DATA(insert OID = 2962 (  uuid_send		   PGNSP PGUID 12 1 0 0 0 f f f f t f i 1 0 17 "2950" _null_ _null_ _null_ _null_ uuid_send _null_ _null_ _null_ ));
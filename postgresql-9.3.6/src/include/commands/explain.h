@@ -41,11 +41,15 @@ typedef struct ExplainState
 	bool		buffers;		/* print buffer usage */
 	bool		timing;			/* print timing */
 	ExplainFormat format;		/* output format */
+	bool		compare;		/* plan without and with hypothetical
+								 * indexes */
+	bool		summary;		/* print planning time by phase */
 	/* other states */
 	PlannedStmt *pstmt;			/* top of plan */
 	List	   *rtable;			/* range table */
 	List	   *rtable_names;	/* alias names for RTEs */
 	int			indent;			/* current indentation level */
+	struct HypoPlannerTimes *planning;	/* planning time to print, or NULL */
 	ExplainStateExtra *extra;	/* pointer to additional data */
 } ExplainState;
 
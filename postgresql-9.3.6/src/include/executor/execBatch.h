@@ -0,0 +1,106 @@
+/*-------------------------------------------------------------------------
+ *
+ * execBatch.h
+ *	  Batch-at-a-time evaluation of sequential scans.
+ *
+ *
+ * Portions Copyright (c) 1996-2013, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/executor/execBatch.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef EXECBATCH_H
+#define EXECBATCH_H
+
+#include "access/htup.h"
+#include "executor/tuptable.h"
+#include "nodes/execnodes.h"
+
+/* rows fetched per batch */
+#define EXEC_BATCH_SIZE			1000
+
+/* pages a batch may keep pinned */
+#define EXEC_BATCH_MAX_PAGES	8
+
+/* column types batches are evaluated on */
+typedef enum ExecBatchType
+{
+	EXEC_BATCH_INT4,			/* int4 and date */
+	EXEC_BATCH_INT8,
+	EXEC_BATCH_FLOAT8
+} ExecBatchType;
+
+typedef enum ExecBatchOp
+{
+	EXEC_BATCH_LT,
+	EXEC_BATCH_LE,
+	EXEC_BATCH_EQ,
+	EXEC_BATCH_NE,
+	EXEC_BATCH_GE,
+	EXEC_BATCH_GT
+} ExecBatchOp;
+
+/*
+ * A qual clause "column op constant" evaluated on whole batches.  Integer
+ * constants are widened to int64, so int4 columns compare against int8
+ * constants too.
+ */
+typedef struct ExecBatchPred
+{
+	int			column;			/* index into the batch's columns */
+	ExecBatchType type;			/* type of the column */
+	ExecBatchOp op;
+	int64		ival;			/* constant of an integer comparison */
+	float8		fval;			/* constant of a float8 comparison */
+} ExecBatchPred;
+
+/*
+ * ExecBatch - the rows of a sequential scan, a batch at a time
+ *
+ * The rows stay on their heap pages, which the batch keeps pinned, and the
+ * scan columns the quals and the consumer of the batch need are deformed
+ * into one array per column.  sel[] lists the rows that passed the quals
+ * evaluated so far.
+ */
+typedef struct ExecBatch
+{
+	MemoryContext mcxt;			/* holds the row arrays */
+
+	/* scan columns deformed into arrays */
+	int			ncolumns;
+	AttrNumber *attnums;		/* attribute number of each column */
+	AttrNumber	maxattr;		/* highest of them */
+	Datum	  **values;			/* values[column][row] */
+	bool	  **isnull;			/* isnull[column][row] */
+
+	/* qual clauses evaluated a batch at a time */
+	int			npreds;
+	ExecBatchPred *preds;
+
+	/* the current batch */
+	int			nrows;			/* rows fetched */
+	HeapTupleData *tuples;		/* the rows, pointing into their pages */
+	Buffer	   *buffers;		/* page of each row */
+	int			nsel;			/* rows that passed the quals */
+	int		   *sel;			/* their indexes, ascending */
+	int			next;			/* next sel[] entry to return as a row */
+	bool	   *match;			/* clause result of each row */
+	int			npins;
+	Buffer		pins[EXEC_BATCH_MAX_PAGES];		/* pages the rows are on */
+	bool		done;			/* scan has returned its last row */
+	TupleTableSlot *slot;		/* for deforming the rows */
+} ExecBatch;
+
+/* GUC parameter */
+extern bool batch_execution;
+
+extern ExecBatch *ExecInitBatch(EState *estate, TupleDesc tupdesc,
+			  Index scanrelid, List *qual, List **residual);
+extern int	ExecBatchColumn(ExecBatch *batch, AttrNumber attnum);
+extern bool ExecBatchAddRow(ExecBatch *batch, HeapTuple tuple, Buffer buffer);
+extern void ExecBatchQual(ExecBatch *batch);
+extern void ExecBatchReset(ExecBatch *batch);
+
+#endif   /* EXECBATCH_H */
@@ -65,6 +65,7 @@ typedef struct IndexInfo
 	uint16	   *ii_ExclusionStrats;		/* array with one entry per column */
 	bool		ii_Unique;
     bool        ii_Hypothetical;	/* flag for checking if an index is hypothetical or not */
+	bool		ii_Clustered;	/* hypothetical index declared clustered */
 	bool		ii_ReadyForInserts;
 	bool		ii_Concurrent;
 	bool		ii_BrokenHotChain;
@@ -961,6 +962,23 @@ typedef struct DomainConstraintState
 	ExprState  *check_expr;		/* for CHECK, a boolean expression */
 } DomainConstraintState;
 
+/* ----------------
+ *		ExprProgramState node
+ *
+ * An ExprState tree flattened into a linear program of steps, which
+ * ExecCompileExpr builds and ExecEvalExprProgram runs.  The steps are
+ * private to execQual.c.
+ * ----------------
+ */
+typedef struct ExprProgramState
+{
+	ExprState	xprstate;
+	struct ExprStep *steps;		/* the program, ending in a DONE step */
+	int			nsteps;
+	Datum		resvalue;		/* result of the program */
+	bool		resnull;
+} ExprProgramState;
+
 
 /* ----------------------------------------------------------------
  *				 Executor State Trees
@@ -1199,11 +1217,18 @@ typedef struct ScanState
 	TupleTableSlot *ss_ScanTupleSlot;
 } ScanState;
 
-/*
- * SeqScan uses a bare ScanState as its state node, since it needs
- * no additional fields.
+/* ----------------
+ *	 SeqScanState information
+ *
+ *		batch			rows fetched and qualified a batch at a time, or
+ *						NULL if the scan runs a row at a time
+ * ----------------
  */
-typedef ScanState SeqScanState;
+typedef struct SeqScanState
+{
+	ScanState	ss;				/* its first field is NodeTag */
+	struct ExecBatch *batch;
+} SeqScanState;
 
 /*
  * These structs store information about index quals that don't have simple
@@ -1684,6 +1709,7 @@ typedef struct GroupState
 /* these structs are private in nodeAgg.c: */
 typedef struct AggStatePerAggData *AggStatePerAgg;
 typedef struct AggStatePerGroupData *AggStatePerGroup;
+typedef struct AggHashSpillData *AggHashSpill;
 
 typedef struct AggState
 {
@@ -1705,6 +1731,17 @@ typedef struct AggState
 	List	   *hash_needed;	/* list of columns needed in hash table */
 	bool		table_filled;	/* hash table filled yet? */
 	TupleHashIterator hashiter; /* for iterating through hash table */
+	/* these fields are used when AGG_HASHED mode runs out of work_mem: */
+	AggHashSpill hash_spill;	/* batch files this pass writes, or NULL */
+	List	   *hash_batches;	/* batch files left to aggregate */
+	TupleTableSlot *hash_spill_slot;	/* slot for reading batch files */
+	int			hash_used_bits; /* hash bits that chose the current batch */
+	bool		hash_spilled;	/* table doesn't hold all groups? */
+	int			hash_batches_used;		/* batch files written, for EXPLAIN */
+	int64		hash_disk_used; /* bytes written to them, for EXPLAIN */
+	Size		hash_mem_peak;	/* peak hash table memory, for EXPLAIN */
+	/* this field is used in AGG_PLAIN mode over a batched SeqScan: */
+	bool		batch_agg;		/* advance aggs a whole batch at a time? */
 } AggState;
 
 /* ----------------
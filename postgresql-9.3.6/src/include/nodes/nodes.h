@@ -205,6 +205,7 @@ typedef enum NodeTag
 	T_NullTestState,
 	T_CoerceToDomainState,
 	T_DomainConstraintState,
+	T_ExprProgramState,
 
 	/*
 	 * TAGS FOR PLANNER NODES (relation.h)
@@ -1967,6 +1967,8 @@ typedef struct DropStmt
 	DropBehavior behavior;		/* RESTRICT or CASCADE behavior */
 	bool		missing_ok;		/* skip error if object is missing? */
 	bool		concurrent;		/* drop index concurrently? */
+	bool		hypothetical;	/* DROP HYPOTHETICAL INDEX?  With no
+								 * objects, DROP ALL HYPOTHETICAL INDEXES */
 } DropStmt;
 
 /* ----------------------
@@ -2097,6 +2099,8 @@ typedef struct IndexStmt
                                      * HYPOTHETICAL INDEX
                                      * SELF TUNING GROUP - PUC-RIO - 2015
                                      */
+	bool		temporary;		/* drop hypothetical index at session end? */
+	bool		oncommitdrop;	/* drop hypothetical index at xact end? */
 	char	   *idxcomment;		/* comment to apply to index, or NULL */
 	Oid			indexOid;		/* OID of an existing index, if any */
 	Oid			oldNode;		/* relfilenode of existing storage, if any */
@@ -497,6 +497,8 @@ typedef struct IndexOptInfo
 	BlockNumber pages;			/* number of disk pages in index */
 	double		tuples;			/* number of index tuples in index */
 	int			tree_height;	/* index tree height, or -1 if unknown */
+	double		allvisfrac;		/* all-visible fraction of the table's pages
+								 * for a hypothetical index's heap fetches */
 
 	/* index descriptor information */
 	int			ncolumns;		/* number of columns in index */
@@ -520,6 +522,7 @@ typedef struct IndexOptInfo
 	bool		unique;			/* true if a unique index */
 	bool		immediate;		/* is uniqueness enforced immediately? */
 	bool		hypothetical;	/* true if index doesn't really exist */
+	bool		clustered;		/* hypothetical index declared clustered */
 	bool		canreturn;		/* can index return IndexTuples? */
 	bool		amcanorderbyop; /* does AM support order by operator result? */
 	bool		amoptionalkey;	/* can query omit key for the first column? */
@@ -0,0 +1,194 @@
+/*-------------------------------------------------------------------------
+ *
+ * hypoindex.h
+ *	  prototypes for hypoindex.c.
+ *
+ * HYPOTHETICAL INDEX
+ * SELF TUNING GROUP - PUC-RIO - 2015
+ *
+ * Portions Copyright (c) 1996-2013, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/optimizer/hypoindex.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef HYPOINDEX_H
+#define HYPOINDEX_H
+
+#include "nodes/execnodes.h"
+#include "nodes/parsenodes.h"
+#include "nodes/plannodes.h"
+#include "nodes/primnodes.h"
+#include "nodes/relation.h"
+#include "storage/block.h"
+#include "utils/guc.h"
+#include "utils/relcache.h"
+
+/*
+ * A session-private hypothetical index.
+ *
+ * These live only in backend memory: CREATE HYPOTHETICAL INDEX with
+ * hypothetical_index_private turned on stores one of these instead of
+ * writing pg_class/pg_index rows, and get_relation_info() turns it into an
+ * IndexOptInfo when planning EXPLAIN HYPOTHETICAL.  Expressions and the
+ * predicate use varno 1, as in the relcache.
+ */
+typedef struct HypoIndex
+{
+	Oid			oid;			/* fake OID, never present in pg_class */
+	char	   *name;			/* index name, unique within the session */
+	Oid			relid;			/* OID of the indexed table */
+	Oid			relam;			/* OID of the access method */
+	Oid			reltablespace;	/* tablespace it would be created in */
+	int			ncolumns;		/* number of index columns */
+	int		   *indexkeys;		/* table column numbers, 0 for expressions */
+	Oid		   *keytypes;		/* table column types, to detect ALTERs */
+	Oid		   *indexcollations;	/* OIDs of collations of index columns */
+	Oid		   *opfamily;		/* OIDs of operator families for columns */
+	Oid		   *opcintype;		/* OIDs of opclass declared input types */
+	int16	   *indoption;		/* per-column INDOPTION_* flags */
+	List	   *indexprs;		/* expressions for non-simple index columns */
+	List	   *indpred;		/* implicit-AND predicate, or NIL */
+	bool		unique;			/* declared UNIQUE? */
+	bool		clustered;		/* declared WITH (clustered)? */
+	Datum		reloptions;		/* validated WITH (...) options, or 0 */
+	int			fillfactor;		/* fillfactor it would be built with */
+
+	/* copied from pg_am so planning needs no catalog access */
+	RegProcedure amcostestimate;
+	bool		amcanorder;
+	bool		amcanorderbyop;
+	bool		amoptionalkey;
+	bool		amsearcharray;
+	bool		amsearchnulls;
+	bool		amhasgettuple;
+	bool		amhasgetbitmap;
+	bool		canreturn;
+} HypoIndex;
+
+/*
+ * Estimated cost to a data modifying statement of maintaining one
+ * hypothetical index, see hypo_index_write_cost().
+ */
+typedef struct HypoIndexWriteCost
+{
+	double		entries;		/* index entries inserted */
+	double		pages;			/* index pages dirtied */
+	double		wal_bytes;		/* WAL generated */
+	double		lost_hot;		/* updates that could no longer be HOT */
+} HypoIndexWriteCost;
+
+/*
+ * The order of a table's rows by the leading plain columns of a btree
+ * index, see hypo_index_key_order() and hypo_index_key_stats().
+ */
+typedef struct HypoKeyOrder
+{
+	int			nkeys;
+	AttrNumber	attnums[INDEX_MAX_KEYS];
+	Oid			sortops[INDEX_MAX_KEYS];	/* "<" or ">" operators */
+	Oid			collations[INDEX_MAX_KEYS];
+	bool		nulls_first[INDEX_MAX_KEYS];
+} HypoKeyOrder;
+
+/*
+ * Per access method model of hypothetical indexes.  estimate_size works as
+ * hypo_index_estimate_size(), with *tree_height preset to -1.  get_stats
+ * fills in the statistics the access method's amcostestimate would read
+ * from the index itself; what stats points to is up to the access method.
+ */
+typedef void (*HypoAmEstimateSize) (Relation heapRelation, Oid relam,
+								int ncolumns, const int *indexkeys,
+								List *indexprs, int fillfactor,
+								double tuples, BlockNumber *pages,
+								int *tree_height);
+typedef void (*HypoAmGetStats) (Relation heapRelation, Oid relam,
+								int ncolumns, const int *indexkeys,
+								List *indexprs, double tuples,
+								void *stats);
+
+typedef struct HypoAmModel
+{
+	Oid			relam;			/* OID of the access method */
+	HypoAmEstimateSize estimate_size;
+	HypoAmGetStats get_stats;
+} HypoAmModel;
+
+/* GUC parameters */
+extern bool hypothetical_index_private;
+extern char *hypothetical_disabled_indexes;
+
+extern Oid hypo_index_store(Relation heapRelation,
+				 const char *indexRelationName,
+				 bool name_given,
+				 IndexInfo *indexInfo,
+				 Oid accessMethodId,
+				 Oid tableSpaceId,
+				 Oid *collationObjectId,
+				 Oid *classObjectId,
+				 int16 *coloptions,
+				 Datum reloptions);
+extern bool hypo_index_remove(const char *schemaname, const char *indexname);
+extern bool hypo_index_remove_oid(Oid indexoid);
+extern int	hypo_index_remove_all(void);
+extern void hypo_index_drop_at_eoxact(Oid indexoid);
+extern void hypo_index_set_visible(List *indexoids);
+extern void hypo_index_reset_visible(void);
+extern bool hypo_index_is_disabled(Oid indexoid);
+extern void hypo_index_invalidate_disabled(void);
+extern bool check_hypothetical_disabled_indexes(char **newval, void **extra,
+									GucSource source);
+extern void assign_hypothetical_disabled_indexes(const char *newval,
+									 void *extra);
+extern HypoIndex *hypo_index_lookup(const char *schemaname,
+				  const char *indexname);
+extern HypoIndex *hypo_index_find(Oid indexoid);
+extern List *hypo_index_list_for_relation(Relation heapRelation);
+extern int	hypo_index_fillfactor(Oid relam, bytea *options);
+extern bool hypo_index_can_return(Oid relam, Oid opfamily, Oid opcintype,
+					  Oid atttype, Oid collation);
+extern double hypo_index_allvisfrac(Relation heapRelation);
+extern void hypo_index_register_am(Oid relam,
+					   HypoAmEstimateSize estimate_size,
+					   HypoAmGetStats get_stats);
+extern void hypo_index_estimate_size(Relation heapRelation, Oid relam,
+						 int ncolumns, const int *indexkeys, List *indexprs,
+						 int fillfactor, double tuples,
+						 BlockNumber *pages, int *tree_height);
+extern bool hypo_index_get_stats(Relation heapRelation, Oid relam,
+					 int ncolumns, const int *indexkeys, List *indexprs,
+					 double tuples, void *stats);
+extern double hypo_index_predicate_tuples(Relation heapRelation,
+							List *indpred, double tuples);
+extern int	hypo_index_key_order(IndexOptInfo *index, HypoKeyOrder *order);
+extern bool hypo_index_key_stats(Relation heapRelation,
+					 const HypoKeyOrder *key, const HypoKeyOrder *physical,
+					 double tuples, double *ndistinct, double *correlation);
+extern Bitmapset *hypo_index_attrs(Bitmapset *attrs, int ncolumns,
+				 const int *indexkeys, List *indexprs, List *indpred);
+extern void hypo_index_write_cost(Relation heapRelation, Oid relam,
+					  int ncolumns, const int *indexkeys, List *indexprs,
+					  List *indpred, int fillfactor, CmdType operation,
+					  double rows, Bitmapset *modifiedCols,
+					  Bitmapset *hypoattrs, HypoIndexWriteCost *cost);
+extern Size HypoIndexShmemSize(void);
+extern void HypoIndexShmemInit(void);
+extern uint64 hypo_index_generation(void);
+extern void hypo_index_catalog_changed(void);
+extern void AtEOXact_HypoIndex(bool isCommit);
+extern void AtEOSubXact_HypoIndex(bool isCommit);
+extern void AtPrepare_HypoIndex(void);
+
+/* in hypoplancache.c */
+extern int	hypothetical_plan_cache_size;
+
+extern char *hypo_query_fingerprint(Query *parse, bool ignore_consts);
+extern char *hypo_plan_cache_key(Query *parse, int cursorOptions,
+					Oid **relids, int *nrelids);
+extern PlannedStmt *hypo_plan_cache_lookup(const char *key);
+extern void hypo_plan_cache_store(const char *key, Oid *relids, int nrelids,
+					  PlannedStmt *plan);
+extern void hypo_plan_cache_reset(void);
+
+#endif   /* HYPOINDEX_H */
@@ -0,0 +1,68 @@
+/*-------------------------------------------------------------------------
+ *
+ * hypotiming.h
+ *	  prototypes for hypotiming.c.
+ *
+ * HYPOTHETICAL INDEX
+ * SELF TUNING GROUP - PUC-RIO - 2015
+ *
+ * Portions Copyright (c) 1996-2013, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/optimizer/hypotiming.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef HYPOTIMING_H
+#define HYPOTIMING_H
+
+/* the parts of planning timed separately */
+typedef enum HypoPlannerPhase
+{
+	HYPO_PHASE_OTHER,			/* anything not listed below */
+	HYPO_PHASE_CATALOG,			/* get_relation_info() */
+	HYPO_PHASE_SELECTIVITY,		/* clause_selectivity() */
+	HYPO_PHASE_PATHS,			/* base relation sizes and paths */
+	HYPO_PHASE_JOIN_SEARCH,		/* make_rel_from_joinlist() */
+	HYPO_PHASE_SETREFS,			/* set_plan_references() */
+	HYPO_NUM_PHASES
+} HypoPlannerPhase;
+
+/* kinds of planning counted separately in the cumulative times */
+#define HYPO_TIMING_REGULAR			0
+#define HYPO_TIMING_HYPOTHETICAL	1
+#define HYPO_TIMING_KINDS			2
+
+/*
+ * Time spent planning, in milliseconds: of one planning for EXPLAIN
+ * (SUMMARY), or summed over many for the cumulative view.  Each phase only
+ * counts the time not spent in a phase nested inside it.
+ */
+typedef struct HypoPlannerTimes
+{
+	int64		plannings;		/* plannings timed */
+	int64		cached;			/* of which the plan cache answered */
+	double		total_ms;
+	double		phase_ms[HYPO_NUM_PHASES];
+} HypoPlannerTimes;
+
+/* GUC parameter */
+extern bool hypothetical_planner_timing;
+
+extern const char *const hypo_phase_names[HYPO_NUM_PHASES];
+
+extern Size HypoTimingShmemSize(void);
+extern void HypoTimingShmemInit(void);
+
+extern void hypo_timing_request(void);
+extern bool hypo_timing_start(void);
+extern void hypo_timing_enter(HypoPlannerPhase phase);
+extern void hypo_timing_exit(void);
+extern void hypo_timing_cached(void);
+extern void hypo_timing_finish(bool hypothetical);
+extern void hypo_timing_abort(void);
+extern void hypo_timing_last(HypoPlannerTimes *times);
+extern void hypo_timing_snapshot(HypoPlannerTimes *times);
+extern void hypo_timing_reset(void);
+
+#endif   /* HYPOTIMING_H */
@@ -0,0 +1,64 @@
+/*-------------------------------------------------------------------------
+ *
+ * hypoworkload.h
+ *	  prototypes for hypoworkload.c.
+ *
+ * HYPOTHETICAL INDEX
+ * SELF TUNING GROUP - PUC-RIO - 2015
+ *
+ * Portions Copyright (c) 1996-2013, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/optimizer/hypoworkload.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef HYPOWORKLOAD_H
+#define HYPOWORKLOAD_H
+
+#include "nodes/relation.h"
+
+/* most columns remembered per statement */
+#define HYPO_WORKLOAD_MAX_COLUMNS	32
+
+/* how a captured column was used */
+#define HYPO_CLAUSE_EQUALITY		'e'		/* restricted with = or IN */
+#define HYPO_CLAUSE_RESTRICTION		'r'		/* any other restriction */
+#define HYPO_CLAUSE_JOIN			'j'		/* join clause */
+
+typedef struct HypoWorkloadColumn
+{
+	Oid			relid;			/* table */
+	AttrNumber	attnum;			/* column */
+	char		kind;			/* HYPO_CLAUSE_* */
+} HypoWorkloadColumn;
+
+/* Identifies a captured statement; the ring is shared by all databases */
+typedef struct HypoWorkloadKey
+{
+	Oid			dbid;			/* database the statement was planned in */
+	uint32		queryid;		/* fingerprint, see standard_planner() */
+} HypoWorkloadKey;
+
+/* A captured statement, as returned by hypo_workload_snapshot() */
+typedef struct HypoWorkloadStatement
+{
+	HypoWorkloadKey key;		/* hash key of the statement */
+	int64		calls;			/* executions since captured */
+	int			ncolumns;
+	HypoWorkloadColumn columns[HYPO_WORKLOAD_MAX_COLUMNS];
+} HypoWorkloadStatement;
+
+/* GUC parameter */
+extern int	hypothetical_workload_entries;
+
+extern Size HypoWorkloadShmemSize(void);
+extern void HypoWorkloadShmemInit(void);
+
+extern uint32 hypo_workload_query_id(Query *query);
+extern void hypo_workload_capture(PlannerInfo *root, uint32 queryid);
+extern void hypo_workload_count(uint32 queryid);
+extern HypoWorkloadStatement *hypo_workload_snapshot(int *nstatements);
+extern void hypo_workload_reset(void);
+
+#endif   /* HYPOWORKLOAD_H */
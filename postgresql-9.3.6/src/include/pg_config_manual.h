@@ -199,6 +199,15 @@
 #define USE_PPC_LWSYNC
 #endif
 
+/*
+ * Define this to let text sorts abbreviate their keys with strxfrm() under
+ * collations other than C.  That's only correct if strxfrm() orders strings
+ * exactly as strcoll() does, which some C libraries are known not to do for
+ * some locales, so it is off by default; text sorts under the C collation
+ * abbreviate their keys either way.
+ */
+/* #define TRUST_STRXFRM */
+
 /*
  *------------------------------------------------------------------------
  * The following symbols are for enabling debugging code, not for
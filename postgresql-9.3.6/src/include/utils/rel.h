@@ -102,6 +102,12 @@ typedef struct RelationData
 	TupleDesc	rd_att;			/* tuple descriptor */
 	Oid			rd_id;			/* relation's object id */
 	List	   *rd_indexlist;	/* list of OIDs of indexes on relation */
+	List	   *rd_hypindexlist;	/* same, including hypothetical indexes
+									 * (valid under the same rd_indexvalid) */
+	bool		rd_hashypothetical; /* rd_hypindexlist has hypothetical
+									 * entries that rd_indexlist lacks */
+	uint64		rd_hypgeneration;	/* hypo_index_generation() when
+									 * rd_hypindexlist was computed */
 	Bitmapset  *rd_indexattr;	/* identifies columns used in indexes */
 	Bitmapset  *rd_keyattr;		/* cols that can be ref'd by foreign keys */
 	Oid			rd_oidindex;	/* OID of unique index on OID, if any */
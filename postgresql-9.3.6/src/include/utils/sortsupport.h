@@ -31,6 +31,14 @@
  * data can be stored using the ssup_extra field.  Any such data
  * should be allocated in the ssup_cxt memory context.
  *
+ * A sort that keeps its leading key in a Datum of its own, as tuplesort.c
+ * does, may ask for "abbreviated keys" by setting the abbreviate field
+ * before calling the BTSORTSUPPORT function.  An opclass that supports them
+ * then supplies a converter that packs a prefix of each value into a
+ * pass-by-value Datum, chosen so that most comparisons of two such
+ * abbreviations decide the order on their own and cost next to nothing;
+ * only abbreviations that compare equal need the authoritative comparator.
+ *
  * Note: since pg_amproc functions are indexed by (lefttype, righttype)
  * it is possible to associate a BTSORTSUPPORT function with a cross-type
  * comparison.  This could sensibly be used to provide a fast comparator
@@ -48,6 +56,7 @@
 #define SORTSUPPORT_H
 
 #include "access/attnum.h"
+#include "utils/relcache.h"
 
 typedef struct SortSupportData *SortSupport;
 
@@ -74,6 +83,12 @@ typedef struct SortSupportData
 	 */
 	AttrNumber	ssup_attno;		/* column number to sort */
 
+	/*
+	 * Set by the caller before calling the BTSORTSUPPORT function if it can
+	 * use abbreviated keys; see below.
+	 */
+	bool		abbreviate;
+
 	/*
 	 * ssup_extra is zeroed before calling the BTSORTSUPPORT function, and is
 	 * not touched subsequently by callers.
@@ -96,8 +111,26 @@ typedef struct SortSupportData
 	int			(*comparator) (Datum x, Datum y, SortSupport ssup);
 
 	/*
-	 * Additional sort-acceleration functions might be added here later.
+	 * Abbreviated key support.  The BTSORTSUPPORT function only sets these
+	 * when abbreviate is true, and then only if it has something to offer.
+	 *
+	 * abbrev_converter turns an original, non-null value into its
+	 * abbreviation.  Once it is set, comparator compares abbreviations, and
+	 * abbrev_full_comparator is the authoritative comparator of original
+	 * values, which the caller must consult whenever comparator returns 0.
+	 *
+	 * abbrev_abort, which may be NULL, is called now and then while the
+	 * caller is still converting values, with the number converted so far;
+	 * if it returns true, the abbreviations aren't telling enough values
+	 * apart to be worth it.  The caller then puts abbrev_full_comparator
+	 * back in comparator, sets abbrev_converter to NULL and goes on with
+	 * original values only.  The caller may also do that at any time on its
+	 * own, for instance when it has to write values out without their
+	 * abbreviations.
 	 */
+	Datum		(*abbrev_converter) (Datum original, SortSupport ssup);
+	bool		(*abbrev_abort) (int memtupcount, SortSupport ssup);
+	int			(*abbrev_full_comparator) (Datum x, Datum y, SortSupport ssup);
 } SortSupportData;
 
 
@@ -109,6 +142,9 @@ typedef struct SortSupportData
 extern int ApplySortComparator(Datum datum1, bool isNull1,
 					Datum datum2, bool isNull2,
 					SortSupport ssup);
+extern int ApplySortAbbrevFullComparator(Datum datum1, bool isNull1,
+							  Datum datum2, bool isNull2,
+							  SortSupport ssup);
 #endif   /* !PG_USE_INLINE */
 #if defined(PG_USE_INLINE) || defined(SORTSUPPORT_INCLUDE_DEFINITIONS)
 /*
@@ -147,10 +183,49 @@ ApplySortComparator(Datum datum1, bool isNull1,
 
 	return compare;
 }
+
+/*
+ * Like ApplySortComparator, but compare original values with the
+ * authoritative comparator while abbreviated keys are in use.
+ */
+STATIC_IF_INLINE int
+ApplySortAbbrevFullComparator(Datum datum1, bool isNull1,
+							  Datum datum2, bool isNull2,
+							  SortSupport ssup)
+{
+	int			compare;
+
+	if (isNull1)
+	{
+		if (isNull2)
+			compare = 0;		/* NULL "=" NULL */
+		else if (ssup->ssup_nulls_first)
+			compare = -1;		/* NULL "<" NOT_NULL */
+		else
+			compare = 1;		/* NULL ">" NOT_NULL */
+	}
+	else if (isNull2)
+	{
+		if (ssup->ssup_nulls_first)
+			compare = 1;		/* NOT_NULL ">" NULL */
+		else
+			compare = -1;		/* NOT_NULL "<" NULL */
+	}
+	else
+	{
+		compare = (*ssup->abbrev_full_comparator) (datum1, datum2, ssup);
+		if (ssup->ssup_reverse)
+			compare = -compare;
+	}
+
+	return compare;
+}
 #endif   /*-- PG_USE_INLINE || SORTSUPPORT_INCLUDE_DEFINITIONS */
 
 /* Other functions in utils/sort/sortsupport.c */
 extern void PrepareSortSupportComparisonShim(Oid cmpFunc, SortSupport ssup);
 extern void PrepareSortSupportFromOrderingOp(Oid orderingOp, SortSupport ssup);
+extern void PrepareSortSupportFromIndexRel(Relation indexRel, int16 strategy,
+							   SortSupport ssup);
 
 #endif   /* SORTSUPPORT_H */
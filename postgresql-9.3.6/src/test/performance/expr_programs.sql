@@ -0,0 +1,98 @@
+--
+-- expr_programs.sql
+--	Compare expression programs with recursive expression evaluation on
+--	TPC-H-style queries.
+--
+-- Generates a lineitem table of TPC-H scale factor :sf in schema
+-- expr_bench, then runs each query :reps times with compile_expressions
+-- off (ExprState trees) and on (linear programs).  It reports the average
+-- time of each query and the ratio between the two.
+--
+-- Run it with "make -C src/test/performance expr-bench", or directly:
+--	psql -X -v sf=1 -v reps=5 -f expr_programs.sql dbname
+--
+\set ON_ERROR_STOP 1
+\timing off
+
+SET client_min_messages = warning;
+DROP SCHEMA IF EXISTS expr_bench CASCADE;
+CREATE SCHEMA expr_bench;
+SET search_path = expr_bench;
+SELECT setseed(0.42);
+
+--
+-- Data: about four lineitems per order, 1.5 million orders per scale factor
+--
+CREATE UNLOGGED TABLE lineitem AS
+	SELECT o AS l_orderkey,
+		   n AS l_linenumber,
+		   1 + (random() * 49)::int AS l_quantity,
+		   (900 + random() * 104000)::float8 AS l_extendedprice,
+		   round((random() * 10)::numeric) / 100 AS l_discount,
+		   round((random() * 8)::numeric) / 100 AS l_tax,
+		   (ARRAY['A', 'N', 'R'])[1 + (random() * 2)::int] AS l_returnflag,
+		   (ARRAY['F', 'O'])[1 + (random())::int] AS l_linestatus,
+		   date '1992-01-01' + (random() * 2500)::int AS l_shipdate
+	FROM generate_series(1, (1500000 * :sf)::int) o,
+		 generate_series(1, 1 + o % 7) n;
+ANALYZE lineitem;
+
+CREATE TABLE bench_query (id int, sql text);
+INSERT INTO bench_query VALUES
+-- Q1: pricing summary report
+(1, 'SELECT l_returnflag, l_linestatus, sum(l_quantity), sum(l_extendedprice),
+		sum(l_extendedprice * (1 - l_discount::float8)),
+		sum(l_extendedprice * (1 - l_discount::float8) * (1 + l_tax::float8)),
+		avg(l_quantity), avg(l_extendedprice), count(*)
+	FROM lineitem WHERE l_shipdate <= date ''1998-12-01'' - 90
+	GROUP BY l_returnflag, l_linestatus ORDER BY 1, 2'),
+-- Q6: forecasting revenue change
+(6, 'SELECT sum(l_extendedprice * l_discount::float8) FROM lineitem
+	WHERE l_shipdate >= date ''1994-01-01'' AND l_shipdate < date ''1995-01-01''
+	  AND l_discount BETWEEN 0.05 AND 0.07 AND l_quantity < 24'),
+-- boolean logic, null tests and a projection over every row
+(100, 'SELECT count(*) FROM (SELECT l_orderkey + l_linenumber AS k,
+		l_quantity * 2 AS q FROM lineitem
+	WHERE (l_returnflag = ''R'' OR l_linestatus = ''F'' OR l_quantity > 40)
+	  AND NOT (l_tax IS NULL) AND l_orderkey % 3 <> 1 OFFSET 0) s');
+
+CREATE TABLE bench_result (id int, compiled bool, ms float8);
+
+--
+-- Run query id reps times and return the average time per run
+--
+CREATE FUNCTION bench_run(id int, compiled bool, reps int) RETURNS float8
+LANGUAGE plpgsql AS $$
+DECLARE
+	cmd			text;
+	started		timestamptz;
+BEGIN
+	SELECT sql INTO cmd FROM bench_query q WHERE q.id = bench_run.id;
+	PERFORM set_config('compile_expressions', compiled::text, true);
+	EXECUTE cmd;				-- warm the cache
+	started := clock_timestamp();
+	FOR i IN 1 .. reps LOOP
+		EXECUTE cmd;
+	END LOOP;
+	RETURN extract(epoch FROM clock_timestamp() - started) * 1000 / reps;
+END;
+$$;
+
+INSERT INTO bench_result
+	SELECT q.id, c, bench_run(q.id, c, :reps)
+	FROM bench_query q, unnest(ARRAY[false, true]) c
+	ORDER BY q.id, c;
+
+--
+-- Report
+--
+\echo
+\echo 'Queries'
+SELECT pg_size_pretty(pg_relation_size('lineitem')) AS data,
+	   t.id AS query,
+	   round(t.ms::numeric, 1) AS tree_ms,
+	   round(p.ms::numeric, 1) AS program_ms,
+	   round((t.ms / p.ms)::numeric, 2) AS speedup
+FROM bench_result t JOIN bench_result p ON p.id = t.id
+WHERE NOT t.compiled AND p.compiled
+ORDER BY t.id;
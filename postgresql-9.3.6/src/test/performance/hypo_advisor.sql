@@ -0,0 +1,7 @@
+\setrandom aid 1 100000
+\setrandom n 1 1000000000
+BEGIN;
+CREATE HYPOTHETICAL INDEX hypo_adv_:n ON pgbench_accounts (abalance, bid);
+EXPLAIN HYPOTHETICAL SELECT * FROM pgbench_accounts WHERE abalance = :aid AND bid = 1;
+DROP HYPOTHETICAL INDEX hypo_adv_:n;
+COMMIT;
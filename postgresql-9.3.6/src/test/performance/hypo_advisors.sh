@@ -0,0 +1,48 @@
+#!/bin/sh
+#
+# hypo_advisors.sh
+#	Measure pgbench TPS with and without concurrent index advisors.
+#
+# HYPOTHETICAL INDEX
+# SELF TUNING GROUP - PUC-RIO - 2015
+#
+# Runs the standard TPC-B-like pgbench workload twice against the same
+# tables: once alone and once while ADVISORS sessions loop over
+# hypo_advisor.sql, creating, planning with and dropping catalog
+# hypothetical indexes on pgbench_accounts.  Neither kind of DDL locks the
+# table against DML or other advisors, so the two TPS figures should only
+# differ by the CPU the advisors take.
+#
+# Usage: hypo_advisors.sh [dbname]
+# Environment: SCALE (10), CLIENTS (8), ADVISORS (32), DURATION (60)
+#
+
+DBNAME=${1:-hypo_bench}
+SCALE=${SCALE:-10}
+CLIENTS=${CLIENTS:-8}
+ADVISORS=${ADVISORS:-32}
+DURATION=${DURATION:-60}
+DIR=`dirname $0`
+
+tps()
+{
+	sed -n 's/^tps = \([0-9.]*\) (excluding.*/\1/p'
+}
+
+createdb $DBNAME 2>/dev/null
+pgbench -i -q -s $SCALE $DBNAME || exit 1
+
+BASE=`pgbench -n -c $CLIENTS -j $CLIENTS -T $DURATION $DBNAME | tps`
+
+pgbench -n -f $DIR/hypo_advisor.sql -c $ADVISORS -j $ADVISORS \
+	-T `expr $DURATION + 10` $DBNAME > /tmp/hypo_advisors.$$ 2>&1 &
+ADVPID=$!
+sleep 5
+LOADED=`pgbench -n -c $CLIENTS -j $CLIENTS -T $DURATION $DBNAME | tps`
+wait $ADVPID
+ADVTPS=`tps < /tmp/hypo_advisors.$$`
+rm -f /tmp/hypo_advisors.$$
+
+echo "production tps alone:         $BASE"
+echo "production tps with advisors: $LOADED"
+echo "advisor tps ($ADVISORS sessions):  $ADVTPS"
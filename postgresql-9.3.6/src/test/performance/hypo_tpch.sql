@@ -0,0 +1,271 @@
+--
+-- hypo_tpch.sql
+--	Compare hypothetical indexes with the real ones on a TPC-H-shaped
+--	dataset.
+--
+-- HYPOTHETICAL INDEX
+-- SELF TUNING GROUP - PUC-RIO - 2015
+--
+-- Generates the eight TPC-H tables at scale factor :sf in schema hypo_tpch,
+-- then for every candidate index plans each query that reads its table
+-- three times: without the index, with the index created hypothetically
+-- and with the index really built.  It reports
+--
+--	- plan agreement: whether the hypothetical plan uses the candidate
+--	  exactly when the real plan does, and has the same node types,
+--	- size-estimate error: pg_hypothetical_index_size() against
+--	  pg_relation_size() of the built index,
+--	- cost error: total cost of the hypothetical plan against the real one,
+--	- planning latency of EXPLAIN HYPOTHETICAL against plain EXPLAIN, each
+--	  averaged over :reps runs with the hypothetical plan cache off.
+--
+-- Run it with "make -C src/test/performance hypo-bench", or directly:
+--	psql -X -v sf=0.1 -v reps=20 -f hypo_tpch.sql dbname
+--
+\set ON_ERROR_STOP 1
+\timing off
+
+SET client_min_messages = warning;
+DROP SCHEMA IF EXISTS hypo_tpch CASCADE;
+CREATE SCHEMA hypo_tpch;
+SET search_path = hypo_tpch;
+SET hypothetical_index_private = off;
+SET hypothetical_plan_cache_size = 0;
+SELECT setseed(0.42);
+
+--
+-- Data, sized like TPC-H's dbgen at the same scale factor
+--
+CREATE TABLE region AS
+	SELECT i AS r_regionkey,
+		   (ARRAY['AFRICA', 'AMERICA', 'ASIA', 'EUROPE', 'MIDDLE EAST'])[i + 1] AS r_name
+	FROM generate_series(0, 4) i;
+
+CREATE TABLE nation AS
+	SELECT i AS n_nationkey, 'NATION ' || i AS n_name, i % 5 AS n_regionkey
+	FROM generate_series(0, 24) i;
+
+CREATE TABLE supplier AS
+	SELECT i AS s_suppkey,
+		   'Supplier#' || lpad(i::text, 9, '0') AS s_name,
+		   (random() * 24)::int AS s_nationkey,
+		   round((random() * 10999 - 999)::numeric, 2) AS s_acctbal
+	FROM generate_series(1, greatest((10000 * :sf)::int, 1)) i;
+
+CREATE TABLE customer AS
+	SELECT i AS c_custkey,
+		   'Customer#' || lpad(i::text, 9, '0') AS c_name,
+		   (random() * 24)::int AS c_nationkey,
+		   round((random() * 10999 - 999)::numeric, 2) AS c_acctbal,
+		   (ARRAY['AUTOMOBILE', 'BUILDING', 'FURNITURE', 'HOUSEHOLD',
+				  'MACHINERY'])[1 + (random() * 4)::int] AS c_mktsegment
+	FROM generate_series(1, greatest((150000 * :sf)::int, 1)) i;
+
+CREATE TABLE part AS
+	SELECT i AS p_partkey,
+		   md5(i::text) AS p_name,
+		   'Brand#' || (1 + (random() * 4)::int) || (1 + (random() * 4)::int) AS p_brand,
+		   (ARRAY['SM', 'MED', 'LG', 'JUMBO', 'WRAP'])[1 + (random() * 4)::int] || ' ' ||
+		   (ARRAY['CASE', 'BOX', 'BAG', 'JAR', 'PKG', 'PACK', 'CAN', 'DRUM'])[1 + (random() * 7)::int] AS p_container,
+		   1 + (random() * 49)::int AS p_size,
+		   round((900 + i % 1000 + random() * 100)::numeric, 2) AS p_retailprice
+	FROM generate_series(1, greatest((200000 * :sf)::int, 1)) i;
+
+CREATE TABLE partsupp AS
+	SELECT p_partkey AS ps_partkey,
+		   1 + (p_partkey + j * 2500) % greatest((10000 * :sf)::int, 1) AS ps_suppkey,
+		   1 + (random() * 9998)::int AS ps_availqty,
+		   round((1 + random() * 999)::numeric, 2) AS ps_supplycost
+	FROM part, generate_series(0, 3) j;
+
+CREATE TABLE orders AS
+	SELECT i AS o_orderkey,
+		   1 + (random() * (greatest((150000 * :sf)::int, 1) - 1))::int AS o_custkey,
+		   (ARRAY['F', 'O', 'P'])[1 + (random() * 2)::int] AS o_orderstatus,
+		   round((1000 + random() * 400000)::numeric, 2) AS o_totalprice,
+		   date '1992-01-01' + (random() * 2405)::int AS o_orderdate,
+		   (ARRAY['1-URGENT', '2-HIGH', '3-MEDIUM', '4-NOT SPECIFIED',
+				  '5-LOW'])[1 + (random() * 4)::int] AS o_orderpriority
+	FROM generate_series(1, greatest((1500000 * :sf)::int, 1)) i;
+
+CREATE TABLE lineitem AS
+	SELECT o_orderkey AS l_orderkey,
+		   n AS l_linenumber,
+		   1 + (random() * (greatest((200000 * :sf)::int, 1) - 1))::int AS l_partkey,
+		   1 + (random() * (greatest((10000 * :sf)::int, 1) - 1))::int AS l_suppkey,
+		   1 + (random() * 49)::int AS l_quantity,
+		   round((900 + random() * 104000)::numeric, 2) AS l_extendedprice,
+		   round((random() * 0.10)::numeric, 2) AS l_discount,
+		   round((random() * 0.08)::numeric, 2) AS l_tax,
+		   (ARRAY['A', 'N', 'R'])[1 + (random() * 2)::int] AS l_returnflag,
+		   o_orderdate + 1 + (random() * 120)::int AS l_shipdate,
+		   (ARRAY['AIR', 'FOB', 'MAIL', 'RAIL', 'REG AIR', 'SHIP',
+				  'TRUCK'])[1 + (random() * 6)::int] AS l_shipmode,
+		   md5(random()::text) AS l_comment
+	FROM orders, LATERAL generate_series(1, 1 + (o_orderkey * 7919) % 7) n;
+
+ANALYZE;
+
+--
+-- Workload: the tables each query reads, so a candidate is only compared
+-- on the queries it could matter to
+--
+CREATE TABLE bench_query (id int, tabs text[], sql text);
+INSERT INTO bench_query VALUES
+(1, '{lineitem}',
+ 'SELECT sum(l_extendedprice * l_discount) FROM lineitem WHERE l_shipdate >= date ''1994-01-01'' AND l_shipdate < date ''1994-01-08'' AND l_discount BETWEEN 0.05 AND 0.07 AND l_quantity < 24'),
+(2, '{lineitem}',
+ 'SELECT count(*) FROM lineitem WHERE l_partkey = 777'),
+(3, '{lineitem}',
+ 'SELECT l_orderkey, l_linenumber FROM lineitem WHERE l_orderkey BETWEEN 1000 AND 1100'),
+(4, '{orders,lineitem}',
+ 'SELECT o_orderdate, sum(l_extendedprice) FROM orders JOIN lineitem ON l_orderkey = o_orderkey WHERE o_custkey = 42 GROUP BY o_orderdate'),
+(5, '{orders}',
+ 'SELECT * FROM orders WHERE o_custkey = 1234'),
+(6, '{orders}',
+ 'SELECT o_orderkey, o_totalprice FROM orders WHERE o_orderdate = date ''1996-06-01'' ORDER BY o_totalprice DESC LIMIT 10'),
+(7, '{customer}',
+ 'SELECT c_name, c_acctbal FROM customer WHERE c_nationkey = 7 AND c_acctbal > 9900'),
+(8, '{part}',
+ 'SELECT p_partkey, p_name FROM part WHERE p_brand = ''Brand#23'' AND p_container = ''MED BOX'' AND p_size = 10'),
+(9, '{partsupp}',
+ 'SELECT ps_suppkey, ps_supplycost FROM partsupp WHERE ps_partkey = 4242 ORDER BY ps_supplycost'),
+(10, '{part,partsupp,supplier}',
+ 'SELECT s_name, ps_supplycost FROM part JOIN partsupp ON ps_partkey = p_partkey JOIN supplier ON s_suppkey = ps_suppkey WHERE p_partkey BETWEEN 100 AND 120');
+
+CREATE TABLE bench_candidate (id int, tab text, cols text);
+INSERT INTO bench_candidate VALUES
+(1, 'lineitem', 'l_shipdate'),
+(2, 'lineitem', 'l_shipdate, l_discount, l_quantity'),
+(3, 'lineitem', 'l_partkey'),
+(4, 'lineitem', 'l_orderkey, l_linenumber'),
+(5, 'orders', 'o_custkey'),
+(6, 'orders', 'o_orderdate, o_totalprice'),
+(7, 'customer', 'c_nationkey, c_acctbal'),
+(8, 'part', 'p_brand, p_container'),
+(9, 'part', 'p_partkey'),
+(10, 'partsupp', 'ps_partkey, ps_supplycost'),
+(11, 'supplier', 's_suppkey');
+
+CREATE TABLE bench_size (candidate int, est_bytes bigint, real_bytes bigint);
+CREATE TABLE bench_tmp (query int, base_plan text, base_ms float8,
+						hypo_plan text, hypo_ms float8);
+CREATE TABLE bench_plan (candidate int, query int,
+						 base_ms float8, hypo_ms float8, real_ms float8,
+						 hypo_uses bool, real_uses bool,
+						 hypo_shape text, real_shape text,
+						 hypo_cost float8, real_cost float8);
+
+--
+-- Plan sql reps times with EXPLAIN (FORMAT JSON), HYPOTHETICAL if asked,
+-- and return the plan and the average time per EXPLAIN
+--
+CREATE FUNCTION bench_explain(sql text, hypothetical bool, reps int,
+							  OUT plan text, OUT ms float8)
+LANGUAGE plpgsql AS $$
+DECLARE
+	cmd			text;
+	started		timestamptz;
+BEGIN
+	cmd := 'EXPLAIN ' || CASE WHEN hypothetical THEN 'HYPOTHETICAL ' ELSE '' END ||
+		'(FORMAT JSON) ' || sql;
+	EXECUTE cmd INTO plan;		-- warm the caches
+	started := clock_timestamp();
+	FOR i IN 1 .. reps LOOP
+		EXECUTE cmd INTO plan;
+	END LOOP;
+	ms := extract(epoch FROM clock_timestamp() - started) * 1000 / reps;
+END;
+$$;
+
+CREATE FUNCTION bench_shape(plan text) RETURNS text
+LANGUAGE sql AS $$
+	SELECT string_agg(m[1], ' > ')
+	FROM regexp_matches(plan, '"Node Type": "([^"]+)"', 'g') m;
+$$;
+
+CREATE FUNCTION bench_cost(plan text) RETURNS float8
+LANGUAGE sql AS $$
+	SELECT (plan::json -> 0 -> 'Plan' ->> 'Total Cost')::float8;
+$$;
+
+CREATE FUNCTION bench_run(reps int) RETURNS void
+LANGUAGE plpgsql AS $$
+DECLARE
+	c			record;
+	q			record;
+	base		record;
+	hypo		record;
+	built		record;
+	uses		text := '"Index Name": "bench_cand"';
+BEGIN
+	FOR c IN SELECT * FROM bench_candidate ORDER BY id LOOP
+		DELETE FROM bench_tmp;
+
+		EXECUTE format('CREATE HYPOTHETICAL INDEX bench_cand ON %I (%s)',
+					   c.tab, c.cols);
+		INSERT INTO bench_size
+			VALUES (c.id, pg_hypothetical_index_size('bench_cand'), NULL);
+		FOR q IN SELECT * FROM bench_query WHERE c.tab = ANY (tabs) ORDER BY id LOOP
+			SELECT * INTO base FROM bench_explain(q.sql, false, reps);
+			SELECT * INTO hypo FROM bench_explain(q.sql, true, reps);
+			INSERT INTO bench_tmp
+				VALUES (q.id, base.plan, base.ms, hypo.plan, hypo.ms);
+		END LOOP;
+		DROP HYPOTHETICAL INDEX bench_cand;
+
+		EXECUTE format('CREATE INDEX bench_cand ON %I (%s)', c.tab, c.cols);
+		UPDATE bench_size SET real_bytes = pg_relation_size('bench_cand')
+			WHERE candidate = c.id;
+		FOR q IN SELECT * FROM bench_query WHERE c.tab = ANY (tabs) ORDER BY id LOOP
+			SELECT * INTO built FROM bench_explain(q.sql, false, reps);
+			INSERT INTO bench_plan
+				SELECT c.id, q.id, t.base_ms, t.hypo_ms, built.ms,
+					   position(uses IN t.hypo_plan) > 0,
+					   position(uses IN built.plan) > 0,
+					   bench_shape(t.hypo_plan), bench_shape(built.plan),
+					   bench_cost(t.hypo_plan), bench_cost(built.plan)
+				FROM bench_tmp t WHERE t.query = q.id;
+		END LOOP;
+		DROP INDEX bench_cand;
+	END LOOP;
+END;
+$$;
+
+SELECT bench_run(:reps);
+
+--
+-- Report
+--
+\echo
+\echo 'Size estimates'
+SELECT c.id, c.tab || ' (' || c.cols || ')' AS candidate,
+	   pg_size_pretty(s.est_bytes) AS estimated,
+	   pg_size_pretty(s.real_bytes) AS real,
+	   round(100.0 * (s.est_bytes - s.real_bytes) / s.real_bytes, 1) AS error_pct
+FROM bench_candidate c JOIN bench_size s ON s.candidate = c.id
+ORDER BY c.id;
+
+\echo 'Plans'
+SELECT candidate, query,
+	   hypo_uses, real_uses, hypo_shape = real_shape AS same_shape,
+	   round((100 * (hypo_cost - real_cost) / real_cost)::numeric, 1) AS cost_error_pct,
+	   round(base_ms::numeric, 3) AS base_ms,
+	   round(hypo_ms::numeric, 3) AS hypo_ms,
+	   round(real_ms::numeric, 3) AS real_ms
+FROM bench_plan
+ORDER BY candidate, query;
+
+\echo 'Summary'
+SELECT count(*) AS plans,
+	   round(100.0 * sum(CASE WHEN hypo_uses = real_uses THEN 1 ELSE 0 END) / count(*), 1)
+		 AS index_use_agreement_pct,
+	   round(100.0 * sum(CASE WHEN hypo_shape = real_shape THEN 1 ELSE 0 END) / count(*), 1)
+		 AS shape_agreement_pct,
+	   round(avg(abs(100 * (hypo_cost - real_cost) / real_cost))::numeric, 1)
+		 AS mean_abs_cost_error_pct,
+	   (SELECT round(avg(abs(100.0 * (est_bytes - real_bytes) / real_bytes)), 1)
+		  FROM bench_size) AS mean_abs_size_error_pct,
+	   round((avg(hypo_ms) - avg(base_ms))::numeric, 3) AS hypo_overhead_ms,
+	   round((avg(hypo_ms) / avg(base_ms))::numeric, 2) AS hypo_vs_base_ratio
+FROM bench_plan;
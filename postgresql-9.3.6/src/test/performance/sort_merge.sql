@@ -0,0 +1,77 @@
+--
+-- sort_merge.sql
+--	Compare the two external sort strategies on data much larger than
+--	work_mem.
+--
+-- Generates :mb megabytes of rows with a random int8 key and a random text
+-- key in schema sort_bench, then sorts them on each key :reps times with
+-- sort_multiway_merge off (replacement selection, heap merges) and on
+-- (quicksorted runs, loser tree merges), work_mem set to :wm.  It reports
+-- the average time of each sort and the ratio between the two strategies.
+--
+-- Sorts of 10GB to 100GB only need a larger :mb, and a tablespace to match.
+-- With trace_sort on, the server log shows the runs and merge passes of
+-- each sort.
+--
+-- Run it with "make -C src/test/performance sort-bench", or directly:
+--	psql -X -v mb=1024 -v wm=64MB -v reps=3 -f sort_merge.sql dbname
+--
+\set ON_ERROR_STOP 1
+\timing off
+
+SET client_min_messages = warning;
+DROP SCHEMA IF EXISTS sort_bench CASCADE;
+CREATE SCHEMA sort_bench;
+SET search_path = sort_bench;
+SELECT setseed(0.42);
+
+--
+-- Data: about 64 bytes per row on disk
+--
+CREATE UNLOGGED TABLE bench_data AS
+	SELECT (random() * 9e18)::int8 AS ikey,
+		   md5(i::text) AS tkey
+	FROM generate_series(1, (:mb * 1024 * 1024 / 64)::int8) i;
+ANALYZE bench_data;
+
+CREATE TABLE bench_result (key text, multiway bool, ms float8);
+
+--
+-- Sort the table on key reps times and return the average time per sort
+--
+CREATE FUNCTION bench_sort(key text, multiway bool, reps int) RETURNS float8
+LANGUAGE plpgsql AS $$
+DECLARE
+	cmd			text;
+	started		timestamptz;
+BEGIN
+	PERFORM set_config('sort_multiway_merge', multiway::text, true);
+	cmd := format('SELECT count(*) FROM (SELECT %I FROM bench_data ORDER BY 1) s',
+				  key);
+	started := clock_timestamp();
+	FOR i IN 1 .. reps LOOP
+		EXECUTE cmd;
+	END LOOP;
+	RETURN extract(epoch FROM clock_timestamp() - started) * 1000 / reps;
+END;
+$$;
+
+SET work_mem = :'wm';
+INSERT INTO bench_result
+	SELECT k, m, bench_sort(k, m, :reps)
+	FROM unnest(ARRAY['ikey', 'tkey']) k, unnest(ARRAY[false, true]) m;
+
+--
+-- Report
+--
+\echo
+\echo 'Sorts'
+SELECT pg_size_pretty(pg_relation_size('bench_data')) AS data,
+	   current_setting('work_mem') AS work_mem,
+	   h.key,
+	   round(h.ms::numeric, 1) AS heap_ms,
+	   round(l.ms::numeric, 1) AS multiway_ms,
+	   round((h.ms / l.ms)::numeric, 2) AS speedup
+FROM bench_result h JOIN bench_result l ON l.key = h.key
+WHERE NOT h.multiway AND l.multiway
+ORDER BY h.key;
@@ -441,3 +441,60 @@ select string_agg(v, NULL) from bytea_test_table;
 select string_agg(v, decode('ee', 'hex')) from bytea_test_table;
 
 drop table bytea_test_table;
+
+-- hashed aggregation that outgrows work_mem spills to disk
+set work_mem = '64kB';
+set enable_sort = off;
+explain (costs off)
+select g % 5000 as k, count(*), sum(g) from generate_series(1, 50000) g group by 1;
+create temp table agg_spill as
+select g % 5000 as k, count(*) as c, sum(g) as s from generate_series(1, 50000) g group by 1;
+reset enable_sort;
+reset work_mem;
+select count(*), sum(c), min(c), max(c), sum(s) from agg_spill;
+drop table agg_spill;
+
+-- batch-at-a-time execution of scans and plain aggregates
+create temp table batch_tbl as
+select case when g % 7 = 0 then null else g end as i,
+       case when g % 11 = 0 then null else g * 1000000000::int8 end as b,
+       case when g % 13 = 0 then null else g / 4.0::float8 end as f,
+       case when g % 17 = 0 then null else '2000-01-01'::date + g end as d
+from generate_series(1, 3000) g;
+insert into batch_tbl values (null, null, 'NaN', null);
+-- each query runs with batching off and on, and the two results must match
+create function batch_check(q text) returns setof text language plpgsql as $$
+declare
+  ndiff bigint;
+begin
+  perform set_config('extra_float_digits', '3', true);
+  perform set_config('batch_execution', 'off', true);
+  execute 'create temp table batch_off as select t::text as r from (' || q || ') t';
+  perform set_config('batch_execution', 'on', true);
+  execute 'create temp table batch_on as select t::text as r from (' || q || ') t';
+  select count(*) into ndiff from
+    ((select r from batch_off except all select r from batch_on)
+     union all
+     (select r from batch_on except all select r from batch_off)) d;
+  if ndiff > 0 then
+    raise exception 'batched and unbatched results differ in % rows', ndiff;
+  end if;
+  return query select r from batch_on order by r;
+  drop table batch_off;
+  drop table batch_on;
+end
+$$;
+select batch_check($$select count(*), count(i), sum(i), round(avg(i), 4), min(i), max(i)
+  from batch_tbl where i > 1000 and b <= 2500000000000$$);
+select batch_check($$select count(f), sum(f), avg(f), min(f), max(f) from batch_tbl where f >= 500$$);
+select batch_check($$select count(f), sum(f), round(avg(f)::numeric, 6), min(f), max(f)
+  from batch_tbl where f < 500$$);
+select batch_check($$select min(d), max(d), count(*) from batch_tbl
+  where d <> '2000-02-01' and '2000-06-01' > d and 10 >= i % 100$$);
+select batch_check($$select * from batch_tbl where i between 995 and 1005 and f < 251$$);
+select batch_check($$select count(*), min(b), max(b) from batch_tbl
+  where b > 2000000000000 and i >= 2990::int8$$);
+select batch_check($$select g, (select count(*) from batch_tbl where i < g) from generate_series(1, 3) g$$);
+select batch_check($$select count(*), sum(i), min(f) from batch_tbl where i < 0$$);
+drop function batch_check(text);
+drop table batch_tbl;
@@ -0,0 +1,335 @@
+--
+-- HYPOTHETICAL INDEX
+--
+-- The estimated size of a hypothetical index should be close to the size
+-- of the same index really built.
+--
+CREATE TABLE hypo_size (id int4, val text, num numeric, flag bool, maybe int4);
+INSERT INTO hypo_size
+  SELECT i, 'value ' || (i % 1000), i / 7.0, i % 2 = 0,
+         CASE WHEN i % 4 = 0 THEN NULL ELSE i END
+  FROM generate_series(1, 100000) i;
+ANALYZE hypo_size;
+
+CREATE INDEX hypo_size_id_real ON hypo_size (id);
+CREATE INDEX hypo_size_val_real ON hypo_size (val);
+CREATE INDEX hypo_size_num_real ON hypo_size (num);
+CREATE INDEX hypo_size_multi_real ON hypo_size (flag, id);
+CREATE INDEX hypo_size_maybe_real ON hypo_size (maybe);
+CREATE INDEX hypo_size_ff_real ON hypo_size (id) WITH (fillfactor = 50);
+
+CREATE HYPOTHETICAL INDEX hypo_size_id_hypo ON hypo_size (id);
+CREATE HYPOTHETICAL INDEX hypo_size_val_hypo ON hypo_size (val);
+CREATE HYPOTHETICAL INDEX hypo_size_num_hypo ON hypo_size (num);
+CREATE HYPOTHETICAL INDEX hypo_size_multi_hypo ON hypo_size (flag, id);
+CREATE HYPOTHETICAL INDEX hypo_size_maybe_hypo ON hypo_size (maybe);
+CREATE HYPOTHETICAL INDEX hypo_size_ff_hypo ON hypo_size (id) WITH (fillfactor = 50);
+
+SELECT name,
+       pg_hypothetical_index_size('hypo_size_' || name || '_hypo')::float8 /
+       pg_relation_size(('hypo_size_' || name || '_real')::regclass)
+         BETWEEN 0.9 AND 1.1 AS close_enough
+  FROM (VALUES ('id'), ('val'), ('num'), ('multi'), ('maybe'), ('ff')) v(name)
+  ORDER BY name;
+
+-- only hypothetical indexes have an estimate
+SELECT pg_hypothetical_index_size('hypo_size_id_real');
+
+-- session-private hypothetical indexes get the same estimate
+SET hypothetical_index_private = on;
+CREATE HYPOTHETICAL INDEX hypo_size_private ON hypo_size (id);
+SELECT pg_hypothetical_index_size('hypo_size_private') =
+       pg_hypothetical_index_size('hypo_size_id_hypo') AS same_estimate;
+DROP HYPOTHETICAL INDEX hypo_size_private;
+DROP HYPOTHETICAL INDEX hypo_size_id_real;
+RESET hypothetical_index_private;
+
+DROP TABLE hypo_size;
+
+-- batched what-if costing
+CREATE TABLE hypo_cost (a int4, b int4);
+INSERT INTO hypo_cost SELECT i, i % 1000 FROM generate_series(1, 10000) i;
+ANALYZE hypo_cost;
+SELECT candidate, query, uses_candidate,
+       total_cost < first_value(total_cost)
+         OVER (PARTITION BY query ORDER BY candidate) AS cheaper
+  FROM hypothetical_index_costs(
+         ARRAY['CREATE INDEX ON hypo_cost (a)',
+               'CREATE HYPOTHETICAL INDEX ON hypo_cost (b)'],
+         ARRAY['SELECT * FROM hypo_cost WHERE a = 42',
+               'SELECT * FROM hypo_cost WHERE b < 10'])
+  ORDER BY candidate, query;
+SELECT * FROM hypothetical_index_costs(ARRAY['DROP TABLE hypo_cost'], '{}');
+SELECT * FROM hypothetical_index_costs('{}', ARRAY['VACUUM hypo_cost']);
+DROP TABLE hypo_cost;
+
+-- index advisor
+CREATE TABLE hypo_adv (a int4, b int4, c text);
+INSERT INTO hypo_adv SELECT i, i % 1000, 'row ' || i FROM generate_series(1, 10000) i;
+ANALYZE hypo_adv;
+SELECT indexdef, size > 0 AS sized, benefit > 0 AS helps
+  FROM hypothetical_index_advisor(
+         ARRAY['SELECT * FROM hypo_adv WHERE a = 42',
+               'SELECT c FROM hypo_adv WHERE b = 7'],
+         1000000000)
+  ORDER BY indexdef;
+-- nothing fits in an empty budget
+SELECT count(*) FROM hypothetical_index_advisor(
+         ARRAY['SELECT * FROM hypo_adv WHERE a = 42'], 0);
+SELECT * FROM hypothetical_index_advisor(ARRAY['SELECT 1'], -1);
+DROP TABLE hypo_adv;
+
+-- workload capture is off unless hypothetical_workload_entries is set
+SHOW hypothetical_workload_entries;
+SELECT count(*) FROM hypothetical_workload();
+SELECT hypothetical_workload_reset();
+
+-- GIN indexes get their statistics from the table's element statistics
+CREATE TABLE hypo_gin (tags int4[]);
+INSERT INTO hypo_gin SELECT ARRAY[i % 10, i % 100, i] FROM generate_series(1, 10000) i;
+ANALYZE hypo_gin;
+SET hypothetical_index_private = on;
+CREATE HYPOTHETICAL INDEX hypo_gin_private ON hypo_gin USING gin (tags);
+SELECT pg_hypothetical_index_size('hypo_gin_private') > 8192 AS sized;
+DROP HYPOTHETICAL INDEX hypo_gin_private;
+RESET hypothetical_index_private;
+DROP TABLE hypo_gin;
+
+-- partial indexes are sized by their predicate, expressions by a sample
+CREATE TABLE hypo_part (status text, note text);
+INSERT INTO hypo_part SELECT CASE WHEN i % 100 = 0 THEN 'open' ELSE 'closed' END, repeat('x', 200) FROM generate_series(1, 10000) i;
+ANALYZE hypo_part;
+SET hypothetical_index_private = on;
+CREATE HYPOTHETICAL INDEX hypo_part_all ON hypo_part (status);
+CREATE HYPOTHETICAL INDEX hypo_part_open ON hypo_part (status) WHERE status = 'open';
+CREATE HYPOTHETICAL INDEX hypo_part_short ON hypo_part (lower(status));
+CREATE HYPOTHETICAL INDEX hypo_part_long ON hypo_part (lower(note));
+SELECT pg_hypothetical_index_size('hypo_part_open') <
+       pg_hypothetical_index_size('hypo_part_all') / 10 AS partial_smaller,
+       pg_hypothetical_index_size('hypo_part_long') >
+       pg_hypothetical_index_size('hypo_part_short') * 4 AS expr_sampled;
+DROP HYPOTHETICAL INDEX hypo_part_all;
+DROP HYPOTHETICAL INDEX hypo_part_open;
+DROP HYPOTHETICAL INDEX hypo_part_short;
+DROP HYPOTHETICAL INDEX hypo_part_long;
+RESET hypothetical_index_private;
+DROP TABLE hypo_part;
+
+-- EXPLAIN (COMPARE) plans without and with hypothetical indexes at once
+CREATE TABLE hypo_cmp (a int4, b text);
+INSERT INTO hypo_cmp SELECT i, 'row ' || i FROM generate_series(1, 10000) i;
+ANALYZE hypo_cmp;
+SET hypothetical_index_private = on;
+CREATE HYPOTHETICAL INDEX hypo_cmp_a ON hypo_cmp (a);
+EXPLAIN (COMPARE, COSTS OFF) SELECT * FROM hypo_cmp WHERE a = 42;
+EXPLAIN (COMPARE, ANALYZE) SELECT * FROM hypo_cmp WHERE a = 42;
+DROP HYPOTHETICAL INDEX hypo_cmp_a;
+RESET hypothetical_index_private;
+DROP TABLE hypo_cmp;
+
+-- hypothetical planning can treat real indexes as dropped
+CREATE TABLE hypo_drop (a int4, b text);
+INSERT INTO hypo_drop SELECT i, 'row ' || i FROM generate_series(1, 10000) i;
+CREATE INDEX hypo_drop_a ON hypo_drop (a);
+ANALYZE hypo_drop;
+SET hypothetical_disabled_indexes = hypo_drop_a, no_such_index;
+EXPLAIN (COMPARE, COSTS OFF) SELECT * FROM hypo_drop WHERE a = 42;
+-- unqualified names are resolved again when search_path changes
+SET search_path = pg_catalog;
+EXPLAIN (COMPARE, COSTS OFF) SELECT * FROM public.hypo_drop WHERE a = 42;
+SET hypothetical_disabled_indexes = 'public.hypo_drop_a';
+EXPLAIN (COMPARE, COSTS OFF) SELECT * FROM public.hypo_drop WHERE a = 42;
+RESET search_path;
+SELECT set_config('hypothetical_disabled_indexes', '"hypo_drop_a', false);
+RESET hypothetical_disabled_indexes;
+DROP TABLE hypo_drop;
+
+-- correlated key columns are costed from a sample of their combination
+CREATE TABLE hypo_key (city int4, zip int4);
+INSERT INTO hypo_key SELECT i / 100, i / 10 FROM generate_series(1, 10000) i;
+ANALYZE hypo_key;
+SELECT bool_and(uses_candidate) AS used,
+       max(CASE WHEN candidate = 1 THEN total_cost END) >=
+       max(CASE WHEN candidate = 2 THEN total_cost END) AS not_cheaper
+  FROM hypothetical_index_costs(
+         ARRAY['CREATE HYPOTHETICAL INDEX ON hypo_key (city, zip)',
+               'CREATE HYPOTHETICAL INDEX ON hypo_key (zip)'],
+         ARRAY['SELECT * FROM hypo_key WHERE city = 5 AND zip = 55'])
+  WHERE candidate > 0;
+DROP TABLE hypo_key;
+
+-- a hypothetical index can be declared clustered
+CREATE TABLE hypo_clu (ts int4, device int4, payload text);
+INSERT INTO hypo_clu SELECT i, (i * 7919) % 1000, repeat('x', 100) FROM generate_series(1, 10000) i;
+ANALYZE hypo_clu;
+SELECT candidate, uses_candidate,
+       total_cost < first_value(total_cost)
+         OVER (ORDER BY candidate) AS cheaper
+  FROM hypothetical_index_costs(
+         ARRAY['CREATE HYPOTHETICAL INDEX ON hypo_clu (device)',
+               'CREATE HYPOTHETICAL INDEX ON hypo_clu (device) WITH (clustered)'],
+         ARRAY['SELECT * FROM hypo_clu WHERE device = 5'])
+  WHERE candidate > 0
+  ORDER BY candidate;
+CREATE HYPOTHETICAL INDEX hypo_clu_dev ON hypo_clu (device) WITH (clustered);
+CLUSTER hypo_clu;
+ALTER TABLE hypo_clu CLUSTER ON hypo_clu_dev;
+CREATE INDEX hypo_clu_real ON hypo_clu (device) WITH (clustered);
+CREATE HYPOTHETICAL INDEX hypo_clu_part ON hypo_clu (device) WITH (clustered) WHERE ts > 0;
+DROP HYPOTHETICAL INDEX hypo_clu_dev;
+DROP TABLE hypo_clu;
+
+-- hypothetical index DDL doesn't lock the table against DML
+CREATE TABLE hypo_lock (a int4);
+BEGIN;
+CREATE HYPOTHETICAL INDEX hypo_lock_a ON hypo_lock (a);
+SELECT mode FROM pg_locks
+  WHERE locktype = 'relation' AND relation = 'hypo_lock'::regclass
+    AND pid = pg_backend_pid();
+SELECT relhasindex FROM pg_class WHERE oid = 'hypo_lock'::regclass;
+COMMIT;
+BEGIN;
+DROP HYPOTHETICAL INDEX hypo_lock_a;
+SELECT mode FROM pg_locks
+  WHERE locktype = 'relation' AND relation = 'hypo_lock'::regclass
+    AND pid = pg_backend_pid();
+COMMIT;
+DROP TABLE hypo_lock;
+
+-- an index-only scan on a hypothetical index reports the visibility map
+CREATE TABLE hypo_ios (a int4, b text) WITH (autovacuum_enabled = false);
+INSERT INTO hypo_ios SELECT i, repeat('x', 100) FROM generate_series(1, 10000) i;
+ANALYZE hypo_ios;
+CREATE HYPOTHETICAL INDEX hypo_ios_a ON hypo_ios (a);
+EXPLAIN HYPOTHETICAL (COSTS OFF) SELECT a FROM hypo_ios WHERE a = 42;
+EXPLAIN HYPOTHETICAL (COSTS OFF) SELECT * FROM hypo_ios WHERE a = 42;
+DROP HYPOTHETICAL INDEX hypo_ios_a;
+DROP TABLE hypo_ios;
+
+-- EXPLAIN (SUMMARY) breaks the planning time down by planner phase
+CREATE TABLE hypo_time (a int4);
+CREATE HYPOTHETICAL INDEX hypo_time_a ON hypo_time (a);
+CREATE FUNCTION hypo_explain_json(cmd text) RETURNS json LANGUAGE plpgsql AS $$
+DECLARE
+  plan json;
+BEGIN
+  EXECUTE cmd INTO plan;
+  RETURN plan;
+END
+$$;
+SELECT json_object_keys(hypo_explain_json(
+  'EXPLAIN HYPOTHETICAL (SUMMARY, FORMAT JSON) SELECT * FROM hypo_time WHERE a = 1'
+  )->0->'Planning Phases');
+SELECT (hypo_explain_json(
+  'EXPLAIN (SUMMARY, COMPARE, FORMAT JSON) SELECT * FROM hypo_time WHERE a = 1'
+  )->0->'Plan With Hypothetical Indexes'->>'Planning Time')::float8 >= 0 AS timed;
+SELECT pg_stat_reset_planner_phases();
+SET hypothetical_planner_timing = on;
+SELECT hypo_explain_json(
+  'EXPLAIN HYPOTHETICAL (FORMAT JSON) SELECT * FROM hypo_time WHERE a = 1'
+  ) IS NOT NULL AS explained;
+SELECT kind, plannings > 0 AS timed FROM pg_stat_planner_phases ORDER BY kind;
+RESET hypothetical_planner_timing;
+DROP FUNCTION hypo_explain_json(text);
+DROP HYPOTHETICAL INDEX hypo_time_a;
+DROP TABLE hypo_time;
+
+-- EXPLAIN HYPOTHETICAL of a data modifying statement shows what keeping up
+-- each hypothetical index would cost it
+CREATE TABLE hypo_write (a int4, b int4, c text) WITH (autovacuum_enabled = false);
+INSERT INTO hypo_write SELECT i, i % 100, 'row ' || i FROM generate_series(1, 10000) i;
+ANALYZE hypo_write;
+CREATE INDEX hypo_write_a ON hypo_write (a);
+CREATE HYPOTHETICAL INDEX hypo_write_b ON hypo_write (b);
+CREATE FUNCTION hypo_write_cost(cmd text) RETURNS SETOF text LANGUAGE plpgsql AS $$
+DECLARE
+  ln text;
+BEGIN
+  FOR ln IN EXECUTE 'EXPLAIN HYPOTHETICAL ' || cmd LOOP
+    IF ln LIKE '%Hypothetical Index%' THEN
+      RETURN NEXT trim(ln);
+    END IF;
+  END LOOP;
+END
+$$;
+SELECT hypo_write_cost('INSERT INTO hypo_write VALUES (0, 0, ''new'')');
+SELECT hypo_write_cost('UPDATE hypo_write SET c = ''z''');
+SELECT hypo_write_cost('UPDATE hypo_write SET b = 0');
+SELECT hypo_write_cost('UPDATE hypo_write SET a = 0');
+SELECT hypo_write_cost('DELETE FROM hypo_write');
+-- an update another hypothetical index spoils HOT for adds entries to all
+SET hypothetical_index_private = on;
+CREATE HYPOTHETICAL INDEX hypo_write_c ON hypo_write (c);
+SELECT hypo_write_cost('UPDATE hypo_write SET c = ''z''');
+DROP HYPOTHETICAL INDEX hypo_write_c;
+RESET hypothetical_index_private;
+DROP FUNCTION hypo_write_cost(text);
+DROP HYPOTHETICAL INDEX hypo_write_b;
+DROP TABLE hypo_write;
+
+-- the hypothetical plan cache answers a repeated query until something the
+-- plan depends on changes; the query is planned twice in one transaction,
+-- so that invalidations from concurrent tests cannot come in between
+CREATE TABLE hypo_pc (a int4, b int4);
+INSERT INTO hypo_pc SELECT i, i % 100 FROM generate_series(1, 10000) i;
+ANALYZE hypo_pc;
+CREATE FUNCTION hypo_plan_cached() RETURNS text LANGUAGE plpgsql AS $$
+DECLARE
+  plan1 json;
+  plan2 json;
+BEGIN
+  EXECUTE 'EXPLAIN HYPOTHETICAL (SUMMARY, FORMAT JSON) SELECT * FROM hypo_pc WHERE a = 1'
+    INTO plan1;
+  EXECUTE 'EXPLAIN HYPOTHETICAL (SUMMARY, FORMAT JSON) SELECT * FROM hypo_pc WHERE a = 1'
+    INTO plan2;
+  RETURN (plan1->0->>'Cached Plan') || ' ' || (plan2->0->>'Cached Plan');
+END
+$$;
+SELECT hypo_plan_cached();
+CREATE HYPOTHETICAL INDEX hypo_pc_a ON hypo_pc (a);
+SELECT hypo_plan_cached();
+ANALYZE hypo_pc;
+SELECT hypo_plan_cached();
+SET random_page_cost = 2;
+SELECT hypo_plan_cached();
+SET hypothetical_disabled_indexes = 'hypo_pc_a';
+SELECT hypo_plan_cached();
+RESET hypothetical_disabled_indexes;
+RESET random_page_cost;
+DROP HYPOTHETICAL INDEX hypo_pc_a;
+SELECT hypo_plan_cached();
+DROP FUNCTION hypo_plan_cached();
+DROP TABLE hypo_pc;
+
+-- hypothetical indexes dropped at commit, at session end or all at once
+CREATE TABLE hypo_life (a int4, b int4);
+CREATE TEMP HYPOTHETICAL INDEX hypo_life_temp ON hypo_life (a);
+SELECT count(*) FROM pg_depend
+  WHERE objid = 'hypo_life_temp'::regclass
+    AND refclassid = 'pg_namespace'::regclass;
+BEGIN;
+CREATE HYPOTHETICAL INDEX hypo_life_xact ON hypo_life (b) ON COMMIT DROP;
+SELECT count(*) FROM pg_index WHERE indrelid = 'hypo_life'::regclass;
+COMMIT;
+SELECT count(*) FROM pg_index WHERE indrelid = 'hypo_life'::regclass;
+SET hypothetical_index_private = on;
+BEGIN;
+CREATE HYPOTHETICAL INDEX hypo_life_private ON hypo_life (b) ON COMMIT DROP;
+COMMIT;
+DROP HYPOTHETICAL INDEX IF EXISTS hypo_life_private;
+-- a private index writes nothing, so a read-only transaction may create it
+BEGIN READ ONLY;
+CREATE HYPOTHETICAL INDEX hypo_life_private ON hypo_life (b) ON COMMIT DROP;
+COMMIT;
+CREATE HYPOTHETICAL INDEX hypo_life_private ON hypo_life (b);
+RESET hypothetical_index_private;
+BEGIN READ ONLY;
+CREATE HYPOTHETICAL INDEX hypo_life_b ON hypo_life (b);
+ROLLBACK;
+CREATE HYPOTHETICAL INDEX hypo_life_b ON hypo_life (b);
+DROP ALL HYPOTHETICAL INDEXES;
+SELECT count(*) FROM pg_index WHERE indrelid = 'hypo_life'::regclass;
+SET hypothetical_index_private = on;
+DROP HYPOTHETICAL INDEX IF EXISTS hypo_life_private;
+RESET hypothetical_index_private;
+DROP TABLE hypo_life;
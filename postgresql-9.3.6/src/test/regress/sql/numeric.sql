@@ -837,3 +837,21 @@ select 10.0 ^ -2147483648 as rounds_to_zero;
 select 10.0 ^ -2147483647 as rounds_to_zero;
 select 10.0 ^ 2147483647 as overflows;
 select 117743296169.0 ^ 1000000000 as overflows;
+
+-- sorts abbreviate the leading numeric key; values beyond the weights the
+-- abbreviation can represent, and values sharing their leading digits,
+-- must still come out in order
+create temp table abbrev_numeric (n numeric);
+insert into abbrev_numeric
+  select (g - 500) * power(10::numeric, g % 40 - 20)
+  from generate_series(1, 1000) g;
+insert into abbrev_numeric
+  values ('NaN'), (0), (1e200), (-1e200), (2e200), (1e-200), (-1e-200),
+         (1.0000000000000001), (1.0000000000000002), (-1.0000000000000001);
+select count(*) from
+  (select n, lag(n) over (order by n) as prev from abbrev_numeric) s
+where prev > n;
+select count(*) from
+  (select n, lag(n) over (order by n desc) as prev from abbrev_numeric) s
+where prev < n;
+drop table abbrev_numeric;
@@ -207,3 +207,34 @@ drop function sillysrf(int);
 -- (see bug #5084)
 select * from (values (2),(null),(1)) v(k) where k = k order by k;
 select * from (values (2),(null),(1)) v(k) where k = k;
+
+-- external sorts with quicksorted runs and loser tree merges
+set work_mem = '64kB';
+set sort_multiway_merge = on;
+select count(*), min(v), max(v), sum(v),
+       sum(case when v < p then 1 else 0 end) as disorder
+from (select v, lag(v) over () as p
+      from (select (g * 7919) % 100003 as v
+            from generate_series(1, 100000) g order by 1) s) x;
+select count(*), sum(case when t > p then 1 else 0 end) as disorder
+from (select t, lag(t) over () as p
+      from (select ((g * 7919) % 100003)::text as t
+            from generate_series(1, 100000) g order by 1 desc) s) x;
+reset sort_multiway_merge;
+reset work_mem;
+
+-- expressions flattened into linear programs, and evaluated as trees
+create temp table expr_tbl (a int, b int, c bool);
+insert into expr_tbl values
+  (1, 2, true), (2, null, false), (null, 3, null), (null, null, true), (4, 4, null);
+select a, b, c, a < b as lt, a < b and c as "and", a < b or c as "or",
+       not (a = b) as ne, a + b is null as isnull, coalesce(a, b) + 1 as tree
+from expr_tbl;
+select * from expr_tbl where (a > 1 or b > 2) and c is not null;
+set compile_expressions = off;
+select a, b, c, a < b as lt, a < b and c as "and", a < b or c as "or",
+       not (a = b) as ne, a + b is null as isnull, coalesce(a, b) + 1 as tree
+from expr_tbl;
+select * from expr_tbl where (a > 1 or b > 2) and c is not null;
+reset compile_expressions;
+drop table expr_tbl;
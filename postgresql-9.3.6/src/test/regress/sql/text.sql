@@ -116,3 +116,42 @@ select format('>>%-s<<', 'Hello');
 select format('>>%10L<<', NULL);
 select format('>>%2$*1$L<<', NULL, 'Hello');
 select format('>>%2$*1$L<<', 0, 'Hello');
+
+-- sorts abbreviate the leading text key; strings sharing their first bytes,
+-- which make the sort give up abbreviating, and strings read back from disk
+-- must still come out in order
+create temp table abbrev_text (t text collate "C");
+insert into abbrev_text
+  select 'same prefix ' || (g % 1000)::text from generate_series(1, 3000) g;
+insert into abbrev_text
+  select md5(g::text) from generate_series(1, 3000) g;
+select count(*) from
+  (select t, lag(t) over (order by t) as prev from abbrev_text) s
+where prev > t;
+select count(*) from
+  (select t, lag(t) over (order by t desc) as prev from abbrev_text
+   where t not like 'same%') s
+where prev < t;
+select bool_and(a[i] <= a[i + 1]) from
+  (select array_agg(t order by t) as a from abbrev_text) s,
+  generate_series(1, 5999) i;
+set work_mem = '64kB';
+select count(*) from
+  (select t, lag(t) over (order by t) as prev from abbrev_text
+   where t not like 'same%') s
+where prev > t;
+reset work_mem;
+create index abbrev_text_idx on abbrev_text (t);
+set enable_seqscan = off;
+set enable_bitmapscan = off;
+select count(*) from
+  (select t, lag(t) over () as prev from
+    (select t from abbrev_text order by t) ss) s
+where prev > t;
+reset enable_seqscan;
+reset enable_bitmapscan;
+create unique index abbrev_text_uniq on abbrev_text (t)
+  where t not like 'same%';
+create unique index abbrev_text_dup on abbrev_text (t)
+  where t = 'same prefix 7';
+drop table abbrev_text;
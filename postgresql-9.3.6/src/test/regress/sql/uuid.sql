@@ -77,3 +77,11 @@ SELECT COUNT(*) FROM guid1 g1 LEFT JOIN guid2 g2 ON g1.guid_field = g2.guid_fiel
 
 -- clean up
 DROP TABLE guid1, guid2 CASCADE;
+
+-- sorts abbreviate the leading uuid key
+CREATE TEMP TABLE abbrev_uuid AS
+  SELECT md5((g % 2000)::text)::uuid AS u FROM generate_series(1, 4000) g;
+SELECT count(*) FROM
+  (SELECT u, lag(u) OVER (ORDER BY u) AS prev FROM abbrev_uuid) s
+WHERE prev > u;
+DROP TABLE abbrev_uuid;